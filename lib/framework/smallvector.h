@@ -0,0 +1,142 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A vector which keeps its first few elements inside the object itself.
+ */
+
+#ifndef _SMALLVECTOR_H_
+#define _SMALLVECTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+/// Like std::vector, but stores up to N elements without allocating, for lists which are usually short or empty.
+/// Only supports the few operations needed so far, and only trivially copyable types.
+template<typename T, unsigned N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SmallVector only supports trivially copyable types.");
+
+public:
+	typedef T *iterator;
+	typedef T const *const_iterator;
+
+	SmallVector() {}
+	SmallVector(SmallVector const &other)
+	{
+		*this = other;
+	}
+	SmallVector &operator =(SmallVector const &other)
+	{
+		if (this != &other)
+		{
+			count = 0;
+			reserve(other.count);
+			std::copy(other.begin(), other.end(), begin());
+			count = other.count;
+		}
+		return *this;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+	bool empty() const
+	{
+		return count == 0;
+	}
+	bool isInline() const  ///< True if nothing has been allocated.
+	{
+		return heap == nullptr;
+	}
+
+	iterator begin()
+	{
+		return heap != nullptr ? heap.get() : local;
+	}
+	iterator end()
+	{
+		return begin() + count;
+	}
+	const_iterator begin() const
+	{
+		return heap != nullptr ? heap.get() : local;
+	}
+	const_iterator end() const
+	{
+		return begin() + count;
+	}
+	T &operator [](size_t index)
+	{
+		return begin()[index];
+	}
+	T const &operator [](size_t index) const
+	{
+		return begin()[index];
+	}
+
+	void push_back(T const &value)
+	{
+		if (count == capacity)
+		{
+			reserve(capacity * 2);
+		}
+		begin()[count++] = value;
+	}
+	iterator erase(iterator first, iterator last)
+	{
+		std::copy(last, end(), first);
+		count -= last - first;
+		return first;
+	}
+	void clear()
+	{
+		count = 0;
+	}
+	void reserve(size_t newCapacity)
+	{
+		if (newCapacity <= capacity)
+		{
+			return;
+		}
+		std::unique_ptr<T[]> newHeap(new T[newCapacity]);
+		std::copy(begin(), end(), newHeap.get());
+		heap = std::move(newHeap);
+		capacity = newCapacity;
+		++heapAllocations();
+	}
+
+	/// Number of times any SmallVector<T, N> has had to allocate, for profiling.
+	static std::atomic<size_t> &heapAllocations()
+	{
+		static std::atomic<size_t> allocations(0);
+		return allocations;
+	}
+
+private:
+	T local[N];
+	std::unique_ptr<T[]> heap;
+	size_t count = 0;
+	size_t capacity = N;
+};
+
+#endif // _SMALLVECTOR_H_
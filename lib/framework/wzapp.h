@@ -68,6 +68,8 @@ struct screeninfo
 
 void wzMain(int &argc, char **argv);
 bool wzMainScreenSetup(int antialiasing = 0, bool fullscreen = false, bool vsync = true, bool highDPI = true);
+bool wzMainHeadlessSetup();	///< Like wzMainScreenSetup, but without creating a window or GL context
+bool wzIsHeadless();		///< Whether wzMainHeadlessSetup was used, so nothing may be rendered
 void wzGetGameToRendererScaleFactor(float *horizScaleFactor, float *vertScaleFactor);
 void wzMainEventLoop();
 void wzQuit();              ///< Quit game
@@ -89,6 +91,7 @@ void wzGrabMouse();		///< Trap mouse cursor in application window
 void wzReleaseMouse();	///< Undo the wzGrabMouse operation
 bool wzActiveWindow();	///< Whether application currently has the mouse pointer over it
 int wzGetTicks();		///< Milliseconds since start of game
+int wzGetCPUCount();		///< Number of logical CPU cores
 WZ_DECL_NONNULL(1) void wzFatalDialog(const char *text);	///< Throw up a modal warning dialog
 
 std::vector<screeninfo> wzAvailableResolutions();
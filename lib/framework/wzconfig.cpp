@@ -24,19 +24,49 @@
 
 // Get platform defines before checking for them.
 #include "wzconfig.h"
+#include "wzconfigbinary.h"
 #include <physfs.h>
 #include "file.h"
 #include <sstream>
 
+/// Parses a file, which holds JSON text, a binary document or a record document. Throws if it holds none of them.
+static nlohmann::json parseDocument(const char *data, size_t size)
+{
+	if (isBinaryJson(data, size))
+	{
+		return decodeBinaryJson(data, size);
+	}
+	if (isRecordDocument(data, size))
+	{
+		return decodeRecordDocument(data, size);
+	}
+	return nlohmann::json::parse(data, data + size);
+}
+
+/// Returns the contents of a file holding the document, in the given format.
+static std::string formatDocument(const nlohmann::json &root, WzConfig::format format)
+{
+	std::string records;
+	if (format == WzConfig::Records && encodeRecordDocument(root, records))
+	{
+		return records;
+	}
+	if (format == WzConfig::Binary || format == WzConfig::Records)
+	{
+		return encodeBinaryJson(root);
+	}
+	std::ostringstream stream;
+	stream << root.dump(4) << std::endl;
+	return stream.str();
+}
+
 WzConfig::~WzConfig()
 {
 	if (mWarning == ReadAndWrite)
 	{
 		ASSERT(mObjStack.empty(), "Some json groups have not been closed, stack size %zu.", mObjStack.size());
-		std::ostringstream stream;
-		stream << mRoot.dump(4) << std::endl;
-		std::string jsonString = stream.str();
-		saveFile(mFilename.toUtf8().c_str(), jsonString.c_str(), jsonString.size());
+		std::string document = formatDocument(mRoot, mFormat);
+		saveFile(mFilename.toUtf8().c_str(), document.c_str(), document.size());
 	}
 	debug(LOG_SAVE, "%s %s", mWarning == ReadAndWrite? "Saving" : "Closing", mFilename.toUtf8().c_str());
 }
@@ -63,7 +93,7 @@ static nlohmann::json jsonMerge(nlohmann::json original, const nlohmann::json& o
 	return original;
 }
 
-WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
+WzConfig::WzConfig(const WzString &name, WzConfig::warning warning, WzConfig::format writeFormat)
 : mArray(nlohmann::json::array())
 {
 	UDWORD size;
@@ -72,6 +102,7 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 	mFilename = name;
 	mStatus = true;
 	mWarning = warning;
+	mFormat = writeFormat;
 	pCurrentObj = &mRoot;
 
 	if (!PHYSFS_exists(name.toUtf8().c_str()))
@@ -97,7 +128,7 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 	}
 
 	try {
-		mRoot = nlohmann::json::parse(data, data + size);
+		mRoot = parseDocument(data, size);
 	}
 	catch (const std::exception &e) {
 		ASSERT(false, "JSON document from %s is invalid: %s", name.toUtf8().c_str(), e.what());
@@ -142,6 +173,37 @@ WzConfig::WzConfig(const WzString &name, WzConfig::warning warning)
 	pCurrentObj = &mRoot;
 }
 
+bool WzConfig::convertFile(const WzString &name, WzConfig::format toFormat)
+{
+	UDWORD size;
+	char *data;
+	if (!PHYSFS_exists(name.toUtf8().c_str()) || !loadFile(name.toUtf8().c_str(), &data, &size))
+	{
+		debug(LOG_ERROR, "Could not open \"%s\"", name.toUtf8().c_str());
+		return false;
+	}
+	nlohmann::json root;
+	try {
+		root = parseDocument(data, size);
+	}
+	catch (const std::exception &e) {
+		debug(LOG_ERROR, "Not converting %s, which is invalid: %s", name.toUtf8().c_str(), e.what());
+		free(data);
+		return false;
+	}
+	free(data);
+
+	std::string document = formatDocument(root, toFormat);
+	return saveFile(name.toUtf8().c_str(), document.c_str(), document.size());
+}
+
+bool WzConfig::saveRecords(const WzString &name, WzRecordWriter &records)
+{
+	std::string document = records.finish();
+	debug(LOG_SAVE, "Saving %s", name.toUtf8().c_str());
+	return saveFile(name.toUtf8().c_str(), document.c_str(), document.size());
+}
+
 bool WzConfig::isAtDocumentRoot() const
 {
 	return pCurrentObj == &mRoot;
@@ -342,7 +404,7 @@ void WzConfig::endGroup()
 		mObjStack.pop_back();
 		if (!mNewObjStack.empty() && &mNewObjStack.back() == pLatestObj)
 		{
-			(*pCurrentObj)[mName.toUtf8()] = *pLatestObj;
+			(*pCurrentObj)[mName.toUtf8()] = std::move(*pLatestObj);
 			mNewObjStack.pop_back();
 		}
 		else
@@ -415,7 +477,7 @@ void WzConfig::nextArrayItem()
 {
 	if (mWarning == ReadAndWrite)
 	{
-		mArray.push_back(*pCurrentObj);
+		mArray.push_back(std::move(*pCurrentObj));
 		if (!mNewObjStack.empty() && &mNewObjStack.back() == pCurrentObj)
 		{
 			mNewObjStack.pop_back();
@@ -452,7 +514,7 @@ void WzConfig::endArray()
 	{
 		if (!pCurrentObj->empty())
 		{
-			mArray.push_back(*pCurrentObj);
+			mArray.push_back(std::move(*pCurrentObj));
 		}
 		if (!mNewObjStack.empty() && &mNewObjStack.back() == pCurrentObj)
 		{
@@ -463,7 +525,7 @@ void WzConfig::endArray()
 		if (!mArray.empty())
 		{
 			ASSERT(pCurrentObj != nullptr, "pCurrentObj is null");
-			(*pCurrentObj)[mName.toUtf8()] = mArray;
+			(*pCurrentObj)[mName.toUtf8()] = std::move(mArray);
 		}
 		mName = mObjNameStack.back();
 		mObjNameStack.pop_back();
@@ -488,11 +550,22 @@ void WzConfig::setValue(const WzString &key, const nlohmann::json &value)
 	(*pCurrentObj)[key.toUtf8()] = value;
 }
 
+void WzConfig::setValue(const WzString &key, nlohmann::json &&value)
+{
+	ASSERT(pCurrentObj != nullptr, "pCurrentObj is null");
+	(*pCurrentObj)[key.toUtf8()] = std::move(value);
+}
+
 void WzConfig::set(const WzString &key, const nlohmann::json &value)
 {
 	setValue(key, value);
 }
 
+void WzConfig::set(const WzString &key, nlohmann::json &&value)
+{
+	setValue(key, std::move(value));
+}
+
 // MARK: json_variant
 
 json_variant::json_variant(int i)
@@ -92,10 +92,15 @@ private:
 	nlohmann::json mObj;
 };
 
+class WzRecordWriter;
+
 class WzConfig
 {
 public:
 	enum warning { ReadAndWrite, ReadOnly, ReadOnlyAndRequired };
+	/// How a ReadAndWrite file is written. Files are read in any format, see wzconfigbinary.h. Records is a record
+	/// document if the document is a list of groups, and otherwise Binary.
+	enum format { Json, Binary, Records };
 
 private:
 	nlohmann::json mRoot = nlohmann::json::object();
@@ -108,11 +113,17 @@ private:
 	WzString mFilename;
 	bool mStatus;
 	warning mWarning;
+	format mFormat;
 
 public:
-	WzConfig(const WzString &name, WzConfig::warning warning);
+	WzConfig(const WzString &name, WzConfig::warning warning, WzConfig::format writeFormat = Json);
 	~WzConfig();
 
+	/// Rewrites an existing file in the given format.
+	static bool convertFile(const WzString &name, WzConfig::format toFormat);
+	/// Writes the document of records to a file. Use convertFile() for other formats.
+	static bool saveRecords(const WzString &name, WzRecordWriter &records);
+
 	Vector3f vector3f(const WzString &name);
 	void setVector3f(const WzString &name, const Vector3f &v);
 	Vector3i vector3i(const WzString &name);
@@ -148,7 +159,9 @@ public:
 	}
 
 	void setValue(const WzString &key, const nlohmann::json &value);
+	void setValue(const WzString &key, nlohmann::json &&value);  ///< Takes the value instead of copying it, such as the temporaries the save code passes.
 	void set(const WzString &key, const nlohmann::json &value);
+	void set(const WzString &key, nlohmann::json &&value);
 
 	WzString group()
 	{
@@ -0,0 +1,712 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file wzconfigbinary.cpp
+ *
+ * Binary encoding of WzConfig documents.
+ *
+ * File format, "varint" being an unsigned LEB128 integer and "zigzag" a signed integer mapped to a varint:
+ *   "WZbs", uint32 version (little-endian), varint string count, each string as varint length and UTF-8 bytes,
+ *   then the root value. Each value is a tag byte, followed by:
+ *     BJ_NULL, BJ_FALSE, BJ_TRUE: nothing.
+ *     BJ_INT: zigzag. BJ_UINT: varint. BJ_FLOAT: IEEE double, little-endian.
+ *     BJ_STRING: varint index into the string table.
+ *     BJ_ARRAY: varint count, then the values.
+ *     BJ_INT_ARRAY: varint count, then a zigzag for each element.
+ *     BJ_OBJECT: varint count, then for each member the string index of its key, and its value, ordered by key.
+ *
+ * Record documents have the same header and string table, with "WZrc" as magic, followed by:
+ *   varint field count, and for each field the varint string index + 1 of its subgroup or 0 if it has none, the varint
+ *   string index of its key or of the part of it before the '#', and the varint string index + 1 of the part after the
+ *   '#' or 0 if it has no '#'. Then the varint string index of the group name prefix, and the varint record count.
+ *   Each record is a varint string index + 1 of its group name, or 0 if the name is the prefix and the zero-padded
+ *   record number, then for each field set the varint field number + 1, a varint index if the field has a '#', and a
+ *   value as above, and then a varint 0.
+ */
+
+#include "wzconfigbinary.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#define BINARY_JSON_MAGIC       "WZbs"
+#define BINARY_JSON_VERSION     1
+#define BINARY_JSON_MAX_DEPTH   256  ///< Savegames nest a few levels deep, so anything deeper is corrupt.
+#define RECORD_DOCUMENT_MAGIC   "WZrc"
+#define RECORD_DOCUMENT_VERSION 1
+
+enum BINARY_JSON_TAG
+{
+	BJ_NULL, BJ_FALSE, BJ_TRUE, BJ_INT, BJ_UINT, BJ_FLOAT, BJ_STRING, BJ_ARRAY, BJ_INT_ARRAY, BJ_OBJECT
+};
+
+struct BINARY_JSON_READER
+{
+	const uint8_t *pos;
+	const uint8_t *end;
+	std::vector<std::string> strings;
+};
+
+static void writeVarint(std::string &out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+static uint64_t zigzagEncode(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzagDecode(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static uint32_t stringIndex(BINARY_JSON_WRITER &writer, std::string const &string)
+{
+	auto i = writer.stringIndex.emplace(string, (uint32_t)writer.strings.size());
+	if (i.second)
+	{
+		writer.strings.push_back(&i.first->first);
+	}
+	return i.first->second;
+}
+
+static void writeString(BINARY_JSON_WRITER &writer, std::string const &string)
+{
+	writeVarint(writer.body, stringIndex(writer, string));
+}
+
+static void writeInt(std::string &out, int64_t value)
+{
+	out.push_back(BJ_INT);
+	writeVarint(out, zigzagEncode(value));
+}
+
+static void writeIntArray(std::string &out, std::initializer_list<int> values)
+{
+	out.push_back(BJ_INT_ARRAY);
+	writeVarint(out, values.size());
+	for (int value : values)
+	{
+		writeVarint(out, zigzagEncode(value));
+	}
+}
+
+/// Whether value can be stored as a BJ_INT_ARRAY.
+static bool isIntArray(nlohmann::json const &value)
+{
+	if (value.empty())
+	{
+		return false;
+	}
+	for (auto const &element : value)
+	{
+		if (!element.is_number_integer() || (element.is_number_unsigned() && element.get<uint64_t>() > (uint64_t)std::numeric_limits<int64_t>::max()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static void writeValue(BINARY_JSON_WRITER &writer, nlohmann::json const &value)
+{
+	std::string &out = writer.body;
+	switch (value.type())
+	{
+	case nlohmann::json::value_t::boolean:
+		out.push_back(value.get<bool>() ? BJ_TRUE : BJ_FALSE);
+		break;
+	case nlohmann::json::value_t::number_integer:
+		writeInt(out, value.get<int64_t>());
+		break;
+	case nlohmann::json::value_t::number_unsigned:
+		out.push_back(BJ_UINT);
+		writeVarint(out, value.get<uint64_t>());
+		break;
+	case nlohmann::json::value_t::number_float:
+		{
+			double number = value.get<double>();
+			uint64_t bits;
+			memcpy(&bits, &number, sizeof(bits));
+			out.push_back(BJ_FLOAT);
+			for (int i = 0; i < 8; ++i)
+			{
+				out.push_back((char)(bits >> (i * 8)));
+			}
+			break;
+		}
+	case nlohmann::json::value_t::string:
+		out.push_back(BJ_STRING);
+		writeString(writer, value.get_ref<std::string const &>());
+		break;
+	case nlohmann::json::value_t::array:
+		if (isIntArray(value))
+		{
+			out.push_back(BJ_INT_ARRAY);
+			writeVarint(out, value.size());
+			for (auto const &element : value)
+			{
+				writeVarint(out, zigzagEncode(element.get<int64_t>()));
+			}
+			break;
+		}
+		out.push_back(BJ_ARRAY);
+		writeVarint(out, value.size());
+		for (auto const &element : value)
+		{
+			writeValue(writer, element);
+		}
+		break;
+	case nlohmann::json::value_t::object:
+		out.push_back(BJ_OBJECT);
+		writeVarint(out, value.size());
+		for (auto i = value.begin(); i != value.end(); ++i)
+		{
+			writeString(writer, i.key());
+			writeValue(writer, i.value());
+		}
+		break;
+	default:
+		out.push_back(BJ_NULL);
+		break;
+	}
+}
+
+/// Returns the start of a file: its magic, version and the strings of writer.
+static std::string fileHeader(const char *magic, uint32_t version, BINARY_JSON_WRITER const &writer)
+{
+	std::string out(magic);
+	for (int i = 0; i < 4; ++i)
+	{
+		out.push_back((char)(version >> (i * 8)));
+	}
+	writeVarint(out, writer.strings.size());
+	for (auto const *string : writer.strings)
+	{
+		writeVarint(out, string->size());
+		out += *string;
+	}
+	return out;
+}
+
+std::string encodeBinaryJson(nlohmann::json const &root)
+{
+	BINARY_JSON_WRITER writer;
+	writeValue(writer, root);
+
+	std::string out = fileHeader(BINARY_JSON_MAGIC, BINARY_JSON_VERSION, writer);
+	out += writer.body;
+	return out;
+}
+
+const unsigned WzRecordWriter::NO_INDEX;
+
+WzRecordWriter::WzRecordWriter(std::string const &namePrefix)
+	: namePrefix(stringIndex(writer, namePrefix))
+{
+}
+
+WzRecordWriter::WzRecordWriter(const char *namePrefix, const WzRecordField *fields, size_t numFields)
+	: WzRecordWriter(std::string(namePrefix))
+{
+	for (size_t i = 0; i < numFields; ++i)
+	{
+		std::string key = fields[i].key;
+		size_t hash = key.find('#');
+		if (hash == std::string::npos)
+		{
+			addField(fields[i].group ? fields[i].group : "", key, false, std::string());
+		}
+		else
+		{
+			addField(fields[i].group ? fields[i].group : "", key.substr(0, hash), true, key.substr(hash + 1));
+		}
+	}
+}
+
+uint32_t WzRecordWriter::addField(std::string const &group, std::string const &prefix, bool indexed, std::string const &suffix)
+{
+	FIELD field;
+	field.group = group.empty() ? 0 : stringIndex(writer, group) + 1;
+	field.prefix = stringIndex(writer, prefix);
+	field.suffix = indexed ? stringIndex(writer, suffix) + 1 : 0;
+	fields.push_back(field);
+	return (uint32_t)fields.size() - 1;
+}
+
+void WzRecordWriter::beginRecord()
+{
+	ASSERT(!inRecord, "beginRecord() without endRecord()");
+	writeVarint(writer.body, 0);
+	inRecord = true;
+	++numRecords;
+}
+
+void WzRecordWriter::beginRecord(std::string const &name)
+{
+	ASSERT(!inRecord, "beginRecord() without endRecord()");
+	writeVarint(writer.body, stringIndex(writer, name) + 1);
+	inRecord = true;
+	++numRecords;
+}
+
+void WzRecordWriter::endRecord()
+{
+	ASSERT_OR_RETURN(, inRecord, "endRecord() without beginRecord()");
+	writeVarint(writer.body, 0);
+	inRecord = false;
+}
+
+bool WzRecordWriter::writeField(unsigned field, unsigned index)
+{
+	bool indexed = index != NO_INDEX;
+	ASSERT_OR_RETURN(false, inRecord, "Field %u written outside a record", field);
+	ASSERT_OR_RETURN(false, field < fields.size(), "Bad field %u", field);
+	ASSERT_OR_RETURN(false, (fields[field].suffix != 0) == indexed, "Field %u written %s an index", field, indexed ? "with" : "without");
+	writeVarint(writer.body, field + 1);
+	if (indexed)
+	{
+		writeVarint(writer.body, index);
+	}
+	return true;
+}
+
+void WzRecordWriter::setInt(unsigned field, int64_t value)
+{
+	setInt(field, NO_INDEX, value);
+}
+
+void WzRecordWriter::setInt(unsigned field, unsigned index, int64_t value)
+{
+	if (writeField(field, index))
+	{
+		writeInt(writer.body, value);
+	}
+}
+
+void WzRecordWriter::setBool(unsigned field, bool value)
+{
+	if (writeField(field, NO_INDEX))
+	{
+		writer.body.push_back(value ? BJ_TRUE : BJ_FALSE);
+	}
+}
+
+void WzRecordWriter::setString(unsigned field, std::string const &value)
+{
+	setString(field, NO_INDEX, value);
+}
+
+void WzRecordWriter::setString(unsigned field, unsigned index, std::string const &value)
+{
+	if (writeField(field, index))
+	{
+		writer.body.push_back(BJ_STRING);
+		writeString(writer, value);
+	}
+}
+
+void WzRecordWriter::setVector2i(unsigned field, Vector2i const &v)
+{
+	setVector2i(field, NO_INDEX, v);
+}
+
+void WzRecordWriter::setVector2i(unsigned field, unsigned index, Vector2i const &v)
+{
+	if (writeField(field, index))
+	{
+		writeIntArray(writer.body, {v.x, v.y});
+	}
+}
+
+void WzRecordWriter::setVector3i(unsigned field, Vector3i const &v)
+{
+	setVector3i(field, NO_INDEX, v);
+}
+
+void WzRecordWriter::setVector3i(unsigned field, unsigned index, Vector3i const &v)
+{
+	if (writeField(field, index))
+	{
+		writeIntArray(writer.body, {v.x, v.y, v.z});
+	}
+}
+
+std::string WzRecordWriter::finish()
+{
+	ASSERT(!inRecord, "beginRecord() without endRecord()");
+	std::string out = fileHeader(RECORD_DOCUMENT_MAGIC, RECORD_DOCUMENT_VERSION, writer);
+	writeVarint(out, fields.size());
+	for (FIELD const &field : fields)
+	{
+		writeVarint(out, field.group);
+		writeVarint(out, field.prefix);
+		writeVarint(out, field.suffix);
+	}
+	writeVarint(out, namePrefix);
+	writeVarint(out, numRecords);
+	out += writer.body;
+	return out;
+}
+
+/// Returns the name of the group for record number, if it has none of its own.
+static std::string recordName(std::string const &namePrefix, uint64_t number)
+{
+	char padded[24];
+	snprintf(padded, sizeof(padded), "%010" PRIu64, number);
+	return namePrefix + padded;
+}
+
+/// Splits key at its first path segment which is a number, as in "orderList/2/type", into the parts before and after
+/// the number. Returns false if key has no such segment.
+static bool splitIndexedKey(std::string const &key, std::string &prefix, unsigned &index, std::string &suffix)
+{
+	size_t start = 0;
+	while (start <= key.size())
+	{
+		size_t end = std::min(key.find('/', start), key.size());
+		size_t length = end - start;
+		// Leading zeroes would be lost, and longer numbers might not fit.
+		bool isNumber = length > 0 && length <= 9 && (key[start] != '0' || length == 1);
+		for (size_t i = start; i < end && isNumber; ++i)
+		{
+			isNumber = key[i] >= '0' && key[i] <= '9';
+		}
+		if (isNumber)
+		{
+			prefix = key.substr(0, start);
+			index = (unsigned)std::stoul(key.substr(start, length));
+			suffix = key.substr(end);
+			return true;
+		}
+		start = end + 1;
+	}
+	return false;
+}
+
+bool encodeRecordDocument(nlohmann::json const &root, std::string &out)
+{
+	if (!root.is_object())
+	{
+		return false;
+	}
+	for (auto const &group : root)
+	{
+		if (!group.is_object())
+		{
+			return false;
+		}
+	}
+
+	std::string namePrefix;
+	if (!root.empty())
+	{
+		namePrefix = root.begin().key();
+		namePrefix.erase(namePrefix.find_last_not_of("0123456789") + 1);
+	}
+	WzRecordWriter records(namePrefix);
+	std::unordered_map<std::string, uint32_t> fieldIndex;
+	auto writeMember = [&](std::string const &group, std::string const &key, nlohmann::json const &value) {
+		std::string prefix, suffix;
+		unsigned index = 0;
+		bool indexed = splitIndexedKey(key, prefix, index, suffix);
+		if (!indexed)
+		{
+			prefix = key;
+		}
+		std::string fieldKey = group + '\0' + prefix + '\0' + (indexed ? '#' : '-') + suffix;
+		auto field = fieldIndex.find(fieldKey);
+		if (field == fieldIndex.end())
+		{
+			field = fieldIndex.emplace(fieldKey, records.addField(group, prefix, indexed, suffix)).first;
+		}
+		records.writeField(field->second, indexed ? index : WzRecordWriter::NO_INDEX);
+		writeValue(records.writer, value);
+	};
+
+	for (auto group = root.begin(); group != root.end(); ++group)
+	{
+		if (group.key() == recordName(namePrefix, records.numRecords))
+		{
+			records.beginRecord();
+		}
+		else
+		{
+			records.beginRecord(group.key());
+		}
+		for (auto member = group.value().begin(); member != group.value().end(); ++member)
+		{
+			// Subgroups are stored as fields of their own, unless they are empty, and would then be lost.
+			if (member.value().is_object() && !member.value().empty() && !member.key().empty())
+			{
+				for (auto subMember = member.value().begin(); subMember != member.value().end(); ++subMember)
+				{
+					writeMember(member.key(), subMember.key(), subMember.value());
+				}
+			}
+			else
+			{
+				writeMember(std::string(), member.key(), member.value());
+			}
+		}
+		records.endRecord();
+	}
+	out = records.finish();
+	return true;
+}
+
+static uint8_t readByte(BINARY_JSON_READER &reader)
+{
+	if (reader.pos == reader.end)
+	{
+		throw std::runtime_error("Unexpected end of binary document");
+	}
+	return *reader.pos++;
+}
+
+static uint64_t readVarint(BINARY_JSON_READER &reader)
+{
+	uint64_t value = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7)
+	{
+		uint8_t byte = readByte(reader);
+		value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return value;
+		}
+	}
+	throw std::runtime_error("Bad integer in binary document");
+}
+
+/// Reads the length of a string, array or object, each element of which takes at least one byte.
+static size_t readCount(BINARY_JSON_READER &reader)
+{
+	uint64_t count = readVarint(reader);
+	if (count > (uint64_t)(reader.end - reader.pos))
+	{
+		throw std::runtime_error("Bad length in binary document");
+	}
+	return (size_t)count;
+}
+
+static std::string const &readString(BINARY_JSON_READER &reader)
+{
+	uint64_t index = readVarint(reader);
+	if (index >= reader.strings.size())
+	{
+		throw std::runtime_error("Bad string index in binary document");
+	}
+	return reader.strings[index];
+}
+
+static nlohmann::json readValue(BINARY_JSON_READER &reader, int depth)
+{
+	if (depth > BINARY_JSON_MAX_DEPTH)
+	{
+		throw std::runtime_error("Binary document nested too deeply");
+	}
+	switch (readByte(reader))
+	{
+	case BJ_NULL:
+		return nlohmann::json();
+	case BJ_FALSE:
+		return false;
+	case BJ_TRUE:
+		return true;
+	case BJ_INT:
+		return zigzagDecode(readVarint(reader));
+	case BJ_UINT:
+		return readVarint(reader);
+	case BJ_FLOAT:
+		{
+			uint64_t bits = 0;
+			for (int i = 0; i < 8; ++i)
+			{
+				bits |= (uint64_t)readByte(reader) << (i * 8);
+			}
+			double number;
+			memcpy(&number, &bits, sizeof(number));
+			return number;
+		}
+	case BJ_STRING:
+		return readString(reader);
+	case BJ_ARRAY:
+		{
+			size_t count = readCount(reader);
+			nlohmann::json array = nlohmann::json::array();
+			array.get_ref<nlohmann::json::array_t &>().reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				array.push_back(readValue(reader, depth + 1));
+			}
+			return array;
+		}
+	case BJ_INT_ARRAY:
+		{
+			size_t count = readCount(reader);
+			nlohmann::json array = nlohmann::json::array();
+			array.get_ref<nlohmann::json::array_t &>().reserve(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				array.push_back(zigzagDecode(readVarint(reader)));
+			}
+			return array;
+		}
+	case BJ_OBJECT:
+		{
+			size_t count = readCount(reader);
+			nlohmann::json object = nlohmann::json::object();
+			nlohmann::json::object_t &members = object.get_ref<nlohmann::json::object_t &>();
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::string const &key = readString(reader);
+				// Members were written in order, so each one goes at the end.
+				members.emplace_hint(members.end(), key, readValue(reader, depth + 1));
+			}
+			return object;
+		}
+	default:
+		throw std::runtime_error("Bad value type in binary document");
+	}
+}
+
+/// Returns the string with the index + 1 read, or nullptr for 0.
+static std::string const *readOptionalString(BINARY_JSON_READER &reader)
+{
+	uint64_t index = readVarint(reader);
+	if (index > reader.strings.size())
+	{
+		throw std::runtime_error("Bad string index in binary document");
+	}
+	return index == 0 ? nullptr : &reader.strings[index - 1];
+}
+
+/// Reads the version and string table of a file starting with magic.
+static void readFileHeader(BINARY_JSON_READER &reader, const char *data, size_t size, const char *magic, uint32_t supportedVersion)
+{
+	if (size < 8 || memcmp(data, magic, 4) != 0)
+	{
+		throw std::runtime_error("Not a binary document");
+	}
+	reader.pos = (const uint8_t *)data + 4;
+	reader.end = (const uint8_t *)data + size;
+	uint32_t version = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		version |= (uint32_t)readByte(reader) << (i * 8);
+	}
+	if (version != supportedVersion)
+	{
+		throw std::runtime_error("Binary document has version " + std::to_string(version) + ", but only version " + std::to_string(supportedVersion) + " is supported");
+	}
+
+	size_t stringCount = readCount(reader);
+	reader.strings.reserve(stringCount);
+	for (size_t i = 0; i < stringCount; ++i)
+	{
+		size_t length = readCount(reader);
+		reader.strings.emplace_back((const char *)reader.pos, length);
+		reader.pos += length;
+	}
+}
+
+bool isBinaryJson(const char *data, size_t size)
+{
+	return size >= 4 && memcmp(data, BINARY_JSON_MAGIC, 4) == 0;
+}
+
+nlohmann::json decodeBinaryJson(const char *data, size_t size)
+{
+	BINARY_JSON_READER reader;
+	readFileHeader(reader, data, size, BINARY_JSON_MAGIC, BINARY_JSON_VERSION);
+
+	nlohmann::json root = readValue(reader, 0);
+	if (reader.pos != reader.end)
+	{
+		throw std::runtime_error("Trailing data after binary document");
+	}
+	return root;
+}
+
+bool isRecordDocument(const char *data, size_t size)
+{
+	return size >= 4 && memcmp(data, RECORD_DOCUMENT_MAGIC, 4) == 0;
+}
+
+nlohmann::json decodeRecordDocument(const char *data, size_t size)
+{
+	BINARY_JSON_READER reader;
+	readFileHeader(reader, data, size, RECORD_DOCUMENT_MAGIC, RECORD_DOCUMENT_VERSION);
+
+	struct FIELD
+	{
+		std::string const *group;
+		std::string const *prefix;
+		std::string const *suffix;
+	};
+	std::vector<FIELD> fields(readCount(reader));
+	for (FIELD &field : fields)
+	{
+		field.group = readOptionalString(reader);
+		field.prefix = &readString(reader);
+		field.suffix = readOptionalString(reader);
+	}
+	std::string const &namePrefix = readString(reader);
+	size_t recordCount = readCount(reader);
+
+	nlohmann::json root = nlohmann::json::object();
+	for (size_t record = 0; record < recordCount; ++record)
+	{
+		std::string const *name = readOptionalString(reader);
+		nlohmann::json &group = root[name ? *name : recordName(namePrefix, record)];
+		group = nlohmann::json::object();
+		while (uint64_t number = readVarint(reader))
+		{
+			if (number > fields.size())
+			{
+				throw std::runtime_error("Bad field in record document");
+			}
+			FIELD const &field = fields[number - 1];
+			std::string key = *field.prefix;
+			if (field.suffix)
+			{
+				key += std::to_string(readVarint(reader));
+				key += *field.suffix;
+			}
+			nlohmann::json &parent = field.group ? group[*field.group] : group;
+			parent[key] = readValue(reader, 2);
+		}
+	}
+	if (reader.pos != reader.end)
+	{
+		throw std::runtime_error("Trailing data after record document");
+	}
+	return root;
+}
@@ -0,0 +1,121 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file wzconfigbinary.h
+ *  Binary encoding of WzConfig documents, for savegames which are written often and are rarely read by people.
+ *
+ *  Every object key and string value is stored once, in a string table at the start, and referred to by index,
+ *  so the names of groups, properties and stats, which repeat for every object, cost a few bytes each. Arrays of
+ *  integers, such as positions and rotations, are stored as flat arrays without a type for each element. Decoding
+ *  gives the same document as parsing the JSON text would, apart from the formatting.
+ *
+ *  Documents which are lists of groups of values, such as the droids, structures and features of a savegame, can
+ *  instead be stored as record documents, which the game writes straight from its object lists with a WzRecordWriter.
+ */
+
+#ifndef WZCONFIGBINARY_H
+#define WZCONFIGBINARY_H
+
+#include "wzconfig.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct BINARY_JSON_WRITER
+{
+	std::string body;
+	std::unordered_map<std::string, uint32_t> stringIndex;
+	std::vector<std::string const *> strings;  ///< Keys of stringIndex, by index.
+};
+
+/// A field of the records of a record document, which stands for the member key of the record's group, or of its
+/// subgroup group if that is set. A '#' in key stands for the index the field is written with, so "ammo/#" written
+/// with index 1 is the member "ammo/1".
+struct WzRecordField
+{
+	const char *group;
+	const char *key;
+};
+
+/// Writes a record document, one record for each group, with the fields given to the constructor. Each record holds
+/// the number, the index if it has a '#', and the value of each field set, so keys are not repeated for each group,
+/// and strings such as stat ids are stored once, in the string table. Reading the document gives a group named
+/// namePrefix and the record's zero-padded number for each record, holding its fields.
+class WzRecordWriter
+{
+public:
+	/// Index for the fields without a '#', so that code writing both kinds of field can pass one.
+	static const unsigned NO_INDEX = ~0u;
+
+	WzRecordWriter(const char *namePrefix, const WzRecordField *fields, size_t numFields);
+
+	void beginRecord();
+	void endRecord();
+
+	void setInt(unsigned field, int64_t value);
+	void setInt(unsigned field, unsigned index, int64_t value);
+	void setBool(unsigned field, bool value);
+	void setString(unsigned field, std::string const &value);
+	void setString(unsigned field, unsigned index, std::string const &value);
+	void setVector2i(unsigned field, Vector2i const &v);
+	void setVector2i(unsigned field, unsigned index, Vector2i const &v);
+	void setVector3i(unsigned field, Vector3i const &v);
+	void setVector3i(unsigned field, unsigned index, Vector3i const &v);
+
+	/// Returns the document. The writer must not be used afterwards.
+	std::string finish();
+
+private:
+	struct FIELD
+	{
+		uint32_t group;   ///< String index of the subgroup + 1, or 0 if none.
+		uint32_t prefix;  ///< String index of the key, or of the part before the '#'.
+		uint32_t suffix;  ///< String index of the part after the '#' + 1, or 0 if the key has no '#'.
+	};
+
+	explicit WzRecordWriter(std::string const &namePrefix);
+	uint32_t addField(std::string const &group, std::string const &prefix, bool indexed, std::string const &suffix);
+	void beginRecord(std::string const &name);
+	bool writeField(unsigned field, unsigned index);
+	friend bool encodeRecordDocument(nlohmann::json const &root, std::string &out);
+
+	BINARY_JSON_WRITER writer;
+	std::vector<FIELD> fields;
+	uint32_t namePrefix;
+	uint32_t numRecords = 0;
+	bool inRecord = false;
+};
+
+/// Returns true if data is a binary document, as opposed to JSON text.
+bool isBinaryJson(const char *data, size_t size);
+/// Returns the binary encoding of a document.
+std::string encodeBinaryJson(const nlohmann::json &root);
+/// Decodes a binary document. Throws std::runtime_error if data is corrupt or has an unsupported version.
+nlohmann::json decodeBinaryJson(const char *data, size_t size);
+
+/// Returns true if data is a record document.
+bool isRecordDocument(const char *data, size_t size);
+/// Returns in out the record document holding root, if root is a list of groups. Returns false, and leaves out
+/// untouched, if root has other members.
+bool encodeRecordDocument(nlohmann::json const &root, std::string &out);
+/// Decodes a record document into its groups. Throws std::runtime_error if data is corrupt or has an unsupported
+/// version.
+nlohmann::json decodeRecordDocument(const char *data, size_t size);
+
+#endif // WZCONFIGBINARY_H
@@ -46,6 +46,9 @@ static Rational modifier;
 /// The real time, the last time graphicsTime updated.
 static uint32_t prevRealTime;
 
+/// If set, tick as often as we are allowed to, instead of following the real time.
+static bool fixedStep = false;
+
 /**
   * Count how many times gameTimeStop has been called without a game time start.
   * We use this to ensure that we can properly nest stop commands.
@@ -171,6 +174,10 @@ void gameTimeUpdate(bool mayUpdate)
 
 	// Calculate the new game time
 	int newDeltaGraphicsTime = quantiseFraction(modifier.n, modifier.d, currTime, prevRealTime);
+	if (fixedStep)
+	{
+		newDeltaGraphicsTime = gameTime + GAME_TICKS_PER_UPDATE - graphicsTime;
+	}
 	ASSERT(newDeltaGraphicsTime >= 0, "Something very wrong.");
 
 	uint32_t newGraphicsTime = graphicsTime + newDeltaGraphicsTime;
@@ -276,6 +283,11 @@ Rational gameTimeGetMod()
 	return modifier;
 }
 
+void gameTimeSetFixedStep(bool enable)
+{
+	fixedStep = enable;
+}
+
 bool gameTimeIsStopped(void)
 {
 	return stopCount != 0;
@@ -99,6 +99,10 @@ void gameTimeSetMod(Rational mod);
 /** Get the current time modifier. */
 Rational gameTimeGetMod();
 
+/** If enabled, every gameTimeUpdate(true) advances the game by one tick, however little real time has passed.
+ *  Used to run the game as fast as possible when nothing is rendered. */
+void gameTimeSetFixedStep(bool enable);
+
 /**
  * Returns the game time, modulo the time period, scaled to 0..requiredRange.
  * For instance getModularScaledGameTime(4096,256) will return a number that cycles through the values
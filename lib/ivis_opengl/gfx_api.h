@@ -77,6 +77,12 @@ namespace gfx_api
 		buffer() {};
 	};
 
+	enum class backend_type
+	{
+		opengl_backend,
+		null_backend, // Accepts and discards everything, for running without a GL context (--headless)
+	};
+
 	struct context
 	{
 		enum class buffer_storage_hint
@@ -90,5 +96,7 @@ namespace gfx_api
 		virtual texture* create_texture(const size_t& width, const size_t& height, const pixel_format& internal_format, const std::string& filename = "") = 0;
 		virtual buffer* create_buffer_object(const buffer::usage&, const buffer_storage_hint& = buffer_storage_hint::static_draw) = 0;
 		static context& get();
+		// Must be called before the first get(), the default is the OpenGL backend.
+		static void select_backend(const backend_type& backend);
 	};
 }
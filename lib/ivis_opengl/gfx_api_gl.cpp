@@ -19,6 +19,7 @@
 
 #include "lib/framework/frame.h"
 #include "gfx_api_gl.h"
+#include "gfx_api_null.h"
 
 static GLenum to_gl(const gfx_api::pixel_format& format)
 {
@@ -174,8 +175,20 @@ gfx_api::buffer * gl_context::create_buffer_object(const gfx_api::buffer::usage
 	return new gl_buffer(usage, hint);
 }
 
+static gfx_api::backend_type selectedBackend = gfx_api::backend_type::opengl_backend;
+
+void gfx_api::context::select_backend(const gfx_api::backend_type& backend)
+{
+	selectedBackend = backend;
+}
+
 gfx_api::context& gfx_api::context::get()
 {
+	if (selectedBackend == gfx_api::backend_type::null_backend)
+	{
+		static null_context nullCtx;
+		return nullCtx;
+	}
 	static gl_context ctx;
 	return ctx;
 }
@@ -0,0 +1,62 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "lib/framework/frame.h"
+#include "gfx_api_null.h"
+
+// MARK: null_texture
+
+void null_texture::bind()
+{
+}
+
+void null_texture::upload(const size_t&, const size_t&, const size_t&, const size_t&, const size_t&, const gfx_api::pixel_format&, const void*, bool)
+{
+}
+
+unsigned null_texture::id()
+{
+	return 0;
+}
+
+// MARK: null_buffer
+
+void null_buffer::bind()
+{
+}
+
+void null_buffer::upload(const size_t&, const void*)
+{
+}
+
+void null_buffer::update(const size_t&, const size_t&, const void*)
+{
+}
+
+// MARK: null_context
+
+gfx_api::texture* null_context::create_texture(const size_t&, const size_t&, const gfx_api::pixel_format&, const std::string&)
+{
+	return new null_texture();
+}
+
+gfx_api::buffer* null_context::create_buffer_object(const gfx_api::buffer::usage&, const buffer_storage_hint&)
+{
+	return new null_buffer();
+}
@@ -33,6 +33,7 @@
 #include "lib/framework/fixedpoint.h"
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
+#include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/piematrix.h"
 #include "lib/ivis_opengl/pienormalize.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -752,7 +753,10 @@ static iIMDShape *_imd_load_level(const WzString &filename, const char **ppFileD
 		s.buffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
 	s.buffers[VBO_TEXCOORD]->upload(texcoords.size() * sizeof(gfx_api::gfxFloat), texcoords.data());
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+	if (!wzIsHeadless())
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind
+	}
 
 	indices.resize(0);
 	vertices.resize(0);
@@ -27,6 +27,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
 #include "lib/framework/fixedpoint.h"
+#include "lib/framework/wzapp.h"
 #include "lib/gamelib/gtime.h"
 #include <time.h>
 
@@ -100,10 +101,13 @@ void GFX::makeTexture(int width, int height, GLenum filter, const gfx_api::pixel
 	mTexture = gfx_api::context::get().create_texture(width, height, format);
 	if (image != nullptr)
 		mTexture->upload(0u, 0u, 0u, width, height, format, image);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if (!wzIsHeadless())
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
 	mWidth = width;
 	mHeight = height;
 	mFormat = format;
@@ -143,7 +147,10 @@ void GFX::buffers(int vertices, const GLvoid *vertBuf, const GLvoid *auxBuf)
 			mBuffers[VBO_TEXCOORD] = gfx_api::context::get().create_buffer_object(gfx_api::buffer::usage::vertex_buffer);
 		mBuffers[VBO_TEXCOORD]->upload(vertices * 4 * sizeof(GLbyte), auxBuf);
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!wzIsHeadless())
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
 	mSize = vertices;
 }
 
@@ -677,6 +684,10 @@ void pie_RenderRadar(const glm::mat4 &modelViewProjectionMatrix)
 /// Load and display a random backdrop picture.
 void pie_LoadBackDrop(SCREENTYPE screenType)
 {
+	if (wzIsHeadless())
+	{
+		return;  // screenInitialise() was never called, so there is nothing to load it into.
+	}
 	switch (screenType)
 	{
 	case SCREEN_RANDOMBDROP:
@@ -23,6 +23,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/wzapp.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/ivis_opengl/piedef.h"
@@ -194,6 +195,10 @@ void pie_Skybox_Init()
 
 void pie_Skybox_Texture(const char *filename)
 {
+	if (wzIsHeadless())
+	{
+		return;  // No skybox was created by screenInitialise().
+	}
 	skyboxGfx->loadTexture(filename);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 }
@@ -76,7 +76,10 @@ bool pie_Initialise()
 
 	pie_UpdateSurfaceGeometry();
 
-	pie_SetDefaultStates();
+	if (!wzIsHeadless())
+	{
+		pie_SetDefaultStates();
+	}
 	debug(LOG_3D, "xcentre %d; ycentre %d", rendSurface.xcentre, rendSurface.ycentre);
 
 	return true;
@@ -94,6 +97,11 @@ void pie_ScreenFlip(int clearMode)
 {
 	GLbitfield clearFlags = 0;
 
+	if (wzIsHeadless())
+	{
+		return;  // Nothing was drawn.
+	}
+
 	screenDoDumpToDiskIfRequired();
 	wzScreenFlip();
 	wzPerfFrame();
@@ -22,6 +22,7 @@
  */
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/wzapp.h"
 
 #include <physfs.h>
 #include "lib/framework/physfs_ext.h"
@@ -887,6 +888,10 @@ pie_internal::SHADER_PROGRAM &pie_ActivateShaderDeprecated(SHADER_MODE shaderMod
 
 void pie_SetDepthBufferStatus(DEPTH_MODE depthMode)
 {
+	if (wzIsHeadless())
+	{
+		return;
+	}
 	switch (depthMode)
 	{
 	case DEPTH_CMP_LEQ_WRT_ON:
@@ -504,7 +504,10 @@ void screenShutDown()
 
 	delete backdropGfx;
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	if (!wzIsHeadless())
+	{
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	}
 }
 
 /// Display a random backdrop from files in dirname starting with basename.
@@ -644,6 +647,10 @@ void screen_GenerateCoordinatesAndVBOs()
 
 void screen_Upload(const char *newBackDropBmp)
 {
+	if (wzIsHeadless())
+	{
+		return;
+	}
 	backdropIsMapPreview = false;
 
 	if (newBackDropBmp) // preview
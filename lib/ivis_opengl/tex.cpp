@@ -19,6 +19,7 @@
 */
 
 #include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
 
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -117,7 +118,10 @@ int pie_AddTexPage(iV_Image *s, const char *filename, bool gameTexture, int page
 			delete _TEX_PAGE[page].id;
 		_TEX_PAGE[page].id = gfx_api::context::get().create_texture(s->width, s->height, format, filename);
 		pie_Texture(page).upload(0u, 0u, 0u, s->width, s->height, iV_getPixelFormat(s), s->bmp, true);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		if (!wzIsHeadless())
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		}
 	}
 	else	// this is an interface texture, do not use compression
 	{
@@ -125,13 +129,21 @@ int pie_AddTexPage(iV_Image *s, const char *filename, bool gameTexture, int page
 			delete _TEX_PAGE[page].id;
 		_TEX_PAGE[page].id = gfx_api::context::get().create_texture(s->width, s->height, gfx_api::pixel_format::rgba, filename);
 		pie_Texture(page).upload(0u, 0u, 0u, s->width, s->height, iV_getPixelFormat(s), s->bmp);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		if (!wzIsHeadless())
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		}
 	}
-	pie_SetTexturePage(page);
 	// it is uploaded, we do not need it anymore
 	free(s->bmp);
 	s->bmp = nullptr;
 
+	if (wzIsHeadless())
+	{
+		return page;  // The null backend has no sampler state to set.
+	}
+	pie_SetTexturePage(page);
+
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	// Use anisotropic filtering, if available, but only max 4.0 to reduce processor burden
@@ -44,6 +44,7 @@
 
 #include "netplay.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "netsocket.h"
 
 #include <miniupnpc/miniwget.h>
@@ -70,6 +71,7 @@
 // WARNING !!! This is initialised via configuration.c !!!
 char masterserver_name[255] = {'\0'};
 static unsigned int masterserver_port = 0, gameserver_port = 0;
+static int compressionLevel = 6;
 
 #define WZ_SERVER_DISCONNECT 0
 #define WZ_SERVER_CONNECT    1
@@ -121,6 +123,8 @@ struct NETSTATS  // data regarding the last one second or so.
 	Statistic       rawBytes;               // Number of actual bytes, in about 1 sec.
 	Statistic       uncompressedBytes;      // Number of bytes sent, before compression, in about 1 sec.
 	Statistic       packets;                // Number of calls to writeAll, in about 1 sec.
+	Statistic       codecMicroseconds;      // Time spent compressing (sent) and decompressing (received), in about 1 sec.
+	Statistic       codecCalls;             // Number of compressed flushes (sent) and decompressing reads (received), in about 1 sec.
 };
 
 struct NET_PLAYER_DATA
@@ -171,10 +175,10 @@ static SocketSet *tmp_socket_set = nullptr;
 static int32_t          NetGameFlags[4] = { 0, 0, 0, 0 };
 char iptoconnect[PATH_MAX] = "\0"; // holds IP/hostname from command line
 
-static NETSTATS nStats              = {{0, 0}, {0, 0}, {0, 0}};
-static NETSTATS nStatsLastSec       = {{0, 0}, {0, 0}, {0, 0}};
-static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}};
-static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStats              = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStatsLastSec       = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static NETSTATS nStatsSecondLastSec = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+static const NETSTATS nZeroStats    = {{0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
 static int nStatsLastUpdateTime = 0;
 
 unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
@@ -187,7 +191,7 @@ unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
 **/
 static char const *versionString = version_getVersionString();
 static int NETCODE_VERSION_MAJOR = 0x1000;
-static int NETCODE_VERSION_MINOR = 1;
+static int NETCODE_VERSION_MINOR = 2;
 
 bool NETisCorrectVersion(uint32_t game_version_major, uint32_t game_version_minor)
 {
@@ -1264,9 +1268,14 @@ unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal)
 	case NetStatisticRawBytes:          statsType = &NETSTATS::rawBytes;          break;
 	case NetStatisticUncompressedBytes: statsType = &NETSTATS::uncompressedBytes; break;
 	case NetStatisticPackets:           statsType = &NETSTATS::packets;           break;
+	case NetStatisticCodecMicroseconds: statsType = &NETSTATS::codecMicroseconds; break;
+	case NetStatisticCodecCalls:        statsType = &NETSTATS::codecCalls;        break;
 	default: ASSERT(false, " "); return 0;
 	}
 
+	// The sockets count these themselves, since compression happens when flushing rather than when sending.
+	socketGetCodecStatistics(nStats.codecMicroseconds.sent, nStats.codecMicroseconds.received, nStats.codecCalls.sent, nStats.codecCalls.received);
+
 	int time = wzGetTicks();
 	if ((unsigned)(time - nStatsLastUpdateTime) >= (unsigned)GAME_TICKS_PER_SEC)
 	{
@@ -1315,6 +1324,10 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		ASSERT_OR_RETURN(false, false, "Wrong queue type.");
 	}
 
+	// The data is written straight from the message, after the header.
+	uint8_t header[NetMessage::rawHeaderMaxLen];
+	unsigned headerLen = message->rawHeader(header);
+
 	if (NetPlay.isHost)
 	{
 		int firstPlayer = player == NET_ALL_PLAYERS ? 0                         : player;
@@ -1324,11 +1337,9 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 			// We are the host, send directly to player.
 			if (sockets[player] != nullptr && player != queue.exclude)
 			{
-				uint8_t *rawData = message->rawDataDup();
 				ssize_t rawLen   = message->rawLen();
 				size_t compressedRawLen;
-				result = writeAll(sockets[player], rawData, rawLen, &compressedRawLen);
-				delete[] rawData;  // Done with the data.
+				result = writeAllWithHeader(sockets[player], header, headerLen, message->data.data(), message->data.size(), &compressedRawLen);
 
 				if (result == rawLen)
 				{
@@ -1355,11 +1366,9 @@ bool NETsend(NETQUEUE queue, NetMessage const *message)
 		// We are a client, send directly to player, who happens to be the host.
 		if (bsocket)
 		{
-			uint8_t *rawData = message->rawDataDup();
 			ssize_t rawLen   = message->rawLen();
 			size_t compressedRawLen;
-			result = writeAll(bsocket, rawData, rawLen, &compressedRawLen);
-			delete[] rawData;  // Done with the data.
+			result = writeAllWithHeader(bsocket, header, headerLen, message->data.data(), message->data.size(), &compressedRawLen);
 
 			if (result == rawLen)
 			{
@@ -1910,6 +1919,8 @@ checkMessages:
 
 bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 {
+	NETreplayLoadNetMessages(gameTime);
+
 	for (unsigned current = 0; current < MAX_PLAYERS; ++current)
 	{
 		*queue = NETgameQueue(current);
@@ -1921,6 +1932,7 @@ bool NETrecvGame(NETQUEUE *queue, uint8_t *type)
 			}
 
 			*type = NETgetMessage(*queue)->type;
+			NETreplaySaveNetMessage(NETgetMessage(*queue), current, gameTime);
 
 			if (*type == GAME_GAME_TIME)
 			{
@@ -2285,17 +2297,61 @@ void NETfixPlayerCount()
 	}
 
 }
+/// Returns true if the received part of a client's hello is all there is to read: the "list" of a 2.3.7 client, or a
+/// version we don't accept, which older clients send without the codec.
+static bool isShortClientHello(const char *buffer, size_t received)
+{
+	if (received == sizeof("list") && strcmp(buffer, "list") == 0)
+	{
+		return true;
+	}
+	if (received < sizeof(int32_t) * 2)
+	{
+		return false;
+	}
+	int32_t major, minor;
+	memcpy(&major, buffer, sizeof(int32_t));
+	memcpy(&minor, buffer + sizeof(int32_t), sizeof(int32_t));
+	return !NETisCorrectVersion(ntohl(major), ntohl(minor));
+}
+
+/// Reads the hello of a new client into buffer, waiting up to NET_TIMEOUT_DELAY for all of it, since TCP may deliver it
+/// in pieces. Returns the number of bytes read, which is less than size if the client went quiet or disconnected.
+static size_t readClientHello(Socket *sock, char *buffer, size_t size)
+{
+	SocketSet *set = allocSocketSet();
+	SocketSet_AddSocket(set, sock);
+	size_t received = 0;
+	const unsigned deadline = wzGetTicks() + NET_TIMEOUT_DELAY;
+	while (received < size && !isShortClientHello(buffer, received))
+	{
+		int remaining = (int)(deadline - wzGetTicks());
+		if (remaining <= 0 || checkSockets(set, remaining) <= 0 || !socketReadReady(sock))
+		{
+			break;
+		}
+		ssize_t result = readNoInt(sock, buffer + received, size - received);
+		if (result == SOCKET_ERROR || result == 0)
+		{
+			break;
+		}
+		received += result;
+	}
+	deleteSocketSet(set);
+	return received;
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // Host a game with a given name and player name. & 4 user game flags
 static void NETallowJoining()
 {
 	unsigned int i;
-	char buffer[10] = {'\0'};
+	char buffer[sizeof(int32_t) * 3] = {'\0'};
 	char *p_buffer;
 	int32_t result;
 	bool connectFailed = true;
-	int32_t major, minor;
-	ssize_t recv_result = 0;
+	int32_t major, minor, codec;
+	size_t recv_result = 0;
 
 	if (allow_joining == false)
 	{
@@ -2350,10 +2406,8 @@ static void NETallowJoining()
 		p_buffer = buffer;
 		// We check for socket activity (connection), and then we check if we got data, since it is possible to have a connection
 		// and have no data waiting.
-		if (checkSockets(tmp_socket_set, NET_TIMEOUT_DELAY) > 0
-		    && socketReadReady(tmp_socket[i])
-		    && (recv_result = readNoInt(tmp_socket[i], p_buffer, 8))
-		    && recv_result != SOCKET_ERROR)
+		recv_result = readClientHello(tmp_socket[i], buffer, sizeof(buffer));
+		if (recv_result == sizeof(buffer) || isShortClientHello(buffer, recv_result))
 		{
 			std::string rIP = "Incoming connection from:";
 			rIP.append(getSocketTextAddress(tmp_socket[i]));
@@ -2369,7 +2423,7 @@ static void NETallowJoining()
 			}
 			else
 			{
-				// New clients send NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR
+				// New clients send NETCODE_VERSION_MAJOR and NETCODE_VERSION_MINOR, followed by the SocketCodec they would like.
 				// Check these numbers with our own.
 
 				memcpy(&major, p_buffer, sizeof(int32_t));
@@ -2377,13 +2431,20 @@ static void NETallowJoining()
 				p_buffer += sizeof(int32_t);
 				memcpy(&minor, p_buffer, sizeof(int32_t));
 				minor = ntohl(minor);
+				p_buffer += sizeof(int32_t);
+				memcpy(&codec, p_buffer, sizeof(int32_t));
+				codec = ntohl(codec);
 
 				if (NETisCorrectVersion(major, minor))
 				{
+					// Only compress if both sides want to, so either can turn it off on a fast network.
+					SocketCodec usedCodec = compressionLevel != 0 && codec != SOCKET_CODEC_NONE ? SOCKET_CODEC_ZLIB : SOCKET_CODEC_NONE;
 					result = htonl(ERROR_NOERROR);
 					memcpy(&buffer, &result, sizeof(result));
-					writeAll(tmp_socket[i], &buffer, sizeof(result));
-					socketBeginCompression(tmp_socket[i]);
+					codec = htonl(usedCodec);
+					memcpy(&buffer[sizeof(result)], &codec, sizeof(codec));
+					writeAll(tmp_socket[i], &buffer, sizeof(result) + sizeof(codec));
+					socketBeginCompression(tmp_socket[i], usedCodec, compressionLevel);
 
 					// Connection is successful.
 					connectFailed = false;
@@ -2413,7 +2474,8 @@ static void NETallowJoining()
 		}
 		else
 		{
-			debug(LOG_NET, "Failed to process joining, socket not ready or no data, recv_result is :%d", (int)recv_result);
+			// Not banned, since an honest client on a bad connection may not get its hello through in time.
+			debug(LOG_NET, "Failed to process joining, got %d of %d bytes of the hello", (int)recv_result, (int)sizeof(buffer));
 			connectFailed = true;
 		}
 
@@ -2899,9 +2961,9 @@ bool NETjoinGame(const char *host, uint32_t port, const char *playername)
 {
 	SocketAddress *hosts = nullptr;
 	unsigned int i;
-	char buffer[sizeof(int32_t) * 2] = { 0 };
+	char buffer[sizeof(int32_t) * 3] = { 0 };
 	char *p_buffer;
-	uint32_t result;
+	uint32_t result, codec;
 
 	if (port == 0)
 	{
@@ -2957,6 +3019,7 @@ bool NETjoinGame(const char *host, uint32_t port, const char *playername)
 	};
 	pushi32(NETCODE_VERSION_MAJOR);
 	pushi32(NETCODE_VERSION_MINOR);
+	pushi32(compressionLevel != 0 ? SOCKET_CODEC_ZLIB : SOCKET_CODEC_NONE);
 
 	if (writeAll(tcp_socket, buffer, sizeof(buffer)) == SOCKET_ERROR
 	    || readAll(tcp_socket, &result, sizeof(result), 1500) != sizeof(result))
@@ -2980,12 +3043,24 @@ bool NETjoinGame(const char *host, uint32_t port, const char *playername)
 		return false;
 	}
 
+	// The host tells us which codec to use, having taken our preference into account.
+	if (readAll(tcp_socket, &codec, sizeof(codec), 1500) != sizeof(codec) || (codec = ntohl(codec)) >= SOCKET_CODEC_COUNT)
+	{
+		debug(LOG_ERROR, "Couldn't agree on a codec with the host.");
+		SocketSet_DelSocket(socket_set, tcp_socket);
+		socketClose(tcp_socket);
+		tcp_socket = nullptr;
+		deleteSocketSet(socket_set);
+		socket_set = nullptr;
+		return false;
+	}
+
 	// Allocate memory for a new socket
 	NETinitQueue(NETnetQueue(NET_HOST_ONLY));
 	// NOTE: tcp_socket = bsocket now!
 	bsocket = tcp_socket;
 	tcp_socket = nullptr;
-	socketBeginCompression(bsocket);
+	socketBeginCompression(bsocket, (SocketCodec)codec, compressionLevel);
 
 	// Send a join message to the host
 	NETbeginEncode(NETnetQueue(NET_HOST_ONLY), NET_JOIN);
@@ -3126,6 +3201,23 @@ unsigned int NETgetGameserverPort()
 	return gameserver_port;
 }
 
+/*!
+ * Set how much to compress game connections
+ * \param level zlib level from 1 to 9, or 0 for no compression
+ */
+void NETsetCompressionLevel(int level)
+{
+	compressionLevel = std::max(0, std::min(level, 9));
+}
+
+/**
+ * @return How much we compress game connections, 0 if not at all.
+ */
+int NETgetCompressionLevel()
+{
+	return compressionLevel;
+}
+
 
 void NETsetPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player)
 {
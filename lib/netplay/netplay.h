@@ -290,7 +290,7 @@ void NETaddRedirects();
 void NETremRedirects();
 void NETdiscoverUPnPDevices();
 
-enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets};
+enum NetStatisticType {NetStatisticRawBytes, NetStatisticUncompressedBytes, NetStatisticPackets, NetStatisticCodecMicroseconds, NetStatisticCodecCalls};
 unsigned NETgetStatistic(NetStatisticType type, bool sent, bool isTotal = false);     // Return some statistic. Call regularly for good results.
 
 void NETplayerKicked(UDWORD index);			// Cleanup after player has been kicked
@@ -315,6 +315,8 @@ void NETsetMasterserverPort(unsigned int port);
 unsigned int NETgetMasterserverPort();
 void NETsetGameserverPort(unsigned int port);
 unsigned int NETgetGameserverPort();
+void NETsetCompressionLevel(int level);  ///< zlib level from 1 (fastest) to 9 (smallest) to compress game connections with, or 0 to not compress them at all.
+int NETgetCompressionLevel();
 
 bool NETsetupTCPIP(const char *machine);
 void NETsetGamePassword(const char *password);
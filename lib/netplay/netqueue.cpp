@@ -26,6 +26,9 @@
 
 // See comments in netqueue.h.
 
+static const size_t NETQUEUE_INITIAL_SIZE = 16;             ///< Number of messages a new queue has room for. Must be a power of 2.
+static const size_t NETQUEUE_MAX_KEPT_CAPACITY = 64 * 1024;  ///< Memory used by popped messages larger than this is freed.
+
 
 // Byte n is the final byte, iff it is less than 256-a[n].
 
@@ -100,22 +103,18 @@ bool decode_uint32_t(uint8_t b, uint32_t &v, unsigned n)
 	return !isLastByte;
 }
 
-uint8_t *NetMessage::rawDataDup() const
+unsigned NetMessage::rawHeader(uint8_t *header) const
 {
 	unsigned encodedLengthOfSize = encodedlength_uint32_t(data.size());
 
-	uint8_t *ret = new uint8_t[1 + encodedLengthOfSize + data.size()];
-
-	ret[0] = type;
+	header[0] = type;
 
 	uint32_t len = data.size();
 	for (unsigned n = 0; n < encodedLengthOfSize; ++n)
 	{
-		encode_uint32_t(ret[n + 1], len, n);
+		encode_uint32_t(header[n + 1], len, n);
 	}
-
-	std::copy(data.begin(), data.end(), ret + 1 + encodedLengthOfSize);
-	return ret;
+	return 1 + encodedLengthOfSize;
 }
 
 size_t NetMessage::rawLen() const
@@ -126,9 +125,26 @@ size_t NetMessage::rawLen() const
 NetQueue::NetQueue()
 	: canGetMessagesForNet(true)
 	, canGetMessages(true)
+	, ring(NETQUEUE_INITIAL_SIZE)
+	, oldestPos(0)
+	, dataPos(0)
+	, messagePos(0)
+	, nextPos(0)
+{}
+
+NetMessage &NetQueue::pushSlot()
 {
-	dataPos = messages.end();
-	messagePos = messages.end();
+	if (nextPos - oldestPos == ring.size())
+	{
+		// Full, so double the size, keeping each message at its number modulo the new size.
+		std::vector<NetMessage> newRing(ring.size() * 2);
+		for (size_t seq = oldestPos; seq != nextPos; ++seq)
+		{
+			std::swap(newRing[seq & (newRing.size() - 1)], slot(seq));
+		}
+		ring.swap(newRing);
+	}
+	return slot(nextPos++);
 }
 
 void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
@@ -159,8 +175,9 @@ void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
 			break;  // Don't have a whole message ready yet.
 		}
 
-		messages.push_front(NetMessage(type));
-		messages.front().data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
+		NetMessage &message = pushSlot();
+		message.type = type;
+		message.data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
 		used += headerLen + len;
 	}
 
@@ -175,36 +192,24 @@ void NetQueue::setWillNeverGetMessagesForNet()
 
 unsigned NetQueue::numMessagesForNet() const
 {
-	unsigned count = 0;
-	if (canGetMessagesForNet)
-	{
-		for (List::iterator i = dataPos; i != messages.begin(); --i)
-		{
-			++count;
-		}
-	}
-
-	return count;
+	return canGetMessagesForNet ? nextPos - dataPos : 0;
 }
 
 const NetMessage &NetQueue::getMessageForNet() const
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for getMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to get!");
+	ASSERT(dataPos != nextPos, "No message to get!");
 
-	// Return the message.
-	List::iterator i = dataPos;
-	--i;
-	return *i;
+	return slot(dataPos);
 }
 
 void NetQueue::popMessageForNet()
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for popMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to pop!");
+	ASSERT(dataPos != nextPos, "No message to pop!");
 
 	// Pop the message.
-	--dataPos;
+	++dataPos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -212,7 +217,9 @@ void NetQueue::popMessageForNet()
 
 void NetQueue::pushMessage(const NetMessage &message)
 {
-	messages.push_front(message);
+	NetMessage &newMessage = pushSlot();
+	newMessage.type = message.type;
+	newMessage.data.assign(message.data.begin(), message.data.end());  // Reuses the memory of the message which was in the slot.
 }
 
 void NetQueue::setWillNeverGetMessages()
@@ -223,27 +230,24 @@ void NetQueue::setWillNeverGetMessages()
 bool NetQueue::haveMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for haveMessage.");
-	return messagePos != messages.begin();
+	return messagePos != nextPos;
 }
 
 const NetMessage &NetQueue::getMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for getMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to get!");
+	ASSERT(messagePos != nextPos, "No message to get!");
 
-	// Return the message.
-	List::iterator i = messagePos;
-	--i;
-	return *i;
+	return slot(messagePos);
 }
 
 void NetQueue::popMessage()
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for popMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to pop!");
+	ASSERT(messagePos != nextPos, "No message to pop!");
 
 	// Pop the message.
-	--messagePos;
+	++messagePos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -253,27 +257,75 @@ void NetQueue::popOldMessages()
 {
 	if (!canGetMessagesForNet)
 	{
-		dataPos = messages.begin();
+		dataPos = nextPos;
 	}
 	if (!canGetMessages)
 	{
-		messagePos = messages.begin();
+		messagePos = nextPos;
 	}
 
-	List::iterator i = messages.end();
-	while (i != dataPos && i != messagePos)
+	// Compare distances from oldestPos, so that it still works when the numbers wrap around.
+	size_t newOldestPos = dataPos - oldestPos < messagePos - oldestPos ? dataPos : messagePos;
+	for (; oldestPos != newOldestPos; ++oldestPos)
 	{
-		--i;
+		NetMessage &old = slot(oldestPos);
+		if (old.data.capacity() > NETQUEUE_MAX_KEPT_CAPACITY)
+		{
+			std::vector<uint8_t>().swap(old.data);  // Don't hang on to the memory of unusually large messages.
+		}
 	}
+}
 
-	if (i == dataPos)
+size_t NETbenchmarkQueues(unsigned players, unsigned messagesPerTick, unsigned ticks, std::chrono::microseconds &time)
+{
+	// What each client sends each tick, as it arrives from the socket.
+	std::vector<uint8_t> rawData;
+	for (unsigned n = 0; n < messagesPerTick; ++n)
 	{
-		dataPos = messages.end();  // Old iterator will become invalid.
+		NetMessage message(n);
+		message.data.assign(24 + n % 16, n);
+		uint8_t header[NetMessage::rawHeaderMaxLen];
+		rawData.insert(rawData.end(), header, header + message.rawHeader(header));
+		rawData.insert(rawData.end(), message.data.begin(), message.data.end());
 	}
-	if (i == messagePos)
+
+	std::vector<NetQueuePair> clients(players);
+	size_t pushed = 0, sentBytes = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned tick = 0; tick < ticks; ++tick)
 	{
-		messagePos = messages.end();  // Old iterator will become invalid.
+		// Receive from each client, and relay to all the others.
+		for (unsigned from = 0; from < players; ++from)
+		{
+			NetQueue &receive = clients[from].receive;
+			receive.writeRawData(rawData.data(), rawData.size());
+			pushed += messagesPerTick;
+			for (; receive.haveMessage(); receive.popMessage())
+			{
+				const NetMessage &message = receive.getMessage();
+				for (unsigned to = 0; to < players; ++to)
+				{
+					if (to != from)
+					{
+						clients[to].send.pushMessage(message);
+						++pushed;
+					}
+				}
+			}
+		}
+		// Send everything.
+		for (unsigned to = 0; to < players; ++to)
+		{
+			NetQueue &send = clients[to].send;
+			for (; send.numMessagesForNet() > 0; send.popMessageForNet())
+			{
+				sentBytes += send.getMessageForNet().rawLen();
+			}
+		}
 	}
+	time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
 
-	messages.erase(i, messages.end());
+	ASSERT(sentBytes == rawData.size() * players * (players - 1) * ticks, "Lost messages");
+	return pushed;
 }
@@ -25,6 +25,8 @@
 #define _NET_QUEUE_H_
 
 #include "lib/framework/frame.h"
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <list>
 #include <deque>
@@ -44,9 +46,13 @@
 class NetMessage
 {
 public:
+	enum { rawHeaderMaxLen = 6 };  ///< The type, and up to 5 bytes for the length of data.
+
 	NetMessage(uint8_t type_ = 0xFF) : type(type_) {}
-	uint8_t *rawDataDup() const;  ///< Returns data compatible with NetQueue::writeRawData(). Must be delete[]d.
-	size_t rawLen() const;        ///< Returns the length of the return value of rawDataDup().
+	/// Writes the type and length of the message to header, which must have room for rawHeaderMaxLen bytes, and returns how many bytes were written.
+	/// The header followed by data is compatible with NetQueue::writeRawData().
+	unsigned rawHeader(uint8_t *header) const;
+	size_t rawLen() const;        ///< Returns the length of the header plus data.
 	uint8_t type;
 	std::vector<uint8_t> data;
 };
@@ -63,6 +69,10 @@ public:
 	{
 		message->data.push_back(v);
 	}
+	void bytes(const uint8_t *v, size_t n) const
+	{
+		message->data.insert(message->data.end(), v, v + n);
+	}
 	bool valid() const
 	{
 		return true;
@@ -82,6 +92,22 @@ public:
 		v = index >= message->data.size() ? 0x00 : message->data[index];
 		++index;
 	}
+	/// Reads n bytes at once. Like byte(), reading past the end gives zeros and makes the reader invalid.
+	void bytes(uint8_t *v, size_t n) const
+	{
+		size_t have = std::min(n, remaining());
+		std::copy_n(message->data.data() + std::min(index, message->data.size()), have, v);
+		std::fill(v + have, v + n, 0x00);
+		index += n;
+	}
+	void skip(size_t n) const
+	{
+		index += n;
+	}
+	size_t remaining() const
+	{
+		return index < message->data.size() ? message->data.size() - index : 0;
+	}
 	bool valid() const
 	{
 		return index <= message->data.size();
@@ -91,6 +117,7 @@ public:
 };
 
 /// A NetQueue is a queue of NetMessages. A NetQueue can convert the messages into a stream of bytes, which can be sent over the network, and converted back into a queue of NetMessages by the NetQueue at the other end.
+/// References returned by getMessageForNet() and getMessage() are only valid until the next message is added.
 class NetQueue
 {
 public:
@@ -115,6 +142,15 @@ public:
 
 private:
 	void popOldMessages();                                             ///< Pops any messages that are no longer needed.
+	NetMessage &pushSlot();                                            ///< Adds a message to the queue, and returns it to be filled in.
+	NetMessage &slot(size_t seq)
+	{
+		return ring[seq & (ring.size() - 1)];
+	}
+	const NetMessage &slot(size_t seq) const
+	{
+		return ring[seq & (ring.size() - 1)];
+	}
 
 	// Disable copy constructor and assignment operator.
 	NetQueue(const NetQueue &);         // TODO When switching to C++0x, use "= delete" notation.
@@ -123,10 +159,13 @@ private:
 	bool canGetMessagesForNet;                                         ///< True if we will send the messages over the network, false if we don't.
 	bool canGetMessages;                                               ///< True if we will get the messages, false if we don't use them ourselves.
 
-	typedef std::list<NetMessage> List;
-	List::iterator                dataPos;                             ///< Last message which was sent over the network.
-	List::iterator                messagePos;                          ///< Last message which was popped.
-	List                          messages;                            ///< List of messages. Messages are added to the front and read from the back.
+	// Messages are numbered in the order they were added, and message number seq is kept in ring[seq % ring.size()]. The slots
+	// of popped messages are reused, including the memory for their data, so a queue in steady use doesn't allocate.
+	std::vector<NetMessage>       ring;                                ///< Messages. The size is a power of 2.
+	size_t                        oldestPos;                           ///< Number of the oldest message which is still needed.
+	size_t                        dataPos;                             ///< Number of the next message to send over the network.
+	size_t                        messagePos;                          ///< Number of the next message to return from getMessage.
+	size_t                        nextPos;                             ///< Number of the next message to be added.
 	std::vector<uint8_t>          incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
 };
 
@@ -145,6 +184,10 @@ public:
 	NetQueue receive;
 };
 
+/// Simulates a host relaying messages for players clients, pushing and popping messagesPerTick from each client through the
+/// queues ticks times. Returns the number of messages pushed.
+size_t NETbenchmarkQueues(unsigned players, unsigned messagesPerTick, unsigned ticks, std::chrono::microseconds &time);
+
 /// Returns the number of bytes required to encode v.
 unsigned encodedlength_uint32_t(uint32_t v);
 /// Returns true iff there is another byte to be encoded.
@@ -0,0 +1,294 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netreplay.cpp
+ *
+ * Recording and playback of the game queue message stream.
+ *
+ * File format, all integers big-endian:
+ *   "WZrp", uint32 version, uint32 settings length, settings as JSON text,
+ *   then for each message: uint32 gameTime, uint8 player, uint8 type, uint32 data length, data,
+ *   terminated by a uint32 gameTime with player REPLAY_END_MARKER.
+ */
+
+#include "lib/framework/frame.h"
+
+#include <physfs.h>
+#include "lib/framework/physfs_ext.h"
+#include "3rdparty/json/json.hpp"
+
+#include "netreplay.h"
+#include "netplay.h"
+#include "nettypes.h"
+#include "netqueue.h"
+
+#include <algorithm>
+#include <vector>
+
+#define REPLAY_MAGIC          "WZrp"
+#define REPLAY_VERSION        1
+#define REPLAY_END_MARKER     0xFF
+#define REPLAY_FILE_EXTENSION ".wzrp"
+#define REPLAY_WRITE_BUFFER   (64 * 1024)
+
+static PHYSFS_file *saveHandle = nullptr;
+static PHYSFS_file *loadHandle = nullptr;
+
+// The next message to be played back, read ahead so we know when it is due.
+static bool haveNextMessage = false;
+static uint32_t nextMessageTime = 0;
+static uint8_t nextMessagePlayer = 0;
+static NetMessage nextMessage;
+
+static void deleteOldReplays(std::string const &dir, unsigned maxReplaysSaved)
+{
+	std::vector<std::string> replays;
+	char **files = PHYSFS_enumerateFiles(dir.c_str());
+	if (files == nullptr)
+	{
+		debug(LOG_ERROR, "Could not list replays in %s: %s", dir.c_str(), WZ_PHYSFS_getLastError());
+		return;
+	}
+	for (char **i = files; *i != nullptr; ++i)
+	{
+		std::string file = *i;
+		if (file.size() > strlen(REPLAY_FILE_EXTENSION) && file.compare(file.size() - strlen(REPLAY_FILE_EXTENSION), std::string::npos, REPLAY_FILE_EXTENSION) == 0)
+		{
+			replays.push_back(file);
+		}
+	}
+	PHYSFS_freeList(files);
+
+	// Replay names start with the date, so the oldest sort first.
+	std::sort(replays.begin(), replays.end());
+	for (size_t i = 0; i + maxReplaysSaved <= replays.size(); ++i)
+	{
+		std::string path = dir + "/" + replays[i];
+		debug(LOG_NET, "Deleting old replay %s", path.c_str());
+		PHYSFS_delete(path.c_str());
+	}
+}
+
+bool NETreplaySaveStart(std::string const &dir, std::string const &filename, nlohmann::json const &settings, unsigned maxReplaysSaved)
+{
+	ASSERT_OR_RETURN(false, saveHandle == nullptr, "Already recording a replay");
+	ASSERT_OR_RETURN(false, maxReplaysSaved > 0, "Not allowed to keep any replays");
+
+	deleteOldReplays(dir, maxReplaysSaved);
+
+	std::string path = dir + "/" + filename + REPLAY_FILE_EXTENSION;
+	saveHandle = PHYSFS_openWrite(path.c_str());
+	if (saveHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not create replay %s: %s", path.c_str(), WZ_PHYSFS_getLastError());
+		return false;
+	}
+	// Messages are small and frequent, so let PhysFS collect them instead of writing each one.
+	PHYSFS_setBuffer(saveHandle, REPLAY_WRITE_BUFFER);
+
+	std::string settingsText = settings.dump();
+	bool ok = WZ_PHYSFS_writeBytes(saveHandle, REPLAY_MAGIC, 4) == 4
+	          && PHYSFS_writeUBE32(saveHandle, REPLAY_VERSION)
+	          && PHYSFS_writeUBE32(saveHandle, settingsText.size())
+	          && WZ_PHYSFS_writeBytes(saveHandle, settingsText.data(), settingsText.size()) == (PHYSFS_sint64)settingsText.size();
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write replay %s: %s", path.c_str(), WZ_PHYSFS_getLastError());
+		PHYSFS_close(saveHandle);
+		saveHandle = nullptr;
+		return false;
+	}
+
+	debug(LOG_NET, "Recording replay %s", path.c_str());
+	return true;
+}
+
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player, uint32_t time)
+{
+	if (saveHandle == nullptr)
+	{
+		return;
+	}
+
+	bool ok = PHYSFS_writeUBE32(saveHandle, time)
+	          && PHYSFS_writeUBE8(saveHandle, player)
+	          && PHYSFS_writeUBE8(saveHandle, message->type)
+	          && PHYSFS_writeUBE32(saveHandle, message->data.size())
+	          && WZ_PHYSFS_writeBytes(saveHandle, message->data.data(), message->data.size()) == (PHYSFS_sint64)message->data.size();
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write replay, stopped recording: %s", WZ_PHYSFS_getLastError());
+		PHYSFS_close(saveHandle);
+		saveHandle = nullptr;
+	}
+}
+
+bool NETreplaySaveStop()
+{
+	if (saveHandle == nullptr)
+	{
+		return false;
+	}
+
+	bool ok = PHYSFS_writeUBE32(saveHandle, 0)
+	          && PHYSFS_writeUBE8(saveHandle, REPLAY_END_MARKER);
+	ok = PHYSFS_close(saveHandle) && ok;
+	saveHandle = nullptr;
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not finish writing replay: %s", WZ_PHYSFS_getLastError());
+	}
+	return ok;
+}
+
+/// Returns true if length bytes, read from the replay, fit in the rest of the file. Lengths are checked before
+/// allocating, so that a corrupt replay can't make us allocate gigabytes.
+static bool replayHasBytes(uint32_t length)
+{
+	PHYSFS_sint64 size = PHYSFS_fileLength(loadHandle);
+	PHYSFS_sint64 pos = PHYSFS_tell(loadHandle);
+	return size >= 0 && pos >= 0 && (PHYSFS_sint64)length <= size - pos;
+}
+
+/// Reads the next message from the replay, or sets haveNextMessage to false at the end of the replay.
+static void readNextMessage()
+{
+	haveNextMessage = false;
+
+	uint32_t dataLen = 0;
+	if (!PHYSFS_readUBE32(loadHandle, &nextMessageTime) || !PHYSFS_readUBE8(loadHandle, &nextMessagePlayer))
+	{
+		debug(LOG_WARNING, "Replay ended without an end marker, the game was probably not shut down cleanly.");
+		return;
+	}
+	if (nextMessagePlayer == REPLAY_END_MARKER)
+	{
+		return;
+	}
+	if (nextMessagePlayer >= MAX_PLAYERS || !PHYSFS_readUBE8(loadHandle, &nextMessage.type) || !PHYSFS_readUBE32(loadHandle, &dataLen))
+	{
+		debug(LOG_ERROR, "Corrupt replay message at gameTime %u", nextMessageTime);
+		return;
+	}
+	if (!replayHasBytes(dataLen))
+	{
+		debug(LOG_ERROR, "Truncated replay message at gameTime %u, length %u", nextMessageTime, dataLen);
+		return;
+	}
+	nextMessage.data.resize(dataLen);
+	if (WZ_PHYSFS_readBytes(loadHandle, nextMessage.data.data(), dataLen) != (PHYSFS_sint64)dataLen)
+	{
+		debug(LOG_ERROR, "Truncated replay message at gameTime %u", nextMessageTime);
+		return;
+	}
+	haveNextMessage = true;
+}
+
+bool NETreplayLoadStart(std::string const &filename, nlohmann::json &settings)
+{
+	ASSERT_OR_RETURN(false, loadHandle == nullptr, "Already playing a replay");
+
+	loadHandle = PHYSFS_openRead(filename.c_str());
+	if (loadHandle == nullptr)
+	{
+		debug(LOG_ERROR, "Could not open replay %s: %s", filename.c_str(), WZ_PHYSFS_getLastError());
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t settingsLen = 0;
+	if (WZ_PHYSFS_readBytes(loadHandle, magic, 4) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0
+	    || !PHYSFS_readUBE32(loadHandle, &version) || !PHYSFS_readUBE32(loadHandle, &settingsLen))
+	{
+		debug(LOG_ERROR, "%s is not a replay", filename.c_str());
+		NETreplayLoadStop();
+		return false;
+	}
+	if (version != REPLAY_VERSION)
+	{
+		debug(LOG_ERROR, "Replay %s has version %u, but only version %u is supported", filename.c_str(), version, REPLAY_VERSION);
+		NETreplayLoadStop();
+		return false;
+	}
+
+	if (!replayHasBytes(settingsLen))
+	{
+		debug(LOG_ERROR, "Truncated replay %s, settings length %u", filename.c_str(), settingsLen);
+		NETreplayLoadStop();
+		return false;
+	}
+	std::string settingsText(settingsLen, '\0');
+	if (WZ_PHYSFS_readBytes(loadHandle, &settingsText[0], settingsLen) != (PHYSFS_sint64)settingsLen)
+	{
+		debug(LOG_ERROR, "Truncated replay %s", filename.c_str());
+		NETreplayLoadStop();
+		return false;
+	}
+	try
+	{
+		settings = nlohmann::json::parse(settingsText);
+	}
+	catch (const std::exception &e)
+	{
+		debug(LOG_ERROR, "Bad settings in replay %s: %s", filename.c_str(), e.what());
+		NETreplayLoadStop();
+		return false;
+	}
+
+	readNextMessage();
+	debug(LOG_NET, "Playing replay %s", filename.c_str());
+	return true;
+}
+
+void NETreplayLoadNetMessages(uint32_t time)
+{
+	if (loadHandle == nullptr)
+	{
+		return;
+	}
+
+	while (haveNextMessage && nextMessageTime <= time)
+	{
+		NETinsertMessageFromNet(NETgameQueue(nextMessagePlayer), &nextMessage);
+		readNextMessage();
+	}
+}
+
+bool NETreplayLoadFinished()
+{
+	return loadHandle != nullptr && !haveNextMessage;
+}
+
+void NETreplayLoadStop()
+{
+	if (loadHandle == nullptr)
+	{
+		return;
+	}
+
+	PHYSFS_close(loadHandle);
+	loadHandle = nullptr;
+	haveNextMessage = false;
+}
+
+bool NETisReplay()
+{
+	return loadHandle != nullptr;
+}
@@ -0,0 +1,51 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file netreplay.h
+ *
+ * Recording and playback of the game queue message stream.
+ *
+ * A replay file holds the game settings, followed by every game queue message in the order it was processed, together
+ * with the gameTime it was processed at. Since the game queues are the only input to the synchronised game state, feeding
+ * the same messages back into the game queues at the same gameTime reproduces the game exactly.
+ */
+#ifndef _NET_REPLAY_H_
+#define _NET_REPLAY_H_
+
+#include "lib/framework/frame.h"
+#include "3rdparty/json/json_fwd.hpp"
+
+#include <string>
+
+class NetMessage;
+
+/// Starts recording to dir/filename, deleting the oldest replays in dir so that at most maxReplaysSaved are kept.
+bool NETreplaySaveStart(std::string const &dir, std::string const &filename, nlohmann::json const &settings, unsigned maxReplaysSaved);
+void NETreplaySaveNetMessage(NetMessage const *message, uint8_t player, uint32_t time);  ///< Records a game queue message, which is being processed at the given gameTime.
+bool NETreplaySaveStop();
+
+/// Opens a replay for playback, and returns the game settings that were saved with it.
+bool NETreplayLoadStart(std::string const &filename, nlohmann::json &settings);
+void NETreplayLoadNetMessages(uint32_t time);  ///< Inserts all messages which were processed at or before the given gameTime into the game queues.
+bool NETreplayLoadFinished();                  ///< Returns true once all messages have been inserted into the game queues.
+void NETreplayLoadStop();
+
+bool NETisReplay();  ///< Returns true if a replay is being played back, in which case no messages of our own are put into the game queues.
+
+#endif // _NET_REPLAY_H_
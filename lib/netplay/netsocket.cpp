@@ -29,6 +29,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <chrono>
 #include <map>
 
 #if !defined(ZLIB_CONST)
@@ -36,6 +37,12 @@
 #endif
 #include <zlib.h>
 
+// On Linux, wait for sockets with epoll, which scales to many connections and has no FD_SETSIZE limit. Elsewhere use select.
+#if defined(WZ_OS_LINUX)
+#  include <sys/epoll.h>
+#  define WZ_SOCKET_EPOLL
+#endif
+
 enum
 {
 	SOCK_CONNECTION,
@@ -77,7 +84,18 @@ struct Socket
 
 struct SocketSet
 {
+	SocketSet()
+#ifdef WZ_SOCKET_EPOLL
+		: epollFd(-1)
+#endif
+	{}
+
 	std::vector<Socket *> fds;
+#ifdef WZ_SOCKET_EPOLL
+	int epollFd;                                         ///< Watches fds for reading, or -1 to use select instead.
+	std::vector<SOCKET> epollRegistered;                 ///< The file descriptor each of fds was registered with, since the Socket may be closed before being removed.
+	mutable std::vector<struct epoll_event> epollEvents;
+#endif
 };
 
 
@@ -87,6 +105,13 @@ static WZ_THREAD *socketThread = nullptr;
 static bool socketThreadQuit;
 typedef std::map<Socket *, std::vector<uint8_t>> SocketThreadWriteMap;
 static SocketThreadWriteMap socketThreadWrites;
+#ifdef WZ_SOCKET_EPOLL
+static int socketThreadEpoll = -1;  ///< Watches the sockets in socketThreadWrites for writing, or -1 to use select instead.
+#endif
+
+// Time spent in zlib, and how often it was called, on all sockets. Only the main thread compresses and decompresses.
+static std::chrono::nanoseconds socketDeflateTime(0), socketInflateTime(0);
+static unsigned socketFlushCount = 0, socketInflateCount = 0;
 
 
 static void socketCloseNow(Socket *sock);
@@ -115,6 +140,67 @@ void setSockErr(int error)
 #endif
 }
 
+#ifdef WZ_SOCKET_EPOLL
+static bool socketEpollAdd(int epollFd, SOCKET fd, uint32_t events, Socket *sock)
+{
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.ptr = sock;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == SOCKET_ERROR)
+	{
+		debug(LOG_ERROR, "Failed to watch socket %p: %s", static_cast<void *>(sock), strSockError(getSockErr()));
+		return false;
+	}
+	return true;
+}
+
+static void socketEpollDel(int epollFd, SOCKET fd)
+{
+	struct epoll_event event;  // Ignored, but must not be NULL before Linux 2.6.9.
+	memset(&event, 0, sizeof(event));
+	// Closing a socket already stops watching it, so ENOENT and EBADF are expected.
+	if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, &event) == SOCKET_ERROR && getSockErr() != ENOENT && getSockErr() != EBADF)
+	{
+		debug(LOG_NET, "Failed to stop watching socket fd %d: %s", fd, strSockError(getSockErr()));
+	}
+}
+#endif
+
+/// Returns the data waiting to be written to sock by the socket thread, waking the thread if needed. Call with socketThreadMutex locked.
+static std::vector<uint8_t> &socketThreadWriteQueue(Socket *sock)
+{
+	if (socketThreadWrites.empty())
+	{
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+	std::pair<SocketThreadWriteMap::iterator, bool> inserted = socketThreadWrites.insert(std::make_pair(sock, std::vector<uint8_t>()));
+#ifdef WZ_SOCKET_EPOLL
+	if (inserted.second && socketThreadEpoll != -1)
+	{
+		socketEpollAdd(socketThreadEpoll, sock->fd[SOCK_CONNECTION], EPOLLOUT, sock);
+	}
+#endif
+	return inserted.first->second;
+}
+
+/// Stops writing to the socket, and closes it if socketClose was already called. Call with socketThreadMutex locked.
+static void socketThreadWriteDone(SocketThreadWriteMap::iterator w)
+{
+	Socket *sock = w->first;
+#ifdef WZ_SOCKET_EPOLL
+	if (socketThreadEpoll != -1)
+	{
+		socketEpollDel(socketThreadEpoll, sock->fd[SOCK_CONNECTION]);
+	}
+#endif
+	socketThreadWrites.erase(w);
+	if (sock->deleteLater)
+	{
+		socketCloseNow(sock);
+	}
+}
+
 #if defined(WZ_OS_WIN)
 typedef int (WINAPI *GETADDRINFO_DLL_FUNC)(const char *node, const char *service,
         const struct addrinfo *hints,
@@ -346,7 +432,9 @@ const char *strSockError(int error)
  */
 static bool connectionIsOpen(Socket *sock)
 {
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	// Not worth creating an epoll instance for a single socket, so this set uses select.
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	ASSERT_OR_RETURN((setSockErr(EBADF), false),
 	                 sock && sock->fd[SOCK_CONNECTION] != INVALID_SOCKET, "Invalid socket");
@@ -388,103 +476,133 @@ static bool connectionIsOpen(Socket *sock)
 	return true;
 }
 
-static int socketThreadFunction(void *)
+/// Sends as much of the data waiting to be written to a socket as it will take without blocking. Call with socketThreadMutex locked.
+static void socketThreadWrite(SocketThreadWriteMap::iterator w)
 {
-	wzMutexLock(socketThreadMutex);
-	while (!socketThreadQuit)
+	Socket *sock = w->first;
+	std::vector<uint8_t> &writeQueue = w->second;
+	ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
+
+	// Write data.
+	// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
+	ssize_t ret = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
+	if (ret != SOCKET_ERROR)
+	{
+		// Erase as much data as written.
+		writeQueue.erase(writeQueue.begin(), writeQueue.begin() + ret);
+		if (writeQueue.empty())
+		{
+			socketThreadWriteDone(w);  // Nothing left to write, delete from pending list.
+		}
+	}
+	else
 	{
+		switch (getSockErr())
+		{
+		case EAGAIN:
+#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
+		case EWOULDBLOCK:
+#endif
+			if (!connectionIsOpen(sock))
+			{
+				debug(LOG_NET, "Socket error");
+				sock->writeError = true;
+				socketThreadWriteDone(w);  // Socket broken, don't try writing to it again.
+				break;
+			}
+		case EINTR:
+			break;
+#if defined(EPIPE)
+		case EPIPE:
+#endif
+		default:
+			sock->writeError = true;
+			socketThreadWriteDone(w);  // Socket broken, don't try writing to it again.
+			break;
+		}
+	}
+}
+
+/// Waits up to 50ms for sockets to become writable, using select, then writes to them. Call with socketThreadMutex locked.
+static void socketThreadSelect()
+{
 #if   defined(WZ_OS_UNIX)
-		SOCKET maxfd = INT_MIN;
+	SOCKET maxfd = INT_MIN;
 #elif defined(WZ_OS_WIN)
-		SOCKET maxfd = 0;
+	SOCKET maxfd = 0;
 #endif
-		fd_set fds;
-		FD_ZERO(&fds);
-		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+	fd_set fds;
+	FD_ZERO(&fds);
+	for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+	{
+		if (!i->second.empty())
 		{
-			if (!i->second.empty())
-			{
-				SOCKET fd = i->first->fd[SOCK_CONNECTION];
-				maxfd = std::max(maxfd, fd);
-				ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
-				FD_SET(fd, &fds);
-			}
+			SOCKET fd = i->first->fd[SOCK_CONNECTION];
+			maxfd = std::max(maxfd, fd);
+			ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
+			FD_SET(fd, &fds);
 		}
-		struct timeval tv = {0, 50 * 1000};
+	}
+	struct timeval tv = {0, 50 * 1000};
 
-		// Check if we can write to any sockets.
-		wzMutexUnlock(socketThreadMutex);
-		int ret = select(maxfd + 1, nullptr, &fds, nullptr, &tv);
-		wzMutexLock(socketThreadMutex);
+	// Check if we can write to any sockets.
+	wzMutexUnlock(socketThreadMutex);
+	int ret = select(maxfd + 1, nullptr, &fds, nullptr, &tv);
+	wzMutexLock(socketThreadMutex);
 
-		// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
-		if (ret > 0)
+	// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
+	if (ret > 0)
+	{
+		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end();)
 		{
-			for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end();)
+			SocketThreadWriteMap::iterator w = i;
+			++i;
+
+			if (FD_ISSET(w->first->fd[SOCK_CONNECTION], &fds))
 			{
-				SocketThreadWriteMap::iterator w = i;
-				++i;
+				socketThreadWrite(w);
+			}
+		}
+	}
+}
 
-				Socket *sock = w->first;
-				std::vector<uint8_t> &writeQueue = w->second;
-				ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
+#ifdef WZ_SOCKET_EPOLL
+/// Waits up to 50ms for sockets to become writable, using epoll, then writes to them. Call with socketThreadMutex locked.
+static void socketThreadEpollWait()
+{
+	struct epoll_event events[64];
 
-				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
-				{
-					continue;  // This socket is not ready for writing, or we don't have anything to write.
-				}
+	// Sockets added to socketThreadWrites while we wait are watched straight away, so don't need to wait for the next call.
+	wzMutexUnlock(socketThreadMutex);
+	int ret = epoll_wait(socketThreadEpoll, events, ARRAY_SIZE(events), 50);
+	wzMutexLock(socketThreadMutex);
 
-				// Write data.
-				// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
-				ssize_t ret = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
-				if (ret != SOCKET_ERROR)
-				{
-					// Erase as much data as written.
-					writeQueue.erase(writeQueue.begin(), writeQueue.begin() + ret);
-					if (writeQueue.empty())
-					{
-						socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-					}
-				}
-				else
-				{
-					switch (getSockErr())
-					{
-					case EAGAIN:
-#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
-					case EWOULDBLOCK:
+	for (int i = 0; i < ret; ++i)
+	{
+		// Only this thread removes sockets, but check anyway, in case the socket was already written to and removed.
+		SocketThreadWriteMap::iterator w = socketThreadWrites.find(static_cast<Socket *>(events[i].data.ptr));
+		if (w != socketThreadWrites.end())
+		{
+			socketThreadWrite(w);
+		}
+	}
+}
 #endif
-						if (!connectionIsOpen(sock))
-						{
-							debug(LOG_NET, "Socket error");
-							sock->writeError = true;
-							socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-							if (sock->deleteLater)
-							{
-								socketCloseNow(sock);
-							}
-							break;
-						}
-					case EINTR:
-						break;
-#if defined(EPIPE)
-					case EPIPE:
+
+static int socketThreadFunction(void *)
+{
+	wzMutexLock(socketThreadMutex);
+	while (!socketThreadQuit)
+	{
+#ifdef WZ_SOCKET_EPOLL
+		if (socketThreadEpoll != -1)
+		{
+			socketThreadEpollWait();
+		}
+		else
 #endif
-					default:
-						sock->writeError = true;
-						socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-						break;
-					}
-				}
-			}
+		{
+			socketThreadSelect();
 		}
 
 		if (socketThreadWrites.empty())
@@ -553,7 +671,10 @@ ssize_t readNoInt(Socket *sock, void *buf, size_t max_size, size_t *rawByteCount
 
 		sock->zInflate.next_out = (Bytef *)buf;
 		sock->zInflate.avail_out = max_size;
+		auto inflateStart = std::chrono::high_resolution_clock::now();
 		int ret = inflate(&sock->zInflate, Z_NO_FLUSH);
+		socketInflateTime += std::chrono::high_resolution_clock::now() - inflateStart;
+		++socketInflateCount;
 		ASSERT(ret != Z_STREAM_ERROR, "zlib inflate not working!");
 		char const *err = nullptr;
 		switch (ret)
@@ -599,6 +720,56 @@ bool socketReadDisconnected(Socket *sock)
 	return sock->readDisconnected;
 }
 
+/// Compresses size bytes of buf into the socket's output buffer, to be sent by socketFlush.
+static void socketDeflate(Socket *sock, const void *buf, size_t size)
+{
+#if ZLIB_VERNUM < 0x1252
+	// zlib < 1.2.5.2 does not support `#define ZLIB_CONST`
+	// Unfortunately, some OSes (ex. OpenBSD) ship with zlib < 1.2.5.2
+	// Workaround: cast away the const of the input, and disable the resulting -Wcast-qual warning
+	#if defined(__clang__)
+	#  pragma clang diagnostic push
+	#  pragma clang diagnostic ignored "-Wcast-qual"
+	#elif defined(__GNUC__)
+	#  pragma GCC diagnostic push
+	#  pragma GCC diagnostic ignored "-Wcast-qual"
+	#endif
+
+	// cast away the const for earlier zlib versions
+	sock->zDeflate.next_in = (Bytef *)buf; // -Wcast-qual
+
+	#if defined(__clang__)
+	#  pragma clang diagnostic pop
+	#elif defined(__GNUC__)
+	#  pragma GCC diagnostic pop
+	#endif
+#else
+	// zlib >= 1.2.5.2 supports ZLIB_CONST
+	sock->zDeflate.next_in = (const Bytef *)buf;
+#endif
+
+	sock->zDeflate.avail_in = size;
+	sock->zDeflateInSize += sock->zDeflate.avail_in;
+	auto deflateStart = std::chrono::high_resolution_clock::now();
+	do
+	{
+		size_t alreadyHave = sock->zDeflateOutBuf.size();
+		sock->zDeflateOutBuf.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
+		sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
+		sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
+
+		int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
+		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+
+		// Remove unused part of buffer.
+		sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
+	}
+	while (sock->zDeflate.avail_out == 0);
+	socketDeflateTime += std::chrono::high_resolution_clock::now() - deflateStart;
+
+	ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+}
+
 /**
  * Similar to write(2) with the exception that this function will block until
  * <em>all</em> data has been written or an error occurs.
@@ -606,6 +777,11 @@ bool socketReadDisconnected(Socket *sock)
  * @return @c size when successful or @c SOCKET_ERROR if an error occurred.
  */
 ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCount)
+{
+	return writeAllWithHeader(sock, nullptr, 0, buf, size, rawByteCount);
+}
+
+ssize_t writeAllWithHeader(Socket *sock, const void *header, size_t headerSize, const void *buf, size_t size, size_t *rawByteCount)
 {
 	size_t ignored;
 	size_t &rawBytes = rawByteCount != nullptr ? *rawByteCount : ignored;
@@ -623,69 +799,31 @@ ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCoun
 		return SOCKET_ERROR;
 	}
 
-	if (size > 0)
+	if (headerSize + size > 0)
 	{
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
-			{
-				wzSemaphorePost(socketThreadSemaphore);
-			}
-			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
+			std::vector<uint8_t> &writeQueue = socketThreadWriteQueue(sock);
+			writeQueue.insert(writeQueue.end(), static_cast<char const *>(header), static_cast<char const *>(header) + headerSize);
 			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
 			wzMutexUnlock(socketThreadMutex);
-			rawBytes = size;
+			rawBytes = headerSize + size;
 		}
 		else
 		{
-		#if ZLIB_VERNUM < 0x1252
-			// zlib < 1.2.5.2 does not support `#define ZLIB_CONST`
-			// Unfortunately, some OSes (ex. OpenBSD) ship with zlib < 1.2.5.2
-			// Workaround: cast away the const of the input, and disable the resulting -Wcast-qual warning
-			#if defined(__clang__)
-			#  pragma clang diagnostic push
-			#  pragma clang diagnostic ignored "-Wcast-qual"
-			#elif defined(__GNUC__)
-			#  pragma GCC diagnostic push
-			#  pragma GCC diagnostic ignored "-Wcast-qual"
-			#endif
-
-			// cast away the const for earlier zlib versions
-			sock->zDeflate.next_in = (Bytef *)buf; // -Wcast-qual
-
-			#if defined(__clang__)
-			#  pragma clang diagnostic pop
-			#elif defined(__GNUC__)
-			#  pragma GCC diagnostic pop
-			#endif
-		#else
-			// zlib >= 1.2.5.2 supports ZLIB_CONST
-			sock->zDeflate.next_in = (const Bytef *)buf;
-		#endif
-
-			sock->zDeflate.avail_in = size;
-			sock->zDeflateInSize += sock->zDeflate.avail_in;
-			do
+			if (headerSize > 0)
 			{
-				size_t alreadyHave = sock->zDeflateOutBuf.size();
-				sock->zDeflateOutBuf.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
-				sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
-				sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
-
-				int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
-				ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
-
-				// Remove unused part of buffer.
-				sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
+				socketDeflate(sock, header, headerSize);
+			}
+			if (size > 0)
+			{
+				socketDeflate(sock, buf, size);
 			}
-			while (sock->zDeflate.avail_out == 0);
-
-			ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
 		}
 	}
 
-	return size;
+	return headerSize + size;
 }
 
 void socketFlush(Socket *sock, size_t *rawByteCount)
@@ -700,6 +838,7 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	}
 
 	// Flush data out of zlib compression state.
+	auto deflateStart = std::chrono::high_resolution_clock::now();
 	do
 	{
 		sock->zDeflate.next_in = (Bytef *)nullptr;
@@ -716,18 +855,16 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 		sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
 	}
 	while (sock->zDeflate.avail_out == 0);
+	socketDeflateTime += std::chrono::high_resolution_clock::now() - deflateStart;
 
 	if (sock->zDeflateOutBuf.empty())
 	{
 		return;  // No data to flush out.
 	}
+	++socketFlushCount;
 
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
-	{
-		wzSemaphorePost(socketThreadSemaphore);
-	}
-	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
+	std::vector<uint8_t> &writeQueue = socketThreadWriteQueue(sock);
 	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
 	wzMutexUnlock(socketThreadMutex);
 
@@ -742,12 +879,13 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	sock->zDeflateOutBuf.clear();
 }
 
-void socketBeginCompression(Socket *sock)
+void socketBeginCompression(Socket *sock, SocketCodec codec, int level)
 {
-	if (sock->isCompressed)
+	if (sock->isCompressed || codec == SOCKET_CODEC_NONE)
 	{
 		return;  // Nothing to do.
 	}
+	ASSERT(codec == SOCKET_CODEC_ZLIB, "Unknown codec %d", (int)codec);
 
 	wzMutexLock(socketThreadMutex);
 
@@ -755,7 +893,7 @@ void socketBeginCompression(Socket *sock)
 	sock->zDeflate.zalloc = Z_NULL;
 	sock->zDeflate.zfree = Z_NULL;
 	sock->zDeflate.opaque = Z_NULL;
-	int ret = deflateInit(&sock->zDeflate, 6);
+	int ret = deflateInit(&sock->zDeflate, std::max<int>(Z_BEST_SPEED, std::min<int>(level, Z_BEST_COMPRESSION)));
 	ASSERT(ret == Z_OK, "deflateInit failed! Sockets won't work.");
 
 	sock->zInflate.zalloc = Z_NULL;
@@ -777,17 +915,40 @@ Socket::~Socket()
 	if (isCompressed)
 	{
 		deflateEnd(&zDeflate);
-		deflateEnd(&zInflate);
+		inflateEnd(&zInflate);
 	}
 }
 
+void socketGetCodecStatistics(unsigned &deflateMicroseconds, unsigned &inflateMicroseconds, unsigned &flushes, unsigned &inflates)
+{
+	deflateMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(socketDeflateTime).count();
+	inflateMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(socketInflateTime).count();
+	flushes = socketFlushCount;
+	inflates = socketInflateCount;
+}
+
 SocketSet *allocSocketSet()
 {
-	return new SocketSet;
+	SocketSet *set = new SocketSet;
+#ifdef WZ_SOCKET_EPOLL
+	set->epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (set->epollFd == SOCKET_ERROR)
+	{
+		debug(LOG_WARNING, "Failed to create epoll instance, using select instead: %s", strSockError(getSockErr()));
+		set->epollFd = -1;
+	}
+#endif
+	return set;
 }
 
 void deleteSocketSet(SocketSet *set)
 {
+#ifdef WZ_SOCKET_EPOLL
+	if (set->epollFd != -1)
+	{
+		close(set->epollFd);
+	}
+#endif
 	delete set;
 }
 
@@ -809,6 +970,13 @@ void SocketSet_AddSocket(SocketSet *set, Socket *socket)
 	}
 
 	set->fds.push_back(socket);
+#ifdef WZ_SOCKET_EPOLL
+	set->epollRegistered.push_back(socket->fd[SOCK_CONNECTION]);
+	if (set->epollFd != -1 && socket->fd[SOCK_CONNECTION] != INVALID_SOCKET)
+	{
+		socketEpollAdd(set->epollFd, socket->fd[SOCK_CONNECTION], EPOLLIN, socket);
+	}
+#endif
 	debug(LOG_NET, "Socket added: set->fds[%lu] = %p", (unsigned long)i, static_cast<void *>(socket));
 }
 
@@ -822,6 +990,15 @@ void SocketSet_DelSocket(SocketSet *set, Socket *socket)
 	{
 		debug(LOG_NET, "Socket %p erased (set->fds[%lu])", static_cast<void *>(socket), (unsigned long)i);
 		set->fds.erase(set->fds.begin() + i);
+#ifdef WZ_SOCKET_EPOLL
+		// The Socket may already be closed, and its file descriptor reused by another Socket in this set, which must stay watched.
+		SOCKET fd = set->epollRegistered[i];
+		set->epollRegistered.erase(set->epollRegistered.begin() + i);
+		if (set->epollFd != -1 && fd != INVALID_SOCKET && std::find(set->epollRegistered.begin(), set->epollRegistered.end(), fd) == set->epollRegistered.end())
+		{
+			socketEpollDel(set->epollFd, fd);
+		}
+#endif
 	}
 }
 
@@ -877,6 +1054,39 @@ static void socketBlockSIGPIPE(const SOCKET fd, bool block_sigpipe)
 #endif
 }
 
+#ifdef WZ_SOCKET_EPOLL
+/// Like the select part of checkSockets, but only looks at the sockets which are ready, instead of every socket in the set.
+static int checkSocketsEpoll(const SocketSet *set, unsigned int timeout)
+{
+	set->epollEvents.resize(set->fds.size());
+
+	int ret;
+	do
+	{
+		ret = epoll_wait(set->epollFd, &set->epollEvents[0], set->epollEvents.size(), std::min<unsigned>(timeout, INT_MAX));
+	}
+	while (ret == SOCKET_ERROR && getSockErr() == EINTR);
+
+	if (ret == SOCKET_ERROR)
+	{
+		debug(LOG_ERROR, "epoll_wait failed: %s", strSockError(getSockErr()));
+		return SOCKET_ERROR;
+	}
+
+	for (size_t i = 0; i < set->fds.size(); ++i)
+	{
+		set->fds[i]->ready = false;
+	}
+	for (int i = 0; i < ret; ++i)
+	{
+		// Errors and hang-ups are reported as ready too, like select does, so that the next read finds out about them.
+		static_cast<Socket *>(set->epollEvents[i].data.ptr)->ready = true;
+	}
+
+	return ret;
+}
+#endif
+
 int checkSockets(const SocketSet *set, unsigned int timeout)
 {
 	if (set->fds.empty())
@@ -917,6 +1127,13 @@ int checkSockets(const SocketSet *set, unsigned int timeout)
 		return ret;
 	}
 
+#ifdef WZ_SOCKET_EPOLL
+	if (set->epollFd != -1)
+	{
+		return checkSocketsEpoll(set, timeout);
+	}
+#endif
+
 	int ret;
 	fd_set fds;
 	do
@@ -967,7 +1184,9 @@ ssize_t readAll(Socket *sock, void *buf, size_t size, unsigned int timeout)
 {
 	ASSERT(!sock->isCompressed, "readAll on compressed sockets not implemented.");
 
-	const SocketSet set = {std::vector<Socket *>(1, sock)};
+	// Not worth creating an epoll instance for a single socket, so this set uses select.
+	SocketSet set;
+	set.fds.push_back(sock);
 
 	size_t received = 0;
 
@@ -1518,6 +1737,14 @@ void SOCKETinit()
 		socketThreadQuit = false;
 		socketThreadMutex = wzMutexCreate();
 		socketThreadSemaphore = wzSemaphoreCreate(0);
+#ifdef WZ_SOCKET_EPOLL
+		socketThreadEpoll = epoll_create1(EPOLL_CLOEXEC);
+		if (socketThreadEpoll == SOCKET_ERROR)
+		{
+			debug(LOG_WARNING, "Failed to create epoll instance, using select instead: %s", strSockError(getSockErr()));
+			socketThreadEpoll = -1;
+		}
+#endif
 		socketThread = wzThreadCreate(socketThreadFunction, nullptr);
 		wzThreadStart(socketThread);
 	}
@@ -1535,6 +1762,13 @@ void SOCKETshutdown()
 		wzThreadJoin(socketThread);
 		wzMutexDestroy(socketThreadMutex);
 		wzSemaphoreDestroy(socketThreadSemaphore);
+#ifdef WZ_SOCKET_EPOLL
+		if (socketThreadEpoll != -1)
+		{
+			close(socketThreadEpoll);
+			socketThreadEpoll = -1;
+		}
+#endif
 		socketThread = nullptr;
 	}
 
@@ -1550,3 +1784,107 @@ void SOCKETshutdown()
 	}
 #endif
 }
+
+size_t SOCKETbenchmarkLoopback(unsigned clients, unsigned messages, size_t messageSize, std::chrono::microseconds &time)
+{
+	time = std::chrono::microseconds(0);
+
+	// Let the system pick a free port, so as not to get in the way of a game being hosted.
+	Socket *listenSock = socketListen(0);
+	if (listenSock == nullptr)
+	{
+		return 0;
+	}
+	unsigned port = 0;
+	for (unsigned i = 0; i < ARRAY_SIZE(listenSock->fd) && port == 0; ++i)
+	{
+		struct sockaddr_storage addr;
+		socklen_t addrLen = sizeof(addr);
+		if (listenSock->fd[i] != INVALID_SOCKET && getsockname(listenSock->fd[i], (struct sockaddr *)&addr, &addrLen) == 0)
+		{
+			port = addr.ss_family == AF_INET6 ? ntohs(((struct sockaddr_in6 *)&addr)->sin6_port) : ntohs(((struct sockaddr_in *)&addr)->sin_port);
+		}
+	}
+	SocketAddress *addr = port != 0 ? resolveHost("127.0.0.1", port) : nullptr;
+
+	// Connect the clients one at a time, since the listen backlog is short.
+	std::vector<Socket *> clientSocks, hostSocks;
+	SocketSet *set = allocSocketSet();
+	bool ok = addr != nullptr;
+	for (unsigned i = 0; i < clients && ok; ++i)
+	{
+		Socket *client = socketOpen(addr, 1000);
+		Socket *host = nullptr;
+		for (unsigned tries = 0; client != nullptr && host == nullptr && tries < 1000; ++tries)
+		{
+			host = socketAccept(listenSock);
+			if (host == nullptr)
+			{
+				wzDelay(1);
+			}
+		}
+		if (client != nullptr)
+		{
+			clientSocks.push_back(client);
+		}
+		if (host != nullptr)
+		{
+			hostSocks.push_back(host);
+			SocketSet_AddSocket(set, host);
+		}
+		ok = client != nullptr && host != nullptr;
+	}
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Only managed to connect %u of %u loopback clients", (unsigned)hostSocks.size(), clients);
+	}
+
+	// Every client sends a message, then the host reads whatever is ready until it has them all, like a host receiving a tick from each player.
+	std::vector<uint8_t> message(messageSize, 0x5A), buf(std::max<size_t>(messageSize, 1024));
+	size_t received = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned m = 0; m < messages && ok; ++m)
+	{
+		for (Socket *client : clientSocks)
+		{
+			ok = ok && writeAll(client, message.data(), message.size()) == (ssize_t)message.size();
+		}
+		size_t expected = size_t(m + 1) * clients * messageSize;
+		while (ok && received < expected)
+		{
+			ok = checkSockets(set, 1000) > 0;
+			for (size_t i = 0; i < hostSocks.size() && ok; ++i)
+			{
+				if (socketReadReady(hostSocks[i]))
+				{
+					ssize_t size = readNoInt(hostSocks[i], buf.data(), buf.size());
+					ok = size > 0;
+					received += std::max<ssize_t>(size, 0);
+				}
+			}
+		}
+	}
+	time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Loopback benchmark failed after receiving %u bytes", (unsigned)received);
+	}
+
+	for (Socket *sock : hostSocks)
+	{
+		SocketSet_DelSocket(set, sock);
+		socketClose(sock);
+	}
+	for (Socket *sock : clientSocks)
+	{
+		socketClose(sock);
+	}
+	deleteSocketSet(set);
+	if (addr != nullptr)
+	{
+		deleteSocketAddress(addr);
+	}
+	socketClose(listenSock);
+
+	return ok ? received : 0;
+}
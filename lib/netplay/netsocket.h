@@ -23,6 +23,8 @@
 
 #include "lib/framework/types.h"
 
+#include <chrono>
+
 #if   defined(WZ_OS_UNIX)
 # include <arpa/inet.h>
 # include <errno.h>
@@ -109,11 +111,20 @@ WZ_DECL_NONNULL(1, 2)
 ssize_t readAll(Socket *sock, void *buf, size_t size, unsigned timeout);///< Reads exactly size bytes from the Socket, or blocks until the timeout expires.
 WZ_DECL_NONNULL(1, 2)
 ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCount = nullptr);  ///< Nonblocking write of size bytes to the Socket. All bytes will be written asynchronously, by a separate thread. Raw count of bytes (after compression) returned in rawByteCount, which will often be 0 until the socket is flushed.
+ssize_t writeAllWithHeader(Socket *sock, const void *header, size_t headerSize, const void *buf, size_t size, size_t *rawByteCount = nullptr);  ///< Like writeAll, but writes the header and then buf, without first copying them together.
 
 // Sockets, compressed.
-WZ_DECL_NONNULL(1) void socketBeginCompression(Socket *sock); ///< Makes future data sent compressed, and future data received expected to be compressed.
+/// How data on a connection is compressed. Both ends must use the same codec, but the zlib level only matters to the sender.
+enum SocketCodec
+{
+	SOCKET_CODEC_NONE,  ///< Sent as is, for fast networks where compressing costs more time than it saves.
+	SOCKET_CODEC_ZLIB,
+	SOCKET_CODEC_COUNT
+};
+WZ_DECL_NONNULL(1) void socketBeginCompression(Socket *sock, SocketCodec codec = SOCKET_CODEC_ZLIB, int level = 6); ///< Makes future data sent compressed, and future data received expected to be compressed.
 WZ_DECL_NONNULL(1) bool socketReadDisconnected(Socket *sock);  ///< If readNoInt returned 0, returns true if this is the result of a disconnect, or false if the input compressed data just hasn't produced any output bytes.
 WZ_DECL_NONNULL(1) void socketFlush(Socket *sock, size_t *rawByteCount = nullptr); ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective. Raw count of bytes (after compression) returned in rawByteCount.
+void socketGetCodecStatistics(unsigned &deflateMicroseconds, unsigned &inflateMicroseconds, unsigned &flushes, unsigned &inflates);  ///< Totals over all sockets, since startup.
 
 // Socket sets.
 WZ_DECL_ALLOCATION SocketSet *allocSocketSet();                         ///< Constructs a SocketSet.
@@ -123,4 +134,8 @@ WZ_DECL_NONNULL(1, 2) void SocketSet_AddSocket(SocketSet *set, Socket *socket);
 WZ_DECL_NONNULL(1, 2) void SocketSet_DelSocket(SocketSet *set, Socket *socket);  ///< Removes a Socket from a SocketSet.
 WZ_DECL_NONNULL(1) int checkSockets(const SocketSet *set, unsigned int timeout); ///< Checks which Sockets are ready for reading. Returns the number of ready Sockets, or returns SOCKET_ERROR on error.
 
+/// Connects clients sockets to a listening socket on the loopback interface, then sends messages rounds of one messageSize message
+/// from every client, which are received through a SocketSet. Returns the number of bytes received, or 0 on failure.
+size_t SOCKETbenchmarkLoopback(unsigned clients, unsigned messages, size_t messageSize, std::chrono::microseconds &time);
+
 #endif //_net_socket_h
@@ -38,6 +38,7 @@
 #include "nettypes.h"
 #include "netqueue.h"
 #include "netlog.h"
+#include "netreplay.h"
 #include "src/order.h"
 #include <cstring>
 
@@ -264,6 +265,25 @@ static void queue(const Q &q, std::vector<T> &v)
 	}
 }
 
+// Byte vectors, such as the data of nested messages, are copied in one go.
+static void queue(const MessageWriter &q, std::vector<uint8_t> &v)
+{
+	uint32_t len = v.size();
+	queue(q, len);
+	q.bytes(v.data(), len);
+}
+
+static void queue(const MessageReader &q, std::vector<uint8_t> &v)
+{
+	uint32_t len = 0;
+	queue(q, len);
+	// Don't let a corrupt length make us allocate more than the message holds.
+	size_t have = std::min<size_t>(len, q.remaining());
+	v.resize(have);
+	q.bytes(v.data(), have);
+	q.skip(len - have);
+}
+
 template<class Q>
 static void queue(const Q &q, NetMessage &v)
 {
@@ -284,6 +304,18 @@ static void queueAuto(T &v)
 	}
 }
 
+static void queueBytesAuto(uint8_t *data, size_t len)
+{
+	if (NETgetPacketDir() == PACKET_ENCODE)
+	{
+		writer.bytes(data, len);
+	}
+	else if (NETgetPacketDir() == PACKET_DECODE)
+	{
+		reader.bytes(data, len);
+	}
+}
+
 // Queue selection functions
 
 /// Gets the &NetQueuePair::send or NetQueue *, corresponding to queue.
@@ -454,7 +486,8 @@ void NETbeginEncode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_ENCODE);
 
 	queueInfo = queue;
-	message = type;
+	message.type = type;
+	message.data.clear();  // Keeps the capacity, so encoding doesn't need to allocate.
 	writer = MessageWriter(message);
 }
 
@@ -474,6 +507,13 @@ bool NETend()
 	// If we are encoding just return true
 	if (NETgetPacketDir() == PACKET_ENCODE)
 	{
+		if (NETisReplay() && (queueInfo.queueType == QUEUE_GAME || queueInfo.queueType == QUEUE_GAME_FORCED))
+		{
+			// While playing back a replay, the game queues only get the recorded messages.
+			NETsetPacketDir(PACKET_INVALID);
+			return true;
+		}
+
 		// Push the message onto the list.
 		NetQueue *queue = sendQueue(queueInfo);
 		if (queue == nullptr) {
@@ -666,10 +706,7 @@ void NETstring(char *str, uint16_t maxlen)
 		len = maxlen - 1;
 	}
 
-	for (unsigned i = 0; i < len; ++i)
-	{
-		queueAuto(str[i]);
-	}
+	queueBytesAuto(reinterpret_cast<uint8_t *>(str), len);
 
 	if (NETgetPacketDir() == PACKET_DECODE)
 	{
@@ -745,18 +782,12 @@ void NETbytes(std::vector<uint8_t> *vec, unsigned maxLen)
 		vec->resize(len);  // vec->assign(len, 0) would call the wrong version of assign, here.
 	}
 
-	for (unsigned i = 0; i < len; ++i)
-	{
-		queueAuto((*vec)[i]);
-	}
+	queueBytesAuto(vec->data(), len);
 }
 
 void NETbin(uint8_t *str, uint32_t len)
 {
-	for (unsigned i = 0; i < len; ++i)
-	{
-		queueAuto(str[i]);
-	}
+	queueBytesAuto(str, len);
 }
 
 void NETPosition(Position *vp)
@@ -789,3 +820,86 @@ void NETnetMessage(NetMessage const **message)
 		return;
 	}
 }
+
+namespace
+{
+/// Has the same fields as a GAME_DROIDINFO move order.
+struct BenchmarkDroidOrder
+{
+	uint8_t player;
+	uint32_t subType;
+	uint32_t order;
+	Vector2i pos;
+	uint8_t add;
+	std::vector<uint32_t> droidIdDeltas;
+};
+}
+
+template<class Q>
+static void queue(const Q &q, BenchmarkDroidOrder &v)
+{
+	queue(q, v.player);
+	queue(q, v.subType);
+	queue(q, v.order);
+	queue(q, v.pos);
+	queue(q, v.add);
+	queue(q, v.droidIdDeltas);
+}
+
+void NETbenchmarkSerialisation(unsigned iterations, std::chrono::microseconds &encodeTime, std::chrono::microseconds &decodeTime, size_t &messageBytes)
+{
+	const uint32_t ordersPerTick = 8;
+
+	BenchmarkDroidOrder order;
+	order.player = 3;
+	order.subType = 1;
+	order.order = 2;  // DORDER_MOVE
+	order.pos = Vector2i(12345, 6789);
+	order.add = false;
+	order.droidIdDeltas.assign(10, 1);
+	order.droidIdDeltas[0] = 70000;
+
+	NetMessage shared(NET_SHARE_GAME_QUEUE);
+	NetMessage orderMessage(GAME_DROIDINFO);
+	encodeTime = decodeTime = std::chrono::microseconds::zero();
+	unsigned failures = 0;
+
+	for (unsigned iteration = 0; iteration < iterations; ++iteration)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		shared.data.clear();
+		MessageWriter w(shared);
+		uint8_t player = order.player;
+		uint32_t num = ordersPerTick;
+		queue(w, player);
+		queue(w, num);
+		for (uint32_t n = 0; n < num; ++n)
+		{
+			orderMessage.data.clear();
+			queue(MessageWriter(orderMessage), order);
+			queue(w, orderMessage);
+		}
+		auto middle = std::chrono::high_resolution_clock::now();
+
+		MessageReader r(shared);
+		queue(r, player);
+		queue(r, num);
+		for (uint32_t n = 0; n < num && r.valid(); ++n)
+		{
+			NetMessage received;
+			queue(r, received);
+			MessageReader orderReader(received);
+			BenchmarkDroidOrder decoded;
+			queue(orderReader, decoded);
+			failures += !orderReader.valid() || decoded.pos != order.pos || decoded.droidIdDeltas != order.droidIdDeltas;
+		}
+		failures += !r.valid() || num != ordersPerTick;
+		auto end = std::chrono::high_resolution_clock::now();
+
+		encodeTime += std::chrono::duration_cast<std::chrono::microseconds>(middle - start);
+		decodeTime += std::chrono::duration_cast<std::chrono::microseconds>(end - middle);
+	}
+
+	ASSERT(failures == 0, "%u messages did not decode correctly", failures);
+	messageBytes = shared.rawLen();
+}
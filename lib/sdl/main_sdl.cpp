@@ -89,6 +89,9 @@ int main(int argc, char *argv[])
 static SDL_Window *WZwindow = nullptr;
 static SDL_GLContext WZglcontext = nullptr;
 
+// Set by wzMainHeadlessSetup(), when running without a window or GL context.
+static bool headlessMode = false;
+
 // The screen that the game window is on.
 int screenIndex = 0;
 // The logical resolution of the game in the game's coordinate system (points).
@@ -306,6 +309,11 @@ int wzGetTicks()
 	return SDL_GetTicks();
 }
 
+int wzGetCPUCount()
+{
+	return SDL_GetCPUCount();
+}
+
 void wzFatalDialog(const char *msg)
 {
 	SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "We have a problem!", msg, nullptr);
@@ -313,6 +321,10 @@ void wzFatalDialog(const char *msg)
 
 void wzScreenFlip()
 {
+	if (headlessMode)
+	{
+		return;
+	}
 	SDL_GL_SwapWindow(WZwindow);
 }
 
@@ -1480,8 +1492,11 @@ void wzGetWindowResolution(int *screen, unsigned int *width, unsigned int *heigh
 		*screen = screenIndex;
 	}
 
-	int currentWidth = 0, currentHeight = 0;
-	SDL_GetWindowSize(WZwindow, &currentWidth, &currentHeight);
+	int currentWidth = windowWidth, currentHeight = windowHeight;
+	if (!headlessMode)
+	{
+		SDL_GetWindowSize(WZwindow, &currentWidth, &currentHeight);
+	}
 	assert(currentWidth >= 0);
 	assert(currentHeight >= 0);
 	if (width != nullptr)
@@ -1494,6 +1509,39 @@ void wzGetWindowResolution(int *screen, unsigned int *width, unsigned int *heigh
 	}
 }
 
+bool wzMainHeadlessSetup()
+{
+	// No video subsystem, so no window and no GL context. Events are still needed for wzAsyncExecOnMainThread.
+	if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+	{
+		debug(LOG_ERROR, "Error: Could not initialise SDL (%s).", SDL_GetError());
+		return false;
+	}
+
+	wzSDLAppEvent = SDL_RegisterEvents(1);
+	if (wzSDLAppEvent == ((Uint32)-1)) {
+		// Failed to register app-defined event with SDL
+		debug(LOG_ERROR, "Error: Failed to register app-defined SDL event (%s).", SDL_GetError());
+		return false;
+	}
+
+	// Pretend to have a window of the configured size, so that the interface code can lay out its widgets.
+	setDisplayScale(100);
+	windowWidth = screenWidth = std::max(pie_GetVideoBufferWidth(), 640);
+	windowHeight = screenHeight = std::max(pie_GetVideoBufferHeight(), 480);
+	pie_SetVideoBufferWidth(screenWidth);
+	pie_SetVideoBufferHeight(screenHeight);
+
+	headlessMode = true;
+	debug(LOG_WZ, "Running headless, game screen is %u x %u", screenWidth, screenHeight);
+	return true;
+}
+
+bool wzIsHeadless()
+{
+	return headlessMode;
+}
+
 // This stage, we handle display mode setting
 bool wzMainScreenSetup(int antialiasing, bool fullscreen, bool vsync, bool highDPI)
 {
@@ -1958,6 +2006,20 @@ void wzGetWindowToRendererScaleFactor(float *horizScaleFactor, float *vertScaleF
 //
 void wzGetGameToRendererScaleFactor(float *horizScaleFactor, float *vertScaleFactor)
 {
+	if (headlessMode)
+	{
+		// Nothing is rendered, so there is no drawable to compare against.
+		if (horizScaleFactor != nullptr)
+		{
+			*horizScaleFactor = 1.f;
+		}
+		if (vertScaleFactor != nullptr)
+		{
+			*vertScaleFactor = 1.f;
+		}
+		return;
+	}
+
 	float horizWindowScaleFactor = 0.f, vertWindowScaleFactor = 0.f;
 	wzGetWindowToRendererScaleFactor(&horizWindowScaleFactor, &vertWindowScaleFactor);
 	assert(horizWindowScaleFactor != 0.f);
@@ -1975,6 +2037,10 @@ void wzGetGameToRendererScaleFactor(float *horizScaleFactor, float *vertScaleFac
 
 void wzSetWindowIsResizable(bool resizable)
 {
+	if (headlessMode)
+	{
+		return;
+	}
 	assert(WZwindow != nullptr);
 	SDL_bool sdl_resizable = (resizable) ? SDL_TRUE : SDL_FALSE;
 	SDL_SetWindowResizable(WZwindow, sdl_resizable);
@@ -2155,7 +2221,11 @@ void wzShutdown()
 {
 	// order is important!
 	sdlFreeCursors();
-	SDL_DestroyWindow(WZwindow);
+	if (WZwindow != nullptr)
+	{
+		SDL_DestroyWindow(WZwindow);
+		WZwindow = nullptr;
+	}
 	SDL_Quit();
 	appPtr->quit();
 	delete appPtr;
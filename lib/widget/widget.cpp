@@ -24,6 +24,7 @@
 #include "lib/framework/frame.h"
 #include "lib/framework/string_ext.h"
 #include "lib/framework/utf.h"
+#include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/textdraw.h"
 #include "lib/ivis_opengl/pieblitfunc.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -938,6 +939,11 @@ void WIDGET::displayRecursive(int xOffset, int yOffset)
  */
 void widgDisplayScreen(W_SCREEN *psScreen)
 {
+	if (wzIsHeadless())
+	{
+		return;
+	}
+
 	// To toggle debug bounding boxes: Press: Left Shift   --  --  --------------
 	//                                        Left Ctrl  ------------  --  --  ----
 	static const int debugSequence[] = { -1, 0, 1, 3, 1, 3, 1, 3, 2, 3, 2, 3, 2, 3, 1, 0, -1};
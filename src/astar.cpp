@@ -35,9 +35,13 @@
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
- *  stored in the PathExploredTile 2D array of tiles.
+ *  Up to 8 pathfinding maps from A* are cached per context cache,  in a LRU list. The
+ *  PathNode heap contains  the priority-heap-sorted  nodes which are to  be explored.
+ *  The path back is stored in the PathExploredTile 2D array of tiles.
+ *  Each job  is assigned to one of FPATH_CONTEXT_CACHES  context caches,  based on the
+ *  destination tile, so  that all jobs which could share a Context use the same cache.
+ *  Each cache is only used by one pathfinding thread, and its jobs are processed in the
+ *  order they were queued, so the results do not depend on the number of threads.
  */
 
 #ifndef WZ_TESTING
@@ -45,8 +49,10 @@
 
 #include "astar.h"
 #include "map.h"
+#include "pathcluster.h"
 #endif
 
+#include <chrono>
 #include <list>
 #include <vector>
 #include <algorithm>
@@ -129,6 +135,7 @@ struct PathBlockingMap
 	PathBlockingType type;
 	std::vector<bool> map;
 	std::vector<bool> dangerMap;	// using threatBits
+	std::shared_ptr<PathClusterGraph const> clusterGraph;  ///< Cluster graph of map, for planning long routes.
 };
 
 struct PathNonblockingArea
@@ -157,7 +164,7 @@ struct PathNonblockingArea
 // Data structures used for pathfinding, can contain cached results.
 struct PathfindContext
 {
-	PathfindContext() : myGameTime(0), iteration(0), blockingMap(nullptr) {}
+	PathfindContext() : myGameTime(0), iteration(0), blockingMap(nullptr), corridor(nullptr) {}
 	bool isBlocked(int x, int y) const
 	{
 		if (dstIgnore.isNonblocking(x, y))
@@ -165,7 +172,7 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth] || (corridor != nullptr && !corridor->contains(x, y));
 	}
 	bool isDangerous(int x, int y) const
 	{
@@ -181,6 +188,7 @@ struct PathfindContext
 		blockingMap = blockingMap_;
 		tileS = tileS_;
 		dstIgnore = dstIgnore_;
+		corridor = nullptr;
 		myGameTime = blockingMap->type.gameTime;
 		nodes.clear();
 
@@ -208,16 +216,60 @@ struct PathfindContext
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+	PathClusterCorridor const *corridor;  ///< If set, only tiles in these clusters are considered nonblocking.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/// Maximum number of contexts in each context cache.
+#define FPATH_CONTEXTS_PER_CACHE 8
+
+/// A set of cached contexts, only ever used by one pathfinding thread at a time.
+struct PathfindContextCache
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	std::vector<Vector2i> path;           ///< Route being built by fpathAStarRoute, kept to save allocations.
+	PathfindContext corridorContext;      ///< Context for searches limited to a corridor of clusters, which can't be reused for other searches.
+	PathClusterCorridor corridor;         ///< Corridor used by corridorContext.
+};
+
+/// Context caches, indexed by PATHJOB::contextCache.
+static PathfindContextCache fpathContextCaches[FPATH_CONTEXT_CACHES];
+
+/// Minimum estimated route length for planning the route with the cluster graph first.
+#define FPATH_CLUSTER_MIN_ESTIMATE (3 * PATH_CLUSTER_SIZE * 140)
+
+/// Most recent cluster graph for each kind of blocking map, for incrementally updating the graph when the map changes.
+static std::vector<std::pair<PathBlockingType, std::shared_ptr<PathClusterGraph const>>> fpathClusterGraphs;
 
 /// Lists of blocking maps from current tick.
 static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
 /// Game time for all blocking maps in fpathBlockingMaps.
 static uint32_t fpathCurrentGameTime;
 
+/// If a blocking map has not been updated for this many changed rectangles, it is rebuilt instead of patched.
+#define FPATH_MAX_PENDING_RECTS 1024
+
+/// Most recent blocking map for each kind of map, and the tiles changed since, for building the next map by only updating the changed tiles.
+struct PathBlockingCache
+{
+	PROPULSION_TYPE propulsion;
+	int owner;
+	FPATH_MOVETYPE moveType;
+	std::shared_ptr<PathBlockingMap> map;
+	uint32_t checksumMap = 0;
+	uint32_t checksumDangerMap = 0;
+	unsigned threatGeneration = 0;               ///< auxThreatGeneration[owner] when the danger map was built.
+	unsigned auxMapGeneration = 0;               ///< auxMapGeneration when the map was built, which changes when switching between missions.
+	int width = 0, height = 0;
+	int scrollMinX = 0, scrollMinY = 0, scrollMaxX = 0, scrollMaxY = 0;
+	std::vector<AuxDirtyRect> pendingRects;      ///< Rectangles changed since map was built.
+	bool pendingFull = false;                    ///< Too much changed since map was built, so rebuild it.
+};
+static std::vector<PathBlockingCache> fpathBlockingCaches;
+/// Factors used for the blocking map checksums, fpathChecksumFactors[i] = 3*fpathChecksumFactors[i - 1] + 1.
+static std::vector<uint32_t> fpathChecksumFactors;
+/// Statistics on how blocking maps were built.
+static FPATH_BLOCKING_STATISTICS fpathBlockingStatistics;
+
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
 static const Vector2i aDirOffset[] =
@@ -234,8 +286,15 @@ static const Vector2i aDirOffset[] =
 
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
+	for (auto &cache : fpathContextCaches)
+	{
+		cache.contexts.clear();
+		cache.path.clear();
+		cache.corridorContext = PathfindContext();
+	}
+	fpathClusterGraphs.clear();
 	fpathBlockingMaps.clear();
+	fpathBlockingCaches.clear();
 }
 
 /** Get the nearest entry in the open list
@@ -432,6 +491,20 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	return nearestCoord;
 }
 
+/// Returns true if the tiles are on the same continent for the propulsion type, so that there may be a route between them.
+static bool fpathSameContinent(PathCoord a, PathCoord b, PROPULSION_TYPE propulsion)
+{
+	switch (propulsion)
+	{
+	case PROPULSION_TYPE_LIFT:
+		return true;
+	case PROPULSION_TYPE_HOVER:
+		return mapTile(a.x, a.y)->hoverContinent == mapTile(b.x, b.y)->hoverContinent;
+	default:
+		return mapTile(a.x, a.y)->limitedContinent == mapTile(b.x, b.y)->limitedContinent;
+	}
+}
+
 static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore)
 {
 	context.assign(blockingMap, tileS, dstIgnore);
@@ -441,6 +514,30 @@ static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlock
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
+/// Tries to find a long route by first finding which clusters it passes through, and then searching only those clusters.
+static bool fpathAStarCorridorRoute(PathfindContextCache &cache, PATHJOB *psJob, PathCoord tileOrig, PathCoord tileDest, PathNonblockingArea dstIgnore)
+{
+	std::shared_ptr<PathBlockingMap> &blockingMap = psJob->blockingMap;
+	if (blockingMap->clusterGraph == nullptr || !blockingMap->dangerMap.empty() || dstIgnore != PathNonblockingArea())
+	{
+		return false;  // The cluster graph does not know about danger or structures at the destination.
+	}
+	if (fpathEstimate(tileOrig, tileDest) < FPATH_CLUSTER_MIN_ESTIMATE || !fpathSameContinent(tileOrig, tileDest, psJob->propulsion))
+	{
+		return false;  // Short route, or no route at all, so planning with the cluster graph would not help.
+	}
+	if (!fpathClusterCorridor(*blockingMap->clusterGraph, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), cache.corridor))
+	{
+		return false;
+	}
+
+	PathfindContext &context = cache.corridorContext;
+	fpathInitContext(context, blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+	context.corridor = &cache.corridor;
+	context.nearestCoord = fpathAStarExplore(context, tileDest);
+	return context.nearestCoord == tileDest;
+}
+
 ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 {
 	ASR_RETVAL      retval = ASR_OK;
@@ -453,6 +550,11 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 	PathCoord endCoord;  // Either nearest coord (mustReverse = true) or orig (mustReverse = false).
 
+	ASSERT_OR_RETURN(ASR_FAILED, psJob->contextCache < FPATH_CONTEXT_CACHES, "Bad context cache %u", psJob->contextCache);
+	PathfindContextCache &cache = fpathContextCaches[psJob->contextCache];
+	std::list<PathfindContext> &fpathContexts = cache.contexts;
+	bool usedCorridor = false;
+
 	std::list<PathfindContext>::iterator contextIterator = fpathContexts.begin();
 	for (contextIterator = fpathContexts.begin(); contextIterator != fpathContexts.end(); ++contextIterator)
 	{
@@ -491,20 +593,29 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	{
 		// We did not find an appropriate context. Make one.
 
-		if (fpathContexts.size() < 30)
+		if (fpathContexts.size() < FPATH_CONTEXTS_PER_CACHE)
 		{
 			fpathContexts.push_back(PathfindContext());
 		}
 		--contextIterator;
 
-		// Init a new context, overwriting the oldest one if we are caching too many.
-		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
-		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
-		endCoord = fpathAStarExplore(*contextIterator, tileDest);
-		contextIterator->nearestCoord = endCoord;
+		if (fpathAStarCorridorRoute(cache, psJob, tileOrig, tileDest, dstIgnore))
+		{
+			// Found the route in the corridor context. The oldest context will be overwritten below, for searching from dest.
+			endCoord = tileDest;
+			usedCorridor = true;
+		}
+		else
+		{
+			// Init a new context, overwriting the oldest one if we are caching too many.
+			// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
+			fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+			endCoord = fpathAStarExplore(*contextIterator, tileDest);
+			contextIterator->nearestCoord = endCoord;
+		}
 	}
 
-	PathfindContext &context = *contextIterator;
+	PathfindContext &context = usedCorridor ? cache.corridorContext : *contextIterator;
 
 	// return the nearest route if no actual route was found
 	if (context.nearestCoord != tileDest)
@@ -513,7 +624,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
+	std::vector<Vector2i> &path = fpathContextCaches[psJob->contextCache].path;
 	path.clear();
 
 	Vector2i newP(0, 0);
@@ -578,7 +689,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		if (!context.isBlocked(tileOrig.x, tileOrig.y))  // If blocked, searching from tileDest to tileOrig wouldn't find the tileOrig tile.
 		{
 			// Next time, search starting from nearest reachable tile to the destination.
-			fpathInitContext(context, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore);
+			fpathInitContext(*contextIterator, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore);
 		}
 	}
 	else
@@ -598,6 +709,26 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+FPATH_BLOCKING_STATISTICS fpathGetBlockingStatistics(bool reset)
+{
+	FPATH_BLOCKING_STATISTICS stats = fpathBlockingStatistics;
+	if (reset)
+	{
+		fpathBlockingStatistics = FPATH_BLOCKING_STATISTICS();
+	}
+	return stats;
+}
+
+/// Returns true if the cached map can't be updated using only the changed rectangles, since the map size, scroll limits or aux maps changed.
+static bool fpathBlockingCacheStale(PathBlockingCache const &cache)
+{
+	return cache.map == nullptr || cache.pendingFull ||
+	       cache.width != mapWidth || cache.height != mapHeight ||
+	       cache.auxMapGeneration != auxMapGeneration ||
+	       cache.scrollMinX != scrollMinX || cache.scrollMinY != scrollMinY ||
+	       cache.scrollMaxX != scrollMaxX || cache.scrollMaxY != scrollMaxY;
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
 	if (fpathCurrentGameTime != gameTime)
@@ -605,6 +736,22 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 		// New tick, remove maps which are no longer needed.
 		fpathCurrentGameTime = gameTime;
 		fpathBlockingMaps.clear();
+
+		// Remember which tiles changed since the previous maps were built.
+		static std::vector<AuxDirtyRect> rects;
+		auxTakeDirtyRects(rects);
+		for (PathBlockingCache &cache : fpathBlockingCaches)
+		{
+			if (cache.pendingFull || cache.pendingRects.size() + rects.size() > FPATH_MAX_PENDING_RECTS)
+			{
+				cache.pendingFull = true;
+				cache.pendingRects.clear();
+			}
+			else
+			{
+				cache.pendingRects.insert(cache.pendingRects.end(), rects.begin(), rects.end());
+			}
+		}
 	}
 
 	// Figure out which map we are looking for.
@@ -620,35 +767,133 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 	});
 	if (i == fpathBlockingMaps.end())
 	{
-		// Didn't find the map, so i does not point to a map.
-		PathBlockingMap *blockMap = new PathBlockingMap();
-		fpathBlockingMaps.emplace_back(blockMap);
+		// Didn't find the map, so build it, preferably by updating the most recent map of the same kind.
+		auto cache = std::find_if(fpathBlockingCaches.begin(), fpathBlockingCaches.end(), [&](PathBlockingCache const &c) {
+			return c.propulsion == type.propulsion && c.owner == type.owner && c.moveType == type.moveType;
+		});
+		if (cache == fpathBlockingCaches.end())
+		{
+			fpathBlockingCaches.emplace_back();
+			cache = fpathBlockingCaches.end() - 1;
+			cache->propulsion = type.propulsion;
+			cache->owner = type.owner;
+			cache->moveType = type.moveType;
+		}
 
-		// blockMap now points to an empty map with no data. Fill the map.
-		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
+		const int numTiles = mapWidth * mapHeight;
+		if (fpathChecksumFactors.size() != 2 * (size_t)numTiles)
+		{
+			fpathChecksumFactors.resize(2 * numTiles);
+			uint32_t factor = 0;
+			for (uint32_t &f : fpathChecksumFactors)
+			{
+				f = factor = 3 * factor + 1;
+			}
+		}
+
+		auto startTime = std::chrono::high_resolution_clock::now();
+		bool incremental = !fpathBlockingCacheStale(*cache);
+		std::shared_ptr<PathBlockingMap> blockMap;
+		uint32_t checksumMap = 0, checksumDangerMap = 0;
+		if (incremental)
+		{
+			// Copy the previous map, and only recalculate the tiles which changed since.
+			blockMap = std::make_shared<PathBlockingMap>(*cache->map);
+			checksumMap = cache->checksumMap;
+			checksumDangerMap = cache->checksumDangerMap;
+			std::vector<bool> &map = blockMap->map;
+			for (AuxDirtyRect const &rect : cache->pendingRects)
 			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
+				for (int y = std::max(rect.y1, 0); y < std::min(rect.y2, mapHeight); ++y)
+					for (int x = std::max(rect.x1, 0); x < std::min(rect.x2, mapWidth); ++x)
+					{
+						bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+						if (map[x + y * mapWidth] != blocking)
+						{
+							map[x + y * mapWidth] = blocking;
+							checksumMap ^= fpathChecksumFactors[x + y * mapWidth];
+						}
+						++fpathBlockingStatistics.tilesUpdated;
+					}
 			}
-		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
+		}
+		else
+		{
+			blockMap = std::make_shared<PathBlockingMap>();
+			std::vector<bool> &map = blockMap->map;
+			map.resize(numTiles);
+			for (int y = 0; y < mapHeight; ++y)
+				for (int x = 0; x < mapWidth; ++x)
+				{
+					map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+					checksumMap ^= map[x + y * mapWidth] * fpathChecksumFactors[x + y * mapWidth];
+				}
+		}
+		blockMap->type = type;
+
+		// The threat bits are all replaced at once when the danger map is updated, so rebuild the whole danger map if they changed.
+		unsigned threatGeneration = type.owner < MAX_PLAYERS ? auxThreatGeneration[type.owner] : 0;
+		std::vector<bool> &dangerMap = blockMap->dangerMap;
+		if (isHumanPlayer(type.owner) || type.moveType != FMT_MOVE)
+		{
+			dangerMap.clear();
+			checksumDangerMap = 0;
+		}
+		else if (!incremental || dangerMap.empty() || cache->threatGeneration != threatGeneration)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
+			dangerMap.resize(numTiles);
+			checksumDangerMap = 0;
 			for (int y = 0; y < mapHeight; ++y)
 				for (int x = 0; x < mapWidth; ++x)
 				{
 					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
+					checksumDangerMap ^= dangerMap[x + y * mapWidth] * fpathChecksumFactors[numTiles + x + y * mapWidth];
 				}
 		}
 		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
 
-		psJob->blockingMap = fpathBlockingMaps.back();
+		using microDuration = std::chrono::duration<uint64_t, std::micro>;
+		uint64_t buildTime = std::chrono::duration_cast<microDuration>(std::chrono::high_resolution_clock::now() - startTime).count();
+		if (incremental)
+		{
+			++fpathBlockingStatistics.incrementalBuilds;
+			fpathBlockingStatistics.incrementalTime += buildTime;
+		}
+		else
+		{
+			++fpathBlockingStatistics.fullBuilds;
+			fpathBlockingStatistics.fullTime += buildTime;
+		}
+
+		// Remember the map, for updating it next time.
+		cache->map = blockMap;
+		cache->checksumMap = checksumMap;
+		cache->checksumDangerMap = checksumDangerMap;
+		cache->threatGeneration = threatGeneration;
+		cache->auxMapGeneration = auxMapGeneration;
+		cache->width = mapWidth;
+		cache->height = mapHeight;
+		cache->scrollMinX = scrollMinX;
+		cache->scrollMinY = scrollMinY;
+		cache->scrollMaxX = scrollMaxX;
+		cache->scrollMaxY = scrollMaxY;
+		cache->pendingRects.clear();
+		cache->pendingFull = false;
+
+		// Update the cluster graph for this kind of map, which only recalculates the clusters where the map changed.
+		auto graph = std::find_if(fpathClusterGraphs.begin(), fpathClusterGraphs.end(), [&](std::pair<PathBlockingType, std::shared_ptr<PathClusterGraph const>> const &g) {
+			return fpathIsEquivalentBlocking(g.first.propulsion, g.first.owner, g.first.moveType, type.propulsion, type.owner, type.moveType);
+		});
+		if (graph == fpathClusterGraphs.end())
+		{
+			fpathClusterGraphs.emplace_back(type, nullptr);
+			graph = fpathClusterGraphs.end() - 1;
+		}
+		graph->second = fpathClusterGraphUpdate(graph->second, blockMap->map, mapWidth, mapHeight);
+		blockMap->clusterGraph = graph->second;
+
+		fpathBlockingMaps.push_back(blockMap);
+		psJob->blockingMap = blockMap;
 	}
 	else
 	{
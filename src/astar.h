@@ -34,7 +34,18 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
+/** Number of independent pathfinding context caches.
+ *
+ *  Jobs are assigned to a cache by destination tile (see fpathContextCache), and each cache is only used by one thread.
+ *  This must not depend on the number of pathfinding threads, since cached contexts can affect the resulting paths.
+ *
+ *  @ingroup pathfinding
+ */
+#define FPATH_CONTEXT_CACHES 4
+
 /** Use the A* algorithm to find a path
+ *
+ *  Uses the context cache given by psJob->contextCache, which must not be in use by any other thread.
  *
  *  @ingroup pathfinding
  */
@@ -44,6 +55,23 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob);
 /// Sets psJob->blockingMap for later use by pathfinding thread, generating the required map if not already generated.
 void fpathSetBlockingMap(PATHJOB *psJob);
 
+/** Statistics on building the blocking maps, for checking how often they can be updated instead of rebuilt.
+ *
+ *  @ingroup pathfinding
+ */
+struct FPATH_BLOCKING_STATISTICS
+{
+	unsigned fullBuilds = 0;          ///< Number of maps built from scratch.
+	unsigned incrementalBuilds = 0;   ///< Number of maps built by updating the changed tiles of the previous map.
+	uint64_t tilesUpdated = 0;        ///< Number of tiles recalculated by incremental builds.
+	uint64_t fullTime = 0;            ///< Total time spent on full builds, in microseconds.
+	uint64_t incrementalTime = 0;     ///< Total time spent on incremental builds, in microseconds.
+};
+
+/// Call from main thread.
+/// Get the blocking map statistics, and optionally reset the counters.
+FPATH_BLOCKING_STATISTICS fpathGetBlockingStatistics(bool reset);
+
 /** Clean up the path finding node table.
  *
  *  @note Call this on shutdown to prevent memory from leaking, or if loading/saving, to prevent stale data from being reused.
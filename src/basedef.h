@@ -133,6 +133,8 @@ struct BASE_OBJECT : public SIMPLE_OBJECT
 	WEAPON              asWeaps[MAX_WEAPONS];
 
 	std::bitset<OBJECT_FLAG_COUNT> flags;
+	unsigned            gridIndex = UINT32_MAX;     ///< Index in the grid after the last gridReset, only used as a hint when updating the grid.
+	unsigned            visQueueIndex = UINT32_MAX; ///< Index in the queue of visTilesUpdateQueued, or UINT32_MAX if not queued.
 
 	NEXTOBJ             psNext;                     ///< Pointer to the next object in the object list
 	NEXTOBJ             psNextFunc;                 ///< Pointer to the next object in the function list
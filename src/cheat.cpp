@@ -81,6 +81,14 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"showorders", kf_ToggleOrders}, //displays unit order/action state.
 	{"pause", kf_TogglePauseMode}, // Pause the game.
 	{"power info", kf_PowerInfo},
+	{"path info", kf_PathInfo},	// pathfinding queue statistics
+	{"id lookup info", kf_IdLookupInfo},	// time looking up objects by id
+	{"grid info", kf_GridInfo},	// time rebuilding and updating the object grid
+	{"projectile info", kf_ProjectileInfo},	// projectile memory use
+	{"effect info", kf_EffectInfo},	// number of effects, and how many were dropped
+	{"net benchmark", kf_NetBenchmark},	// time encoding and decoding droid orders, and relaying messages through the queues
+	{"socket benchmark", kf_SocketBenchmark},	// time receiving messages from many clients over loopback sockets
+	{"tick profile", kf_ToggleTickProfile},	// time each phase of the game state updates, writes tick-performance.csv
 	{"reload me", kf_Reload},	// reload selected weapons immediately
 	{"desync me", kf_ForceDesync},
 	{"damage me", kf_DamageMe},
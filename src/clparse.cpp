@@ -77,8 +77,13 @@ typedef struct _poptContext
 
 /// Enable automatic test games
 static bool wz_autogame = false;
+/// Run without a window, GL context or sound
+static bool wz_headless = false;
 static std::string wz_saveandquit;
 static std::string wz_test;
+static std::string wz_replay;
+static std::string wz_convert;
+static bool wz_convert_binary = false;
 
 static void poptPrintHelp(poptContext ctx, FILE *output)
 {
@@ -247,6 +252,10 @@ typedef enum
 	CLI_AUTOGAME,
 	CLI_SAVEANDQUIT,
 	CLI_SKIRMISH,
+	CLI_HEADLESS,
+	CLI_REPLAY,
+	CLI_SAVETOJSON,
+	CLI_SAVETOBINARY,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable()
@@ -282,6 +291,10 @@ static const struct poptOption *getOptionsTable()
 		{ "autogame", POPT_ARG_NONE, CLI_AUTOGAME,   N_("Run games automatically for testing"), nullptr },
 		{ "saveandquit", POPT_ARG_STRING, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name") },
 		{ "skirmish", POPT_ARG_STRING, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test") },
+		{ "headless", POPT_ARG_NONE, CLI_HEADLESS,   N_("Run the game as fast as possible without graphics or sound (implies --autogame)"), nullptr },
+		{ "replay", POPT_ARG_STRING, CLI_REPLAY,     N_("Play back a recorded skirmish or multiplayer game"), N_("replay file") },
+		{ "savetojson", POPT_ARG_STRING, CLI_SAVETOJSON, N_("Convert a binary savegame to JSON and exit"), N_("savegame directory") },
+		{ "savetobinary", POPT_ARG_STRING, CLI_SAVETOBINARY, N_("Convert a JSON savegame to binary and exit"), N_("savegame directory") },
 		// Terminating entry
 		{ nullptr, 0, 0,              nullptr,                                    nullptr },
 	};
@@ -649,9 +662,41 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			}
 			wz_test = token;
 			break;
+
+		case CLI_HEADLESS:
+			wz_headless = true;
+			wz_autogame = true;
+			break;
+
+		case CLI_REPLAY:
+			hostlaunch = 3;
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("No replay file given");
+			}
+			wz_replay = token;
+			break;
+
+		case CLI_SAVETOJSON:
+		case CLI_SAVETOBINARY:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr)
+			{
+				qFatal("No savegame directory given");
+			}
+			wz_convert = token;
+			wz_convert_binary = option == CLI_SAVETOBINARY;
+			break;
 		};
 	}
 
+	if (wz_headless && GetGameMode() == GS_TITLE_SCREEN && hostlaunch != 2 && hostlaunch != 3)
+	{
+		// There is no way to click through the menus without a window.
+		qFatal("--headless needs a game to start, use it together with --skirmish, --replay, --game, --loadskirmish or --loadcampaign");
+	}
+
 	return true;
 }
 
@@ -660,6 +705,11 @@ bool autogame_enabled()
 	return wz_autogame;
 }
 
+bool headless_enabled()
+{
+	return wz_headless;
+}
+
 const std::string &saveandquit_enabled()
 {
 	return wz_saveandquit;
@@ -669,3 +719,18 @@ const std::string &wz_skirmish_test()
 {
 	return wz_test;
 }
+
+const std::string &wz_replay_file()
+{
+	return wz_replay;
+}
+
+const std::string &wz_convert_savegame()
+{
+	return wz_convert;
+}
+
+bool wz_convert_to_binary()
+{
+	return wz_convert_binary;
+}
@@ -29,7 +29,11 @@ bool ParseCommandLine(int argc, const char * const *argv);
 bool ParseCommandLineEarly(int argc, const char * const *argv);
 
 bool autogame_enabled();
+bool headless_enabled();
 const std::string &saveandquit_enabled();
 const std::string &wz_skirmish_test();
+const std::string &wz_replay_file();
+const std::string &wz_convert_savegame();  ///< Savegame directory to convert with --savetojson or --savetobinary, if any.
+bool wz_convert_to_binary();
 
 #endif // __INCLUDED_SRC_CLPARSE_H__
@@ -50,6 +50,7 @@
 #include "ingameop.h"
 #include "multiint.h"
 #include "multiplay.h"
+#include "qtscript.h"
 #include "radar.h"
 #include "seqdisp.h"
 #include "texture.h"
@@ -131,6 +132,12 @@ bool loadConfig()
 	{
 		war_SetScrollEvent(ini.value("scrollEvent").toInt());
 	}
+	if (ini.contains("pathfindingThreads"))
+	{
+		war_SetPathfindingThreads(ini.value("pathfindingThreads").toInt());
+	}
+	war_SetBinarySaves(ini.value("binarySaves", false).toBool());
+	war_SetRecordReplays(ini.value("recordReplays", true).toBool());
 	rotateRadar = ini.value("rotateRadar", true).toBool();
 	radarRotationArrow = ini.value("radarRotationArrow", true).toBool();
 	hostQuitConfirmation = ini.value("hostQuitConfirmation", true).toBool();
@@ -141,6 +148,8 @@ bool loadConfig()
 	        ini.value("fontfacebold", "Bold").toString().toUtf8().constData());
 	NETsetMasterserverPort(ini.value("masterserver_port", MASTERSERVERPORT).toInt());
 	NETsetGameserverPort(ini.value("gameserver_port", GAMESERVERPORT).toInt());
+	NETsetCompressionLevel(ini.value("compressionLevel", 6).toInt());
+	setConcurrentScripts(ini.value("concurrentScripts", false).toBool());
 	war_SetFMVmode((FMV_MODE)ini.value("FMVmode", FMV_FULLSCREEN).toInt());
 	war_setScanlineMode((SCANLINE_MODE)ini.value("scanlines", SCANLINES_OFF).toInt());
 	seq_SetSubtitles(ini.value("subtitles", true).toBool());
@@ -251,6 +260,9 @@ bool saveConfig()
 	ini.setValue("cameraSpeed", war_GetCameraSpeed());	// camera speed
 	ini.setValue("radarJump", war_GetRadarJump());		// radar jump
 	ini.setValue("scrollEvent", war_GetScrollEvent());	// scroll event
+	ini.setValue("pathfindingThreads", war_GetPathfindingThreads());
+	ini.setValue("binarySaves", war_GetBinarySaves());
+	ini.setValue("recordReplays", war_GetRecordReplays());
 	ini.setValue("cameraAccel", getCameraAccel());		// camera acceleration
 	ini.setValue("mouseflip", (SDWORD)(getInvertMouseStatus()));	// flipmouse
 	ini.setValue("nomousewarp", (SDWORD)getMouseWarp());		// mouse warp
@@ -278,6 +290,8 @@ bool saveConfig()
 	ini.setValue("masterserver_name", NETgetMasterserverName());
 	ini.setValue("masterserver_port", NETgetMasterserverPort());
 	ini.setValue("gameserver_port", NETgetGameserverPort());
+	ini.setValue("compressionLevel", NETgetCompressionLevel());
+	ini.setValue("concurrentScripts", getConcurrentScripts());
 	if (!bMultiPlayer)
 	{
 		ini.setValue("colour", getPlayerColour(0));			// favourite colour.
@@ -1953,7 +1953,7 @@ void	dealWithLMB()
 			        mouseTileX, mouseTileY, world_coord(mouseTileX), world_coord(mouseTileY),
 			        (int)psTile->limitedContinent, (int)psTile->hoverContinent, psTile->level, (int)psTile->illumination,
 			        aux & AUXBITS_DANGER ? "danger" : "", aux & AUXBITS_THREAT ? "threat" : "",
-			        (int)psTile->watchers[selectedPlayer], (int)psTile->sensors[selectedPlayer], (int)psTile->jammers[selectedPlayer]);
+			        (int)mapTileVision(psTile)->watchers[selectedPlayer], (int)mapTileVision(psTile)->sensors[selectedPlayer], (int)mapTileVision(psTile)->jammers[selectedPlayer]);
 		}
 
 		return;
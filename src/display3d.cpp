@@ -27,6 +27,7 @@
 #include "lib/framework/opengl.h"
 #include "lib/framework/math_ext.h"
 #include "lib/framework/stdio_ext.h"
+#include "lib/framework/wzapp.h"
 
 /* Includes direct access to render library */
 #include "lib/ivis_opengl/pieblitfunc.h"
@@ -1195,7 +1196,8 @@ bool init3DView()
 	player.r.y = 0; // rotation
 	player.r.x = DEG(360 + INITIAL_STARTING_PITCH); // angle
 
-	if (!initTerrain())
+	// The terrain is only needed for drawing, and its buffers need a GL context.
+	if (!wzIsHeadless() && !initTerrain())
 	{
 		return false;
 	}
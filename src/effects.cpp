@@ -72,6 +72,8 @@
 #endif
 #include <glm/gtx/transform.hpp>
 
+#include <memory>
+
 #define	GRAVITON_GRAVITY	((float)-800)
 #define	EFFECT_X_FLIP		0x1
 #define	EFFECT_Y_FLIP		0x2
@@ -152,7 +154,72 @@
 #define SHOCKWAVE_SPEED	(GAME_TICKS_PER_SEC)
 #define	MAX_SHOCKWAVE_SIZE				500
 
-static std::list<EFFECT *> activeList;
+/* Number of effects allocated at once */
+#define EFFECT_CHUNK_SIZE				256
+/* Most effects of one group which may exist at once, and the number above which effects are only added where they can be seen */
+#define EFFECT_POOL_BUDGET				2048
+#define EFFECT_POOL_LOD_LIMIT			1024
+
+/// The live effects of one group. The effects are kept in chunks which never move, since the effect being updated and the
+/// render buckets point into them while more effects are added. A dead effect is replaced by the last one in the pool.
+class EffectPool
+{
+public:
+	size_t size() const
+	{
+		return count;
+	}
+	EFFECT &operator [](size_t index)
+	{
+		return chunks[index / EFFECT_CHUNK_SIZE][index % EFFECT_CHUNK_SIZE];
+	}
+	void push_back(EFFECT const &effect)
+	{
+		if (count == chunks.size() * EFFECT_CHUNK_SIZE)
+		{
+			chunks.emplace_back(new EFFECT[EFFECT_CHUNK_SIZE]);
+		}
+		(*this)[count++] = effect;
+	}
+	void swapRemove(size_t index)
+	{
+		--count;
+		if (index != count)
+		{
+			(*this)[index] = (*this)[count];
+		}
+	}
+	void clear()
+	{
+		count = 0;
+		chunks.clear();
+	}
+	/// Calls func(first, number) for each run of consecutive effects.
+	template<typename Func>
+	void forEachRun(Func func)
+	{
+		for (size_t start = 0; start < count; start += EFFECT_CHUNK_SIZE)
+		{
+			func(chunks[start / EFFECT_CHUNK_SIZE].get(), std::min<size_t>(count - start, EFFECT_CHUNK_SIZE));
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<EFFECT[]>> chunks;
+	size_t count = 0;
+};
+
+static EffectPool effectPools[EFFECT_FREED];
+
+/// Effects which spawn other effects are updated first, so that what they spawn is drawn straight away.
+static const EFFECT_GROUP effectUpdateOrder[EFFECT_FREED] =
+{
+	EFFECT_DESTRUCTION, EFFECT_SAT_LASER, EFFECT_FIREWORK, EFFECT_FIRE, EFFECT_GRAVITON,
+	EFFECT_CONSTRUCTION, EFFECT_WAYPOINT, EFFECT_EXPLOSION, EFFECT_SMOKE, EFFECT_BLOOD
+};
+
+/* Number of effects not added, since there were too many */
+static	size_t	effectsDropped = 0;
 
 /* Tick counts for updates on a particular interval */
 static	UDWORD	lastUpdateStructures[EFFECT_STRUCTURE_DIVISION];
@@ -207,16 +274,16 @@ static void effectSetupSatLaser(EFFECT *psEffect);
 static void effectSetupFirework(EFFECT *psEffect);
 
 static void effectStructureUpdates();
+static bool effectWanted(EFFECT const &effect, size_t poolSize);
 
 static UDWORD effectGetNumFrames(EFFECT *psEffect);
 
 void shutdownEffectsSystem()
 {
-	for (auto eff : activeList)
+	for (EffectPool &pool : effectPools)
 	{
-		delete eff;
+		pool.clear();
 	}
-	activeList.clear();
 }
 
 /*!
@@ -304,7 +371,8 @@ void addEffect(const Vector3i *pos, EFFECT_GROUP group, EFFECT_TYPE type, bool s
 	{
 		return;
 	}
-	EFFECT *psEffect = new EFFECT();
+	EFFECT effect;
+	EFFECT *psEffect = &effect;
 	/* Reset control bits */
 	psEffect->control = 0;
 
@@ -396,38 +464,109 @@ void addEffect(const Vector3i *pos, EFFECT_GROUP group, EFFECT_TYPE type, bool s
 	}
 
 	ASSERT(psEffect->imd != nullptr || group == EFFECT_DESTRUCTION || group == EFFECT_FIRE || group == EFFECT_SAT_LASER, "null effect imd");
+	ASSERT_OR_RETURN(, group < EFFECT_FREED, "Bad effect group %d", (int)group);
 
-	activeList.push_back(psEffect);
+	if (!effectWanted(effect, effectPools[group].size()))
+	{
+		++effectsDropped;
+		return;
+	}
+	effectPools[group].push_back(effect);
 }
 
+/** Decides whether to add an effect to a pool of the given size. Once there are many effects of a group, new ones are only
+    added where they can be seen, and beyond the budget not at all. Effects which matter, or spawn others, are always added. */
+static bool effectWanted(EFFECT const &effect, size_t poolSize)
+{
+	if (effect.control & EFFECT_ESSENTIAL)
+	{
+		return true;
+	}
+	switch (effect.group)
+	{
+	case EFFECT_WAYPOINT:
+	case EFFECT_DESTRUCTION:
+	case EFFECT_SAT_LASER:
+	case EFFECT_FIRE:
+	case EFFECT_FIREWORK:
+		return true;
+	default:
+		break;
+	}
+	if (poolSize >= EFFECT_POOL_BUDGET)
+	{
+		return false;
+	}
+	return poolSize < EFFECT_POOL_LOD_LIMIT || clipXY(effect.position.x, effect.position.z);
+}
+
+/** Moves effects by their velocity. Effects which don't exist yet stay put. Branch free, so the compiler can vectorise it. */
+static void moveEffects(EFFECT *effects, size_t count)
+{
+	const float fraction = graphicsTimeFraction;
+	const uint32_t now = graphicsTime;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float step = effects[i].birthTime <= now ? fraction : 0.f;
+		effects[i].position += effects[i].velocity * step;
+	}
+}
 
 /* Calls all the update functions for each different currently active effect */
 void processEffects(const glm::mat4 &viewMatrix)
 {
-	for (auto it = activeList.begin(); it != activeList.end(); )
+	for (EFFECT_GROUP group : effectUpdateOrder)
 	{
-		EFFECT *psEffect = *it;
+		EffectPool &pool = effectPools[group];
 
-		if (psEffect->birthTime <= graphicsTime)  // Don't process, if it doesn't exist yet
+		// Effects may be added to the pool while updating, and are then updated too.
+		for (size_t i = 0; i < pool.size();)
 		{
-			if (!updateEffect(psEffect))
+			EFFECT *psEffect = &pool[i];
+			if (psEffect->birthTime <= graphicsTime && !updateEffect(psEffect))  // Don't process, if it doesn't exist yet
 			{
-				delete psEffect;
-				it = activeList.erase(it);
+				pool.swapRemove(i);  // Brings in an effect which hasn't been updated yet.
 				continue;
 			}
-			if (psEffect->group != EFFECT_FREED && clipXY(psEffect->position.x, psEffect->position.z))
+			++i;
+		}
+
+		// Smoke and blood only drift, so move them all at once. Explosions don't move, apart from tesla explosions rising,
+		// and their update is spent on frames, lights and shockwaves, so there is nothing to batch for them.
+		if ((group == EFFECT_SMOKE || group == EFFECT_BLOOD) && !gamePaused())
+		{
+			pool.forEachRun(moveEffects);
+		}
+
+		for (size_t i = 0; i < pool.size(); ++i)
+		{
+			EFFECT *psEffect = &pool[i];
+			if (psEffect->birthTime <= graphicsTime && clipXY(psEffect->position.x, psEffect->position.z))
 			{
 				bucketAddTypeToList(RENDER_EFFECT, psEffect, viewMatrix);
 			}
 		}
-		++it;
 	}
 
 	/* Add any structure effects */
 	effectStructureUpdates();
 }
 
+size_t effectsCount()
+{
+	size_t count = 0;
+	for (EffectPool const &pool : effectPools)
+	{
+		count += pool.size();
+	}
+	return count;
+}
+
+size_t effectsDroppedCount()
+{
+	return effectsDropped;
+}
+
 /* The general update function for all effects - calls a specific one for each. Returns false if effect should be deleted. */
 static bool updateEffect(EFFECT *psEffect)
 {
@@ -800,10 +939,7 @@ static bool updateBlood(EFFECT *psEffect)
 			return false; /* Kill it off */
 		}
 	}
-	/* Move it about in the world */
-	psEffect->position.x += graphicsTimeAdjustedIncrement(psEffect->velocity.x);
-	psEffect->position.y += graphicsTimeAdjustedIncrement(psEffect->velocity.y);
-	psEffect->position.z += graphicsTimeAdjustedIncrement(psEffect->velocity.z);
+	/* Moved about in the world by moveEffects */
 	return true;
 }
 
@@ -841,10 +977,7 @@ static bool updatePolySmoke(EFFECT *psEffect)
 		}
 	}
 
-	/* Update position */
-	psEffect->position.x += graphicsTimeAdjustedIncrement(psEffect->velocity.x);
-	psEffect->position.y += graphicsTimeAdjustedIncrement(psEffect->velocity.y);
-	psEffect->position.z += graphicsTimeAdjustedIncrement(psEffect->velocity.z);
+	/* Position is updated by moveEffects */
 
 	/* If it doesn't get killed by frame number, then by age */
 	if (TEST_CYCLIC(psEffect))
@@ -2220,34 +2353,37 @@ bool writeFXData(const char *fileName)
 {
 	int i = 0;
 	WzConfig ini(WzString::fromUtf8(fileName), WzConfig::ReadAndWrite);
-	for (auto iter = activeList.cbegin(); iter != activeList.end(); ++iter, i++)
-	{
-		EFFECT *it = *iter;
-		ini.beginGroup("effect_" + WzString::number(i));
-		ini.setValue("control", it->control);
-		ini.setValue("group", it->group);
-		ini.setValue("type", it->type);
-		ini.setValue("frameNumber", it->frameNumber);
-		ini.setValue("size", it->size);
-		ini.setValue("baseScale", it->baseScale);
-		ini.setValue("specific", it->specific);
-		ini.setVector3f("position", it->position);
-		ini.setVector3f("velocity", it->velocity);
-		ini.setVector3i("rotation", it->rotation);
-		ini.setVector3i("spin", it->spin);
-		ini.setValue("birthTime", it->birthTime);
-		ini.setValue("lastFrame", it->lastFrame);
-		ini.setValue("frameDelay", it->frameDelay);
-		ini.setValue("lifeSpan", it->lifeSpan);
-		ini.setValue("radius", it->radius);
-
-		if (it->imd)
-		{
-			ini.setValue("imd_name", modelName(it->imd));
-		}
+	for (EFFECT_GROUP group : effectUpdateOrder)
+	{
+		for (size_t index = 0; index < effectPools[group].size(); ++index, i++)
+		{
+			EFFECT *it = &effectPools[group][index];
+			ini.beginGroup("effect_" + WzString::number(i));
+			ini.setValue("control", it->control);
+			ini.setValue("group", it->group);
+			ini.setValue("type", it->type);
+			ini.setValue("frameNumber", it->frameNumber);
+			ini.setValue("size", it->size);
+			ini.setValue("baseScale", it->baseScale);
+			ini.setValue("specific", it->specific);
+			ini.setVector3f("position", it->position);
+			ini.setVector3f("velocity", it->velocity);
+			ini.setVector3i("rotation", it->rotation);
+			ini.setVector3i("spin", it->spin);
+			ini.setValue("birthTime", it->birthTime);
+			ini.setValue("lastFrame", it->lastFrame);
+			ini.setValue("frameDelay", it->frameDelay);
+			ini.setValue("lifeSpan", it->lifeSpan);
+			ini.setValue("radius", it->radius);
+
+			if (it->imd)
+			{
+				ini.setValue("imd_name", modelName(it->imd));
+			}
 
-		// Move on to reading the next effect
-		ini.endGroup();
+			// Move on to reading the next effect
+			ini.endGroup();
+		}
 	}
 
 	// Everything is just fine!
@@ -2266,7 +2402,8 @@ bool readFXData(const char *fileName)
 	for (int i = 0; i < list.size(); ++i)
 	{
 		ini.beginGroup(list[i]);
-		EFFECT *curEffect = new EFFECT();
+		EFFECT effect;
+		EFFECT *curEffect = &effect;
 
 		curEffect->control      = ini.value("control").toInt();
 		curEffect->group        = (EFFECT_GROUP)ini.value("group").toInt();
@@ -2300,7 +2437,12 @@ bool readFXData(const char *fileName)
 		// Move on to reading the next effect
 		ini.endGroup();
 
-		activeList.push_back(curEffect);
+		if (curEffect->group < 0 || curEffect->group >= EFFECT_FREED)
+		{
+			debug(LOG_ERROR, "Skipping %s, which has bad group %d", list[i].toUtf8().c_str(), (int)curEffect->group);
+			continue;
+		}
+		effectPools[curEffect->group].push_back(effect);
 	}
 
 	/* Hopefully everything's just fine by now */
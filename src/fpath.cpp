@@ -29,6 +29,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
+#include "lib/framework/math_ext.h"
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
@@ -37,6 +38,7 @@
 #include "map.h"
 #include "multiplay.h"
 #include "astar.h"
+#include "warzoneconfig.h"
 
 #include "fpath.h"
 
@@ -56,47 +58,60 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = nullptr;
-static WZ_MUTEX         *fpathMutex = nullptr;
-static WZ_SEMAPHORE     *fpathSemaphore = nullptr;
 using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+struct QueuedPathJob
+{
+	packagedPathJob task;
+	int             queuedTime;     ///< wzGetTicks() when the job was queued, for statistics.
+};
+struct PathWorker
+{
+	WZ_THREAD               *thread = nullptr;
+	WZ_SEMAPHORE            *semaphore = nullptr;  ///< Posted when jobs becomes non-empty.
+	std::list<QueuedPathJob> jobs;                 ///< Jobs for the context caches handled by this thread, in the order they were queued.
+};
+static WZ_MUTEX         *fpathMutex = nullptr;     ///< Protects the job lists and fpathStatistics.
+static std::vector<PathWorker> pathWorkers;         ///< Context cache n is handled by pathWorkers[n % pathWorkers.size()].
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
-
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = nullptr;
+static FPATH_STATISTICS fpathStatistics;
 
 static PATHRESULT fpathExecute(PATHJOB psJob);
 
 
 /** This runs in a separate thread */
-static int fpathThreadFunc(void *)
+static int fpathThreadFunc(void *data)
 {
+	PathWorker &worker = *static_cast<PathWorker *>(data);
+
 	wzMutexLock(fpathMutex);
 
-	while (!fpathQuit)
+	while (true)
 	{
-		if (pathJobs.empty())
+		if (worker.jobs.empty())
 		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			if (fpathQuit)
+			{
+				break;  // Only quit once all queued jobs are done, so that no droid is left waiting for a result which never comes.
+			}
 			wzMutexUnlock(fpathMutex);
-			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
+			wzSemaphoreWait(worker.semaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
 			continue;
 		}
 
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		// Run the first job in the queue, leaving it in the queue so that fpathJobQueueLength counts it.
+		QueuedPathJob &job = worker.jobs.front();
 
 		wzMutexUnlock(fpathMutex);
-		job();
+		job.task();
+		int latency = wzGetTicks() - job.queuedTime;
 		wzMutexLock(fpathMutex);
 
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
+		worker.jobs.pop_front();
+		--fpathStatistics.queueLength;
+		++fpathStatistics.jobsDone;
+		fpathStatistics.totalLatency += latency;
+		fpathStatistics.maxLatency = std::max<unsigned>(fpathStatistics.maxLatency, latency);
 	}
 	wzMutexUnlock(fpathMutex);
 	return 0;
@@ -109,13 +124,27 @@ bool fpathInitialise()
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	if (pathWorkers.empty())
 	{
+		// More threads than context caches would never have anything to do.
+		int numThreads = war_GetPathfindingThreads();
+		if (numThreads <= 0)
+		{
+			numThreads = wzGetCPUCount() - 1;  // Leave a core for the main thread.
+		}
+		numThreads = clip(numThreads, 1, FPATH_CONTEXT_CACHES);
+
 		fpathMutex = wzMutexCreate();
-		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, nullptr);
-		wzThreadStart(fpathThread);
+		fpathStatistics = FPATH_STATISTICS();
+		fpathStatistics.threads = numThreads;
+		pathWorkers.resize(numThreads);  // Must not be resized while the threads are running, since they keep a reference to their PathWorker.
+		for (PathWorker &worker : pathWorkers)
+		{
+			worker.semaphore = wzSemaphoreCreate(0);
+			worker.thread = wzThreadCreate(fpathThreadFunc, &worker);
+			wzThreadStart(worker.thread);
+		}
+		debug(LOG_WZ, "Started %d pathfinding threads", numThreads);
 	}
 
 	return true;
@@ -124,20 +153,23 @@ bool fpathInitialise()
 
 void fpathShutdown()
 {
-	if (fpathThread)
+	if (!pathWorkers.empty())
 	{
-		// Signal the path finding thread to quit
+		// Signal the path finding threads to quit
 		fpathQuit = true;
-		wzSemaphorePost(fpathSemaphore);  // Wake up thread.
+		for (PathWorker &worker : pathWorkers)
+		{
+			wzSemaphorePost(worker.semaphore);  // Wake up thread.
+		}
 
-		wzThreadJoin(fpathThread);
-		fpathThread = nullptr;
+		for (PathWorker &worker : pathWorkers)
+		{
+			wzThreadJoin(worker.thread);
+			wzSemaphoreDestroy(worker.semaphore);
+		}
+		pathWorkers.clear();
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = nullptr;
-		wzSemaphoreDestroy(fpathSemaphore);
-		fpathSemaphore = nullptr;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = nullptr;
 	}
 	fpathHardTableReset();
 }
@@ -292,6 +324,13 @@ static Position findNonblockingPosition(Position pos, PROPULSION_TYPE propulsion
 
 
 
+/// Chooses the context cache for a job. All jobs to the same destination tile must use the same cache, since only those can share a context.
+static unsigned fpathContextCache(int destX, int destY)
+{
+	return (unsigned)(map_coord(destX) * 7 + map_coord(destY) * 13) % FPATH_CONTEXT_CACHES;
+}
+
+
 static void fpathSetMove(MOVE_CONTROL *psMoveCntl, SDWORD targetX, SDWORD targetY)
 {
 	psMoveCntl->asPath.resize(1);
@@ -380,6 +419,7 @@ queuePathfinding:
 	job.moveType = moveType;
 	job.owner = owner;
 	job.acceptNearest = acceptNearest;
+	job.contextCache = fpathContextCache(tX, tY);
 	job.deleted = false;
 	fpathSetBlockingMap(&job);
 
@@ -388,18 +428,23 @@ queuePathfinding:
 	// job or result for each droid in the system at any time.
 	fpathRemoveDroidData(id);
 
-	packagedPathJob task([job]() { return fpathExecute(job); });
-	pathResults[id] = task.get_future();
+	QueuedPathJob queuedJob;
+	queuedJob.task = packagedPathJob([job]() { return fpathExecute(job); });
+	queuedJob.queuedTime = wzGetTicks();
+	pathResults[id] = queuedJob.task.get_future();
 
-	// Add to end of list
+	// Add to end of list of the thread handling the context cache
+	PathWorker &worker = pathWorkers[job.contextCache % pathWorkers.size()];
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
+	bool isFirstJob = worker.jobs.empty();
+	worker.jobs.push_back(std::move(queuedJob));
+	++fpathStatistics.queueLength;
+	fpathStatistics.maxQueueLength = std::max(fpathStatistics.maxQueueLength, fpathStatistics.queueLength);
 	wzMutexUnlock(fpathMutex);
 
 	if (isFirstJob)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		wzSemaphorePost(worker.semaphore);  // Wake up processing thread.
 	}
 
 	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
@@ -499,13 +544,30 @@ PATHRESULT fpathExecute(PATHJOB job)
 	return result;
 }
 
+FPATH_STATISTICS fpathGetStatistics(bool reset)
+{
+	ASSERT_OR_RETURN(FPATH_STATISTICS(), fpathMutex != nullptr, "Pathfinding not initialised");
+
+	wzMutexLock(fpathMutex);
+	FPATH_STATISTICS stats = fpathStatistics;
+	if (reset)
+	{
+		fpathStatistics.maxQueueLength = fpathStatistics.queueLength;
+		fpathStatistics.jobsDone = 0;
+		fpathStatistics.totalLatency = 0;
+		fpathStatistics.maxLatency = 0;
+	}
+	wzMutexUnlock(fpathMutex);
+	return stats;
+}
+
 /** Find the length of the job queue. Function is thread-safe. */
 static int fpathJobQueueLength()
 {
 	int count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	count = fpathStatistics.queueLength;
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -539,10 +601,9 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength();
 
 	/* Check initial state */
-	assert(fpathThread != nullptr);
+	assert(!pathWorkers.empty());
 	assert(fpathMutex != nullptr);
-	assert(fpathSemaphore != nullptr);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -608,7 +669,7 @@ void fpathTest(int x, int y, int x2, int y2)
 	{
 		fpathRemoveDroidData(i);
 	}
-	//assert(pathJobs.empty()); // can now be marked .deleted as well
+	//assert(fpathJobQueueLength() == 0); // can now be marked .deleted as well
 	assert(pathResults.empty());
 	(void)r;  // Squelch unused-but-set warning.
 }
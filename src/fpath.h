@@ -56,6 +56,7 @@ struct PATHJOB
 	int		owner;		///< Player owner
 	std::shared_ptr<PathBlockingMap> blockingMap;   ///< Map of blocking tiles.
 	bool		acceptNearest;
+	unsigned        contextCache;   ///< Which pathfinding context cache (and therefore which thread) processes this job.
 	bool            deleted;        ///< Droid was deleted, so throw away result when complete. Must still process this PATHJOB, since processing order can affect resulting paths (but can't affect the path length).
 };
 
@@ -76,6 +77,20 @@ void fpathShutdown();
 
 void fpathUpdate();
 
+/** Pathfinding queue statistics, for seeing whether droids are stuck waiting for paths. */
+struct FPATH_STATISTICS
+{
+	unsigned threads = 0;          ///< Number of pathfinding threads.
+	unsigned queueLength = 0;      ///< Number of jobs currently queued or being processed.
+	unsigned maxQueueLength = 0;   ///< Largest number of queued jobs since the statistics were last reset.
+	unsigned jobsDone = 0;         ///< Number of jobs completed since the statistics were last reset.
+	uint64_t totalLatency = 0;     ///< Sum of the times from queueing to completion of the completed jobs, in milliseconds.
+	unsigned maxLatency = 0;       ///< Longest time from queueing to completion, in milliseconds.
+};
+
+/** Get the pathfinding queue statistics, and optionally reset the counters. Function is thread-safe. */
+FPATH_STATISTICS fpathGetStatistics(bool reset);
+
 /** Find a route for a droid to a location.
  */
 FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD targetX, SDWORD targetY, FPATH_MOVETYPE moveType);
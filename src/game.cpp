@@ -27,6 +27,7 @@
 #include "lib/framework/endian_hack.h"
 #include "lib/framework/math_ext.h"
 #include "lib/framework/wzconfig.h"
+#include "lib/framework/wzconfigbinary.h"
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/strres.h"
@@ -1764,38 +1765,6 @@ static void getIniDroidOrder(WzConfig &ini, WzString const &key, DroidOrder &ord
 	getIniStructureStats(ini, key + "/stats", order.psStats);
 }
 
-static void setIniBaseObject(WzConfig &ini, WzString const &key, BASE_OBJECT const *object)
-{
-	if (object != nullptr && object->died <= 1)
-	{
-		ini.setValue(key + "/id", object->id);
-		ini.setValue(key + "/player", object->player);
-		ini.setValue(key + "/type", object->type);
-#ifdef DEBUG
-		//ini.setValue(key + "/debugfunc", WzString::fromUtf8(psCurr->targetFunc));
-		//ini.setValue(key + "/debugline", psCurr->targetLine);
-#endif
-	}
-}
-
-static void setIniStructureStats(WzConfig &ini, WzString const &key, STRUCTURE_STATS const *stats)
-{
-	if (stats != nullptr)
-	{
-		ini.setValue(key, stats->id);
-	}
-}
-
-static void setIniDroidOrder(WzConfig &ini, WzString const &key, DroidOrder const &order)
-{
-	ini.setValue(key + "/type", order.type);
-	ini.setVector2i(key + "/pos", order.pos);
-	ini.setVector2i(key + "/pos2", order.pos2);
-	ini.setValue(key + "/direction", order.direction);
-	setIniBaseObject(ini, key + "/obj", order.psObj);
-	setIniStructureStats(ini, key + "/stats", order.psStats);
-}
-
 static void allocatePlayers()
 {
 	for (int i = 0; i < MAX_PLAYERS; i++)
@@ -1898,6 +1867,7 @@ bool loadGame(const char *pGameToLoad, bool keepObjects, bool freeMem, bool User
 			mission.apsFlagPosLists[player] = nullptr;
 			mission.apsExtractorLists[player] = nullptr;
 		}
+		objmemOffWorldChanged();
 		mission.apsOilList[0] = nullptr;
 		mission.apsSensorList[0] = nullptr;
 
@@ -2653,6 +2623,45 @@ error:
 }
 // -----------------------------------------------------------------------------------------
 
+/// The files of a savegame which hold its objects, templates and research, and make up most of it. The droids,
+/// structures and features are always written as record documents, straight from the object lists, and the templates
+/// and research in the binary format if enabled. The rest are small and always written as JSON. All of them are read
+/// in any format, and JSON is written for them only by converting a savegame.
+static const char *binarySaveFiles[] =
+{
+	"droid.json", "mdroid.json", "limbo.json", "struct.json", "mstruct.json", "feature.json", "mfeature.json", "templates.json", "resstate.json"
+};
+static const size_t numRecordSaveFiles = 7;  ///< The first files of binarySaveFiles, which are written as records.
+
+static WzConfig::format saveFormat()
+{
+	return war_GetBinarySaves() ? WzConfig::Binary : WzConfig::Json;
+}
+
+bool convertSaveGame(const char *saveDir, bool toBinary)
+{
+	bool ok = true;
+	int converted = 0;
+	for (size_t i = 0; i < ARRAY_SIZE(binarySaveFiles); ++i)
+	{
+		std::string path = std::string(saveDir) + "/" + binarySaveFiles[i];
+		if (!PHYSFS_exists(path.c_str()))
+		{
+			continue;  // mstruct.json and mfeature.json are only saved during missions.
+		}
+		WzConfig::format binaryFormat = i < numRecordSaveFiles ? WzConfig::Records : WzConfig::Binary;
+		if (!WzConfig::convertFile(WzString::fromUtf8(path.c_str()), toBinary ? binaryFormat : WzConfig::Json))
+		{
+			ok = false;
+			continue;
+		}
+		++converted;
+	}
+	ASSERT_OR_RETURN(false, converted > 0, "No savegame files found in %s", saveDir);
+	debug(LOG_INFO, "Converted %d files of %s to %s", converted, saveDir, toBinary ? "binary" : "JSON");
+	return ok;
+}
+
 bool saveGame(const char *aFileName, GAME_TYPE saveType)
 {
 	UDWORD			fileExtension;
@@ -4469,52 +4478,188 @@ static void loadSaveObject(WzConfig &ini, BASE_OBJECT *psObj)
 	psObj->born = ini.value("born", 2).toInt();
 }
 
-static void writeSaveObject(WzConfig &ini, BASE_OBJECT *psObj)
+/// Fields written by writeSaveObject, which the droid, structure and feature records start with.
+enum OBJECT_FIELD
+{
+	OF_NAME, OF_ID, OF_PLAYER, OF_HEALTH, OF_POSITION, OF_ROTATION, OF_TIME_ANIMATION_STARTED, OF_ANIMATION_EVENT,
+	OF_SELECTED, OF_LAST_EMISSION, OF_PERIODICAL_DAMAGE_START, OF_PERIODICAL_DAMAGE, OF_BORN, OF_DIED, OF_TIME_LAST_HIT,
+	OF_VISIBLE, OF_COUNT
+};
+
+#define OBJECT_FIELDS \
+	{nullptr, "name"}, {nullptr, "id"}, {nullptr, "player"}, {nullptr, "health"}, {nullptr, "position"}, {nullptr, "rotation"}, \
+	{nullptr, "timeAnimationStarted"}, {nullptr, "animationEvent"}, {nullptr, "selected"}, {nullptr, "lastEmission"}, \
+	{nullptr, "periodicalDamageStart"}, {nullptr, "periodicalDamage"}, {nullptr, "born"}, {nullptr, "died"}, \
+	{nullptr, "timeLastHit"}, {nullptr, "visible/#"}
+
+/// Fields written by setRecordTarget, from the field given to it on.
+enum TARGET_FIELD
+{
+	TARGET_ID, TARGET_PLAYER, TARGET_TYPE, TARGET_COUNT
+};
+
+/// Fields written by setRecordDroidOrder, from the field given to it on.
+enum ORDER_FIELD
+{
+	ORDER_TYPE, ORDER_POS, ORDER_POS2, ORDER_DIRECTION, ORDER_OBJ, ORDER_STATS = ORDER_OBJ + TARGET_COUNT, ORDER_COUNT
+};
+
+enum DROID_FIELD
+{
+	DF_AMMO = OF_COUNT, DF_LAST_FIRED, DF_SHOTS_FIRED, DF_WEAPON_ROTATION, DF_ACTION_TARGET,
+	DF_LAST_FRUSTRATED_TIME = DF_ACTION_TARGET + TARGET_COUNT, DF_EXPERIENCE, DF_ORDER, DF_ORDER_LIST_SIZE = DF_ORDER + ORDER_COUNT,
+	DF_ORDER_LIST, DF_SECONDARY_ORDER = DF_ORDER_LIST + ORDER_COUNT, DF_ACTION, DF_ACTION_STRING, DF_ACTION_POS,
+	DF_ACTION_STARTED, DF_ACTION_POINTS, DF_BASE_STRUCT, DF_AIGROUP = DF_BASE_STRUCT + TARGET_COUNT, DF_AIGROUP_TYPE,
+	DF_GROUP, DF_COMMANDER, DF_RESISTANCE, DF_DROID_TYPE, DF_WEAPONS, DF_BODY, DF_PROPULSION, DF_BRAIN, DF_REPAIR, DF_ECM,
+	DF_SENSOR, DF_CONSTRUCT, DF_WEAPON, DF_MOVE_STATUS, DF_PATH_INDEX, DF_PATH_LENGTH, DF_PATH_NODE, DF_MOVE_DESTINATION,
+	DF_MOVE_SOURCE, DF_MOVE_TARGET, DF_MOVE_SPEED, DF_MOVE_DIRECTION, DF_BUMP_DIR, DF_VERT_SPEED, DF_BUMP_TIME,
+	DF_SHUFFLE_START, DF_ATTACK_RUN, DF_LAST_BUMP, DF_PAUSE_TIME, DF_BUMP_POSITION, DF_ON_MISSION, DF_COUNT
+};
+
+static const WzRecordField droidFields[] =
+{
+	OBJECT_FIELDS,
+	{nullptr, "ammo/#"}, {nullptr, "lastFired/#"}, {nullptr, "shotsFired/#"}, {nullptr, "rotation/#"},
+	{nullptr, "actionTarget/#/id"}, {nullptr, "actionTarget/#/player"}, {nullptr, "actionTarget/#/type"},
+	{nullptr, "lastFrustratedTime"}, {nullptr, "experience"},
+	{nullptr, "order/type"}, {nullptr, "order/pos"}, {nullptr, "order/pos2"}, {nullptr, "order/direction"},
+	{nullptr, "order/obj/id"}, {nullptr, "order/obj/player"}, {nullptr, "order/obj/type"}, {nullptr, "order/stats"},
+	{nullptr, "orderList/size"},
+	{nullptr, "orderList/#/type"}, {nullptr, "orderList/#/pos"}, {nullptr, "orderList/#/pos2"}, {nullptr, "orderList/#/direction"},
+	{nullptr, "orderList/#/obj/id"}, {nullptr, "orderList/#/obj/player"}, {nullptr, "orderList/#/obj/type"}, {nullptr, "orderList/#/stats"},
+	{nullptr, "secondaryOrder"}, {nullptr, "action"}, {nullptr, "actionString"}, {nullptr, "action/pos"},
+	{nullptr, "actionStarted"}, {nullptr, "actionPoints"},
+	{nullptr, "baseStruct/id"}, {nullptr, "baseStruct/player"}, {nullptr, "baseStruct/type"},
+	{nullptr, "aigroup"}, {nullptr, "aigroup/type"}, {nullptr, "group"}, {nullptr, "commander"}, {nullptr, "resistance"},
+	{nullptr, "droidType"}, {nullptr, "weapons"},
+	{"parts", "body"}, {"parts", "propulsion"}, {"parts", "brain"}, {"parts", "repair"}, {"parts", "ecm"},
+	{"parts", "sensor"}, {"parts", "construct"}, {"parts", "weapon/#"},
+	{nullptr, "moveStatus"}, {nullptr, "pathIndex"}, {nullptr, "pathLength"}, {nullptr, "pathNode/#"},
+	{nullptr, "moveDestination"}, {nullptr, "moveSource"}, {nullptr, "moveTarget"}, {nullptr, "moveSpeed"},
+	{nullptr, "moveDirection"}, {nullptr, "bumpDir"}, {nullptr, "vertSpeed"}, {nullptr, "bumpTime"},
+	{nullptr, "shuffleStart"}, {nullptr, "attackRun/#"}, {nullptr, "lastBump"}, {nullptr, "pauseTime"},
+	{nullptr, "bumpPosition"}, {nullptr, "onMission"}
+};
+static_assert(sizeof(droidFields) / sizeof(droidFields[0]) == DF_COUNT, "droidFields doesn't match DROID_FIELD");
+
+enum STRUCTURE_FIELD
+{
+	SF_RESISTANCE = OF_COUNT, SF_STATUS, SF_WEAPONS, SF_WEAPON, SF_AMMO, SF_LAST_FIRED, SF_SHOTS_FIRED,
+	SF_WEAPON_ROTATION, SF_TARGET, SF_TARGET_DEBUG_FUNC = SF_TARGET + TARGET_COUNT, SF_TARGET_DEBUG_LINE,
+	SF_CURRENT_BUILD_POINTS, SF_MODULES, SF_PRODUCTION_LOOPS, SF_FACTORY_TIME_STARTED, SF_BUILD_POINTS_REMAINING,
+	SF_FACTORY_TIME_START_HOLD, SF_LOOPS_PERFORMED, SF_FACTORY_SECONDARY_ORDER, SF_FACTORY_TEMPLATE,
+	SF_ASSEMBLY_POINT_POS, SF_ASSEMBLY_POINT_SELECTED, SF_ASSEMBLY_POINT_NUMBER, SF_FACTORY_COMMANDER_ID,
+	SF_FACTORY_COMMANDER_PLAYER, SF_PRODUCTION_RUNS, SF_RUN_QUANTITY, SF_RUN_BUILT, SF_RUN_TEMPLATE,
+	SF_RESEARCH_TIME_START_HOLD, SF_RESEARCH_TARGET, SF_REPAIR_TARGET, SF_DELIVERY_POINT_POS = SF_REPAIR_TARGET + TARGET_COUNT,
+	SF_DELIVERY_POINT_SELECTED, SF_REARM_TIME_STARTED, SF_REARM_TIME_LAST_UPDATED, SF_REARM_TARGET,
+	SF_WALL_TYPE = SF_REARM_TARGET + TARGET_COUNT, SF_COUNT
+};
+
+static const WzRecordField structureFields[] =
+{
+	OBJECT_FIELDS,
+	{nullptr, "resistance"}, {nullptr, "status"}, {nullptr, "weapons"}, {nullptr, "parts/weapon/#"},
+	{nullptr, "ammo/#"}, {nullptr, "lastFired/#"}, {nullptr, "shotsFired/#"}, {nullptr, "rotation/#"},
+	{nullptr, "target/#/id"}, {nullptr, "target/#/player"}, {nullptr, "target/#/type"},
+	{nullptr, "target/#/debugfunc"}, {nullptr, "target/#/debugline"},
+	{nullptr, "currentBuildPts"}, {nullptr, "modules"},
+	{nullptr, "Factory/productionLoops"}, {nullptr, "Factory/timeStarted"}, {nullptr, "Factory/buildPointsRemaining"},
+	{nullptr, "Factory/timeStartHold"}, {nullptr, "Factory/loopsPerformed"}, {nullptr, "Factory/secondaryOrder"},
+	{nullptr, "Factory/template"}, {nullptr, "Factory/assemblyPoint/pos"}, {nullptr, "Factory/assemblyPoint/selected"},
+	{nullptr, "Factory/assemblyPoint/number"}, {nullptr, "Factory/commander/id"}, {nullptr, "Factory/commander/player"},
+	{nullptr, "Factory/productionRuns"}, {nullptr, "Factory/Run/#/quantity"}, {nullptr, "Factory/Run/#/built"},
+	{nullptr, "Factory/Run/#/template"},
+	{nullptr, "Research/timeStartHold"}, {nullptr, "Research/target"},
+	{nullptr, "Repair/target/id"}, {nullptr, "Repair/target/player"}, {nullptr, "Repair/target/type"},
+	{nullptr, "Repair/deliveryPoint/pos"}, {nullptr, "Repair/deliveryPoint/selected"},
+	{nullptr, "Rearm/timeStarted"}, {nullptr, "Rearm/timeLastUpdated"},
+	{nullptr, "Rearm/target/id"}, {nullptr, "Rearm/target/player"}, {nullptr, "Rearm/target/type"},
+	{nullptr, "Wall/type"}
+};
+static_assert(sizeof(structureFields) / sizeof(structureFields[0]) == SF_COUNT, "structureFields doesn't match STRUCTURE_FIELD");
+
+static const WzRecordField featureFields[] =
+{
+	OBJECT_FIELDS
+};
+
+static void setRecordPlayer(WzRecordWriter &records, int player)
+{
+	if (scavengerSlot() == player)
+	{
+		records.setString(OF_PLAYER, "scavenger");
+	}
+	else
+	{
+		records.setInt(OF_PLAYER, player);
+	}
+}
+
+static void setRecordTarget(WzRecordWriter &records, unsigned field, unsigned index, BASE_OBJECT const *object)
+{
+	records.setInt(field + TARGET_ID, index, object->id);
+	records.setInt(field + TARGET_PLAYER, index, object->player);
+	records.setInt(field + TARGET_TYPE, index, object->type);
+}
+
+static void setRecordDroidOrder(WzRecordWriter &records, unsigned field, unsigned index, DroidOrder const &order)
+{
+	records.setInt(field + ORDER_TYPE, index, order.type);
+	records.setVector2i(field + ORDER_POS, index, order.pos);
+	records.setVector2i(field + ORDER_POS2, index, order.pos2);
+	records.setInt(field + ORDER_DIRECTION, index, order.direction);
+	if (order.psObj != nullptr && order.psObj->died <= 1)
+	{
+		setRecordTarget(records, field + ORDER_OBJ, index, order.psObj);
+	}
+	if (order.psStats != nullptr)
+	{
+		records.setString(field + ORDER_STATS, index, order.psStats->id.toUtf8());
+	}
+}
+
+static void writeSaveObject(WzRecordWriter &records, BASE_OBJECT *psObj)
 {
-	ini.setValue("id", psObj->id);
-	setPlayer(ini, psObj->player);
-	ini.setValue("health", psObj->body);
-	ini.setVector3i("position", psObj->pos);
-	ini.setVector3i("rotation", toVector(psObj->rot));
+	records.setInt(OF_ID, psObj->id);
+	setRecordPlayer(records, psObj->player);
+	records.setInt(OF_HEALTH, psObj->body);
+	records.setVector3i(OF_POSITION, psObj->pos);
+	records.setVector3i(OF_ROTATION, toVector(psObj->rot));
 	if (psObj->timeAnimationStarted)
 	{
-		ini.setValue("timeAnimationStarted", psObj->timeAnimationStarted);
+		records.setInt(OF_TIME_ANIMATION_STARTED, psObj->timeAnimationStarted);
 	}
 	if (psObj->animationEvent)
 	{
-		ini.setValue("animationEvent", psObj->animationEvent);
+		records.setInt(OF_ANIMATION_EVENT, psObj->animationEvent);
 	}
-	ini.setValue("selected", psObj->selected);	// third kind of group
+	records.setInt(OF_SELECTED, psObj->selected);	// third kind of group
 	if (psObj->lastEmission)
 	{
-		ini.setValue("lastEmission", psObj->lastEmission);
+		records.setInt(OF_LAST_EMISSION, psObj->lastEmission);
 	}
 	if (psObj->periodicalDamageStart > 0)
 	{
-		ini.setValue("periodicalDamageStart", psObj->periodicalDamageStart);
+		records.setInt(OF_PERIODICAL_DAMAGE_START, psObj->periodicalDamageStart);
 	}
 	if (psObj->periodicalDamage > 0)
 	{
-		ini.setValue("periodicalDamage", psObj->periodicalDamage);
+		records.setInt(OF_PERIODICAL_DAMAGE, psObj->periodicalDamage);
 	}
-	ini.setValue("born", psObj->born);
+	records.setInt(OF_BORN, psObj->born);
 	if (psObj->died > 0)
 	{
-		ini.setValue("died", psObj->died);
+		records.setInt(OF_DIED, psObj->died);
 	}
 	if (psObj->timeLastHit != UDWORD_MAX)
 	{
-		ini.setValue("timeLastHit", psObj->timeLastHit);
-	}
-	if (psObj->selected)
-	{
-		ini.setValue("selected", psObj->selected);
+		records.setInt(OF_TIME_LAST_HIT, psObj->timeLastHit);
 	}
 	for (int i = 0; i < game.maxPlayers; i++)
 	{
 		if (psObj->visible[i])
 		{
-			ini.setValue("visible/" + WzString::number(i), psObj->visible[i]);
+			records.setInt(OF_VISIBLE, i, psObj->visible[i]);
 		}
 	}
 }
@@ -4748,145 +4893,133 @@ static bool loadSaveDroid(const char *pFileName, DROID **ppsCurrentDroidLists)
 /*
 Writes the linked list of droids for each player to a file
 */
-static bool writeDroid(WzConfig &ini, DROID *psCurr, bool onMission, int &counter)
+static void writeDroid(WzRecordWriter &records, DROID *psCurr, bool onMission)
 {
-	ini.beginGroup("droid_" + (WzString::number(counter++).leftPadToMinimumLength(WzUniCodepoint::fromASCII('0'), 10)));  // Zero padded so that alphabetical sort works.
-	ini.setValue("name", psCurr->aName);
+	records.beginRecord();
+	records.setString(OF_NAME, psCurr->aName);
 
 	// write common BASE_OBJECT info
-	writeSaveObject(ini, psCurr);
+	writeSaveObject(records, psCurr);
 
 	for (int i = 0; i < psCurr->numWeaps; i++)
 	{
 		if (psCurr->asWeaps[i].nStat > 0)
 		{
-			ini.setValue("ammo/" + WzString::number(i), psCurr->asWeaps[i].ammo);
-			ini.setValue("lastFired/" + WzString::number(i), psCurr->asWeaps[i].lastFired);
-			ini.setValue("shotsFired/" + WzString::number(i), psCurr->asWeaps[i].shotsFired);
-			ini.setVector3i("rotation/" + WzString::number(i), toVector(psCurr->asWeaps[i].rot));
+			records.setInt(DF_AMMO, i, psCurr->asWeaps[i].ammo);
+			records.setInt(DF_LAST_FIRED, i, psCurr->asWeaps[i].lastFired);
+			records.setInt(DF_SHOTS_FIRED, i, psCurr->asWeaps[i].shotsFired);
+			records.setVector3i(DF_WEAPON_ROTATION, i, toVector(psCurr->asWeaps[i].rot));
 		}
 	}
 	for (int i = 0; i < MAX_WEAPONS; i++)
 	{
-		setIniBaseObject(ini, "actionTarget/" + WzString::number(i), psCurr->psActionTarget[i]);
+		if (psCurr->psActionTarget[i] != nullptr && psCurr->psActionTarget[i]->died <= 1)
+		{
+			setRecordTarget(records, DF_ACTION_TARGET, i, psCurr->psActionTarget[i]);
+		}
 	}
 	if (psCurr->lastFrustratedTime > 0)
 	{
-		ini.setValue("lastFrustratedTime", psCurr->lastFrustratedTime);
+		records.setInt(DF_LAST_FRUSTRATED_TIME, psCurr->lastFrustratedTime);
 	}
 	if (psCurr->experience > 0)
 	{
-		ini.setValue("experience", psCurr->experience);
+		records.setInt(DF_EXPERIENCE, psCurr->experience);
 	}
 
-	setIniDroidOrder(ini, "order", psCurr->order);
-	ini.setValue("orderList/size", psCurr->listSize);
+	setRecordDroidOrder(records, DF_ORDER, WzRecordWriter::NO_INDEX, psCurr->order);
+	records.setInt(DF_ORDER_LIST_SIZE, psCurr->listSize);
 	for (int i = 0; i < psCurr->listSize; ++i)
 	{
-		setIniDroidOrder(ini, "orderList/" + WzString::number(i), psCurr->asOrderList[i]);
+		setRecordDroidOrder(records, DF_ORDER_LIST, i, psCurr->asOrderList[i]);
 	}
-	if (psCurr->timeLastHit != UDWORD_MAX)
-	{
-		ini.setValue("timeLastHit", psCurr->timeLastHit);
-	}
-	ini.setValue("secondaryOrder", psCurr->secondaryOrder);
-	ini.setValue("action", psCurr->action);
-	ini.setValue("actionString", getDroidActionName(psCurr->action)); // future-proofing
-	ini.setVector2i("action/pos", psCurr->actionPos);
-	ini.setValue("actionStarted", psCurr->actionStarted);
-	ini.setValue("actionPoints", psCurr->actionPoints);
+	records.setInt(DF_SECONDARY_ORDER, psCurr->secondaryOrder);
+	records.setInt(DF_ACTION, psCurr->action);
+	records.setString(DF_ACTION_STRING, getDroidActionName(psCurr->action)); // future-proofing
+	records.setVector2i(DF_ACTION_POS, psCurr->actionPos);
+	records.setInt(DF_ACTION_STARTED, psCurr->actionStarted);
+	records.setInt(DF_ACTION_POINTS, psCurr->actionPoints);
 	if (psCurr->psBaseStruct != nullptr)
 	{
-		ini.setValue("baseStruct/id", psCurr->psBaseStruct->id);
-		ini.setValue("baseStruct/player", psCurr->psBaseStruct->player);	// always ours, but for completeness
-		ini.setValue("baseStruct/type", psCurr->psBaseStruct->type);		// always a building, but for completeness
+		setRecordTarget(records, DF_BASE_STRUCT, WzRecordWriter::NO_INDEX, psCurr->psBaseStruct);	// always our building, but for completeness
 	}
 	if (psCurr->psGroup)
 	{
-		ini.setValue("aigroup", psCurr->psGroup->id);	// AI and commander/transport group
-		ini.setValue("aigroup/type", psCurr->psGroup->type);
+		records.setInt(DF_AIGROUP, psCurr->psGroup->id);	// AI and commander/transport group
+		records.setInt(DF_AIGROUP_TYPE, psCurr->psGroup->type);
 	}
-	ini.setValue("group", psCurr->group);	// different kind of group. of course.
+	records.setInt(DF_GROUP, psCurr->group);	// different kind of group. of course.
 	if (hasCommander(psCurr) && psCurr->psGroup->psCommander->died <= 1)
 	{
-		ini.setValue("commander", psCurr->psGroup->psCommander->id);
+		records.setInt(DF_COMMANDER, psCurr->psGroup->psCommander->id);
 	}
 	if (psCurr->resistance > 0)
 	{
-		ini.setValue("resistance", psCurr->resistance);
-	}
-	ini.setValue("droidType", psCurr->droidType);
-	ini.setValue("weapons", psCurr->numWeaps);
-	ini.beginGroup("parts");
-	ini.setValue("body", (asBodyStats + psCurr->asBits[COMP_BODY])->id);
-	ini.setValue("propulsion", (asPropulsionStats + psCurr->asBits[COMP_PROPULSION])->id);
-	ini.setValue("brain", (asBrainStats + psCurr->asBits[COMP_BRAIN])->id);
-	ini.setValue("repair", (asRepairStats + psCurr->asBits[COMP_REPAIRUNIT])->id);
-	ini.setValue("ecm", (asECMStats + psCurr->asBits[COMP_ECM])->id);
-	ini.setValue("sensor", (asSensorStats + psCurr->asBits[COMP_SENSOR])->id);
-	ini.setValue("construct", (asConstructStats + psCurr->asBits[COMP_CONSTRUCT])->id);
+		records.setInt(DF_RESISTANCE, psCurr->resistance);
+	}
+	records.setInt(DF_DROID_TYPE, psCurr->droidType);
+	records.setInt(DF_WEAPONS, psCurr->numWeaps);
+	records.setString(DF_BODY, (asBodyStats + psCurr->asBits[COMP_BODY])->id.toUtf8());
+	records.setString(DF_PROPULSION, (asPropulsionStats + psCurr->asBits[COMP_PROPULSION])->id.toUtf8());
+	records.setString(DF_BRAIN, (asBrainStats + psCurr->asBits[COMP_BRAIN])->id.toUtf8());
+	records.setString(DF_REPAIR, (asRepairStats + psCurr->asBits[COMP_REPAIRUNIT])->id.toUtf8());
+	records.setString(DF_ECM, (asECMStats + psCurr->asBits[COMP_ECM])->id.toUtf8());
+	records.setString(DF_SENSOR, (asSensorStats + psCurr->asBits[COMP_SENSOR])->id.toUtf8());
+	records.setString(DF_CONSTRUCT, (asConstructStats + psCurr->asBits[COMP_CONSTRUCT])->id.toUtf8());
 	for (int j = 0; j < psCurr->numWeaps; j++)
 	{
-		ini.setValue("weapon/" + WzString::number(j + 1), (asWeaponStats + psCurr->asWeaps[j].nStat)->id);
+		records.setString(DF_WEAPON, j + 1, (asWeaponStats + psCurr->asWeaps[j].nStat)->id.toUtf8());
 	}
-	ini.endGroup();
-	ini.setValue("moveStatus", psCurr->sMove.Status);
-	ini.setValue("pathIndex", psCurr->sMove.pathIndex);
-	ini.setValue("pathLength", psCurr->sMove.asPath.size());
+	records.setInt(DF_MOVE_STATUS, psCurr->sMove.Status);
+	records.setInt(DF_PATH_INDEX, psCurr->sMove.pathIndex);
+	records.setInt(DF_PATH_LENGTH, psCurr->sMove.asPath.size());
 	for (unsigned i = 0; i < psCurr->sMove.asPath.size(); i++)
 	{
-		ini.setVector2i("pathNode/" + WzString::number(i), psCurr->sMove.asPath[i]);
-	}
-	ini.setVector2i("moveDestination", psCurr->sMove.destination);
-	ini.setVector2i("moveSource", psCurr->sMove.src);
-	ini.setVector2i("moveTarget", psCurr->sMove.target);
-	ini.setValue("moveSpeed", psCurr->sMove.speed);
-	ini.setValue("moveDirection", psCurr->sMove.moveDir);
-	ini.setValue("bumpDir", psCurr->sMove.bumpDir);
-	ini.setValue("vertSpeed", psCurr->sMove.iVertSpeed);
-	ini.setValue("bumpTime", psCurr->sMove.bumpTime);
-	ini.setValue("shuffleStart", psCurr->sMove.shuffleStart);
+		records.setVector2i(DF_PATH_NODE, i, psCurr->sMove.asPath[i]);
+	}
+	records.setVector2i(DF_MOVE_DESTINATION, psCurr->sMove.destination);
+	records.setVector2i(DF_MOVE_SOURCE, psCurr->sMove.src);
+	records.setVector2i(DF_MOVE_TARGET, psCurr->sMove.target);
+	records.setInt(DF_MOVE_SPEED, psCurr->sMove.speed);
+	records.setInt(DF_MOVE_DIRECTION, psCurr->sMove.moveDir);
+	records.setInt(DF_BUMP_DIR, psCurr->sMove.bumpDir);
+	records.setInt(DF_VERT_SPEED, psCurr->sMove.iVertSpeed);
+	records.setInt(DF_BUMP_TIME, psCurr->sMove.bumpTime);
+	records.setInt(DF_SHUFFLE_START, psCurr->sMove.shuffleStart);
 	for (int i = 0; i < MAX_WEAPONS; ++i)
 	{
-		ini.setValue("attackRun/" + WzString::number(i), psCurr->asWeaps[i].usedAmmo);
+		records.setInt(DF_ATTACK_RUN, i, psCurr->asWeaps[i].usedAmmo);
 	}
-	ini.setValue("lastBump", psCurr->sMove.lastBump);
-	ini.setValue("pauseTime", psCurr->sMove.pauseTime);
-	ini.setVector2i("bumpPosition", psCurr->sMove.bumpPos.xy());
-	ini.setValue("onMission", onMission);
-	ini.endGroup();
-	return true;
+	records.setInt(DF_LAST_BUMP, psCurr->sMove.lastBump);
+	records.setInt(DF_PAUSE_TIME, psCurr->sMove.pauseTime);
+	records.setVector2i(DF_BUMP_POSITION, psCurr->sMove.bumpPos.xy());
+	records.setBool(DF_ON_MISSION, onMission);
+	records.endRecord();
 }
 
 static bool writeDroidFile(const char *pFileName, DROID **ppsCurrentDroidLists)
 {
-	WzConfig ini(WzString::fromUtf8(pFileName), WzConfig::ReadAndWrite);
-	int counter = 0;
+	WzRecordWriter records("droid_", droidFields, ARRAY_SIZE(droidFields));
 	bool onMission = (ppsCurrentDroidLists[0] == mission.apsDroidLists[0]);
 
 	for (int player = 0; player < MAX_PLAYERS; player++)
 	{
 		for (DROID *psCurr = ppsCurrentDroidLists[player]; psCurr != nullptr; psCurr = psCurr->psNext)
 		{
-			writeDroid(ini, psCurr, onMission, counter);
+			writeDroid(records, psCurr, onMission);
 			if (isTransporter(psCurr))	// if transporter save any droids in the grp
 			{
 				for (DROID *psTrans = psCurr->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
 				{
 					if (psTrans != psCurr)
 					{
-						writeDroid(ini, psTrans, onMission, counter);
+						writeDroid(records, psTrans, onMission);
 					}
 				}
-				//always save transporter droids that are in the mission list with an invalid value
-				if (ppsCurrentDroidLists[player] == mission.apsDroidLists[player])
-				{
-					ini.setVector3i("position", Vector3i(-1, -1, -1)); // was INVALID_XY
-				}
 			}
 		}
 	}
-	return true;
+	return WzConfig::saveRecords(WzString::fromUtf8(pFileName), records);
 }
 
 
@@ -5026,7 +5159,7 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 		}
 		// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 		// the scripts -so in ALL CASES overwrite the ID!
-		psStructure->id = psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98; // hack to remove struct id zero
+		setObjectId(psStructure, psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98); // hack to remove struct id zero
 		psStructure->periodicalDamage = psSaveStructure->periodicalDamage;
 		periodicalDamageTime = psSaveStructure->periodicalDamageStart;
 		psStructure->periodicalDamageStart = periodicalDamageTime;
@@ -5148,7 +5281,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		}
 		if (id > 0)
 		{
-			psStructure->id = id;	// force correct ID
+			setObjectId(psStructure, id);	// force correct ID
 		}
 
 		// common BASE_OBJECT info
@@ -5363,153 +5496,144 @@ Writes the linked list of structure for each player to a file
 */
 bool writeStructFile(const char *pFileName)
 {
-	WzConfig ini(WzString::fromUtf8(pFileName), WzConfig::ReadAndWrite);
-	int counter = 0;
+	WzRecordWriter records("structure_", structureFields, ARRAY_SIZE(structureFields));
 
 	for (int player = 0; player < MAX_PLAYERS; player++)
 	{
 		for (STRUCTURE *psCurr = apsStructLists[player]; psCurr != nullptr; psCurr = psCurr->psNext)
 		{
-			ini.beginGroup("structure_" + (WzString::number(counter++).leftPadToMinimumLength(WzUniCodepoint::fromASCII('0'), 10)));  // Zero padded so that alphabetical sort works.
-			ini.setValue("name", psCurr->pStructureType->id);
+			records.beginRecord();
+			records.setString(OF_NAME, psCurr->pStructureType->id.toUtf8());
 
-			writeSaveObject(ini, psCurr);
+			writeSaveObject(records, psCurr);
 
 			if (psCurr->resistance > 0)
 			{
-				ini.setValue("resistance", psCurr->resistance);
+				records.setInt(SF_RESISTANCE, psCurr->resistance);
 			}
 			if (psCurr->status != SS_BUILT)
 			{
-				ini.setValue("status", psCurr->status);
+				records.setInt(SF_STATUS, psCurr->status);
 			}
-			ini.setValue("weapons", psCurr->numWeaps);
+			records.setInt(SF_WEAPONS, psCurr->numWeaps);
 			for (unsigned j = 0; j < psCurr->numWeaps; j++)
 			{
-				ini.setValue("parts/weapon/" + WzString::number(j + 1), (asWeaponStats + psCurr->asWeaps[j].nStat)->id);
+				records.setString(SF_WEAPON, j + 1, (asWeaponStats + psCurr->asWeaps[j].nStat)->id.toUtf8());
 				if (psCurr->asWeaps[j].nStat > 0)
 				{
-					ini.setValue("ammo/" + WzString::number(j), psCurr->asWeaps[j].ammo);
-					ini.setValue("lastFired/" + WzString::number(j), psCurr->asWeaps[j].lastFired);
-					ini.setValue("shotsFired/" + WzString::number(j), psCurr->asWeaps[j].shotsFired);
-					ini.setVector3i("rotation/" + WzString::number(j), toVector(psCurr->asWeaps[j].rot));
+					records.setInt(SF_AMMO, j, psCurr->asWeaps[j].ammo);
+					records.setInt(SF_LAST_FIRED, j, psCurr->asWeaps[j].lastFired);
+					records.setInt(SF_SHOTS_FIRED, j, psCurr->asWeaps[j].shotsFired);
+					records.setVector3i(SF_WEAPON_ROTATION, j, toVector(psCurr->asWeaps[j].rot));
 				}
 			}
 			for (unsigned i = 0; i < psCurr->numWeaps; i++)
 			{
 				if (psCurr->psTarget[i] && !psCurr->psTarget[i]->died)
 				{
-					ini.setValue("target/" + WzString::number(i) + "/id", psCurr->psTarget[i]->id);
-					ini.setValue("target/" + WzString::number(i) + "/player", psCurr->psTarget[i]->player);
-					ini.setValue("target/" + WzString::number(i) + "/type", psCurr->psTarget[i]->type);
+					setRecordTarget(records, SF_TARGET, i, psCurr->psTarget[i]);
 #ifdef DEBUG
-					ini.setValue("target/" + WzString::number(i) + "/debugfunc", WzString::fromUtf8(psCurr->targetFunc[i]));
-					ini.setValue("target/" + WzString::number(i) + "/debugline", psCurr->targetLine[i]);
+					records.setString(SF_TARGET_DEBUG_FUNC, i, psCurr->targetFunc[i]);
+					records.setInt(SF_TARGET_DEBUG_LINE, i, psCurr->targetLine[i]);
 #endif
 				}
 			}
-			ini.setValue("currentBuildPts", psCurr->currentBuildPts);
+			records.setInt(SF_CURRENT_BUILD_POINTS, psCurr->currentBuildPts);
 			if (psCurr->pFunctionality)
 			{
 				if (psCurr->pStructureType->type == REF_FACTORY || psCurr->pStructureType->type == REF_CYBORG_FACTORY
 				    || psCurr->pStructureType->type == REF_VTOL_FACTORY)
 				{
 					FACTORY *psFactory = (FACTORY *)psCurr->pFunctionality;
-					ini.setValue("modules", psCurr->capacity);
-					ini.setValue("Factory/productionLoops", psFactory->productionLoops);
-					ini.setValue("Factory/timeStarted", psFactory->timeStarted);
-					ini.setValue("Factory/buildPointsRemaining", psFactory->buildPointsRemaining);
-					ini.setValue("Factory/timeStartHold", psFactory->timeStartHold);
-					ini.setValue("Factory/loopsPerformed", psFactory->loopsPerformed);
+					records.setInt(SF_MODULES, psCurr->capacity);
+					records.setInt(SF_PRODUCTION_LOOPS, psFactory->productionLoops);
+					records.setInt(SF_FACTORY_TIME_STARTED, psFactory->timeStarted);
+					records.setInt(SF_BUILD_POINTS_REMAINING, psFactory->buildPointsRemaining);
+					records.setInt(SF_FACTORY_TIME_START_HOLD, psFactory->timeStartHold);
+					records.setInt(SF_LOOPS_PERFORMED, psFactory->loopsPerformed);
 					// statusPending and pendingCount belong to the GUI, not the game state.
-					ini.setValue("Factory/secondaryOrder", psFactory->secondaryOrder);
+					records.setInt(SF_FACTORY_SECONDARY_ORDER, psFactory->secondaryOrder);
 
 					if (psFactory->psSubject != nullptr)
 					{
-						ini.setValue("Factory/template", psFactory->psSubject->multiPlayerID);
+						records.setInt(SF_FACTORY_TEMPLATE, psFactory->psSubject->multiPlayerID);
 					}
 					FLAG_POSITION *psFlag = ((FACTORY *)psCurr->pFunctionality)->psAssemblyPoint;
 					if (psFlag != nullptr)
 					{
-						ini.setVector3i("Factory/assemblyPoint/pos", psFlag->coords);
+						records.setVector3i(SF_ASSEMBLY_POINT_POS, psFlag->coords);
 						if (psFlag->selected)
 						{
-							ini.setValue("Factory/assemblyPoint/selected", psFlag->selected);
+							records.setBool(SF_ASSEMBLY_POINT_SELECTED, psFlag->selected);
 						}
-						ini.setValue("Factory/assemblyPoint/number", psFlag->factoryInc);
+						records.setInt(SF_ASSEMBLY_POINT_NUMBER, psFlag->factoryInc);
 					}
 					if (psFactory->psCommander)
 					{
-						ini.setValue("Factory/commander/id", psFactory->psCommander->id);
-						ini.setValue("Factory/commander/player", psFactory->psCommander->player);
+						records.setInt(SF_FACTORY_COMMANDER_ID, psFactory->psCommander->id);
+						records.setInt(SF_FACTORY_COMMANDER_PLAYER, psFactory->psCommander->player);
 					}
-					ini.setValue("Factory/secondaryOrder", psFactory->secondaryOrder);
 					ProductionRun emptyRun;
 					bool haveRun = psFactory->psAssemblyPoint->factoryInc < asProductionRun[psFactory->psAssemblyPoint->factoryType].size();
 					ProductionRun const &productionRun = haveRun ? asProductionRun[psFactory->psAssemblyPoint->factoryType][psFactory->psAssemblyPoint->factoryInc] : emptyRun;
-					ini.setValue("Factory/productionRuns", (int)productionRun.size());
+					records.setInt(SF_PRODUCTION_RUNS, (int)productionRun.size());
 					for (size_t runNum = 0; runNum < productionRun.size(); runNum++)
 					{
 						ProductionRunEntry psCurrentProd = productionRun.at(runNum);
-						ini.setValue("Factory/Run/" + WzString::number(runNum) + "/quantity", psCurrentProd.quantity);
-						ini.setValue("Factory/Run/" + WzString::number(runNum) + "/built", psCurrentProd.built);
-						if (psCurrentProd.psTemplate) ini.setValue("Factory/Run/" + WzString::number(runNum) + "/template",
-							        psCurrentProd.psTemplate->multiPlayerID);
+						records.setInt(SF_RUN_QUANTITY, runNum, psCurrentProd.quantity);
+						records.setInt(SF_RUN_BUILT, runNum, psCurrentProd.built);
+						if (psCurrentProd.psTemplate) records.setInt(SF_RUN_TEMPLATE, runNum, psCurrentProd.psTemplate->multiPlayerID);
 					}
 				}
 				else if (psCurr->pStructureType->type == REF_RESEARCH)
 				{
-					ini.setValue("modules", psCurr->capacity);
-					ini.setValue("Research/timeStartHold", ((RESEARCH_FACILITY *)psCurr->pFunctionality)->timeStartHold);
+					records.setInt(SF_MODULES, psCurr->capacity);
+					records.setInt(SF_RESEARCH_TIME_START_HOLD, ((RESEARCH_FACILITY *)psCurr->pFunctionality)->timeStartHold);
 					if (((RESEARCH_FACILITY *)psCurr->pFunctionality)->psSubject)
 					{
-						ini.setValue("Research/target", ((RESEARCH_FACILITY *)psCurr->pFunctionality)->psSubject->id);
+						records.setString(SF_RESEARCH_TARGET, ((RESEARCH_FACILITY *)psCurr->pFunctionality)->psSubject->id.toUtf8());
 					}
 				}
 				else if (psCurr->pStructureType->type == REF_POWER_GEN)
 				{
-					ini.setValue("modules", psCurr->capacity);
+					records.setInt(SF_MODULES, psCurr->capacity);
 				}
 				else if (psCurr->pStructureType->type == REF_REPAIR_FACILITY)
 				{
 					REPAIR_FACILITY *psRepair = ((REPAIR_FACILITY *)psCurr->pFunctionality);
 					if (psRepair->psObj)
 					{
-						ini.setValue("Repair/target/id", psRepair->psObj->id);
-						ini.setValue("Repair/target/player", psRepair->psObj->player);
-						ini.setValue("Repair/target/type", psRepair->psObj->type);
+						setRecordTarget(records, SF_REPAIR_TARGET, WzRecordWriter::NO_INDEX, psRepair->psObj);
 					}
 					FLAG_POSITION *psFlag = psRepair->psDeliveryPoint;
 					if (psFlag)
 					{
-						ini.setVector3i("Repair/deliveryPoint/pos", psFlag->coords);
+						records.setVector3i(SF_DELIVERY_POINT_POS, psFlag->coords);
 						if (psFlag->selected)
 						{
-							ini.setValue("Repair/deliveryPoint/selected", psFlag->selected);
+							records.setBool(SF_DELIVERY_POINT_SELECTED, psFlag->selected);
 						}
 					}
 				}
 				else if (psCurr->pStructureType->type == REF_REARM_PAD)
 				{
 					REARM_PAD *psReArmPad = ((REARM_PAD *)psCurr->pFunctionality);
-					ini.setValue("Rearm/timeStarted", psReArmPad->timeStarted);
-					ini.setValue("Rearm/timeLastUpdated", psReArmPad->timeLastUpdated);
+					records.setInt(SF_REARM_TIME_STARTED, psReArmPad->timeStarted);
+					records.setInt(SF_REARM_TIME_LAST_UPDATED, psReArmPad->timeLastUpdated);
 					if (psReArmPad->psObj)
 					{
-						ini.setValue("Rearm/target/id", psReArmPad->psObj->id);
-						ini.setValue("Rearm/target/player", psReArmPad->psObj->player);
-						ini.setValue("Rearm/target/type", psReArmPad->psObj->type);
+						setRecordTarget(records, SF_REARM_TARGET, WzRecordWriter::NO_INDEX, psReArmPad->psObj);
 					}
 				}
 				else if (psCurr->pStructureType->type == REF_WALL || psCurr->pStructureType->type == REF_GATE)
 				{
-					ini.setValue("Wall/type", psCurr->pFunctionality->wall.type);
+					records.setInt(SF_WALL_TYPE, psCurr->pFunctionality->wall.type);
 				}
 			}
-			ini.endGroup();
+			records.endRecord();
 		}
 	}
-	return true;
+	return WzConfig::saveRecords(WzString::fromUtf8(pFileName), records);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -5688,7 +5812,7 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 			scriptSetDerrickPos(pFeature->pos.x, pFeature->pos.y);
 		}
 		//restore values
-		pFeature->id = psSaveFeature->id;
+		setObjectId(pFeature, psSaveFeature->id);
 		pFeature->rot.direction = DEG(psSaveFeature->direction);
 		pFeature->periodicalDamage = psSaveFeature->periodicalDamage;
 		if (psHeader->version >= VERSION_14)
@@ -5757,11 +5881,11 @@ bool loadSaveFeature2(const char *pFileName)
 		int id = ini.value("id", -1).toInt();
 		if (id > 0)
 		{
-			pFeature->id = id;
+			setObjectId(pFeature, id);
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			setObjectId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot = ini.vector3i("rotation");
 
@@ -5781,17 +5905,16 @@ Writes the linked list of features to a file
 */
 bool writeFeatureFile(const char *pFileName)
 {
-	WzConfig ini(WzString::fromUtf8(pFileName), WzConfig::ReadAndWrite);
-	int counter = 0;
+	WzRecordWriter records("feature_", featureFields, ARRAY_SIZE(featureFields));
 
 	for (FEATURE *psCurr = apsFeatureLists[0]; psCurr != nullptr; psCurr = psCurr->psNext)
 	{
-		ini.beginGroup("feature_" + (WzString::number(counter++).leftPadToMinimumLength(WzUniCodepoint::fromASCII('0'), 10)));  // Zero padded so that alphabetical sort works.
-		ini.setValue("name", psCurr->psStats->id);
-		writeSaveObject(ini, psCurr);
-		ini.endGroup();
+		records.beginRecord();
+		records.setString(OF_NAME, psCurr->psStats->id.toUtf8());
+		writeSaveObject(records, psCurr);
+		records.endRecord();
 	}
-	return true;
+	return WzConfig::saveRecords(WzString::fromUtf8(pFileName), records);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -5856,7 +5979,7 @@ bool loadSaveTemplate(const char *pFileName)
 
 bool writeTemplateFile(const char *pFileName)
 {
-	WzConfig ini(pFileName, WzConfig::ReadAndWrite);
+	WzConfig ini(pFileName, WzConfig::ReadAndWrite, saveFormat());
 
 	auto writeTemplate = [&](DROID_TEMPLATE *psCurr) {
 		saveTemplateCommon(ini, psCurr);
@@ -6238,7 +6361,7 @@ bool loadSaveResearch(const char *pFileName)
 // Write out the current state of the Research per player
 static bool writeResearchFile(char *pFileName)
 {
-	WzConfig ini(WzString::fromUtf8(pFileName), WzConfig::ReadAndWrite);
+	WzConfig ini(WzString::fromUtf8(pFileName), WzConfig::ReadAndWrite, saveFormat());
 
 	for (size_t i = 0; i < asResearch.size(); ++i)
 	{
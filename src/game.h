@@ -121,6 +121,8 @@ bool loadScriptState(char *pFileName);
 bool loadTerrainTypeMap(char *pFileData, UDWORD filesize);
 
 bool saveGame(const char *aFileName, GAME_TYPE saveType);
+/// Rewrites the objects, templates and research of a savegame directory as JSON, to read or edit them, or back as binary, with the objects as records.
+bool convertSaveGame(const char *saveDir, bool toBinary);
 
 // Get the campaign number for loadGameInit game
 UDWORD getCampaign(const char *fileName);
@@ -38,6 +38,7 @@
 #include "lib/ivis_opengl/tex.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/sound/audio_id.h"
 #include "lib/sound/cdaudio.h"
@@ -48,6 +49,7 @@
 #include "advvis.h"
 #include "atmos.h"
 #include "challenge.h"
+#include "clparse.h"
 #include "cmddroid.h"
 #include "configuration.h"
 #include "console.h"
@@ -86,6 +88,7 @@
 #include "scripttabs.h"
 #include "scriptvals.h"
 #include "text.h"
+#include "tickperf.h"
 #include "transporter.h"
 #include "warzoneconfig.h"
 #include "main.h"
@@ -699,11 +702,13 @@ bool systemInitialise(float horizScaleFactor, float vertScaleFactor)
 		return false;
 	}
 
-	if (!audio_Init(droidAudioTrackStopped, war_getSoundEnabled()))
+	// No audio device when headless, without touching the saved sound setting
+	const bool soundEnabled = war_getSoundEnabled() && !headless_enabled();
+	if (!audio_Init(droidAudioTrackStopped, soundEnabled))
 	{
 		debug(LOG_SOUND, "Continuing without audio");
 	}
-	if (war_getSoundEnabled() && war_GetMusicEnabled())
+	if (soundEnabled && war_GetMusicEnabled())
 	{
 		cdAudio_Open(UserMusicPath);
 	}
@@ -765,6 +770,7 @@ void systemShutdown()
 	levShutDown();
 	widgShutDown();
 	fpathShutdown();
+	visShutdown();
 	mapShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
@@ -1142,6 +1148,7 @@ bool stageTwoShutDown()
 	debug(LOG_WZ, "== stageTwoShutDown ==");
 
 	fpathShutdown();
+	visShutdown();
 
 	cdAudio_Stop();
 
@@ -1307,6 +1314,10 @@ bool stageThreeShutDown()
 
 	hostlaunch = 0;
 
+	NETreplaySaveStop();
+	NETreplayLoadStop();
+	tickPerfStop();
+
 	removeSpotters();
 
 	// There is an asymmetry in scripts initialization and destruction, due
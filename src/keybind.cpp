@@ -18,6 +18,7 @@
 	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 */
 #include <string.h>
+#include <chrono>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/stdio_ext.h"
@@ -53,6 +54,7 @@
 
 #include "cheat.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netsocket.h"
 #include "multiplay.h"
 #include "multimenu.h"
 #include "atmos.h"
@@ -72,6 +74,9 @@
 #include "scriptextern.h"
 #include "mission.h"
 #include "mapgrid.h"
+#include "projectile.h"
+#include "astar.h"
+#include "fpath.h"
 #include "order.h"
 #include "selection.h"
 #include "difficulty.h"
@@ -82,6 +87,7 @@
 #include "template.h"
 #include "qtscript.h"
 #include "multigifts.h"
+#include "tickperf.h"
 
 /*
 	KeyBind.c
@@ -197,6 +203,131 @@ void	kf_PowerInfo()
 	}
 }
 
+void kf_PathInfo()
+{
+	FPATH_STATISTICS stats = fpathGetStatistics(true);
+	console("Pathfinding: %u threads, %u jobs queued (max %u)", stats.threads, stats.queueLength, stats.maxQueueLength);
+	console("%u jobs done, latency avg %u ms, max %u ms", stats.jobsDone, stats.jobsDone ? (unsigned)(stats.totalLatency / stats.jobsDone) : 0, stats.maxLatency);
+	FPATH_BLOCKING_STATISTICS blocking = fpathGetBlockingStatistics(true);
+	console("Blocking maps: %u full builds, avg %u us", blocking.fullBuilds, blocking.fullBuilds ? (unsigned)(blocking.fullTime / blocking.fullBuilds) : 0);
+	console("%u incremental builds, avg %u us, %u tiles", blocking.incrementalBuilds, blocking.incrementalBuilds ? (unsigned)(blocking.incrementalTime / blocking.incrementalBuilds) : 0, (unsigned)blocking.tilesUpdated);
+}
+
+// Time looking up objects by id with the id index, compared to searching the object lists
+void kf_IdLookupInfo()
+{
+	std::vector<uint32_t> ids;
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+		{
+			ids.push_back(psDroid->id);
+		}
+		for (STRUCTURE *psStruct = apsStructLists[player]; psStruct != nullptr; psStruct = psStruct->psNext)
+		{
+			ids.push_back(psStruct->id);
+		}
+	}
+	for (FEATURE *psFeat = apsFeatureLists[0]; psFeat != nullptr; psFeat = psFeat->psNext)
+	{
+		ids.push_back(psFeat->id);
+	}
+	if (ids.empty())
+	{
+		console("No objects to look up");
+		return;
+	}
+
+	const unsigned lookups = 10000;
+	using microDuration = std::chrono::duration<uint64_t, std::micro>;
+	unsigned found = 0;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned i = 0; i < lookups; ++i)
+	{
+		found += getBaseObjFromId(ids[i % ids.size()]) != nullptr;
+	}
+	auto indexTime = std::chrono::high_resolution_clock::now();
+	for (unsigned i = 0; i < lookups; ++i)
+	{
+		found += IdToPointer(ids[i % ids.size()], ANYPLAYER) != nullptr;
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	console("Id lookup: %u objects, %u lookups (%u found)", (unsigned)ids.size(), lookups, found);
+	console("Index %u us, list search %u us", (unsigned)std::chrono::duration_cast<microDuration>(indexTime - startTime).count(), (unsigned)std::chrono::duration_cast<microDuration>(endTime - indexTime).count());
+}
+
+void kf_GridInfo()
+{
+	const unsigned iterations = 100;
+	std::chrono::microseconds rebuildTime, updateTime;
+	gridBenchmark(iterations, rebuildTime, updateTime);
+	console("Grid: %u objects, rebuild %u us, update %u us (average of %u, without moving anything)", (unsigned)gridObjectCount(), (unsigned)(rebuildTime.count() / iterations), (unsigned)(updateTime.count() / iterations), iterations);
+}
+
+void kf_ProjectileInfo()
+{
+	// What happened since the last time, so that rates during a battle can be compared between builds.
+	static PROJECTILE_POOL_STATS last = {0, 0, 0, 0, 0};
+	static UDWORD lastTime = 0;
+	PROJECTILE_POOL_STATS stats = proj_GetPoolStats();
+	if (gameTime < lastTime || stats.slabs < last.slabs)
+	{
+		last = PROJECTILE_POOL_STATS{0, 0, 0, 0, 0};  // A new game.
+		lastTime = 0;
+	}
+	console("Projectiles: %u in use, room for %u in %u slabs, %u created", (unsigned)stats.live, (unsigned)stats.capacity, (unsigned)stats.slabs, (unsigned)stats.created);
+	console("Damaged lists: %u allocations", (unsigned)stats.damagedAllocations);
+	console("In the last %u ms: %u projectiles created, %u slabs and %u damaged lists allocated", (unsigned)(gameTime - lastTime), (unsigned)(stats.created - last.created), (unsigned)(stats.slabs - last.slabs), (unsigned)(stats.damagedAllocations - last.damagedAllocations));
+	last = stats;
+	lastTime = gameTime;
+}
+
+void kf_EffectInfo()
+{
+	console("Effects: %u live, %u not added since there were too many", (unsigned)effectsCount(), (unsigned)effectsDroppedCount());
+}
+
+void kf_NetBenchmark()
+{
+	const unsigned iterations = 10000;
+	std::chrono::microseconds encodeTime, decodeTime;
+	size_t messageBytes;
+	NETbenchmarkSerialisation(iterations, encodeTime, decodeTime, messageBytes);
+	double megabytes = double(messageBytes) * iterations / (1024 * 1024);
+	console("Droid orders: %u messages of %u bytes, encoded at %.1f MB/s, decoded at %.1f MB/s", iterations, (unsigned)messageBytes, megabytes * 1e6 / std::max<int64_t>(encodeTime.count(), 1), megabytes * 1e6 / std::max<int64_t>(decodeTime.count(), 1));
+
+	const unsigned players = 10, messagesPerTick = 20, ticks = 1000;
+	std::chrono::microseconds queueTime;
+	size_t pushed = NETbenchmarkQueues(players, messagesPerTick, ticks, queueTime);
+	console("Host relaying %u messages per tick for %u players: %u messages pushed and popped in %u us", messagesPerTick, players, (unsigned)pushed, (unsigned)queueTime.count());
+}
+
+void kf_SocketBenchmark()
+{
+	const unsigned clients = 200, messages = 100, messageSize = 64;
+	std::chrono::microseconds time;
+	size_t received = SOCKETbenchmarkLoopback(clients, messages, messageSize, time);
+	if (received == 0)
+	{
+		console("Socket benchmark failed, see the log for details");
+		return;
+	}
+	console("%u loopback clients sent %u messages of %u bytes each, received in %u us", clients, messages, messageSize, (unsigned)time.count());
+}
+
+void kf_ToggleTickProfile()
+{
+	if (tickPerfActive())
+	{
+		tickPerfStop();
+	}
+	else
+	{
+		tickPerfStart();
+	}
+}
+
 void kf_DamageMe()
 {
 #ifndef DEBUG
@@ -649,6 +780,12 @@ void	kf_FrameRate()
 		                          NETgetStatistic(NetStatisticUncompressedBytes, false),
 		                          NETgetStatistic(NetStatisticPackets, true),
 		                          NETgetStatistic(NetStatisticPackets, false));
+		unsigned flushes = NETgetStatistic(NetStatisticCodecCalls, true), inflates = NETgetStatistic(NetStatisticCodecCalls, false);
+		CONPRINTF("COMPRESSION:  Time: s-%uus r-%uus  Per flush: %uus  Per read: %uus",
+		                          NETgetStatistic(NetStatisticCodecMicroseconds, true),
+		                          NETgetStatistic(NetStatisticCodecMicroseconds, false),
+		                          NETgetStatistic(NetStatisticCodecMicroseconds, true) / std::max(flushes, 1u),
+		                          NETgetStatistic(NetStatisticCodecMicroseconds, false) / std::max(inflates, 1u));
 	}
 	gameStats = !gameStats;
 	CONPRINTF("Built: %s %s", getCompileDate(), __TIME__);
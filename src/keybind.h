@@ -267,6 +267,14 @@ bool runningMultiplayer();
 
 void kf_ForceDesync();
 void kf_PowerInfo();
+void kf_PathInfo();
+void kf_IdLookupInfo();
+void kf_GridInfo();
+void kf_ProjectileInfo();
+void kf_EffectInfo();
+void kf_NetBenchmark();
+void kf_SocketBenchmark();
+void kf_ToggleTickProfile();
 void kf_BuildNextPage();
 void kf_BuildPrevPage();
 void kf_DamageMe();
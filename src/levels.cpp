@@ -1049,7 +1049,7 @@ bool levLoadData(char const *name, Sha256 const *hash, char *pSaveName, GAME_TYP
 	if (autogame_enabled())
 	{
 		gameTimeSetMod(Rational(500));
-		if (hostlaunch != 2) // tests will specify the AI manually
+		if (hostlaunch != 2 && hostlaunch != 3) // tests will specify the AI manually, replays have none
 		{
 			jsAutogameSpecific("multiplay/skirmish/semperfi.js", selectedPlayer);
 		}
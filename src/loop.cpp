@@ -85,6 +85,7 @@
 #include "random.h"
 #include "qtscript.h"
 #include "version.h"
+#include "tickperf.h"
 
 #include "warzoneconfig.h"
 
@@ -133,6 +134,45 @@ LOOP_MISSION_STATE		loopMissionState = LMS_NORMAL;
 // this is set by scrStartMission to say what type of new level is to be started
 LEVEL_TYPE nextMissionType = LDS_NONE;
 
+/// Deal with the mission state. Returns GAMECODE_CONTINUE, unless the game loop needs to be restarted or left.
+static GAMECODE updateMissionState()
+{
+	switch (loopMissionState)
+	{
+	case LMS_CLEAROBJECTS:
+		missionDestroyObjects();
+		setScriptPause(true);
+		loopMissionState = LMS_SETUPMISSION;
+		break;
+
+	case LMS_NORMAL:
+		// default
+		break;
+	case LMS_SETUPMISSION:
+		setScriptPause(false);
+		if (!setUpMission(nextMissionType))
+		{
+			return GAMECODE_QUITGAME;
+		}
+		break;
+	case LMS_SAVECONTINUE:
+		// just wait for this to be changed when the new mission starts
+		break;
+	case LMS_NEWLEVEL:
+		//nextMissionType = MISSION_NONE;
+		nextMissionType = LDS_NONE;
+		return GAMECODE_NEWLEVEL;
+		break;
+	case LMS_LOADGAME:
+		return GAMECODE_LOADGAME;
+		break;
+	default:
+		ASSERT(false, "unknown loopMissionState");
+		break;
+	}
+	return GAMECODE_CONTINUE;
+}
+
 static GAMECODE renderLoop()
 {
 	if (bMultiPlayer && !NetPlay.isHostAlive && NetPlay.bComms && !NetPlay.isHost)
@@ -352,38 +392,10 @@ static GAMECODE renderLoop()
 	}
 
 	// deal with the mission state
-	switch (loopMissionState)
+	GAMECODE missionCode = updateMissionState();
+	if (missionCode != GAMECODE_CONTINUE)
 	{
-	case LMS_CLEAROBJECTS:
-		missionDestroyObjects();
-		setScriptPause(true);
-		loopMissionState = LMS_SETUPMISSION;
-		break;
-
-	case LMS_NORMAL:
-		// default
-		break;
-	case LMS_SETUPMISSION:
-		setScriptPause(false);
-		if (!setUpMission(nextMissionType))
-		{
-			return GAMECODE_QUITGAME;
-		}
-		break;
-	case LMS_SAVECONTINUE:
-		// just wait for this to be changed when the new mission starts
-		break;
-	case LMS_NEWLEVEL:
-		//nextMissionType = MISSION_NONE;
-		nextMissionType = LDS_NONE;
-		return GAMECODE_NEWLEVEL;
-		break;
-	case LMS_LOADGAME:
-		return GAMECODE_LOADGAME;
-		break;
-	default:
-		ASSERT(false, "unknown loopMissionState");
-		break;
+		return missionCode;
 	}
 
 	int clearMode = 0;
@@ -417,6 +429,20 @@ static GAMECODE renderLoop()
 	return GAMECODE_CONTINUE;
 }
 
+/// Replaces renderLoop when running headless. Does the parts of it which affect the game state, but no drawing, sound or input.
+static GAMECODE headlessLoop()
+{
+	if (!paused && !gameUpdatePaused() && bMultiPlayer)
+	{
+		multiPlayerLoop();
+	}
+	if (!paused && !consolePaused())
+	{
+		updateConsoleMessages();
+	}
+	return updateMissionState();
+}
+
 // Carry out the various counting operations we perform each loop
 void countUpdate(bool synch)
 {
@@ -536,14 +562,20 @@ static void gameStateUpdate()
 	syncDebug("My client version = %s", version_getVersionString());
 	syncDebugSetCrc(crc);
 
-	// Actually send pending droid orders.
-	sendQueuedDroidInfo();
+	{
+		TickPerfScope perf(TICK_PERF_NETWORK);
 
-	sendPlayerGameTime();
-	NETflush();  // Make sure the game time tick message is really sent over the network.
+		// Actually send pending droid orders.
+		sendQueuedDroidInfo();
+
+		sendPlayerGameTime();
+		NETflush();  // Make sure the game time tick message is really sent over the network.
+	}
 
 	if (!paused && !scriptPaused())
 	{
+		TickPerfScope perf(TICK_PERF_SCRIPTS);
+
 		/* Update the event system */
 		if (!bInTutorial)
 		{
@@ -560,19 +592,34 @@ static void gameStateUpdate()
 	handleAbandonedStructures();
 
 	// Update the visibility change stuff
-	visUpdateLevel();
+	{
+		TickPerfScope perf(TICK_PERF_VISIBILITY);
+		visUpdateLevel();
+	}
 
 	// Put all droids/structures/features into the grid.
-	gridReset();
+	{
+		TickPerfScope perf(TICK_PERF_GRID);
+		gridReset();
+	}
 
 	// Check which objects are visible.
-	processVisibility();
+	{
+		TickPerfScope perf(TICK_PERF_VISIBILITY);
+		processVisibility();
+	}
 
 	// Update the map.
-	mapUpdate();
+	{
+		TickPerfScope perf(TICK_PERF_MAP);
+		mapUpdate();
+	}
 
 	//update the findpath system
-	fpathUpdate();
+	{
+		TickPerfScope perf(TICK_PERF_PATHFINDING);
+		fpathUpdate();
+	}
 
 	// update the command droids
 	cmdDroidUpdate();
@@ -584,54 +631,78 @@ static void gameStateUpdate()
 		//update the current power available for a player
 		updatePlayerPower(i);
 
-		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
-		}
+			TickPerfScope perf(TICK_PERF_DROIDS);
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
-		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
-		}
+			DROID *psNext;
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+			}
 
-		// FIXME: These for-loops are code duplicationo
-		STRUCTURE *psNBuilding;
-		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
-		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, false);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+			}
 		}
-		for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, true); // update for mission
+			TickPerfScope perf(TICK_PERF_STRUCTURES);
+
+			// FIXME: These for-loops are code duplicationo
+			STRUCTURE *psNBuilding;
+			for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, false);
+			}
+			for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, true); // update for mission
+			}
 		}
 	}
 
+	// Apply the vision of the droids and structures which moved or were built, before the projectiles and AI use it.
+	{
+		TickPerfScope perf(TICK_PERF_VISIBILITY);
+		visTilesUpdateQueued();
+	}
+
 	missionTimerUpdate();
 
-	proj_UpdateAll();
+	{
+		TickPerfScope perf(TICK_PERF_PROJECTILES);
+		proj_UpdateAll();
+	}
 
-	FEATURE *psNFeat;
-	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
 	{
-		psNFeat = psCFeat->psNext;
-		featureUpdate(psCFeat);
+		TickPerfScope perf(TICK_PERF_FEATURES);
+
+		FEATURE *psNFeat;
+		for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
+		{
+			psNFeat = psCFeat->psNext;
+			featureUpdate(psCFeat);
+		}
 	}
 
 	// Clean up dead droid pointers in UI.
 	hciUpdate();
 
 	// Free dead droid memory.
-	objmemUpdate();
+	{
+		TickPerfScope perf(TICK_PERF_OBJMEM);
+		objmemUpdate();
+	}
 
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
@@ -677,7 +748,9 @@ GAMECODE gameLoop()
 
 		unsigned before = wzGetTicks();
 		syncDebug("Begin game state update, gameTime = %d", gameTime);
+		tickPerfBeginTick();
 		gameStateUpdate();
+		tickPerfEndTick();
 		syncDebug("End game state update, gameTime = %d", gameTime);
 		unsigned after = wzGetTicks();
 
@@ -695,7 +768,7 @@ GAMECODE gameLoop()
 	}
 
 	unsigned before = wzGetTicks();
-	GAMECODE renderReturn = renderLoop();
+	GAMECODE renderReturn = wzIsHeadless() ? headlessLoop() : renderLoop();
 	unsigned after = wzGetTicks();
 
 	renderBudget += (after - before) * updateFraction.n;
@@ -712,8 +785,8 @@ void videoLoop()
 
 	ASSERT(videoMode == 1, "videoMode out of sync");
 
-	// display a frame of the FMV
-	videoFinished = !seq_UpdateFullScreenVideo(nullptr);
+	// display a frame of the FMV, or skip it if there is nowhere to display it
+	videoFinished = wzIsHeadless() || !seq_UpdateFullScreenVideo(nullptr);
 	pie_ScreenFlip(CLEAR_BLACK);
 
 	// should we stop playing?
@@ -53,6 +53,7 @@
 #include "lib/ivis_opengl/piepalette.h"
 #include "lib/ivis_opengl/piemode.h"
 #include "lib/ivis_opengl/screen.h"
+#include "lib/ivis_opengl/gfx_api.h"
 #include "lib/netplay/netplay.h"
 #include "lib/script/script.h"
 #include "lib/sound/audio.h"
@@ -1168,6 +1169,8 @@ int realmain(int argc, char *argv[])
 
 	PHYSFS_mkdir("music");	// custom music overriding default music and music mods
 
+	PHYSFS_mkdir("replay");	// recordings of the most recent skirmish and multiplayer games, played back with --replay=replay/file
+
 	make_dir(SaveGamePath, "savegames", nullptr); 	// save games
 	PHYSFS_mkdir("savegames/campaign");		// campaign save games
 	PHYSFS_mkdir("savegames/skirmish");		// skirmish save games
@@ -1305,7 +1308,23 @@ int realmain(int argc, char *argv[])
 		}
 	}
 
-	if (!wzMainScreenSetup(war_getAntialiasing(), war_getFullscreen(), war_GetVsync()))
+	if (!wz_convert_savegame().empty())
+	{
+		// Only needs the filesystem, so there is no need to start the game.
+		return convertSaveGame(wz_convert_savegame().c_str(), wz_convert_to_binary()) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (headless_enabled())
+	{
+		// Nothing is drawn, so don't create a window or GL context, and run the game as fast as possible.
+		gfx_api::context::select_backend(gfx_api::backend_type::null_backend);
+		if (!wzMainHeadlessSetup())
+		{
+			return EXIT_FAILURE;
+		}
+		gameTimeSetFixedStep(true);
+	}
+	else if (!wzMainScreenSetup(war_getAntialiasing(), war_getFullscreen(), war_GetVsync()))
 	{
 		return EXIT_FAILURE;
 	}
@@ -1320,7 +1339,7 @@ int realmain(int argc, char *argv[])
 	int h = pie_GetVideoBufferHeight();
 
 	char buf[256];
-	ssprintf(buf, "Video Mode %d x %d (%s)", w, h, war_getFullscreen() ? "fullscreen" : "window");
+	ssprintf(buf, "Video Mode %d x %d (%s)", w, h, headless_enabled() ? "headless" : war_getFullscreen() ? "fullscreen" : "window");
 	addDumpInfo(buf);
 
 	float horizScaleFactor, vertScaleFactor;
@@ -1332,13 +1351,16 @@ int realmain(int argc, char *argv[])
 	{
 		return EXIT_FAILURE;
 	}
-	if (!screenInitialise())
+	if (!headless_enabled())
 	{
-		return EXIT_FAILURE;
-	}
-	if (!pie_LoadShaders())
-	{
-		return EXIT_FAILURE;
+		if (!screenInitialise())
+		{
+			return EXIT_FAILURE;
+		}
+		if (!pie_LoadShaders())
+		{
+			return EXIT_FAILURE;
+		}
 	}
 	unsigned int windowWidth = 0, windowHeight = 0;
 	wzGetWindowResolution(nullptr, &windowWidth, &windowHeight);
@@ -69,6 +69,13 @@ static int lastDangerPlayer = -1;
 //scroll min and max values
 SDWORD		scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
 
+std::vector<AuxDirtyRect> auxDirtyRects;
+unsigned auxThreatGeneration[MAX_PLAYERS];
+unsigned auxMapGeneration = 0;
+
+/// If there are more dirty rectangles than this, they are merged into one.
+#define AUX_MAX_DIRTY_RECTS 256
+
 /* Structure definitions for loading and saving map data */
 struct MAP_SAVEHEADER  // : public GAME_SAVEHEADER
 {
@@ -105,6 +112,7 @@ struct GATEWAY_SAVE
 /* The size and contents of the map */
 SDWORD	mapWidth = 0, mapHeight = 0;
 MAPTILE	*psMapTiles = nullptr;
+MAPTILE_VISION *psMapVision = nullptr;
 uint8_t *psBlockMap[AUX_MAX];
 uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];        // yes, we waste one element... eyes wide open... makes API nicer
 
@@ -786,6 +794,8 @@ bool mapLoad(char *filename, bool preview)
 	/* Allocate the memory for the map */
 	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE));
 	ASSERT(psMapTiles != nullptr, "Out of memory");
+	psMapVision = (MAPTILE_VISION *)calloc(width * height, sizeof(MAPTILE_VISION));
+	ASSERT(psMapVision != nullptr, "Out of memory");
 
 	mapWidth = width;
 	mapHeight = height;
@@ -820,9 +830,7 @@ bool mapLoad(char *filename, bool preview)
 		psMapTiles[i].height = height * ELEVATION_SCALE;
 
 		// Visibility stuff
-		memset(psMapTiles[i].watchers, 0, sizeof(psMapTiles[i].watchers));
-		memset(psMapTiles[i].sensors, 0, sizeof(psMapTiles[i].sensors));
-		memset(psMapTiles[i].jammers, 0, sizeof(psMapTiles[i].jammers));
+		memset(&psMapVision[i], 0, sizeof(psMapVision[i]));
 		psMapTiles[i].sensorBits = 0;
 		psMapTiles[i].jammerBits = 0;
 		psMapTiles[i].tileExploredBits = 0;
@@ -883,6 +891,7 @@ bool mapLoad(char *filename, bool preview)
 	{
 		psAuxMap[x] = (uint8_t *)malloc(mapWidth * mapHeight * sizeof(*psAuxMap[0]));
 	}
+	++auxMapGeneration;
 
 	// Set our blocking bits
 	for (y = 0; y < mapHeight; y++)
@@ -1040,6 +1049,7 @@ bool mapShutdown()
 	}
 
 	free(psMapTiles);
+	free(psMapVision);
 	delete[] mapDecals;
 	free(psGroundTypes);
 	free(map);
@@ -1056,12 +1066,14 @@ bool mapShutdown()
 		free(psAuxMap[x]);
 		psAuxMap[x] = nullptr;
 	}
+	++auxMapGeneration;
 
 	map = nullptr;
 	floodbucket = nullptr;
 	psGroundTypes = nullptr;
 	mapDecals = nullptr;
 	psMapTiles = nullptr;
+	psMapVision = nullptr;
 	mapWidth = mapHeight = 0;
 	numTile_names = 0;
 	Tile_names = nullptr;
@@ -1673,6 +1685,46 @@ static const Vector2i aDirOffset[] =
 	Vector2i(1, 1),
 };
 
+void auxMarkDirtyRect(int x, int y)
+{
+	if (!auxDirtyRects.empty())
+	{
+		// Grow the last rectangle, if the tile is next to it. Structures and features mark their tiles row by row.
+		AuxDirtyRect &rect = auxDirtyRects.back();
+		if (x == rect.x2 && y >= rect.y1 && y < rect.y2 && rect.y2 - rect.y1 == 1)
+		{
+			++rect.x2;
+			return;
+		}
+		if (y == rect.y2 && x >= rect.x1 && x < rect.x2)
+		{
+			++rect.y2;
+			return;
+		}
+	}
+	if (auxDirtyRects.size() >= AUX_MAX_DIRTY_RECTS)
+	{
+		// Too many changes to be worth tracking separately, so merge them.
+		AuxDirtyRect all = {x, y, x + 1, y + 1};
+		for (AuxDirtyRect const &rect : auxDirtyRects)
+		{
+			all.x1 = std::min(all.x1, rect.x1);
+			all.y1 = std::min(all.y1, rect.y1);
+			all.x2 = std::max(all.x2, rect.x2);
+			all.y2 = std::max(all.y2, rect.y2);
+		}
+		auxDirtyRects.assign(1, all);
+		return;
+	}
+	auxDirtyRects.push_back({x, y, x + 1, y + 1});
+}
+
+void auxTakeDirtyRects(std::vector<AuxDirtyRect> &rects)
+{
+	rects.clear();
+	std::swap(rects, auxDirtyRects);
+}
+
 // Flood fill a "continent".
 // TODO take into account scroll limits and update continents on scroll limit changes
 static void mapFloodFill(int x, int y, int continent, uint8_t blockedBits, uint16_t MAPTILE::*varContinent)
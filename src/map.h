@@ -92,24 +92,31 @@ struct GROUND_TYPE
 };
 
 /* Information stored with each tile */
+/* The fields used by pathfinding, wavecasting and map_Height come first. The per-player vision counters, which only the
+ * visibility code uses, are kept separately in MAPTILE_VISION, to keep the tiles small. */
 struct MAPTILE
 {
+	int32_t                 height;                 ///< The height at the top left of the tile
+	int32_t                 waterLevel;             ///< At what height is the water for this tile
+	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
+	uint16_t		hoverContinent;		///< For hover type propulsions
 	uint8_t			tileInfoBits;
+	uint8_t			illumination;	// How bright is this tile?
+	uint8_t			ground;			///< The ground type used for the terrain renderer
 	PlayerMask              tileExploredBits;
 	PlayerMask              sensorBits;             ///< bit per player, who can see tile with sensor
-	uint8_t			illumination;	// How bright is this tile?
-	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
+	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
 	uint16_t		texture;		// Which graphics texture is on this tile
-	int32_t                 height;                 ///< The height at the top left of the tile
-	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
+	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
 	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
+	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
 	PIELIGHT		colour;
-	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
-	uint16_t		hoverContinent;		///< For hover type propulsions
-	uint8_t			ground;			///< The ground type used for the terrain renderer
-	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
-	int32_t                 waterLevel;             ///< At what height is the water for this tile
-	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
+};
+
+/* Vision counters of each tile, in a separate array parallel to psMapTiles */
+struct MAPTILE_VISION
+{
+	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
 	uint8_t                 sensors[MAX_PLAYERS];   ///< player sees this tile with this many radar sensors
 	uint8_t                 jammers[MAX_PLAYERS];   ///< player jams the tile with this many objects
 };
@@ -117,6 +124,7 @@ struct MAPTILE
 /* The size and contents of the map */
 extern SDWORD	mapWidth, mapHeight;
 extern MAPTILE *psMapTiles;
+extern MAPTILE_VISION *psMapVision;
 extern float waterLevel;
 extern GROUND_TYPE *psGroundTypes;
 extern int numGroundTypes;
@@ -145,6 +153,39 @@ extern char *tilesetDir;
 extern uint8_t *psBlockMap[AUX_MAX];
 extern uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];	// yes, we waste one element... eyes wide open... makes API nicer
 
+/// Rectangle of tiles, x1 <= x < x2 and y1 <= y < y2, where aux or blocking bits changed.
+struct AuxDirtyRect
+{
+	int x1, y1, x2, y2;
+};
+
+/// Changes to the aux and blocking bits of all players since auxTakeDirtyRects was last called, for incrementally updating the pathfinding blocking maps.
+/// Only the auxSetAll/auxSetAllied/auxSetEnemy/auxClearAll/auxSetBlocking/auxClearBlocking functions record changes, the single-player versions are for the danger map.
+extern std::vector<AuxDirtyRect> auxDirtyRects;
+/// Incremented whenever the threat bits of a player are restored from the danger map.
+extern unsigned auxThreatGeneration[MAX_PLAYERS];
+/// Incremented whenever the aux maps are allocated, freed or swapped with the mission's, so the changed tiles no longer describe them.
+extern unsigned auxMapGeneration;
+
+void auxMarkDirtyRect(int x, int y);
+
+/// Record that the aux or blocking bits of a tile changed.
+WZ_DECL_ALWAYS_INLINE static inline void auxMarkDirty(int x, int y)
+{
+	if (!auxDirtyRects.empty())
+	{
+		AuxDirtyRect &rect = auxDirtyRects.back();
+		if (x >= rect.x1 && x < rect.x2 && y >= rect.y1 && y < rect.y2)
+		{
+			return;  // Already marked.
+		}
+	}
+	auxMarkDirtyRect(x, y);
+}
+
+/// Moves the rectangles changed since the last call into rects.
+void auxTakeDirtyRects(std::vector<AuxDirtyRect> &rects);
+
 /// Find aux bitfield for a given tile
 WZ_DECL_ALWAYS_INLINE static inline uint8_t auxTile(int x, int y, int player)
 {
@@ -176,6 +217,10 @@ static inline void auxMapRestore(int player, int slot, int mask)
 		cached = psAuxMap[MAX_PLAYERS + slot][i];
 		psAuxMap[player][i] = original ^ ((original ^ cached) & mask);
 	}
+	if (player < MAX_PLAYERS && (mask & AUXBITS_THREAT) != 0)
+	{
+		++auxThreatGeneration[player];
+	}
 }
 
 /// Set aux bits. Always set identically for all players. States not set are retained.
@@ -189,6 +234,8 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAll(int x, int y, int state)
 {
 	int i;
 
+	auxMarkDirty(x, y);
+
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		psAuxMap[i][x + y * mapWidth] |= state;
@@ -200,6 +247,8 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetAllied(int x, int y, int player,
 {
 	int i;
 
+	auxMarkDirty(x, y);
+
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (alliancebits[player] & (1 << i))
@@ -214,6 +263,8 @@ WZ_DECL_ALWAYS_INLINE static inline void auxSetEnemy(int x, int y, int player, i
 {
 	int i;
 
+	auxMarkDirty(x, y);
+
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (!(alliancebits[player] & (1 << i)))
@@ -234,6 +285,8 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 {
 	int i;
 
+	auxMarkDirty(x, y);
+
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		psAuxMap[i][x + y * mapWidth] &= ~state;
@@ -243,12 +296,14 @@ WZ_DECL_ALWAYS_INLINE static inline void auxClearAll(int x, int y, int state)
 /// Set blocking bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSetBlocking(int x, int y, int state)
 {
+	auxMarkDirty(x, y);
 	psBlockMap[0][x + y * mapWidth] |= state;
 }
 
 /// Clear blocking bits. Always set identically for all players. States not cleared are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxClearBlocking(int x, int y, int state)
 {
+	auxMarkDirty(x, y);
 	psBlockMap[0][x + y * mapWidth] &= ~state;
 }
 
@@ -444,6 +499,12 @@ static inline WZ_DECL_PURE MAPTILE *mapTile(Vector2i const &v)
 	return mapTile(v.x, v.y);
 }
 
+/** Return a pointer to the vision counters of a tile returned by mapTile */
+static inline WZ_DECL_PURE MAPTILE_VISION *mapTileVision(const MAPTILE *psTile)
+{
+	return &psMapVision[psTile - psMapTiles];
+}
+
 /** Return a pointer to the tile structure at x,y in world coordinates */
 static inline WZ_DECL_PURE MAPTILE *worldTile(int32_t x, int32_t y)
 {
@@ -32,125 +32,254 @@
 #include "pointtree.h"
 
 
-static PointTree *gridPointTree = nullptr;  // A quad-tree-like object.
-static PointTree::Filter *gridFiltersUnseen;
-static PointTree::Filter *gridFiltersDroidsByPlayer;
+// The grid is kept in two layers, which are both quad-tree-like objects. Structures and features don't move, so their
+// layer only changes when one is added or removed. Droids move a little every tick, so their layer is re-sorted starting
+// from the previous order. Points in the same place are sorted by object id, so the order doesn't depend on the history.
+// Queries go to a merge of the two layers, since looking in one tree costs much less than looking in two.
+enum GRID_LAYER
+{
+	GRID_LAYER_DROIDS,
+	GRID_LAYER_STATIC,  ///< Structures and features.
+	GRID_LAYER_COUNT
+};
+
+struct GridFilter
+{
+	PointTree::Filter filter;
+};
+
+static PointTree *gridLayers = nullptr;
+static PointTree *gridPointTree = nullptr;  ///< The merged layers.
+static GridFilter *gridFiltersDroidsByPlayer;
 
 // initialise the grid system
 bool gridInitialise()
 {
-	ASSERT(gridPointTree == nullptr, "gridInitialise already called, without calling gridShutDown.");
+	ASSERT(gridLayers == nullptr, "gridInitialise already called, without calling gridShutDown.");
+	gridLayers = new PointTree[GRID_LAYER_COUNT];
 	gridPointTree = new PointTree;
-	gridFiltersUnseen = new PointTree::Filter[MAX_PLAYERS];
-	gridFiltersDroidsByPlayer = new PointTree::Filter[MAX_PLAYERS];
+	gridFiltersDroidsByPlayer = new GridFilter[MAX_PLAYERS];
 
 	return true;  // Yay, nothing failed!
 }
 
-// reset the grid system
-void gridReset()
+static void gridResetSeen(BASE_OBJECT *psObj)
+{
+	for (unsigned char &viewer : psObj->seenThisTick)
+	{
+		viewer = 0;
+	}
+}
+
+static void gridStoreIndices(PointTree const &layer)
+{
+	for (unsigned i = 0; i < layer.size(); ++i)
+	{
+		static_cast<BASE_OBJECT *>(layer.pointData(i))->gridIndex = i;
+	}
+}
+
+static void gridUpdateDroids(PointTree &layer, bool rebuild, bool resetSeen)
+{
+	static std::vector<DROID *> previous;  // Droids which were in the layer, in the previous order. static to avoid allocations.
+	static std::vector<DROID *> added;
+	previous.assign(rebuild ? 0 : layer.size(), nullptr);
+	added.clear();
+
+	for (unsigned player = 0; player < MAX_PLAYERS; player++)
+	{
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+		{
+			if (!psDroid->died)
+			{
+				if (resetSeen)
+				{
+					gridResetSeen(psDroid);
+				}
+				// The index may be out of date, if the droid spent some time outside the lists, but then the order is just a worse hint.
+				unsigned index = psDroid->gridIndex;
+				if (index < previous.size() && previous[index] == nullptr)
+				{
+					previous[index] = psDroid;
+				}
+				else
+				{
+					added.push_back(psDroid);
+				}
+			}
+		}
+	}
+
+	layer.clear();
+	for (DROID *psDroid : previous)
+	{
+		if (psDroid != nullptr)
+		{
+			layer.insert(psDroid, psDroid->pos.x, psDroid->pos.y, psDroid->id);
+		}
+	}
+	for (DROID *psDroid : added)
+	{
+		layer.insert(psDroid, psDroid->pos.x, psDroid->pos.y, psDroid->id);
+	}
+	if (rebuild)
+	{
+		layer.sort();
+	}
+	else
+	{
+		layer.sortNearlySorted();
+	}
+	gridStoreIndices(layer);
+}
+
+static void gridUpdateStatic(PointTree &layer, bool rebuild, bool resetSeen)
 {
-	gridPointTree->clear();
+	if (rebuild)
+	{
+		layer.clear();
+	}
+	static std::vector<bool> present;  // Whether each point in the layer is still a live structure or feature. static to avoid allocations.
+	static std::vector<BASE_OBJECT *> added;
+	static PointTree::IndexVector removed;
+	present.assign(layer.size(), false);
+	added.clear();
 
-	// Put all existing objects into the point tree.
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
-		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+		BASE_OBJECT *start[2] = {apsStructLists[player], apsFeatureLists[player]};
 		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
 		{
 			for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
-					for (unsigned char &viewer : psObj->seenThisTick)
+					if (resetSeen)
+					{
+						gridResetSeen(psObj);
+					}
+					// Only compares pointers, since objects which were removed from the layer may have been freed.
+					unsigned index = psObj->gridIndex;
+					if (index < present.size() && !present[index] && layer.pointData(index) == psObj)
 					{
-						viewer = 0;
+						present[index] = true;
+					}
+					else
+					{
+						added.push_back(psObj);
 					}
 				}
 			}
 		}
 	}
 
-	gridPointTree->sort();
+	removed.clear();
+	for (unsigned i = 0; i < present.size(); ++i)
+	{
+		if (!present[i])
+		{
+			removed.push_back(i);
+		}
+	}
+	if (added.empty() && removed.empty())
+	{
+		return;  // Nothing was built, destroyed or removed since last time.
+	}
+
+	layer.erase(removed);
+	size_t sortedSize = layer.size();
+	for (BASE_OBJECT *psObj : added)
+	{
+		layer.insert(psObj, psObj->pos.x, psObj->pos.y, psObj->id);
+	}
+	layer.sortInserted(sortedSize);
+	gridStoreIndices(layer);
+}
+
+// reset the grid system
+void gridReset()
+{
+	gridUpdateDroids(gridLayers[GRID_LAYER_DROIDS], false, true);
+	gridUpdateStatic(gridLayers[GRID_LAYER_STATIC], false, true);
+	gridPointTree->merge(gridLayers[GRID_LAYER_DROIDS], gridLayers[GRID_LAYER_STATIC]);
 
 	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 	{
-		gridFiltersUnseen[player].reset(*gridPointTree);
-		gridFiltersDroidsByPlayer[player].reset(*gridPointTree);
+		gridFilterReset(gridFiltersDroidsByPlayer[player]);
 	}
 }
 
 // shutdown the grid system
 void gridShutDown()
 {
+	delete[] gridLayers;
+	gridLayers = nullptr;
 	delete gridPointTree;
 	gridPointTree = nullptr;
-	delete[] gridFiltersUnseen;
-	gridFiltersUnseen = nullptr;
 	delete[] gridFiltersDroidsByPlayer;
 	gridFiltersDroidsByPlayer = nullptr;
 }
 
-static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
+size_t gridObjectCount()
 {
-	// cast to int64 to avoid integer overflow
-	return ((int64_t)x * (int64_t)x + (int64_t)y * (int64_t)y) <= ((int64_t)radius * (int64_t)radius);
+	return gridPointTree->size();
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
-template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+void gridBenchmark(unsigned iterations, std::chrono::microseconds &rebuildTime, std::chrono::microseconds &updateTime)
 {
-	if (filter == nullptr)
+	// Work on separate layers, since updating the real grid between game state updates could change what scripts see.
+	// The objects' gridIndex hints end up pointing into these layers, which only costs a slower update next tick.
+	PointTree layers[GRID_LAYER_COUNT];
+	PointTree merged;
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (unsigned i = 0; i < iterations; ++i)
 	{
-		gridPointTree->query(x, y, radius);
+		gridUpdateDroids(layers[GRID_LAYER_DROIDS], true, false);
+		gridUpdateStatic(layers[GRID_LAYER_STATIC], true, false);
+		merged.merge(layers[GRID_LAYER_DROIDS], layers[GRID_LAYER_STATIC]);
 	}
-	else
+	auto rebuiltTime = std::chrono::high_resolution_clock::now();
+	for (unsigned i = 0; i < iterations; ++i)
 	{
-		gridPointTree->query(*filter, x, y, radius);
+		gridUpdateDroids(layers[GRID_LAYER_DROIDS], false, false);
+		gridUpdateStatic(layers[GRID_LAYER_STATIC], false, false);
+		merged.merge(layers[GRID_LAYER_DROIDS], layers[GRID_LAYER_STATIC]);
 	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
-	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
+	auto endTime = std::chrono::high_resolution_clock::now();
+	rebuildTime = std::chrono::duration_cast<std::chrono::microseconds>(rebuiltTime - startTime);
+	updateTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - rebuiltTime);
+}
+
+static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
+{
+	// cast to int64 to avoid integer overflow
+	return ((int64_t)x * (int64_t)x + (int64_t)y * (int64_t)y) <= ((int64_t)radius * (int64_t)radius);
+}
+
+// Find the objects that could affect a location (x,y in world coords), which are within radius and pass the condition.
+template<class Condition>
+static void gridQueryFiltered(GridList &results, int32_t x, int32_t y, uint32_t radius, GridFilter *filter, Condition const &condition)
+{
+	results.clear();
+	PointTree::Filter *treeFilter = filter != nullptr ? &filter->filter : nullptr;
+	gridPointTree->visit(treeFilter, x - radius, y - radius, x + radius, y + radius, [&](void *pointData, unsigned index) {
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(pointData);
 		if (!condition.test(obj))  // Check if we should skip this object.
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
+			if (treeFilter != nullptr)
+			{
+				treeFilter->erase(index);  // Stop the object from appearing in future searches.
+			}
 		}
 		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
 		{
-			*w = *i;
-			++w;
+			results.push_back(obj);
 		}
-	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
+	});
 	/*
 	// In case you are curious.
-	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
+	debug(LOG_WARNING, "gridQueryFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)results.size());
 	*/
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
-	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
-	return gridList;
-}
-
-template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
-{
-	gridPointTree->query(x, y, x2, y2);
-
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
-	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
-	}
-	return gridList;
 }
 
 struct ConditionTrue
@@ -161,14 +290,17 @@ struct ConditionTrue
 	}
 };
 
-GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+void gridQuery(GridList &results, int32_t x, int32_t y, uint32_t radius)
 {
-	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
+	gridQueryFiltered(results, x, y, radius, nullptr, ConditionTrue());
 }
 
-GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+void gridQueryArea(GridList &results, int32_t x, int32_t y, int32_t x2, int32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	results.clear();
+	gridPointTree->visit(nullptr, x, y, x2, y2, [&results](void *pointData, unsigned) {
+		results.push_back(static_cast<BASE_OBJECT *>(pointData));
+	});
 }
 
 struct ConditionDroidsByPlayer
@@ -181,9 +313,9 @@ struct ConditionDroidsByPlayer
 	int player;
 };
 
-GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+static void gridQueryDroidsByPlayer(GridList &results, int32_t x, int32_t y, uint32_t radius, int player, GridFilter *filter)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
+	gridQueryFiltered(results, x, y, radius, filter, ConditionDroidsByPlayer(player));
 }
 
 struct ConditionUnseen
@@ -196,15 +328,67 @@ struct ConditionUnseen
 	int player;
 };
 
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player)
+void gridQueryUnseen(GridList &results, int32_t x, int32_t y, uint32_t radius, int player, GridFilter *filter)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
+	gridQueryFiltered(results, x, y, radius, filter, ConditionUnseen(player));
 }
 
-BASE_OBJECT **gridIterateDup()
+void gridNearest(GridList &results, int32_t x, int32_t y, unsigned k, uint32_t maxRadius, std::function<bool (BASE_OBJECT *)> const &condition)
 {
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	PointTree::ResultVector nearest;
+	gridPointTree->nearest(nearest, x, y, k, maxRadius, [&condition](void *pointData) {
+		return condition(static_cast<BASE_OBJECT *>(pointData));
+	});
+	results.clear();
+	for (void *pointData : nearest)
+	{
+		results.push_back(static_cast<BASE_OBJECT *>(pointData));
+	}
+}
+
+BASE_OBJECT *gridNearest(int32_t x, int32_t y, uint32_t maxRadius, std::function<bool (BASE_OBJECT *)> const &condition)
+{
+	GridList results;
+	gridNearest(results, x, y, 1, maxRadius, condition);
+	return results.empty() ? nullptr : results[0];
+}
+
+GridFilter *gridFilterCreate()
+{
+	GridFilter *filter = new GridFilter;
+	gridFilterReset(*filter);
+	return filter;
+}
+
+void gridFilterDelete(GridFilter *filter)
+{
+	delete filter;
+}
+
+void gridFilterReset(GridFilter &filter)
+{
+	filter.filter.reset(*gridPointTree);
+}
+
+// The original, non-reentrant interface, which shares one result list and one filter per player between all callers.
+
+GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
+{
+	static GridList gridList;
+	gridQuery(gridList, x, y, radius);
+	return gridList;
+}
+
+GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
+{
+	static GridList gridList;
+	gridQueryArea(gridList, x, y, x2, y2);
+	return gridList;
+}
+
+GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
+{
+	static GridList gridList;
+	gridQueryDroidsByPlayer(gridList, x, y, radius, player, &gridFiltersDroidsByPlayer[player]);
+	return gridList;
 }
@@ -24,8 +24,13 @@
 #ifndef __INCLUDED_SRC_MAPGRID_H__
 #define __INCLUDED_SRC_MAPGRID_H__
 
+#include <chrono>
+#include <functional>
+
 typedef std::vector<BASE_OBJECT *> GridList;
 typedef GridList::const_iterator GridIterator;
+/// Remembers objects which failed the condition of a filtered query, so that later queries can skip them. Invalidated by gridReset.
+struct GridFilter;
 
 // initialise the grid system
 bool gridInitialise();
@@ -37,6 +42,12 @@ void gridShutDown();
 // Resets seenThisTick[] to false.
 void gridReset();
 
+/// Number of objects in the grid.
+size_t gridObjectCount();
+
+/// Times rebuilding the grid from scratch, and updating it when nothing has moved, iterations times each.
+void gridBenchmark(unsigned iterations, std::chrono::microseconds &rebuildTime, std::chrono::microseconds &updateTime);
+
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
@@ -46,8 +57,26 @@ GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t
 /// Find all objects within radius where object->type == OBJ_DROID && object->player == player.
 GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player);
 
-// Used for visibility.
-/// Find all objects within radius where object->seenThisTick[player] != 255.
-GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
+// Reentrant queries, which replace the contents of the caller's results instead of returning a shared list.
+// They may run concurrently from several threads, as long as gridReset is not called meanwhile and no GridFilter is used by two threads at once.
+
+/// Find all objects within radius.
+void gridQuery(GridList &results, int32_t x, int32_t y, uint32_t radius);
+
+/// Find all objects within the rectangle from (x, y) to (x2, y2).
+void gridQueryArea(GridList &results, int32_t x, int32_t y, int32_t x2, int32_t y2);
+
+/// Find all objects within radius where object->seenThisTick[player] != 255. The filter is optional.
+void gridQueryUnseen(GridList &results, int32_t x, int32_t y, uint32_t radius, int player, GridFilter *filter = nullptr);
+
+/// Find the k objects nearest to (x, y), no further than maxRadius, for which condition(object) is true. Nearest first.
+void gridNearest(GridList &results, int32_t x, int32_t y, unsigned k, uint32_t maxRadius, std::function<bool (BASE_OBJECT *)> const &condition);
+
+/// Find the object nearest to (x, y), no further than maxRadius, for which condition(object) is true, or nullptr if there is none.
+BASE_OBJECT *gridNearest(int32_t x, int32_t y, uint32_t maxRadius, std::function<bool (BASE_OBJECT *)> const &condition);
+
+GridFilter *gridFilterCreate();            ///< Creates a filter, ready for use with the current grid contents.
+void gridFilterDelete(GridFilter *filter);
+void gridFilterReset(GridFilter &filter);  ///< Prepares a filter for use with the current grid contents.
 
 #endif // __INCLUDED_SRC_MAPGRID_H__
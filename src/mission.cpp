@@ -244,6 +244,7 @@ void initMission()
 		mission.apsExtractorLists[inc] = nullptr;
 		apsLimboDroids[inc] = nullptr;
 	}
+	objmemOffWorldChanged();
 	mission.apsSensorList[0] = nullptr;
 	mission.apsOilList[0] = nullptr;
 	offWorldKeepLists = false;
@@ -330,12 +331,14 @@ bool missionShutDown()
 			apsExtractorLists[inc] = mission.apsExtractorLists[inc];
 			mission.apsExtractorLists[inc] = nullptr;
 		}
+		objmemOffWorldChanged();
 		apsSensorList[0] = mission.apsSensorList[0];
 		apsOilList[0] = mission.apsOilList[0];
 		mission.apsSensorList[0] = nullptr;
 		mission.apsOilList[0] = nullptr;
 
 		psMapTiles = mission.psMapTiles;
+		psMapVision = mission.psMapVision;
 		mapWidth = mission.mapWidth;
 		mapHeight = mission.mapHeight;
 		for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -350,6 +353,7 @@ bool missionShutDown()
 			psAuxMap[i] = mission.psAuxMap[i];
 			mission.psAuxMap[i] = nullptr;
 		}
+		++auxMapGeneration;
 		std::swap(mission.psGateways, gwGetGateways());
 	}
 
@@ -710,11 +714,15 @@ static void saveMissionData()
 
 	debug(LOG_SAVE, "called");
 
+	// finish updating the tiles seen by droids and structures, before the map is swapped out
+	visTilesUpdateQueued();
+
 	//clear out the audio
 	audio_StopAll();
 
 	//save the mission data
 	mission.psMapTiles = psMapTiles;
+	mission.psMapVision = psMapVision;
 	mission.mapWidth = mapWidth;
 	mission.mapHeight = mapHeight;
 	for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -796,6 +804,7 @@ static void saveMissionData()
 		mission.apsFlagPosLists[inc] = apsFlagPosLists[inc];
 		mission.apsExtractorLists[inc] = apsExtractorLists[inc];
 	}
+	objmemOffWorldChanged();
 	mission.apsSensorList[0] = apsSensorList[0];
 	mission.apsOilList[0] = apsOilList[0];
 
@@ -864,12 +873,14 @@ void restoreMissionData()
 		apsExtractorLists[inc] = mission.apsExtractorLists[inc];
 		mission.apsExtractorLists[inc] = nullptr;
 	}
+	objmemOffWorldChanged();
 	apsSensorList[0] = mission.apsSensorList[0];
 	apsOilList[0] = mission.apsOilList[0];
 	mission.apsSensorList[0] = nullptr;
 	//swap mission data over
 
 	psMapTiles = mission.psMapTiles;
+	psMapVision = mission.psMapVision;
 
 	mapWidth = mission.mapWidth;
 	mapHeight = mission.mapHeight;
@@ -883,6 +894,7 @@ void restoreMissionData()
 		psAuxMap[i] = mission.psAuxMap[i];
 		mission.psAuxMap[i] = nullptr;
 	}
+	++auxMapGeneration;
 	scrollMinX = mission.scrollMinX;
 	scrollMinY = mission.scrollMinY;
 	scrollMaxX = mission.scrollMaxX;
@@ -890,6 +902,7 @@ void restoreMissionData()
 	std::swap(mission.psGateways, gwGetGateways());
 	//and clear the mission pointers
 	mission.psMapTiles	= nullptr;
+	mission.psMapVision	= nullptr;
 	mission.mapWidth	= 0;
 	mission.mapHeight	= 0;
 	mission.scrollMinX	= 0;
@@ -1072,6 +1085,7 @@ void saveCampaignData()
 		// Reserve the droids for selected player for start of next campaign
 		mission.apsDroidLists[selectedPlayer] = apsDroidLists[selectedPlayer];
 		apsDroidLists[selectedPlayer] = nullptr;
+		objmemOffWorldChanged();
 		psDroid = mission.apsDroidLists[selectedPlayer];
 		while (psDroid != nullptr)
 		{
@@ -1371,7 +1385,10 @@ void swapMissionPointers()
 {
 	debug(LOG_SAVE, "called");
 
+	visTilesUpdateQueued();  // Must update the tiles of the map the objects are on.
+
 	std::swap(psMapTiles, mission.psMapTiles);
+	std::swap(psMapVision, mission.psMapVision);
 	std::swap(mapWidth,   mission.mapWidth);
 	std::swap(mapHeight,  mission.mapHeight);
 	for (int i = 0; i < ARRAY_SIZE(mission.psBlockMap); ++i)
@@ -1382,6 +1399,7 @@ void swapMissionPointers()
 	{
 		std::swap(psAuxMap[i],   mission.psAuxMap[i]);
 	}
+	++auxMapGeneration;
 	//swap gateway zones
 	std::swap(mission.psGateways, gwGetGateways());
 	std::swap(scrollMinX, mission.scrollMinX);
@@ -1396,6 +1414,7 @@ void swapMissionPointers()
 		std::swap(apsFlagPosLists[inc],   mission.apsFlagPosLists[inc]);
 		std::swap(apsExtractorLists[inc], mission.apsExtractorLists[inc]);
 	}
+	objmemOffWorldChanged();
 	std::swap(apsSensorList[0], mission.apsSensorList[0]);
 	std::swap(apsOilList[0],    mission.apsOilList[0]);
 }
@@ -2930,6 +2949,7 @@ void missionDestroyObjects()
 				psDroid = psNext;
 			}
 			mission.apsDroidLists[Player] = nullptr;
+			objmemOffWorldChanged();
 
 			psStruct = apsStructLists[Player];
 
@@ -58,6 +58,7 @@
 
 #include "lib/gamelib/gtime.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "lib/script/script.h"
 #include "lib/widget/editbox.h"
 #include "lib/widget/button.h"
@@ -166,6 +167,8 @@ static bool EnablePasswordPrompt = false;	// if we need the password prompt
 LOBBY_ERROR_TYPES LobbyError = ERROR_NOERROR;
 static char tooltipbuffer[MaxGames][256] = {{'\0'}};
 static bool toggleFilter = true;	// Used to show all games or only games that are of the same version
+static bool testSeedSet = false;	// Whether the skirmish test gave a random seed, so that it plays out the same each time
+static uint32_t testSeed = 0;
 /// end of globals.
 // ////////////////////////////////////////////////////////////////////////////
 // Function protos
@@ -440,9 +443,9 @@ void loadMultiScripts()
 	uint32_t oldHash1 = DataHash[DATA_SCRIPT];
 	uint32_t oldHash2 = DataHash[DATA_SCRIPTVAL];
 
-	// Load AI players
+	// Load AI players, unless replaying a game, in which case their orders are in the replay.
 	resForceBaseDir("multiplay/skirmish/");
-	for (unsigned i = 0; i < game.maxPlayers; i++)
+	for (unsigned i = 0; i < game.maxPlayers && !NETisReplay(); i++)
 	{
 		if (NetPlay.players[i].ai < 0 && i == selectedPlayer)
 		{
@@ -2808,7 +2811,8 @@ void addPlayerBox(bool players)
  */
 static void SendFireUp()
 {
-	uint32_t randomSeed = rand();  // Pick a random random seed for the synchronised random number generator.
+	// Pick a random random seed for the synchronised random number generator, unless replaying a game, or running a skirmish test with a seed.
+	uint32_t randomSeed = hostlaunch == 3 ? replayGameRandSeed() : hostlaunch == 2 && testSeedSet ? testSeed : rand();
 
 	NETbeginEncode(NETbroadcastQueue(), NET_FIREUP);
 	NETuint32_t(&randomSeed);
@@ -3575,6 +3579,10 @@ void startMultiplayerGame()
 
 		resetDataHash();	// need to reset it, since host's data has changed.
 		createLimitSet();
+		if (hostlaunch == 3)
+		{
+			applyReplayStructureLimits();
+		}
 		debug(LOG_NET, "sending our options to all clients");
 		sendOptions();
 		NEThaltJoining();							// stop new players entering.
@@ -4011,6 +4019,8 @@ static bool loadSettings(const WzString &filename)
 	game.base = ini.value("bases", game.base + 1).toInt() - 1;		// count from 1 like the humans do
 	sstrcpy(game.name, ini.value("name").toWzString().toUtf8().c_str());
 	locked.position = !ini.value("allowPositionChange", !locked.position).toBool();
+	testSeedSet = ini.contains("seed");
+	testSeed = ini.value("seed", 0).toUInt();
 	ini.endGroup();
 	return true;
 }
@@ -4148,16 +4158,24 @@ bool startMultiOptions(bool bReenter)
 
 	loadMapPreview(false);
 
-	if (autogame_enabled())
+	if (autogame_enabled() || hostlaunch == 3)
 	{
 		if (!ingame.localJoiningInProgress)
 		{
 			processMultiopWidgets(MULTIOP_HOST);
 		}
 		SendReadyRequest(selectedPlayer, true);
-		if (hostlaunch == 2)
+		if (hostlaunch == 2 || hostlaunch == 3)
 		{
-			loadSettings("tests/" + WzString::fromUtf8(wz_skirmish_test()));
+			if (hostlaunch == 2)
+			{
+				loadSettings("tests/" + WzString::fromUtf8(wz_skirmish_test()));
+			}
+			else if (!loadReplaySettings(wz_replay_file()))
+			{
+				debug(LOG_FATAL, "Could not play back replay %s", wz_replay_file().c_str());
+				abort();
+			}
 			startMultiplayerGame();
 			// reset flag in case people dropped/quit on join screen
 			NETsetPlayerConnectionStatus(CONNECTIONSTATUS_NORMAL, NET_ALL_PLAYERS);
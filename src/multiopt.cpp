@@ -61,6 +61,19 @@
 #include "multirecv.h"
 #include "scriptfuncs.h"
 #include "template.h"
+#include "random.h"
+#include "version.h"
+#include "warzoneconfig.h"
+
+#include "lib/netplay/netreplay.h"
+#include "3rdparty/json/json.hpp"
+
+#include <stdexcept>
+
+#define MAX_REPLAYS_SAVED 10   ///< Number of recorded games to keep in the replay directory.
+
+static uint32_t replayRandomSeed = 0;
+static std::vector<MULTISTRUCTLIMITS> replayStructureLimits;
 
 // send complete game info set!
 void sendOptions()
@@ -467,9 +480,175 @@ bool multiGameInit()
 	gameInit();
 	msgStackReset();	//for multiplayer msgs, reset message stack
 
+	if (!NETisReplay() && war_GetRecordReplays())
+	{
+		startReplayRecording();
+	}
+
+	return true;
+}
+
+// ////////////////////////////////////////////////////////////////////////////
+// Replays. The settings are everything sendOptions and SendFireUp tell the clients, plus the player slots.
+
+void startReplayRecording()
+{
+	nlohmann::json settings = nlohmann::json::object();
+	settings["version"] = version_getVersionString();
+	settings["selectedPlayer"] = selectedPlayer;
+	settings["randomSeed"] = gameRandSeed();
+
+	nlohmann::json &gameSettings = settings["game"];
+	gameSettings["type"] = game.type;
+	gameSettings["map"] = game.map;
+	gameSettings["hash"] = game.hash.toString();
+	gameSettings["maxPlayers"] = game.maxPlayers;
+	gameSettings["name"] = game.name;
+	gameSettings["power"] = game.power;
+	gameSettings["base"] = game.base;
+	gameSettings["alliance"] = game.alliance;
+	gameSettings["scavengers"] = game.scavengers;
+	gameSettings["isMapMod"] = game.isMapMod;
+	gameSettings["techLevel"] = game.techLevel;
+	gameSettings["flags"] = ingame.flags;
+	nlohmann::json &modHashes = gameSettings["modHashes"] = nlohmann::json::array();
+	for (auto &hash : game.modHashes)
+	{
+		modHashes.push_back(hash.toString());
+	}
+	nlohmann::json &structureLimits = gameSettings["structureLimits"] = nlohmann::json::array();
+	for (unsigned i = 0; i < ingame.numStructureLimits; ++i)
+	{
+		structureLimits.push_back({ingame.pStructureLimits[i].id, ingame.pStructureLimits[i].limit});
+	}
+
+	nlohmann::json &players = settings["players"] = nlohmann::json::array();
+	for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+	{
+		nlohmann::json player = nlohmann::json::object();
+		player["name"] = NetPlay.players[i].name;
+		player["position"] = NetPlay.players[i].position;
+		player["colour"] = NetPlay.players[i].colour;
+		player["allocated"] = NetPlay.players[i].allocated;
+		player["team"] = NetPlay.players[i].team;
+		player["ai"] = NetPlay.players[i].ai;
+		player["difficulty"] = NetPlay.players[i].difficulty;
+		player["skDiff"] = game.skDiff[i];
+		player["alliances"] = std::vector<uint8_t>(alliances[i], alliances[i] + MAX_PLAYERS);
+		players.push_back(player);
+	}
+
+	time_t aclock;
+	time(&aclock);
+	struct tm *newtime = localtime(&aclock);
+	char filename[256];
+	snprintf(filename, sizeof(filename), "%04d%02d%02d_%02d%02d%02d_%s", newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec, game.map);
+	for (char *c = filename; *c != '\0'; ++c)
+	{
+		if (!isalnum((unsigned char)*c) && *c != '-' && *c != '_')
+		{
+			*c = '_';
+		}
+	}
+
+	NETreplaySaveStart("replay", filename, settings, MAX_REPLAYS_SAVED);
+}
+
+bool loadReplaySettings(const std::string &filename)
+{
+	nlohmann::json settings;
+	if (!NETreplayLoadStart(filename, settings))
+	{
+		return false;
+	}
+
+	try
+	{
+		if (settings.at("version").get<std::string>() != version_getVersionString())
+		{
+			debug(LOG_WARNING, "Replay was recorded with version %s, playback may not match.", settings.at("version").get<std::string>().c_str());
+		}
+
+		nlohmann::json const &gameSettings = settings.at("game");
+		game.type = gameSettings.at("type").get<uint8_t>();
+		sstrcpy(game.map, gameSettings.at("map").get<std::string>().c_str());
+		game.hash.fromString(gameSettings.at("hash").get<std::string>());
+		game.maxPlayers = gameSettings.at("maxPlayers").get<uint8_t>();
+		sstrcpy(game.name, gameSettings.at("name").get<std::string>().c_str());
+		game.power = gameSettings.at("power").get<uint32_t>();
+		game.base = gameSettings.at("base").get<uint8_t>();
+		game.alliance = gameSettings.at("alliance").get<uint8_t>();
+		game.scavengers = gameSettings.at("scavengers").get<bool>();
+		game.isMapMod = gameSettings.at("isMapMod").get<bool>();
+		game.techLevel = gameSettings.at("techLevel").get<uint32_t>();
+		ingame.flags = gameSettings.at("flags").get<uint8_t>();
+		if (!gameSettings.at("modHashes").empty())
+		{
+			debug(LOG_WARNING, "Replay was recorded with %u mods, they must be loaded for playback to match.", (unsigned)gameSettings.at("modHashes").size());
+		}
+		replayStructureLimits.clear();
+		for (auto const &limit : gameSettings.at("structureLimits"))
+		{
+			replayStructureLimits.push_back({limit.at(0).get<uint32_t>(), limit.at(1).get<uint32_t>()});
+		}
+
+		nlohmann::json const &players = settings.at("players");
+		if (players.size() != MAX_PLAYERS)
+		{
+			throw std::runtime_error(astringf("%u players, expected %u", (unsigned)players.size(), MAX_PLAYERS));
+		}
+		for (unsigned i = 0; i < MAX_PLAYERS; ++i)
+		{
+			nlohmann::json const &player = players[i];
+			sstrcpy(NetPlay.players[i].name, player.at("name").get<std::string>().c_str());
+			NetPlay.players[i].position = player.at("position").get<int32_t>();
+			setPlayerColour(i, player.at("colour").get<int32_t>());
+			NetPlay.players[i].allocated = player.at("allocated").get<bool>();
+			NetPlay.players[i].team = player.at("team").get<int32_t>();
+			NetPlay.players[i].ai = player.at("ai").get<int8_t>();
+			NetPlay.players[i].difficulty = player.at("difficulty").get<int8_t>();
+			game.skDiff[i] = player.at("skDiff").get<uint8_t>();
+			for (unsigned j = 0; j < MAX_PLAYERS; ++j)
+			{
+				alliances[i][j] = player.at("alliances").at(j).get<uint8_t>();
+			}
+		}
+
+		selectedPlayer = realSelectedPlayer = settings.at("selectedPlayer").get<uint32_t>();
+		replayRandomSeed = settings.at("randomSeed").get<uint32_t>();
+	}
+	catch (const std::exception &e)
+	{
+		debug(LOG_ERROR, "Bad settings in replay %s: %s", filename.c_str(), e.what());
+		NETreplayLoadStop();
+		return false;
+	}
+
+	resetReplayFinished();
+	netPlayersUpdated = true;
 	return true;
 }
 
+uint32_t replayGameRandSeed()
+{
+	return replayRandomSeed;
+}
+
+void applyReplayStructureLimits()
+{
+	if (ingame.numStructureLimits)
+	{
+		free(ingame.pStructureLimits);
+		ingame.pStructureLimits = nullptr;
+	}
+	ingame.numStructureLimits = replayStructureLimits.size();
+	if (ingame.numStructureLimits > 0)
+	{
+		ingame.pStructureLimits = (MULTISTRUCTLIMITS *)malloc(ingame.numStructureLimits * sizeof(MULTISTRUCTLIMITS));
+		std::copy(replayStructureLimits.begin(), replayStructureLimits.end(), ingame.pStructureLimits);
+	}
+}
+
 ////////////////////////////////
 // at the end of every game.
 bool multiGameShutdown()
@@ -66,6 +66,7 @@
 #include "scriptfuncs.h"
 #include "template.h"
 #include "lib/netplay/netplay.h"								// the netplay library.
+#include "lib/netplay/netreplay.h"
 #include "modding.h"
 #include "multiplay.h"								// warzone net stuff.
 #include "multijoin.h"								// player management stuff.
@@ -75,6 +76,7 @@
 #include "multiint.h"
 #include "keymap.h"
 #include "cheat.h"
+#include "clparse.h"
 
 // ////////////////////////////////////////////////////////////////////////////
 // ////////////////////////////////////////////////////////////////////////////
@@ -104,6 +106,8 @@ static SDWORD locy[MAX_MSG_STACK];
 static DROID *msgDroid[MAX_MSG_STACK];
 static SDWORD msgStackPos = -1;				//top element pointer
 
+static bool replayFinished = false;			// whether the end of the replay being played has been announced
+
 // ////////////////////////////////////////////////////////////////////////////
 // Local Prototypes
 
@@ -891,9 +895,25 @@ bool recvMessage()
 		NETpop(queue);
 	}
 
+	if (NETreplayLoadFinished() && !replayFinished)
+	{
+		replayFinished = true;
+		debug(LOG_INFO, "Replay finished at gameTime %u.", gameTime);
+		addConsoleMessage(_("The replay has finished."), DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
+		if (autogame_enabled())
+		{
+			exit(0);
+		}
+	}
+
 	return true;
 }
 
+void resetReplayFinished()
+{
+	replayFinished = false;
+}
+
 void HandleBadParam(const char *msg, const int from, const int actual)
 {
 	char buf[255];
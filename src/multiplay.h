@@ -194,6 +194,12 @@ void playerResponding();
 bool multiGameInit();
 bool multiGameShutdown();
 
+void startReplayRecording();
+bool loadReplaySettings(const std::string &filename);  ///< Opens a replay for playback, and sets up the game as it was recorded.
+uint32_t replayGameRandSeed();
+void resetReplayFinished();  ///< Lets the end of the next replay be announced, and end an autogame.
+void applyReplayStructureLimits();
+
 // syncing.
 bool sendScoreCheck();							//score check only(frontend)
 bool sendPing();							// allow game to request pings.
@@ -24,6 +24,7 @@
  *
  */
 #include <string.h>
+#include <unordered_map>
 
 #include "lib/framework/frame.h"
 #include "objects.h"
@@ -69,6 +70,26 @@ FLAG_POSITION	*apsFlagPosLists[MAX_PLAYERS];
 /* The list of destroyed objects */
 BASE_OBJECT		*psDestroyedObj = nullptr;
 
+/// All droids, structures and features in the object lists (including the mission and limbo lists), by id.
+/// Droids inside transporters are not in any list, so are not in the index either.
+static std::unordered_map<uint32_t, BASE_OBJECT *> objIdIndex;
+/// Whether an object was ever added with the id of another, which only happens with broken savegames or maps.
+/// Then the index holds the first of them, and the lists must be searched for the others when it goes.
+static bool objIdCollision = false;
+
+/// Whether there are droids or features in the mission or limbo lists, which IdToObject must search without the index.
+/// Only checked again after those lists may have changed, see objmemOffWorldChanged.
+static bool offWorldChecked = false;
+static bool offWorldDroids = false;
+static bool offWorldFeatures = false;
+
+/// Whether list is one of the lists of the current map, as opposed to the mission or limbo lists.
+template <typename OBJECT>
+static bool isOnWorldList(OBJECT *list[])
+{
+	return (void *)list == (void *)apsDroidLists || (void *)list == (void *)apsStructLists || (void *)list == (void *)apsFeatureLists;
+}
+
 /* Forward function declarations */
 #ifdef DEBUG
 static void objListIntegCheck();
@@ -88,6 +109,9 @@ bool objmemInitialise()
 /* Release the object heaps */
 void objmemShutdown()
 {
+	objIdIndex.clear();
+	objIdCollision = false;
+	objmemOffWorldChanged();
 }
 
 // Check that psVictim is not referred to by any other object in the game. We can dump out some extra data in debug builds that help track down sources of dangling pointer errors.
@@ -248,6 +272,17 @@ uint32_t generateSynchronisedObjectId()
 /* Add the object to its list
  * \param list is a pointer to the object list
  */
+/// Adds the object to the index, unless an object with the same id is there already.
+static void indexObject(BASE_OBJECT *psObj)
+{
+	auto i = objIdIndex.emplace(psObj->id, psObj);
+	if (!i.second && i.first->second != psObj)
+	{
+		objIdCollision = true;
+		ASSERT(false, "Object of type %d has id %u, which object of type %d already has, the first one stays in the index", (int)psObj->type, psObj->id, (int)i.first->second->type);
+	}
+}
+
 template <typename OBJECT>
 static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 {
@@ -256,6 +291,12 @@ static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 	// Prepend the object to the top of the list
 	object->psNext = list[player];
 	list[player] = object;
+
+	indexObject(object);
+	if (!isOnWorldList(list))
+	{
+		objmemOffWorldChanged();
+	}
 }
 
 /* Add the object to its list
@@ -282,6 +323,8 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 	ASSERT(gameTime - deltaGameTime <= gameTime || gameTime == 2, "Expected %u <= %u, bad time", gameTime - deltaGameTime, gameTime);
 
+	objmemForgetObject(object);
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[object->player] == object)
 	{
@@ -328,6 +371,12 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 {
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 
+	objmemForgetObject(object);
+	if (!isOnWorldList(list))
+	{
+		objmemOffWorldChanged();
+	}
+
 	// If the message to remove is the first one in the list then mark the next one as the first
 	if (list[player] == object)
 	{
@@ -768,155 +817,161 @@ void checkFactoryFlags()
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+/// Returns an object other than psExclude with the given id from the object lists, or nullptr.
+static BASE_OBJECT *findOtherObjectInLists(uint32_t id, BASE_OBJECT const *psExclude)
 {
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
-
-	for (int i = 0; i < 3; ++i)
+	BASE_OBJECT **lists[] = {(BASE_OBJECT **)apsDroidLists, (BASE_OBJECT **)apsStructLists, (BASE_OBJECT **)apsFeatureLists,
+	                         (BASE_OBJECT **)mission.apsDroidLists, (BASE_OBJECT **)mission.apsStructLists, (BASE_OBJECT **)mission.apsFeatureLists,
+	                         (BASE_OBJECT **)apsLimboDroids};
+	for (BASE_OBJECT **list : lists)
 	{
-		psObj = nullptr;
-		switch (i)
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
 		{
-		case 0:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = apsFeatureLists[0];
-			default: break;
-			}
-			break;
-		case 1:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = mission.apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = mission.apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = mission.apsFeatureLists[0]; break;
-			default: break;
-			}
-			break;
-		case 2:
-			if (player == 0 && type == OBJ_DROID)
+			for (BASE_OBJECT *psObj = list[player]; psObj != nullptr; psObj = psObj->psNext)
 			{
-				psObj = apsLimboDroids[0];
-			}
-			break;
-		}
-
-		while (psObj)
-		{
-			if (psObj->id == id)
-			{
-				return psObj;
-			}
-			// if transporter check any droids in the grp
-			if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-			{
-				for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
+				if (psObj->id == id && psObj != psExclude)
 				{
-					if (psTrans->id == id)
-					{
-						return (BASE_OBJECT *)psTrans;
-					}
+					return psObj;
 				}
 			}
-			psObj = psObj->psNext;
 		}
 	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
-
 	return nullptr;
 }
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromId(UDWORD id)
+/// Removes the object from the index, putting back another object with the same id if there is one.
+static void unindexObject(BASE_OBJECT *psObj)
 {
-	unsigned int i;
-	UDWORD			player;
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
+	auto i = objIdIndex.find(psObj->id);
+	if (i == objIdIndex.end() || i->second != psObj)
+	{
+		return;
+	}
+	BASE_OBJECT *psOther = objIdCollision ? findOtherObjectInLists(psObj->id, psObj) : nullptr;
+	if (psOther != nullptr)
+	{
+		i->second = psOther;
+	}
+	else
+	{
+		objIdIndex.erase(i);
+	}
+}
+
+void objmemForgetObject(BASE_OBJECT *psObj)
+{
+	unindexObject(psObj);
+}
+
+void setObjectId(BASE_OBJECT *psObj, uint32_t id)
+{
+	auto i = objIdIndex.find(psObj->id);
+	bool indexed = i != objIdIndex.end() && i->second == psObj;
+	if (indexed)
+	{
+		unindexObject(psObj);
+	}
+	psObj->id = id;
+	if (indexed)
+	{
+		indexObject(psObj);
+	}
+}
 
-	for (i = 0; i < 7; ++i)
+BASE_OBJECT *findObjectById(uint32_t id)
+{
+	auto i = objIdIndex.find(id);
+	return i != objIdIndex.end() ? i->second : nullptr;
+}
+
+void objmemOffWorldChanged()
+{
+	offWorldChecked = false;
+}
+
+bool objmemHasOffWorldObjects(OBJECT_TYPE type)
+{
+	if (!offWorldChecked)
 	{
-		for (player = 0; player < MAX_PLAYERS; ++player)
+		offWorldDroids = false;
+		for (int i = 0; i < MAX_PLAYERS; ++i)
 		{
-			switch (i)
-			{
-			case 0:
-				psObj = (BASE_OBJECT *)apsDroidLists[player];
-				break;
-			case 1:
-				psObj = (BASE_OBJECT *)apsStructLists[player];
-				break;
-			case 2:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			case 3:
-				psObj = (BASE_OBJECT *)mission.apsDroidLists[player];
-				break;
-			case 4:
-				psObj = (BASE_OBJECT *)mission.apsStructLists[player];
-				break;
-			case 5:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)mission.apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			case 6:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsLimboDroids[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			default:
-				psObj = nullptr;
-				break;
-			}
+			offWorldDroids = offWorldDroids || mission.apsDroidLists[i] != nullptr || apsLimboDroids[i] != nullptr;
+		}
+		offWorldFeatures = mission.apsFeatureLists[0] != nullptr;
+		offWorldChecked = true;
+	}
+	switch (type)
+	{
+	case OBJ_DROID: return offWorldDroids;
+	case OBJ_FEATURE: return offWorldFeatures;
+	default: return false;
+	}
+}
 
-			while (psObj)
+// Find a droid inside a transporter in one of the droid lists of the given players
+static DROID *findTransportedDroid(uint32_t id, unsigned beginPlayer, unsigned endPlayer)
+{
+	DROID **lists[3] = {apsDroidLists, mission.apsDroidLists, apsLimboDroids};
+	for (DROID **list : lists)
+	{
+		for (unsigned player = beginPlayer; player < endPlayer; ++player)
+		{
+			for (DROID *psDroid = list[player]; psDroid != nullptr; psDroid = psDroid->psNext)
 			{
-				if (psObj->id == id)
+				if (!isTransporter(psDroid))
 				{
-					return psObj;
+					continue;
 				}
-				// if transporter check any droids in the grp
-				if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
+				for (DROID *psTrans = psDroid->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
 				{
-					for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
+					if (psTrans->id == id)
 					{
-						if (psTrans->id == id)
-						{
-							return (BASE_OBJECT *)psTrans;
-						}
+						return psTrans;
 					}
 				}
-				psObj = psObj->psNext;
 			}
 		}
 	}
-	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
+	return nullptr;
+}
+
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	BASE_OBJECT *psObj = findObjectById(id);
+	if (psObj != nullptr && psObj->type == type && (type == OBJ_FEATURE || psObj->player == player))
+	{
+		return psObj;
+	}
+	if (type == OBJ_DROID && player < MAX_PLAYERS)
+	{
+		// Droids in transporters are not in the index.
+		psObj = findTransportedDroid(id, player, player + 1);
+		if (psObj != nullptr)
+		{
+			return psObj;
+		}
+	}
+	ASSERT(false, "failed to find id %d for player %d", id, player);
 
 	return nullptr;
 }
 
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromId(UDWORD id)
+{
+	BASE_OBJECT *psObj = findObjectById(id);
+	if (psObj == nullptr)
+	{
+		// Droids in transporters are not in the index.
+		psObj = findTransportedDroid(id, 0, MAX_PLAYERS);
+	}
+	ASSERT(psObj != nullptr, "getBaseObjFromId() failed for id %d", id);
+
+	return psObj;
+}
+
 UDWORD getRepairIdFromFlag(FLAG_POSITION *psFlag)
 {
 	unsigned int i;
@@ -101,6 +101,18 @@ void removeFlagPosition(FLAG_POSITION *psDel);
 void freeAllFlagPositions();
 void freeAllAssemblyPoints();
 
+/// Remove an object from the id index, if it is there. Called whenever the object leaves its list, or is deleted.
+void objmemForgetObject(BASE_OBJECT *psObj);
+/// Change the id of an object, which may already be in an object list.
+void setObjectId(BASE_OBJECT *psObj, uint32_t id);
+/// Find a droid, structure or feature in the object lists (including the mission and limbo lists) by id, using a hash table.
+/// Doesn't find droids inside transporters, returns nullptr if not found.
+BASE_OBJECT *findObjectById(uint32_t id);
+/// Call after moving whole object lists between the current map and the mission or limbo lists.
+void objmemOffWorldChanged();
+/// Whether there are droids or features of the given type in the mission or limbo lists.
+bool objmemHasOffWorldObjects(OBJECT_TYPE type);
+
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 BASE_OBJECT *getBaseObjFromId(UDWORD id);
@@ -0,0 +1,454 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Abstract cluster graph for hierarchical pathfinding.
+ *  How this works:
+ *  * The map is divided into clusters of PATH_CLUSTER_SIZE×PATH_CLUSTER_SIZE tiles.
+ *  * Wherever there is a run of tiles which are passable on both sides of the border
+ *    between two neighbouring clusters, there is an entrance. An entrance is a pair of
+ *    portal tiles, one on each side of the border, in the middle of the run.
+ *  * The distances between all portals of a cluster, moving only inside the cluster,
+ *    are precomputed. The portals and these distances form a small abstract graph.
+ *  * To find a long route, the abstract graph is searched instead of the map, which
+ *    gives the clusters the route passes through. The A* search in astar.cpp is then
+ *    limited to this corridor of clusters, so it explores far fewer tiles.
+ *  Graphs are never modified after being built, since the pathfinding threads may be
+ *  using them. When a blocking map changes, the previous graph is copied, and only the
+ *  entrances and clusters near the changed tiles are recalculated.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "pathcluster.h"
+
+#include <algorithm>
+
+#define PATH_CLUSTER_UNREACHABLE 0xFFFFFFFF
+
+struct PathClusterPortal
+{
+	int16_t x, y;           ///< Tile of the portal.
+	int     twin;           ///< Global index of the portal on the other side of the entrance.
+};
+
+struct PathCluster
+{
+	std::vector<PathClusterPortal> portals;  ///< Portals through the north, west, east and south borders, in that order.
+	std::vector<unsigned> dist;              ///< dist[i + j * portals.size()] is the distance from portals[i] to portals[j] inside the cluster.
+	int firstPortal = 0;                     ///< Global index of portals[0].
+};
+
+struct PathClusterGraph
+{
+	int x0(int cluster) const
+	{
+		return cluster % clustersX * PATH_CLUSTER_SIZE;
+	}
+	int y0(int cluster) const
+	{
+		return cluster / clustersX * PATH_CLUSTER_SIZE;
+	}
+	int clusterAt(int x, int y) const
+	{
+		return x / PATH_CLUSTER_SIZE + y / PATH_CLUSTER_SIZE * clustersX;
+	}
+	bool isBlocked(int x, int y) const
+	{
+		return blocking[x + y * width];
+	}
+
+	int width = 0, height = 0;                       ///< Map size, in tiles.
+	int clustersX = 0, clustersY = 0;                ///< Map size, in clusters.
+	std::vector<bool> blocking;                      ///< The blocking map this graph was built from.
+	std::vector<std::vector<int16_t>> eastEntrances;   ///< For each cluster, the y coordinates of the entrances through the east border.
+	std::vector<std::vector<int16_t>> southEntrances;  ///< For each cluster, the x coordinates of the entrances through the south border.
+	std::vector<PathCluster> clusters;
+	std::vector<int> portalCluster;                  ///< Cluster of each portal, by global index.
+	int numPortals = 0;
+};
+
+struct PathClusterNode
+{
+	bool operator <(PathClusterNode const &z) const
+	{
+		// Sort descending est, fallback to ascending index, so that the order is well defined.
+		if (est != z.est)
+		{
+			return est > z.est;
+		}
+		return index > z.index;
+	}
+
+	unsigned est;
+	unsigned dist;
+	int index;
+};
+
+static inline unsigned clusterEstimate(int x1, int y1, int x2, int y2)
+{
+	// Same costs as fpathEstimate in astar.cpp.
+	unsigned xDelta = abs(x1 - x2), yDelta = abs(y1 - y2);
+	return std::min(xDelta, yDelta) * (198 - 140) + std::max(xDelta, yDelta) * 140;
+}
+
+/// Finds the runs of tiles which are passable on both sides of a border.
+static void findEntrances(PathClusterGraph const &graph, std::vector<int16_t> &entrances, int x, int y, int dx, int dy, int length)
+{
+	// (x, y) is the first tile on the near side of the border, (x + dy, y + dx) is on the far side, and we walk along (dx, dy).
+	entrances.clear();
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i)
+	{
+		int nx = x + i * dx, ny = y + i * dy;
+		bool open = i < length && !graph.isBlocked(nx, ny) && !graph.isBlocked(nx + dy, ny + dx);
+		if (open && runStart < 0)
+		{
+			runStart = i;
+		}
+		else if (!open && runStart >= 0)
+		{
+			int middle = (runStart + i - 1) / 2;
+			entrances.push_back(dx != 0 ? x + middle : y + middle);
+			runStart = -1;
+		}
+	}
+}
+
+static void updateEntrances(PathClusterGraph &graph, int cluster)
+{
+	int x0 = graph.x0(cluster), y0 = graph.y0(cluster);
+	int w = std::min(PATH_CLUSTER_SIZE, graph.width - x0), h = std::min(PATH_CLUSTER_SIZE, graph.height - y0);
+	if (x0 + w < graph.width)
+	{
+		findEntrances(graph, graph.eastEntrances[cluster], x0 + w - 1, y0, 0, 1, h);
+	}
+	if (y0 + h < graph.height)
+	{
+		findEntrances(graph, graph.southEntrances[cluster], x0, y0 + h - 1, 1, 0, w);
+	}
+}
+
+/// Finds the distances from source to all tiles of the cluster, moving only inside the cluster, with the same movement rules as fpathAStarExplore.
+static void clusterDistances(PathClusterGraph const &graph, int cluster, Vector2i source, std::vector<unsigned> &dist, std::vector<PathClusterNode> &heap)
+{
+	static const Vector2i dirs[] = {Vector2i(0, 1), Vector2i(-1, 1), Vector2i(-1, 0), Vector2i(-1, -1), Vector2i(0, -1), Vector2i(1, -1), Vector2i(1, 0), Vector2i(1, 1)};
+
+	int x0 = graph.x0(cluster), y0 = graph.y0(cluster);
+	int x1 = std::min(x0 + PATH_CLUSTER_SIZE, graph.width), y1 = std::min(y0 + PATH_CLUSTER_SIZE, graph.height);
+	auto blocked = [&](int x, int y) {
+		return x < x0 || y < y0 || x >= x1 || y >= y1 || graph.isBlocked(x, y);
+	};
+
+	dist.assign(PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE, PATH_CLUSTER_UNREACHABLE);
+	heap.clear();
+	heap.push_back({0, 0, (source.x - x0) + (source.y - y0) * PATH_CLUSTER_SIZE});
+	dist[heap.back().index] = 0;
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end());
+		PathClusterNode node = heap.back();
+		heap.pop_back();
+		if (node.dist != dist[node.index])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		int x = x0 + node.index % PATH_CLUSTER_SIZE, y = y0 + node.index / PATH_CLUSTER_SIZE;
+		for (unsigned dir = 0; dir < ARRAY_SIZE(dirs); ++dir)
+		{
+			int nx = x + dirs[dir].x, ny = y + dirs[dir].y;
+			if (blocked(nx, ny))
+			{
+				continue;
+			}
+			if (dir % 2 != 0 && (blocked(x + dirs[(dir + 1) % 8].x, y + dirs[(dir + 1) % 8].y) || blocked(x + dirs[(dir + 7) % 8].x, y + dirs[(dir + 7) % 8].y)))
+			{
+				continue;  // We cannot cut corners.
+			}
+			unsigned newDist = node.dist + (dir % 2 != 0 ? 198 : 140);
+			int index = (nx - x0) + (ny - y0) * PATH_CLUSTER_SIZE;
+			if (newDist < dist[index])
+			{
+				dist[index] = newDist;
+				heap.push_back({newDist, newDist, index});
+				std::push_heap(heap.begin(), heap.end());
+			}
+		}
+	}
+}
+
+static void updateCluster(PathClusterGraph &graph, int cluster)
+{
+	int cx = cluster % graph.clustersX, cy = cluster / graph.clustersX;
+	int x0 = graph.x0(cluster), y0 = graph.y0(cluster);
+	int x1 = std::min(x0 + PATH_CLUSTER_SIZE, graph.width) - 1, y1 = std::min(y0 + PATH_CLUSTER_SIZE, graph.height) - 1;
+	PathCluster &c = graph.clusters[cluster];
+
+	c.portals.clear();
+	if (cy > 0)
+	{
+		for (int16_t x : graph.southEntrances[cluster - graph.clustersX])
+		{
+			c.portals.push_back({x, (int16_t)y0, 0});
+		}
+	}
+	if (cx > 0)
+	{
+		for (int16_t y : graph.eastEntrances[cluster - 1])
+		{
+			c.portals.push_back({(int16_t)x0, y, 0});
+		}
+	}
+	for (int16_t y : graph.eastEntrances[cluster])
+	{
+		c.portals.push_back({(int16_t)x1, y, 0});
+	}
+	for (int16_t x : graph.southEntrances[cluster])
+	{
+		c.portals.push_back({x, (int16_t)y1, 0});
+	}
+
+	unsigned n = c.portals.size();
+	c.dist.resize(n * n);
+	std::vector<unsigned> dist;
+	std::vector<PathClusterNode> heap;
+	for (unsigned i = 0; i < n; ++i)
+	{
+		clusterDistances(graph, cluster, Vector2i(c.portals[i].x, c.portals[i].y), dist, heap);
+		for (unsigned j = 0; j < n; ++j)
+		{
+			c.dist[i + j * n] = dist[(c.portals[j].x - x0) + (c.portals[j].y - y0) * PATH_CLUSTER_SIZE];
+		}
+	}
+}
+
+/// Assigns global portal indices, and connects the portals on each side of each entrance.
+static void linkClusters(PathClusterGraph &graph)
+{
+	graph.numPortals = 0;
+	graph.portalCluster.clear();
+	for (unsigned cluster = 0; cluster < graph.clusters.size(); ++cluster)
+	{
+		graph.clusters[cluster].firstPortal = graph.numPortals;
+		graph.numPortals += graph.clusters[cluster].portals.size();
+		graph.portalCluster.resize(graph.numPortals, cluster);
+	}
+	for (unsigned cluster = 0; cluster < graph.clusters.size(); ++cluster)
+	{
+		PathCluster &c = graph.clusters[cluster];
+		int cx = cluster % graph.clustersX, cy = cluster / graph.clustersX;
+		int numNorth = cy > 0 ? graph.southEntrances[cluster - graph.clustersX].size() : 0;
+		int numWest = cx > 0 ? graph.eastEntrances[cluster - 1].size() : 0;
+		int numEast = graph.eastEntrances[cluster].size();
+		for (int i = 0; i < numEast; ++i)
+		{
+			PathCluster &east = graph.clusters[cluster + 1];
+			int eastNumNorth = cy > 0 ? graph.southEntrances[cluster + 1 - graph.clustersX].size() : 0;
+			c.portals[numNorth + numWest + i].twin = east.firstPortal + eastNumNorth + i;
+			east.portals[eastNumNorth + i].twin = c.firstPortal + numNorth + numWest + i;
+		}
+		for (unsigned i = 0; i < graph.southEntrances[cluster].size(); ++i)
+		{
+			PathCluster &south = graph.clusters[cluster + graph.clustersX];
+			c.portals[numNorth + numWest + numEast + i].twin = south.firstPortal + i;
+			south.portals[i].twin = c.firstPortal + numNorth + numWest + numEast + i;
+		}
+	}
+}
+
+std::shared_ptr<PathClusterGraph const> fpathClusterGraphUpdate(std::shared_ptr<PathClusterGraph const> const &previous, std::vector<bool> const &blockingMap, int width, int height)
+{
+	ASSERT_OR_RETURN(nullptr, blockingMap.size() == (size_t)width * height, "Blocking map has wrong size");
+
+	std::shared_ptr<PathClusterGraph> graph;
+	std::vector<bool> changed;
+	if (previous != nullptr && previous->width == width && previous->height == height)
+	{
+		if (previous->blocking == blockingMap)
+		{
+			return previous;  // Nothing changed.
+		}
+		graph = std::make_shared<PathClusterGraph>(*previous);
+		changed.resize(graph->clusters.size());
+		for (int y = 0; y < height; ++y)
+			for (int x = 0; x < width; ++x)
+			{
+				if (graph->blocking[x + y * width] != blockingMap[x + y * width])
+				{
+					changed[graph->clusterAt(x, y)] = true;
+				}
+			}
+	}
+	else
+	{
+		graph = std::make_shared<PathClusterGraph>();
+		graph->width = width;
+		graph->height = height;
+		graph->clustersX = (width + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+		graph->clustersY = (height + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+		graph->eastEntrances.resize(graph->clustersX * graph->clustersY);
+		graph->southEntrances.resize(graph->clustersX * graph->clustersY);
+		graph->clusters.resize(graph->clustersX * graph->clustersY);
+		changed.assign(graph->clusters.size(), true);
+	}
+	graph->blocking = blockingMap;
+
+	// Entrances on any border of a changed cluster may have changed, which changes the portals of the clusters on both sides.
+	int numClusters = graph->clusters.size();
+	std::vector<bool> dirty(numClusters);
+	for (int cluster = 0; cluster < numClusters; ++cluster)
+	{
+		if (!changed[cluster])
+		{
+			continue;
+		}
+		int cx = cluster % graph->clustersX, cy = cluster / graph->clustersX;
+		updateEntrances(*graph, cluster);
+		dirty[cluster] = true;
+		if (cx > 0)
+		{
+			updateEntrances(*graph, cluster - 1);
+			dirty[cluster - 1] = true;
+		}
+		if (cy > 0)
+		{
+			updateEntrances(*graph, cluster - graph->clustersX);
+			dirty[cluster - graph->clustersX] = true;
+		}
+		if (cx + 1 < graph->clustersX)
+		{
+			dirty[cluster + 1] = true;
+		}
+		if (cy + 1 < graph->clustersY)
+		{
+			dirty[cluster + graph->clustersX] = true;
+		}
+	}
+	int numDirty = 0;
+	for (int cluster = 0; cluster < numClusters; ++cluster)
+	{
+		if (dirty[cluster])
+		{
+			updateCluster(*graph, cluster);
+			++numDirty;
+		}
+	}
+	linkClusters(*graph);
+
+	debug(LOG_NEVER, "Updated %d of %d path clusters, %d portals", numDirty, numClusters, graph->numPortals);
+	return graph;
+}
+
+bool fpathClusterCorridor(PathClusterGraph const &graph, Vector2i orig, Vector2i dest, PathClusterCorridor &corridor)
+{
+	ASSERT_OR_RETURN(false, orig.x >= 0 && orig.y >= 0 && orig.x < graph.width && orig.y < graph.height, "Bad origin");
+	ASSERT_OR_RETURN(false, dest.x >= 0 && dest.y >= 0 && dest.x < graph.width && dest.y < graph.height, "Bad destination");
+
+	int origCluster = graph.clusterAt(orig.x, orig.y);
+	int destCluster = graph.clusterAt(dest.x, dest.y);
+	if (origCluster == destCluster)
+	{
+		return false;
+	}
+	PathCluster const &oc = graph.clusters[origCluster];
+
+	// Distances to the portals of the origin and destination clusters.
+	std::vector<unsigned> origDist, destDist;
+	std::vector<PathClusterNode> heap;
+	clusterDistances(graph, destCluster, dest, destDist, heap);
+	clusterDistances(graph, origCluster, orig, origDist, heap);
+
+	// A* over the portals, with the destination as an extra node.
+	int const destNode = graph.numPortals;
+	std::vector<unsigned> dist(graph.numPortals + 1, PATH_CLUSTER_UNREACHABLE);
+	std::vector<int> prev(graph.numPortals + 1, -1);
+	heap.clear();
+	auto addNode = [&](int index, unsigned newDist, int from) {
+		if (newDist >= dist[index])
+		{
+			return;
+		}
+		dist[index] = newDist;
+		prev[index] = from;
+		unsigned est = newDist;
+		if (index != destNode)
+		{
+			PathClusterPortal const &portal = graph.clusters[graph.portalCluster[index]].portals[index - graph.clusters[graph.portalCluster[index]].firstPortal];
+			est += clusterEstimate(portal.x, portal.y, dest.x, dest.y);
+		}
+		heap.push_back({est, newDist, index});
+		std::push_heap(heap.begin(), heap.end());
+	};
+	for (unsigned i = 0; i < oc.portals.size(); ++i)
+	{
+		unsigned d = origDist[(oc.portals[i].x - graph.x0(origCluster)) + (oc.portals[i].y - graph.y0(origCluster)) * PATH_CLUSTER_SIZE];
+		if (d != PATH_CLUSTER_UNREACHABLE)
+		{
+			addNode(oc.firstPortal + i, d, -1);
+		}
+	}
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end());
+		PathClusterNode node = heap.back();
+		heap.pop_back();
+		if (node.dist != dist[node.index])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		if (node.index == destNode)
+		{
+			break;
+		}
+
+		int cluster = graph.portalCluster[node.index];
+		PathCluster const &c = graph.clusters[cluster];
+		unsigned n = c.portals.size();
+		unsigned i = node.index - c.firstPortal;
+		for (unsigned j = 0; j < n; ++j)
+		{
+			if (j != i && c.dist[i + j * n] != PATH_CLUSTER_UNREACHABLE)
+			{
+				addNode(c.firstPortal + j, node.dist + c.dist[i + j * n], node.index);
+			}
+		}
+		addNode(c.portals[i].twin, node.dist + 140, node.index);
+		if (cluster == destCluster)
+		{
+			unsigned d = destDist[(c.portals[i].x - graph.x0(cluster)) + (c.portals[i].y - graph.y0(cluster)) * PATH_CLUSTER_SIZE];
+			if (d != PATH_CLUSTER_UNREACHABLE)
+			{
+				addNode(destNode, node.dist + d, node.index);
+			}
+		}
+	}
+
+	if (prev[destNode] < 0)
+	{
+		return false;  // No route, let the normal search find the nearest reachable tile.
+	}
+
+	corridor.clustersX = graph.clustersX;
+	corridor.clusters.assign(graph.clusters.size(), false);
+	corridor.clusters[destCluster] = true;
+	for (int index = prev[destNode]; index >= 0; index = prev[index])
+	{
+		corridor.clusters[graph.portalCluster[index]] = true;
+	}
+	return true;
+}
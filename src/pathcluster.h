@@ -0,0 +1,69 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Abstract cluster graph for hierarchical pathfinding.
+ */
+
+#ifndef __INCLUDED_SRC_PATHCLUSTER_H__
+#define __INCLUDED_SRC_PATHCLUSTER_H__
+
+#include "lib/framework/vector.h"
+
+#include <memory>
+#include <vector>
+
+/// Width and height of a cluster, in tiles.
+#define PATH_CLUSTER_SIZE 16
+
+struct PathClusterGraph;
+
+/** Set of clusters which a route is allowed to pass through.
+ *
+ *  @ingroup pathfinding
+ */
+struct PathClusterCorridor
+{
+	bool contains(int x, int y) const
+	{
+		return clusters[x / PATH_CLUSTER_SIZE + y / PATH_CLUSTER_SIZE * clustersX];
+	}
+
+	int clustersX = 0;
+	std::vector<bool> clusters;
+};
+
+/** Get the cluster graph for a blocking map.
+ *
+ *  If previous is given, and was built for a map of the same size, it is returned unchanged if the blocking map is
+ *  the same, otherwise a copy is made and only the clusters near changed tiles are recalculated.
+ *  Graphs are never modified once returned, so they may be used by the pathfinding threads.
+ *
+ *  @ingroup pathfinding
+ */
+std::shared_ptr<PathClusterGraph const> fpathClusterGraphUpdate(std::shared_ptr<PathClusterGraph const> const &previous, std::vector<bool> const &blockingMap, int width, int height);
+
+/** Find which clusters a route from orig to dest passes through, by searching the cluster graph.
+ *
+ *  @return false if orig and dest are in the same cluster, or if there is no route.
+ *
+ *  @ingroup pathfinding
+ */
+bool fpathClusterCorridor(PathClusterGraph const &graph, Vector2i orig, Vector2i dest, PathClusterCorridor &corridor);
+
+#endif // __INCLUDED_SRC_PATHCLUSTER_H__
@@ -35,7 +35,10 @@ may overlap, in which case they are combined.
 
 For illustrations, run "make check" and look at tests/pointtree.ppm. (Different image each time.)
 The coloured areas are the points in the ranges (note that each range also contains some points
-outside the rectangles). The orange points are the search results.
+outside the rectangles).
+
+Queries don't store anything in the PointTree, so several threads can query the same sorted PointTree
+at once. Filters do get modified by queries, so each thread needs its own.
 */
 
 // Expands bit pattern abcd efgh to 0a0b 0c0d 0e0f 0g0h
@@ -77,24 +80,124 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
-void PointTree::insert(void *pointData, int32_t x, int32_t y)
+// Inverse of expand, ignoring the odd bits.
+static uint32_t compact(uint64_t r)
+{
+	r &= 0x5555555555555555ULL;
+	r = (r | r >> 1)  & 0x3333333333333333ULL;
+	r = (r | r >> 2)  & 0x0F0F0F0F0F0F0F0FULL;
+	r = (r | r >> 4)  & 0x00FF00FF00FF00FFULL;
+	r = (r | r >> 8)  & 0x0000FFFF0000FFFFULL;
+	r = (r | r >> 16) & 0x00000000FFFFFFFFULL;
+	return r;
+}
+
+void PointTree::insert(void *pointData, int32_t x, int32_t y, uint32_t tieBreak)
 {
-	points.push_back(Point(interleave(x, y), pointData));
+	points.push_back(Point{interleave(x, y), tieBreak, pointData});
+	minPointX = std::min(minPointX, x);
+	minPointY = std::min(minPointY, y);
+	maxPointX = std::max(maxPointX, x);
+	maxPointY = std::max(maxPointY, y);
 }
 
 void PointTree::clear()
 {
 	points.clear();
+	minPointX = minPointY = INT32_MAX;
+	maxPointX = maxPointY = INT32_MIN;
+}
+
+uint64_t PointTree::distanceSq(unsigned index, int32_t x, int32_t y) const
+{
+	int64_t dx = (int32_t)(compact(points[index].key >> 1) - 0x80000000u) - (int64_t)x;
+	int64_t dy = (int32_t)(compact(points[index].key) - 0x80000000u) - (int64_t)y;
+	return dx * dx + dy * dy;
+}
+
+bool PointTree::isCovered(int32_t x, int32_t y, int64_t radius) const
+{
+	return x - radius <= minPointX && y - radius <= minPointY && x + radius >= maxPointX && y + radius >= maxPointY;
+}
+
+template<class T>
+static bool pointTreeSortFunction(T const &a, T const &b)
+{
+	return a.key < b.key || (a.key == b.key && a.tieBreak < b.tieBreak);  // Sort only by position and tieBreak, not by pointer address, even if two units are in the same place.
 }
 
-static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
+template<class T>
+static bool pointTreeKeyFunction(T const &a, uint64_t key)
 {
-	return a.first < b.first;  // Sort only by position, not by pointer address, even if two units are in the same place.
+	return a.key < key;
+}
+
+template<class T>
+static bool pointTreeKeyFunctionUpper(uint64_t key, T const &a)
+{
+	return key < a.key;
 }
 
 void PointTree::sort()
 {
-	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction<Point>);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+}
+
+void PointTree::sortNearlySorted()
+{
+	// Insertion sort, which is stable and linear if each point only has to move a short distance. If too many points
+	// turn out to be far from their place, give up and do a normal sort instead of taking quadratic time.
+	size_t movesLeft = points.size() * 8 + 64;
+	for (size_t i = 1; i < points.size(); ++i)
+	{
+		Point point = points[i];
+		size_t j = i;
+		for (; j > 0 && pointTreeSortFunction(point, points[j - 1]); --j)
+		{
+			points[j] = points[j - 1];
+		}
+		points[j] = point;
+		movesLeft -= std::min(movesLeft, i - j);
+		if (movesLeft == 0)
+		{
+			sort();
+			return;
+		}
+	}
+}
+
+void PointTree::sortInserted(size_t sortedSize)
+{
+	std::stable_sort(points.begin() + sortedSize, points.end(), pointTreeSortFunction<Point>);
+	std::inplace_merge(points.begin(), points.begin() + sortedSize, points.end(), pointTreeSortFunction<Point>);
+}
+
+void PointTree::erase(IndexVector const &indices)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+	size_t w = indices[0];
+	for (size_t n = 0; n < indices.size(); ++n)
+	{
+		size_t end = n + 1 < indices.size() ? indices[n + 1] : points.size();
+		for (size_t r = indices[n] + 1; r < end; ++r)
+		{
+			points[w++] = points[r];
+		}
+	}
+	points.resize(w);
+}
+
+void PointTree::merge(PointTree const &a, PointTree const &b)
+{
+	points.resize(a.points.size() + b.points.size());
+	std::merge(a.points.begin(), a.points.end(), b.points.begin(), b.points.end(), points.begin(), pointTreeSortFunction<Point>);
+	minPointX = std::min(a.minPointX, b.minPointX);
+	minPointY = std::min(a.minPointY, b.minPointY);
+	maxPointX = std::max(a.maxPointX, b.maxPointX);
+	maxPointY = std::max(a.maxPointY, b.maxPointY);
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -109,27 +212,7 @@ struct PointTreeRange
 	uint64_t a, z;
 };
 
-// If !IsFiltered, function is trivially optimised to "return i;".
-template<bool IsFiltered>
-static unsigned current(std::vector<unsigned> &filterData, unsigned i)
-{
-	unsigned ret = i;
-	while (IsFiltered && filterData[ret])
-	{
-		ret += filterData[ret];
-	}
-	while (IsFiltered && filterData[i])
-	{
-		unsigned next = i + filterData[i];
-		filterData[i] = ret - i;
-		i = next;
-	}
-
-	return ret;
-}
-
-template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::findRanges(Ranges &ranges, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -144,7 +227,7 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 	uint64_t splitY1 = expandY(splitYo - 1);
 	uint64_t splitY2 = expandY(splitYo);
 
-	PointTreeRange ranges[4] = {{minX    | minY,    splitX1 | splitY1},
+	PointTreeRange splitRanges[4] = {{minX    | minY,    splitX1 | splitY1},
 		{splitX2 | minY,    maxX    | splitY1},
 		{minX    | splitY2, splitX1 | maxY},
 		{splitX2 | splitY2, maxX    | maxY}
@@ -178,19 +261,19 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 					ppm[py][px][2] /= 2;
 				}
 				uint64_t nn = expandX(ax) | expandY(ay);
-				if (ranges[0].a <= nn && nn <= ranges[0].z)
+				if (splitRanges[0].a <= nn && nn <= splitRanges[0].z)
 				{
 					ppm[py][px][0] /= 2;
 				}
-				if (ranges[1].a <= nn && nn <= ranges[1].z)
+				if (splitRanges[1].a <= nn && nn <= splitRanges[1].z)
 				{
 					ppm[py][px][1] /= 2;
 				}
-				if (ranges[2].a <= nn && nn <= ranges[2].z)
+				if (splitRanges[2].a <= nn && nn <= splitRanges[2].z)
 				{
 					ppm[py][px][2] /= 2;
 				}
-				if (ranges[3].a <= nn && nn <= ranges[3].z && ((ax ^ ay) & 2))
+				if (splitRanges[3].a <= nn && nn <= splitRanges[3].z && ((ax ^ ay) & 2))
 				{
 					ppm[py][px][0] /= 2;
 					ppm[py][px][1] /= 2;
@@ -201,62 +284,40 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 #endif //DUMP_IMAGE
 
 	// Sort ranges ready to be merged.
-	if (ranges[1].a > ranges[2].a)
+	if (splitRanges[1].a > splitRanges[2].a)
 	{
-		std::swap(ranges[1], ranges[2]);
+		std::swap(splitRanges[1], splitRanges[2]);
 	}
 	// Merge ranges if needed.
-	if (ranges[2].z + 1 >= ranges[3].a)
+	if (splitRanges[2].z + 1 >= splitRanges[3].a)
 	{
-		ranges[2].z = ranges[3].z;
+		splitRanges[2].z = splitRanges[3].z;
 		--numRanges;
 	}
-	if (ranges[1].z + 1 >= ranges[2].a)
+	if (splitRanges[1].z + 1 >= splitRanges[2].a)
 	{
-		ranges[1].z = ranges[2].z;
-		ranges[2] = ranges[3];
+		splitRanges[1].z = splitRanges[2].z;
+		splitRanges[2] = splitRanges[3];
 		--numRanges;
 	}
-	if (ranges[0].z + 1 >= ranges[1].a)
+	if (splitRanges[0].z + 1 >= splitRanges[1].a)
 	{
-		ranges[0].z = ranges[1].z;
-		ranges[1] = ranges[2];
-		ranges[2] = ranges[3];
+		splitRanges[0].z = splitRanges[1].z;
+		splitRanges[1] = splitRanges[2];
+		splitRanges[2] = splitRanges[3];
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
-	if (IsFiltered)
-	{
-		lastFilteredQueryIndices.clear();
-	}
+	ranges.minX = minX;
+	ranges.maxX = maxX;
+	ranges.minY = minY;
+	ranges.maxY = maxY;
+	ranges.count = numRanges;
 	for (int r = 0; r != numRanges; ++r)
 	{
-		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
-		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
-		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
-
-		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
-		{
-			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
-			uint64_t py = points[i].first & 0x5555555555555555ULL;
-			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
-			{
-				lastQueryResults.push_back(points[i].second);
-				if (IsFiltered)
-				{
-					lastFilteredQueryIndices.push_back(i);
-				}
-#ifdef DUMP_IMAGE
-				if (doDump)
-				{
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][0] = 192;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][1] = 128;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][2] = 0;
-				}
-#endif //DUMP_IMAGE
-			}
-		}
+		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers and tieBreaks are ignored when searching.
+		ranges.begin[r] = std::lower_bound(points.begin(),                   points.end(), splitRanges[r].a, pointTreeKeyFunction<Point>) - points.begin();
+		ranges.end[r]   = std::upper_bound(points.begin() + ranges.begin[r], points.end(), splitRanges[r].z, pointTreeKeyFunctionUpper<Point>) - points.begin();
 	}
 
 #ifdef DUMP_IMAGE
@@ -266,31 +327,38 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
+}
 
-	return lastQueryResults;
+void PointTree::query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const
+{
+	visit(nullptr, x - radius, y - radius, x + radius, y + radius, [&results](void *pointData, unsigned) {
+		results.push_back(pointData);
+	});
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
-	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	lastQueryResults.clear();
+	visit(nullptr, x, y, x2, y2, [this](void *pointData, unsigned) {
+		lastQueryResults.push_back(pointData);
+	});
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
 {
-	Filter unused;
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	lastQueryResults.clear();
+	query(lastQueryResults, x, y, radius);
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
 {
-	int32_t minXo = x - radius;
-	int32_t maxXo = x + radius;
-	int32_t minYo = y - radius;
-	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	lastQueryResults.clear();
+	lastFilteredQueryIndices.clear();
+	visit(&filter, x - radius, y - radius, x + radius, y + radius, [this](void *pointData, unsigned index) {
+		lastQueryResults.push_back(pointData);
+		lastFilteredQueryIndices.push_back(index);
+	});
+	return lastQueryResults;
 }
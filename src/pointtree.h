@@ -47,14 +47,130 @@ public:
 	private:
 		friend class PointTree;
 
+		/// Returns the first index >= i which has not been erased, and shortens the path for next time.
+		unsigned current(unsigned i)
+		{
+			unsigned ret = i;
+			while (data[ret])
+			{
+				ret += data[ret];
+			}
+			while (data[i])
+			{
+				unsigned next = i + data[i];
+				data[i] = ret - i;
+				i = next;
+			}
+			return ret;
+		}
+
 		typedef std::vector<unsigned> Data;
 
 		Data data;
 	};
 
-	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
+	/// Ranges of points which may be in a query square, see findRanges.
+	struct Ranges
+	{
+		bool contains(uint64_t point) const
+		{
+			uint64_t px = point & 0xAAAAAAAAAAAAAAAAULL;
+			uint64_t py = point & 0x5555555555555555ULL;
+			return px >= minX && px <= maxX && py >= minY && py <= maxY;
+		}
+
+		uint64_t minX, maxX, minY, maxY;  ///< Interleaved bounds of the square.
+		unsigned begin[4], end[4];        ///< Point index ranges [begin, end), which may also contain points outside the square.
+		int count;
+	};
+
+	/// Inserts a point into the point tree. Points in exactly the same place are sorted by tieBreak, and then by the order they were inserted.
+	void insert(void *pointData, int32_t x, int32_t y, uint32_t tieBreak = 0);
 	void clear();                                                             ///< Clears the PointTree.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
+	/// Same result as sort(), but faster if the points were inserted nearly in order, for example in the order of the previous sort.
+	void sortNearlySorted();
+	/// Same result as sort(), if the first sortedSize points were already sorted. Faster if only a few points were inserted since.
+	void sortInserted(size_t sortedSize);
+	/// Removes the points at the given indices, which must be in increasing order. Leaves the PointTree sorted, if it was sorted.
+	void erase(IndexVector const &indices);
+	/// Replaces the points by those of a and b, which must be sorted. Leaves the PointTree sorted, as if all the points had been inserted and sorted.
+	void merge(PointTree const &a, PointTree const &b);
+	size_t size() const
+	{
+		return points.size();
+	}
+	void *pointData(unsigned index) const  ///< Returns the point at the index passed to a visitor, or in sorted order after sorting.
+	{
+		return points[index].data;
+	}
+
+	/// Calls visitor(pointData, index) for each point in the square from (minX, minY) to (maxX, maxY) inclusive, which has not been erased from filter.
+	/// Pass nullptr as filter to visit all points. The index can be passed to Filter::erase, to skip the point in later queries.
+	/// Thread safe, as long as the PointTree is not modified meanwhile and each thread uses its own filter, since the only state is in the filter.
+	template<class Visitor>
+	void visit(Filter *filter, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY, Visitor &&visitor) const
+	{
+		Ranges ranges;
+		findRanges(ranges, minX, minY, maxX, maxY);
+		for (int r = 0; r != ranges.count; ++r)
+		{
+			unsigned end = ranges.end[r];
+			for (unsigned i = filter != nullptr ? filter->current(ranges.begin[r]) : ranges.begin[r]; i < end; i = filter != nullptr ? filter->current(i + 1) : i + 1)
+			{
+				if (ranges.contains(points[i].key))  // Only visit point if it's at least in the desired square.
+				{
+					visitor(points[i].data, i);
+				}
+			}
+		}
+	}
+	/// Appends all points less than or equal to radius from (x, y), possibly plus some extra nearby points, to results.
+	/// (More specifically, appends all objects in a square with edge length 2*radius.) Thread safe, see visit().
+	void query(ResultVector &results, int32_t x, int32_t y, uint32_t radius) const;
+
+	/// Appends to results the k points nearest to (x, y), no further than maxRadius, for which predicate(pointData) is true.
+	/// Nearest first, and points at the same distance in sorted order. Thread safe, see visit().
+	template<class Predicate>
+	void nearest(ResultVector &results, int32_t x, int32_t y, unsigned k, uint32_t maxRadius, Predicate &&predicate) const
+	{
+		// Search squares of doubling size, only visiting the ring which was not covered by the previous square. Once k
+		// points are closer than the edge of the square, nothing outside the square can be any closer.
+		std::vector<Nearest> candidates;
+		unsigned closeEnough = 0;
+		int64_t inner = -1;
+		int64_t outer = std::min<int64_t>(maxRadius, NEAREST_START_RADIUS);
+		while (true)
+		{
+			visitRing(x, y, inner, outer, [&](void *pointData, unsigned index) {
+				if (predicate(pointData))
+				{
+					uint64_t distSq = distanceSq(index, x, y);
+					if (distSq <= (uint64_t)maxRadius * maxRadius)
+					{
+						candidates.push_back(Nearest{distSq, index, pointData});
+					}
+				}
+			});
+			bool covered = isCovered(x, y, outer);
+			closeEnough = std::count_if(candidates.begin(), candidates.end(), [outer](Nearest const &candidate) {
+				return candidate.distSq <= (uint64_t)(outer * outer);
+			});
+			if (closeEnough >= k || outer >= maxRadius || covered)
+			{
+				break;
+			}
+			inner = outer;
+			outer = std::min<int64_t>(outer * 2, maxRadius);
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+		for (unsigned n = 0; n < std::min<size_t>(k, candidates.size()); ++n)
+		{
+			results.push_back(candidates[n].pointData);
+		}
+	}
+
 	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
 	/// (More specifically, returns all objects in a square with edge length 2*radius.)
 	/// Note: Not thread safe, because it modifies lastQueryResults.
@@ -70,13 +186,66 @@ public:
 	IndexVector lastFilteredQueryIndices;
 
 private:
-	typedef std::pair<uint64_t, void *> Point;
+	struct Point
+	{
+		uint64_t key;       ///< Interleaved coordinates.
+		uint32_t tieBreak;
+		void *data;
+	};
 	typedef std::vector<Point> Vector;
 
-	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	struct Nearest
+	{
+		bool operator <(Nearest const &b) const
+		{
+			return distSq < b.distSq || (distSq == b.distSq && index < b.index);
+		}
+
+		uint64_t distSq;
+		unsigned index;
+		void *pointData;
+	};
+	enum
+	{
+		NEAREST_START_RADIUS = 512  ///< Size of the first square searched by nearest, in the same units as the points.
+	};
+
+	/// Finds the ranges of sorted points which may be in the square from (minXo, minYo) to (maxXo, maxYo).
+	void findRanges(Ranges &ranges, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo) const;
+	uint64_t distanceSq(unsigned index, int32_t x, int32_t y) const;  ///< Squared distance from the point at index to (x, y).
+	bool isCovered(int32_t x, int32_t y, int64_t radius) const;          ///< Whether the square with edge length 2*radius contains all points.
+
+	/// Visits the points in the rectangle, clipped to the area containing points, so the coordinates can't overflow.
+	template<class Visitor>
+	void visitRect(int64_t minX, int64_t minY, int64_t maxX, int64_t maxY, Visitor &&visitor) const
+	{
+		minX = std::max<int64_t>(minX, minPointX);
+		minY = std::max<int64_t>(minY, minPointY);
+		maxX = std::min<int64_t>(maxX, maxPointX);
+		maxY = std::min<int64_t>(maxY, maxPointY);
+		if (minX <= maxX && minY <= maxY)
+		{
+			visit(nullptr, minX, minY, maxX, maxY, visitor);
+		}
+	}
+	/// Visits the points in the square with edge length 2*outer, but not in the square with edge length 2*inner. Use inner = -1 to visit the whole square.
+	template<class Visitor>
+	void visitRing(int32_t x, int32_t y, int64_t inner, int64_t outer, Visitor &&visitor) const
+	{
+		if (inner < 0)
+		{
+			visitRect(x - outer, y - outer, x + outer, y + outer, visitor);
+			return;
+		}
+		visitRect(x - outer,     y - outer,     x + outer,     y - inner - 1, visitor);  // Top.
+		visitRect(x - outer,     y + inner + 1, x + outer,     y + outer,     visitor);  // Bottom.
+		visitRect(x - outer,     y - inner,     x - inner - 1, y + inner,     visitor);  // Left.
+		visitRect(x + inner + 1, y - inner,     x + outer,     y + inner,     visitor);  // Right.
+	}
 
 	Vector points;
+	int32_t minPointX = INT32_MAX, minPointY = INT32_MAX;  ///< Bounds of all points inserted since the last clear.
+	int32_t maxPointX = INT32_MIN, maxPointY = INT32_MIN;
 };
 
 #endif //_point_tree_h
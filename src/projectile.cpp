@@ -59,6 +59,8 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #ifndef GLM_ENABLE_EXPERIMENTAL
 	#define GLM_ENABLE_EXPERIMENTAL
 #endif
@@ -76,9 +78,12 @@ struct INTERVAL
 	int begin, end;  // Time 1 = 0, time 2 = 1024. Or begin >= end if empty.
 };
 
-// Watermelon:they are from droid.c
 /* The range for neighbouring objects */
 #define PROJ_NEIGHBOUR_RANGE (TILE_UNITS*4)
+/* Size of the cells used to find the objects a projectile might hit */
+#define PROJ_BROADPHASE_CELL (TILE_UNITS*2)
+/* Number of projectiles allocated at once */
+#define PROJ_POOL_SLAB_SIZE 256
 // used to create a specific ID for projectile objects to facilitate tracking them.
 static const UDWORD ProjectileTrackerID =	0xdead0000;
 
@@ -88,6 +93,69 @@ static std::vector<PROJECTILE *> psProjectileList;
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
 
+/// Memory for projectiles. Hundreds of projectiles can be fired and freed every second, so instead of allocating each one,
+/// they are kept in slabs which stay allocated, and the slot of a freed projectile is reused by the next one. Projectiles
+/// never move, so pointers to them stay valid until they are destroyed.
+class ProjectilePool
+{
+public:
+	PROJECTILE *create(uint32_t id, unsigned player);
+	void destroy(PROJECTILE *psProj);
+	void freeSlabs();  ///< Frees all memory, must only be called once all projectiles are destroyed.
+
+	size_t slabCount() const
+	{
+		return slabs.size();
+	}
+	size_t capacity() const
+	{
+		return slabs.size() * PROJ_POOL_SLAB_SIZE;
+	}
+	size_t liveCount() const
+	{
+		return capacity() - freeSlots.size();
+	}
+	size_t createdCount() const
+	{
+		return created;
+	}
+
+private:
+	typedef std::aligned_storage<sizeof(PROJECTILE), alignof(PROJECTILE)>::type Slot;
+
+	std::vector<std::unique_ptr<Slot[]>> slabs;
+	std::vector<Slot *> freeSlots;
+	size_t created = 0;
+};
+
+static ProjectilePool projPool;
+
+/// The objects which projectiles could hit this tick, binned once per tick by the cells touched by their shapes as they moved
+/// during the tick. Objects don't move while projectiles are updated, so each projectile only needs to look at the cells its
+/// own path touches.
+struct ProjectileBroadphase
+{
+	struct CellRect
+	{
+		int x1, y1, x2, y2;  ///< Inclusive.
+	};
+
+	void build();
+	/// Finds the objects which might collide with something moving from a to b. They are in list order, which is the same on all clients.
+	void query(std::vector<BASE_OBJECT *> &candidates, Vector2i a, Vector2i b);
+	CellRect cellRect(Vector2i a, Vector2i b, int extent) const;
+
+	int width = 0, height = 0;          ///< Size of the map in cells.
+	std::vector<BASE_OBJECT *> objects;
+	std::vector<CellRect> objectCells;  ///< Cells touched by each object.
+	std::vector<unsigned> cellStart;    ///< The objects touching cell c are cellObjects[cellStart[c]] to cellObjects[cellStart[c + 1] - 1].
+	std::vector<unsigned> cellObjects;  ///< Indices into objects.
+	std::vector<unsigned> cellFill;     ///< Scratch space for build.
+	std::vector<unsigned> found;        ///< Scratch space for query.
+};
+
+static ProjectileBroadphase projBroadphase;
+
 /***************************************************************************/
 
 // the last unit that did damage - used by script functions
@@ -196,6 +264,10 @@ proj_InitSystem()
 void
 proj_FreeAllProjectiles()
 {
+	for (PROJECTILE *psProj : psProjectileList)
+	{
+		projPool.destroy(psProj);
+	}
 	psProjectileList.clear();
 	psProjectileNext = psProjectileList.end();
 }
@@ -206,6 +278,7 @@ bool
 proj_Shutdown()
 {
 	proj_FreeAllProjectiles();
+	projPool.freeSlabs();
 
 	return true;
 }
@@ -413,7 +486,7 @@ bool proj_SendProjectileAngled(WEAPON *psWeap, SIMPLE_OBJECT *psAttacker, int pl
 	ASSERT_OR_RETURN(false, psStats != nullptr, "Invalid weapon stats");
 	ASSERT_OR_RETURN(false, psTarget == nullptr || !psTarget->died, "Aiming at dead target!");
 
-	PROJECTILE *psProj = new PROJECTILE(ProjectileTrackerID | (realTime >> 4), player);
+	PROJECTILE *psProj = projPool.create(ProjectileTrackerID | (realTime >> 4), player);
 
 	/* get muzzle offset */
 	if (psAttacker == nullptr)
@@ -793,15 +866,20 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 
 	closestCollisionSpacetime.time = 0xFFFFFFFF;
 
-	/* Check nearby objects for possible collisions */
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	/* Check objects near the path of the projectile for possible collisions */
+	static std::vector<BASE_OBJECT *> candidates;  // static to avoid allocations.
+	projBroadphase.query(candidates, psProj->prevSpacetime.pos.xy(), psProj->pos.xy());
+	for (BASE_OBJECT *psTempObj : candidates)
 	{
-		BASE_OBJECT *psTempObj = *gi;
 		CHECK_OBJECT(psTempObj);
 
-		if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
+		Vector2i offset = psTempObj->pos.xy() - psProj->pos.xy();
+		if ((int64_t)offset.x * offset.x + (int64_t)offset.y * offset.y > (int64_t)PROJ_NEIGHBOUR_RANGE * PROJ_NEIGHBOUR_RANGE)
+		{
+			// Only objects near where the projectile ended up can be hit, as when it searched the object grid
+			continue;
+		}
+		else if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
 		{
 			// Dont damage one target twice
 			continue;
@@ -1156,7 +1234,7 @@ static void proj_ImpactFunc(PROJECTILE *psObj)
 		psObj->born = gameTime;
 
 		static GridList gridList;  // static to avoid allocations.
-		gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, psStats->upgrade[psObj->player].radius);
+		gridQuery(gridList, psObj->pos.x, psObj->pos.y, psStats->upgrade[psObj->player].radius);
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psCurr = *gi;
@@ -1323,12 +1401,163 @@ void PROJECTILE::update()
 /***************************************************************************/
 
 // iterate through all projectiles and update their status
+void ProjectileBroadphase::build()
+{
+	width = (world_coord(mapWidth) + PROJ_BROADPHASE_CELL - 1) / PROJ_BROADPHASE_CELL;
+	height = (world_coord(mapHeight) + PROJ_BROADPHASE_CELL - 1) / PROJ_BROADPHASE_CELL;
+	objects.clear();
+	objectCells.clear();
+	cellStart.assign(width * height + 1, 0);
+
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		BASE_OBJECT *start[3] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
+		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
+		{
+			for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
+			{
+				if (psObj->died || (psObj->type == OBJ_FEATURE && !((FEATURE *)psObj)->psStats->damageable))
+				{
+					continue;  // Can't be hit, see proj_InFlightFunc.
+				}
+				Vector2i prevPos = isDroid(psObj) ? castDroid(psObj)->prevSpacetime.pos.xy() : psObj->pos.xy();
+				ObjectShape shape = establishTargetShape(psObj);
+				CellRect rect = cellRect(prevPos, psObj->pos.xy(), std::max(shape.size.x, shape.size.y));
+				objects.push_back(psObj);
+				objectCells.push_back(rect);
+				for (int y = rect.y1; y <= rect.y2; ++y)
+				{
+					for (int x = rect.x1; x <= rect.x2; ++x)
+					{
+						++cellStart[y * width + x + 1];
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t c = 1; c < cellStart.size(); ++c)
+	{
+		cellStart[c] += cellStart[c - 1];
+	}
+	cellObjects.resize(cellStart.back());
+	cellFill.assign(cellStart.begin(), cellStart.end() - 1);
+	for (unsigned i = 0; i < objects.size(); ++i)
+	{
+		CellRect const &rect = objectCells[i];
+		for (int y = rect.y1; y <= rect.y2; ++y)
+		{
+			for (int x = rect.x1; x <= rect.x2; ++x)
+			{
+				cellObjects[cellFill[y * width + x]++] = i;
+			}
+		}
+	}
+}
+
+ProjectileBroadphase::CellRect ProjectileBroadphase::cellRect(Vector2i a, Vector2i b, int extent) const
+{
+	CellRect rect;
+	rect.x1 = clip((std::min(a.x, b.x) - extent) / PROJ_BROADPHASE_CELL, 0, width - 1);
+	rect.y1 = clip((std::min(a.y, b.y) - extent) / PROJ_BROADPHASE_CELL, 0, height - 1);
+	rect.x2 = clip((std::max(a.x, b.x) + extent) / PROJ_BROADPHASE_CELL, 0, width - 1);
+	rect.y2 = clip((std::max(a.y, b.y) + extent) / PROJ_BROADPHASE_CELL, 0, height - 1);
+	return rect;
+}
+
+void ProjectileBroadphase::query(std::vector<BASE_OBJECT *> &candidates, Vector2i a, Vector2i b)
+{
+	candidates.clear();
+	if (width <= 0 || height <= 0)
+	{
+		return;
+	}
+	found.clear();
+	CellRect rect = cellRect(a, b, 0);  // The objects' cells already include their size.
+	for (int y = rect.y1; y <= rect.y2; ++y)
+	{
+		for (int x = rect.x1; x <= rect.x2; ++x)
+		{
+			int c = y * width + x;
+			found.insert(found.end(), cellObjects.begin() + cellStart[c], cellObjects.begin() + cellStart[c + 1]);
+		}
+	}
+	// Objects can touch several cells, and the order must not depend on which cells were looked at.
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+	for (unsigned i : found)
+	{
+		candidates.push_back(objects[i]);
+	}
+}
+
+PROJECTILE *ProjectilePool::create(uint32_t id, unsigned player)
+{
+	if (freeSlots.empty())
+	{
+		slabs.emplace_back(new Slot[PROJ_POOL_SLAB_SIZE]);
+		// Hand out the slots in address order.
+		for (unsigned i = PROJ_POOL_SLAB_SIZE; i-- > 0;)
+		{
+			freeSlots.push_back(&slabs.back()[i]);
+		}
+	}
+	Slot *slot = freeSlots.back();
+	freeSlots.pop_back();
+	++created;
+	return new(slot) PROJECTILE(id, player);
+}
+
+void ProjectilePool::destroy(PROJECTILE *psProj)
+{
+	psProj->~PROJECTILE();
+	freeSlots.push_back(reinterpret_cast<Slot *>(psProj));
+}
+
+void ProjectilePool::freeSlabs()
+{
+	ASSERT_OR_RETURN(, liveCount() == 0, "%u projectiles still in use", (unsigned)liveCount());
+	freeSlots.clear();
+	slabs.clear();
+}
+
+bool PROJECTILE::deleteIfDead()
+{
+	if (died == 0 || died >= gameTime - deltaGameTime)
+	{
+		return false;
+	}
+	projPool.destroy(this);
+	return true;
+}
+
+PROJECTILE_POOL_STATS proj_GetPoolStats()
+{
+	PROJECTILE_POOL_STATS stats;
+	stats.live = projPool.liveCount();
+	stats.capacity = projPool.capacity();
+	stats.slabs = projPool.slabCount();
+	stats.created = projPool.createdCount();
+	stats.damagedAllocations = decltype(PROJECTILE::psDamaged)::heapAllocations();
+	return stats;
+}
+
 void proj_UpdateAll()
 {
-	std::vector<PROJECTILE *> psProjectileListOld = psProjectileList;
+	if (psProjectileList.empty())
+	{
+		return;
+	}
 
-	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
-	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fun(&PROJECTILE::update));
+	// Objects don't move while the projectiles are being updated, so only look for them once.
+	projBroadphase.build();
+
+	// Update all projectiles. Penetrating projectiles may add to psProjectileList, but those are only updated next tick.
+	// Index, since adding may reallocate the list.
+	for (size_t i = 0, count = psProjectileList.size(); i < count; ++i)
+	{
+		psProjectileList[i]->update();
+	}
 
 	// Remove and free dead projectiles.
 	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fun(&PROJECTILE::deleteIfDead)), psProjectileList.end());
@@ -1346,7 +1575,7 @@ static void proj_checkPeriodicalDamage(PROJECTILE *psProj)
 	WEAPON_STATS *psStats = psProj->psWStats;
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, psStats->upgrade[psProj->player].periodicalDamageRadius);
+	gridQuery(gridList, psProj->pos.x, psProj->pos.y, psStats->upgrade[psProj->player].periodicalDamageRadius);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psCurr = *gi;
@@ -56,6 +56,17 @@ PROJECTILE *proj_GetNext();		///< Get next projectile in the list.
 
 void	proj_FreeAllProjectiles();	///< Free all projectiles in the list.
 
+/// How much memory projectiles use, for profiling.
+struct PROJECTILE_POOL_STATS
+{
+	size_t live;                ///< Projectiles in use.
+	size_t capacity;            ///< Projectiles that fit in the allocated memory.
+	size_t slabs;               ///< Allocations made for projectiles.
+	size_t created;             ///< Projectiles created since starting.
+	size_t damagedAllocations;  ///< Allocations made because a projectile damaged too many objects to store inline.
+};
+PROJECTILE_POOL_STATS proj_GetPoolStats();
+
 void setExpGain(int player, int gain);
 int getExpGain(int player);
 
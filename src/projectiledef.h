@@ -25,6 +25,7 @@
 #define __INCLUDED_PROJECTILEDEF_H__
 
 #include "basedef.h"
+#include "lib/framework/smallvector.h"
 #include "lib/gamelib/gtime.h"
 
 #include <vector>
@@ -43,22 +44,14 @@ struct PROJECTILE : public SIMPLE_OBJECT
 	PROJECTILE(uint32_t id, unsigned player) : SIMPLE_OBJECT(OBJ_PROJECTILE, id, player) {}
 
 	void            update();
-	bool            deleteIfDead()
-	{
-		if (died == 0 || died >= gameTime - deltaGameTime)
-		{
-			return false;
-		}
-		delete this;
-		return true;
-	}
+	bool            deleteIfDead();         ///< Returns the projectile to the projectile pool, if it has been dead for a tick.
 
 	UBYTE           state;                  ///< current projectile state
 	UBYTE           bVisible;               ///< whether the selected player should see the projectile
 	WEAPON_STATS   *psWStats;               ///< firing weapon stats
 	BASE_OBJECT    *psSource;               ///< what fired the projectile
 	BASE_OBJECT    *psDest;                 ///< target of this projectile
-	std::vector<BASE_OBJECT *> psDamaged;   ///< the targets that have already been dealt damage to (don't damage the same target twice)
+	SmallVector<BASE_OBJECT *, 4> psDamaged; ///< the targets that have already been dealt damage to (don't damage the same target twice)
 
 	Vector3i        src = Vector3i(0, 0, 0); ///< Where projectile started
 	Vector3i        dst = Vector3i(0, 0, 0); ///< The target coordinates
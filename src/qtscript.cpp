@@ -62,11 +62,14 @@
 #include <QtScript/QScriptEngine>
 #include <QtScript/QScriptValue>
 #include <QtScript/QScriptValueIterator>
+#include <QtScript/QScriptString>
 #include <QtScript/QScriptSyntaxCheckResult>
 #include <QtCore/QList>
 #include <QtCore/QQueue>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QVector>
 #include <QtCore/QFileInfo>
 #include <QtCore/QElapsedTimer>
 #include <QtGui/QStandardItemModel>
@@ -91,15 +94,23 @@
 #include "clparse.h"
 #include "mission.h"
 #include "modding.h"
+#include "random.h"
 #include "version.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "qtscriptdebug.h"
 #include "qtscriptfuncs.h"
+#include "tickperf.h"
 
 #define ATTACK_THROTTLE 1000
+#define TIMER_CALLS_PER_TICK 10  ///< Per script, any further timers that are due wait for the next tick.
 
 typedef QList<QStandardItem *> QStandardItemList;
 
@@ -132,20 +143,84 @@ struct timerNode
 	{
 		return function == t.function && player == t.player;
 	}
-	// implement operator less TODO
 };
 
 #define MAX_US 20000
 #define HALF_MAX_US 10000
 
-/// List of timer events for scripts. Before running them, we sort the list then run as many as we have time for.
-/// In this way, we implement load balancing of events and keep frame rates tidy for users. Since scripts run on the
-/// host, we do not need to worry about each peer simulating the world differently.
-static QList<timerNode> timers;
+/// Timer events for scripts, by the gameTime they are due at and then by the order they were scheduled in, so that
+/// timers which are due at the same time always run in the same order. Global scripts run on every client and must
+/// behave the same everywhere, so nothing about the timers may depend on wall clock time or on the other scripts.
+typedef std::pair<int, uint32_t> TIMER_KEY;
+static std::map<TIMER_KEY, timerNode> timers;
+static uint32_t timerSequence = 0;
+
+/// Global scripts, as opposed to AI scripts, which only run on the client responsible for their player.
+static QSet<QScriptEngine *> globalScripts;
 
 /// Scripting engine (what others call the scripting context, but QtScript's nomenclature is different).
 static QList<QScriptEngine *> scripts;
 
+/// Whether AI scripts get their API functions wrapped when loaded, so that their timers can run concurrently.
+static bool concurrentScripts = false;
+/// AI scripts which were loaded with their API functions wrapped, and whose timers run concurrently.
+static QSet<QScriptEngine *> concurrentEngines;
+
+/// A call of an API function which changes the game state, made by an AI script while running concurrently.
+struct DEFERRED_CALL
+{
+	QScriptValue function;
+	QScriptValue thisObject;
+	QScriptValueList args;
+};
+
+/// A message about an AI script running concurrently, logged once all the scripts have finished.
+struct SCRIPT_MESSAGE
+{
+	code_part part;
+	bool failed;  ///< Whether to report the message as a failed assertion.
+	std::string text;
+};
+
+/// The timers an AI script runs this tick, concurrently with the other AI scripts, and the changes they asked for.
+struct CONCURRENT_RUN
+{
+	QScriptEngine *engine;
+	int player;
+	std::vector<std::pair<QString, QScriptValueList>> calls;
+	std::vector<DEFERRED_CALL> deferred;
+	std::vector<SCRIPT_MESSAGE> messages;
+	std::unique_ptr<MersenneTwister> random;  ///< For syncRandom, made when first needed.
+	int newGroups;  ///< Groups made by newGroup, numbered from nextGroup.
+};
+/// Only filled while AI scripts run concurrently, and not changed until they have all finished.
+static QHash<QScriptEngine *, CONCURRENT_RUN *> concurrentRuns;
+static WZ_MUTEX *scriptStateMutex = nullptr;
+
+static int nextGroup = 1;  // group zero reserved
+
+/// Replaces Math.random in autogames, so that a test game with a given seed plays out the same each time.
+static std::map<QScriptEngine *, MersenneTwister> autogameRandom;
+
+static void scheduleTimer(const timerNode &node)
+{
+	timers.emplace(TIMER_KEY(node.frameTime, timerSequence++), node);
+}
+
+/// How long to delay the first call of a new repeating timer, so that timers with the same interval, such as the
+/// timers of several copies of the same AI, are spread over the ticks of the interval instead of all running at once.
+static int timerPhase(QScriptEngine *engine, int ms)
+{
+	int slots = std::max(ms / GAME_TICKS_PER_UPDATE, 1);
+	// The player of a global script is the local player, which differs between clients.
+	int index = globalScripts.contains(engine) ? 0 : engine->globalObject().property("me").toInt32();
+	for (const auto &i : timers)
+	{
+		index += i.second.engine == engine && i.second.type == TIMER_REPEAT && i.second.ms == ms;
+	}
+	return index % slots * GAME_TICKS_PER_UPDATE;
+}
+
 /// Whether the scripts have been set up or not
 static bool scriptsReady = false;
 
@@ -178,6 +253,24 @@ typedef QHash<QString, MONITOR_BIN> MONITOR;
 static QHash<QScriptEngine *, MONITOR *> monitors;
 static QHash<QScriptEngine *, QStringList> eventNamespaces; // separate event namespaces for libraries
 
+/// A function which an event calls, if the script defines it.
+struct EVENT_HANDLER
+{
+	QString name;
+	QScriptString handle;  ///< name, interned in the engine, for faster lookup.
+};
+
+/// What firing an event needs to know about an engine, so that it does not have to look up globals or build names each time.
+/// Only the names are cached, not the functions, since scripts may replace their event functions at any time.
+struct ENGINE_DISPATCH
+{
+	int player;
+	bool receiveAll;
+	std::string profileName;                             ///< "scriptName/me", for the tick profiler.
+	QHash<QString, QVector<EVENT_HANDLER>> handlers;     ///< For each event fired so far, its namespaced variants, then the event itself.
+};
+static QHash<QScriptEngine *, ENGINE_DISPATCH> dispatchTables;
+
 static MODELMAP models;
 static QStandardItemModel *triggerModel;
 static bool globalDialog = false;
@@ -193,43 +286,148 @@ void doNotSaveGlobal(const QString &global)
 	internalNamespace.insert(global);
 }
 
-// Call a function by name
-static QScriptValue callFunction(QScriptEngine *engine, const QString &function, const QScriptValueList &args, bool event = true)
+void scriptDispatchChanged(QScriptEngine *engine)
 {
-	if (event)
+	ENGINE_DISPATCH &dispatch = dispatchTables[engine];
+	dispatch.player = engine->globalObject().property("me").toInt32();
+	dispatch.receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+	dispatch.profileName = QString("%1/%2").arg(engine->globalObject().property("scriptName").toString()).arg(dispatch.player).toStdString();
+	dispatch.handlers.clear();
+}
+
+ScriptStateLock::ScriptStateLock() : locked(!concurrentRuns.isEmpty())
+{
+	if (locked)
+	{
+		wzMutexLock(scriptStateMutex);
+	}
+}
+
+ScriptStateLock::~ScriptStateLock()
+{
+	if (locked)
+	{
+		wzMutexUnlock(scriptStateMutex);
+	}
+}
+
+int32_t scriptSyncRandom(QScriptEngine *engine, uint32_t limit)
+{
+	CONCURRENT_RUN *run = concurrentRuns.value(engine);
+	if (run == nullptr)
+	{
+		return gameRand(limit);
+	}
+	if (!run->random)
+	{
+		// Leave the game's own sequence alone, which is the same on all clients, unlike which AIs run here.
+		run->random.reset(new MersenneTwister(gameRandSeed() ^ gameTime * 0x9E3779B9u ^ run->player));
+	}
+	return run->random->u32() % limit;
+}
+
+int scriptNewGroup(QScriptEngine *engine)
+{
+	CONCURRENT_RUN *run = concurrentRuns.value(engine);
+	if (run == nullptr)
+	{
+		return nextGroup++;
+	}
+	return nextGroup + run->newGroups++;
+}
+
+static ENGINE_DISPATCH &engineDispatch(QScriptEngine *engine)
+{
+	QHash<QScriptEngine *, ENGINE_DISPATCH>::iterator i = dispatchTables.find(engine);
+	if (i == dispatchTables.end())
+	{
+		scriptDispatchChanged(engine);
+		i = dispatchTables.find(engine);
+	}
+	return *i;
+}
+
+/// Returns the functions to look for when firing event in engine.
+static QVector<EVENT_HANDLER> const &eventHandlers(QScriptEngine *engine, const QString &event)
+{
+	ENGINE_DISPATCH &dispatch = engineDispatch(engine);
+	QHash<QString, QVector<EVENT_HANDLER>>::iterator i = dispatch.handlers.find(event);
+	if (i == dispatch.handlers.end())
 	{
-		// recurse into variants, if any
-		for (const QString &s : eventNamespaces[engine])
+		ScriptStateLock lock;  // Another script running concurrently may be changing its namespaces.
+		QVector<EVENT_HANDLER> handlers;
+		for (const QString &s : eventNamespaces.value(engine))
 		{
-			const QScriptValue &value = engine->globalObject().property(s + function);
-			if (value.isValid() && value.isFunction())
-			{
-				callFunction(engine, s + function, args, event);
-			}
+			handlers.push_back({s + event, engine->toStringHandle(s + event)});
 		}
+		handlers.push_back({event, engine->toStringHandle(event)});
+		i = dispatch.handlers.insert(event, handlers);
 	}
-	code_part level = event ? LOG_SCRIPT : LOG_ERROR;
-	QScriptValue value = engine->globalObject().property(function);
-	if (!value.isValid() || !value.isFunction())
+	return *i;
+}
+
+/// Makes sure callFunction finds the handlers of event in engine ready, and so only reads the dispatch tables.
+static void prepareEventHandlers(QScriptEngine *engine, const QString &event)
+{
+	QVector<EVENT_HANDLER> const handlers = eventHandlers(engine, event);  // copied, since the recursion adds more
+	for (int i = 0; i < handlers.size() - 1; ++i)
 	{
-		// not necessarily an error, may just be a trigger that is not defined (ie not needed)
-		// or it could be a typo in the function name or ...
-		debug(level, "called function (%s) not defined", function.toUtf8().constData());
-		return false;
+		const QScriptValue &value = engine->globalObject().property(handlers[i].handle);
+		if (value.isValid() && value.isFunction())
+		{
+			prepareEventHandlers(engine, handlers[i].name);
+		}
+	}
+}
+
+static void reportScriptMessage(const SCRIPT_MESSAGE &message)
+{
+	if (message.failed)
+	{
+		ASSERT(false, "%s", message.text.c_str());
+	}
+	else
+	{
+		debug(message.part, "%s", message.text.c_str());
+	}
+}
+
+/// Logs a message about a script, or if the script is running concurrently, keeps it until all the scripts have
+/// finished, since the debug log is not thread-safe.
+template <typename... P>
+static void scriptMessage(QScriptEngine *engine, code_part part, bool failed, char const *format, P &&... params)
+{
+	if (!failed && !enabled_debug[part])
+	{
+		return;
+	}
+	SCRIPT_MESSAGE message = {part, failed, astringf(format, std::forward<P>(params)...)};
+	CONCURRENT_RUN *run = concurrentRuns.value(engine);
+	if (run != nullptr)
+	{
+		run->messages.push_back(std::move(message));
+		return;
 	}
+	reportScriptMessage(message);
+}
+
+// Call a function which has already been looked up
+static QScriptValue callResolvedFunction(QScriptEngine *engine, const QString &function, QScriptValue const &value, const QScriptValueList &args)
+{
 	QElapsedTimer timer;
 	timer.start();
 	QScriptValue result = value.call(QScriptValue(), args);
 	int ticks = timer.nsecsElapsed() / 1000;
-	MONITOR *monitor = monitors.value(engine); // pick right one for this engine
-	MONITOR_BIN m;
-	if (monitor->contains(function))
+	if (tickPerfActive())
 	{
-		m = monitor->value(function);
+		ScriptStateLock lock;
+		tickPerfAddScript(engineDispatch(engine).profileName, std::chrono::microseconds(ticks));
 	}
+	MONITOR *monitor = monitors.value(engine); // pick right one for this engine
+	MONITOR_BIN &m = (*monitor)[function];
 	if (ticks > MAX_US)
 	{
-		debug(LOG_SCRIPT, "%s took %dus at time %d", function.toUtf8().constData(), ticks, wzGetTicks());
+		scriptMessage(engine, LOG_SCRIPT, false, "%s took %dus at time %d", function.toUtf8().constData(), ticks, wzGetTicks());
 		m.overMaxTimeCalls++;
 	}
 	else if (ticks > HALF_MAX_US)
@@ -243,23 +441,279 @@ static QScriptValue callFunction(QScriptEngine *engine, const QString &function,
 		m.worstGameTime = gameTime;
 	}
 	m.time += ticks;
-	monitor->insert(function, m);
 	if (engine->hasUncaughtException())
 	{
 		int line = engine->uncaughtExceptionLineNumber();
 		QStringList bt = engine->uncaughtExceptionBacktrace();
 		for (int i = 0; i < bt.size(); i++)
 		{
-			debug(LOG_ERROR, "%d : %s", i, bt.at(i).toUtf8().constData());
+			scriptMessage(engine, LOG_ERROR, false, "%d : %s", i, bt.at(i).toUtf8().constData());
 		}
-		ASSERT(false, "Uncaught exception calling function \"%s\" at line %d: %s",
-		       function.toUtf8().constData(), line, result.toString().toUtf8().constData());
+		scriptMessage(engine, LOG_ERROR, true, "Uncaught exception calling function \"%s\" at line %d: %s",
+		              function.toUtf8().constData(), line, result.toString().toUtf8().constData());
 		engine->clearExceptions();
 		return QScriptValue();
 	}
 	return result;
 }
 
+// Call a function by name
+static QScriptValue callFunction(QScriptEngine *engine, const QString &function, const QScriptValueList &args, bool event = true)
+{
+	if (event)
+	{
+		// recurse into variants, if any (copied, since the script may call namespace or include, which clears the cache)
+		QVector<EVENT_HANDLER> const handlers = eventHandlers(engine, function);
+		for (int i = 0; i < handlers.size() - 1; ++i)
+		{
+			const QScriptValue &value = engine->globalObject().property(handlers[i].handle);
+			if (value.isValid() && value.isFunction())
+			{
+				callFunction(engine, handlers[i].name, args, event);
+			}
+		}
+		const QScriptValue &value = engine->globalObject().property(handlers.back().handle);
+		if (!value.isValid() || !value.isFunction())
+		{
+			// not necessarily an error, may just be a trigger that is not defined (ie not needed)
+			scriptMessage(engine, LOG_SCRIPT, false, "called function (%s) not defined", function.toUtf8().constData());
+			return false;
+		}
+		return callResolvedFunction(engine, function, value, args);
+	}
+	QScriptValue value = engine->globalObject().property(function);
+	if (!value.isValid() || !value.isFunction())
+	{
+		// could be a typo in the function name or ...
+		debug(LOG_ERROR, "called function (%s) not defined", function.toUtf8().constData());
+		return false;
+	}
+	return callResolvedFunction(engine, function, value, args);
+}
+
+void setConcurrentScripts(bool enabled)
+{
+	concurrentScripts = enabled;
+}
+
+bool getConcurrentScripts()
+{
+	return concurrentScripts;
+}
+
+/// API functions which change the game state or the state of the scripts. While AI scripts run concurrently, calls to
+/// these are only made once all the scripts have finished. The script gets what deferredCallResult works out from the
+/// game state at the time of the call, or undefined.
+static const char *deferredFunctions[] =
+{
+	"setTimer", "queue", "removeTimer",
+	"addLabel", "removeLabel", "resetLabel", "resetArea", "addSpotter", "removeSpotter", "syncRequest",
+	"setAlliance", "sendAllianceRequest", "setAssemblyPoint", "setSunPosition", "setSunIntensity", "setWeather", "setSky",
+	"cameraSlide", "cameraTrack", "cameraZoom", "replaceTexture", "changePlayerColour", "setHealth", "useSafetyTransport",
+	"restoreLimboMissionData", "setCampaignNumber", "hackNetOff", "hackNetOn", "hackAddMessage", "hackRemoveMessage",
+	"hackChangeMe", "hackMarkTiles", "receiveAllEvents", "hackDoNotSave", "hackPlayIngameAudio", "hackStopIngameAudio",
+	"console", "clearConsole", "pursueResearch", "groupAddArea", "groupAddDroid", "groupAdd",
+	"orderDroid", "orderDroidLoc", "orderDroidBuild", "orderDroidObj", "buildDroid", "addDroid", "addDroidToTransporter",
+	"addFeature", "activateStructure", "chat", "addBeacon", "removeBeacon", "setDroidLimit", "setCommanderLimit",
+	"setConstructorLimit", "setExperienceModifier", "centreView", "playSound", "gameOverMessage", "setStructureLimits",
+	"applyLimitSet", "setMissionTime", "setReinforcementTime", "completeResearch", "enableResearch", "setPower",
+	"setPowerModifier", "setPowerStorageMaximum", "extraPowerTime", "setTutorialMode", "setDesign", "enableTemplate",
+	"removeTemplate", "setMiniMap", "setReticuleButton", "setReticuleFlash", "showReticuleWidget", "showInterface",
+	"hideInterface", "addReticuleButton", "removeReticuleButton", "enableStructure", "makeComponentAvailable",
+	"enableComponent", "removeStruct", "removeObject", "setScrollParams", "setScrollLimits", "addStructure", "loadLevel",
+	"setDroidExperience", "donateObject", "donatePower", "setNoGoArea", "startTransporterEntry", "setTransporterExit",
+	"setObjectFlag", "fireWeaponAtLoc", "fireWeaponAtObj"
+};
+
+static QScriptValueList contextArguments(QScriptContext *context)
+{
+	QScriptValueList args;
+	for (int i = 0; i < context->argumentCount(); ++i)
+	{
+		args += context->argument(i);
+	}
+	return args;
+}
+
+/// Calls the wrapped API function, while no other script is using the game state.
+static QScriptValue js_lockedCall(QScriptContext *context, QScriptEngine *)
+{
+	ScriptStateLock lock;
+	return context->callee().data().call(context->thisObject(), contextArguments(context));
+}
+
+/// Calls the wrapped API function, or remembers the call for later if the script is running concurrently.
+static QScriptValue js_deferredCall(QScriptContext *context, QScriptEngine *engine)
+{
+	QScriptValue data = context->callee().data();
+	QScriptValueList args = contextArguments(context);
+	CONCURRENT_RUN *run = concurrentRuns.value(engine);
+	if (run == nullptr)
+	{
+		return data.property("function").call(context->thisObject(), args);
+	}
+	QScriptValue result;
+	QScriptValue resultFunction = data.property("result");
+	if (resultFunction.isFunction())
+	{
+		ScriptStateLock lock;
+		result = resultFunction.call(context->thisObject(), args);
+		if (engine->hasUncaughtException())
+		{
+			return result;  // The call would fail the same way, so pass on the exception now instead.
+		}
+	}
+	run->deferred.push_back({data.property("function"), context->thisObject(), args});
+	return result;
+}
+
+/// Replaces the API functions of a script by wrappers which make them safe to call while AI scripts run concurrently.
+static void wrapConcurrentFunctions(QScriptEngine *engine)
+{
+	QSet<QString> deferred;
+	for (const char *name : deferredFunctions)
+	{
+		deferred.insert(name);
+	}
+	QScriptValueIterator it(engine->globalObject());
+	while (it.hasNext())
+	{
+		it.next();
+		// Leave the built in objects of the engine alone, and profile, which only calls a script function.
+		if (!it.value().isFunction() || (it.flags() & QScriptValue::SkipInEnumeration) || it.name() == "profile")
+		{
+			continue;
+		}
+		if (!deferred.contains(it.name()))
+		{
+			QScriptValue wrapper = engine->newFunction(js_lockedCall);
+			wrapper.setData(it.value());
+			it.setValue(wrapper);
+			continue;
+		}
+		QScriptValue data = engine->newObject();
+		data.setProperty("function", it.value());
+		QScriptEngine::FunctionSignature result = deferredCallResult(it.name());
+		if (result != nullptr)
+		{
+			data.setProperty("result", engine->newFunction(result));
+		}
+		QScriptValue wrapper = engine->newFunction(js_deferredCall);
+		wrapper.setData(data);
+		it.setValue(wrapper);
+	}
+}
+
+/// Math.random for autogames, a number in [0, 1) from the script's own sequence.
+static QScriptValue js_autogameRandom(QScriptContext *, QScriptEngine *engine)
+{
+	return QScriptValue(autogameRandom.at(engine).u32() / 4294967296.0);
+}
+
+static QScriptValueList timerArguments(const timerNode &node)
+{
+	QScriptValueList args;
+	if (node.baseobj > 0)
+	{
+		args += convMax(IdToObject(node.baseobjtype, node.baseobj, node.player), node.engine);
+	}
+	else if (!node.stringarg.isEmpty())
+	{
+		args += node.stringarg;
+	}
+	return args;
+}
+
+static void runConcurrentTimerCalls(CONCURRENT_RUN *run)
+{
+	for (const auto &call : run->calls)
+	{
+		callFunction(run->engine, call.first, call.second, true);
+	}
+}
+
+/// Runs the timers of the AI scripts, with a thread for each script. All scripts see the game state as it was before
+/// any of them ran, and the changes they ask for are made afterwards, a script at a time in player order, so that the
+/// outcome does not depend on which thread happened to finish first.
+static void runConcurrentTimers(const std::vector<timerNode> &runlist)
+{
+	if (scriptStateMutex == nullptr)
+	{
+		scriptStateMutex = wzMutexCreate();
+	}
+	std::vector<CONCURRENT_RUN> runs;
+	for (auto *engine : scripts)
+	{
+		if (concurrentEngines.contains(engine))
+		{
+			runs.push_back({engine, engineDispatch(engine).player, {}, {}, {}, nullptr, 0});
+		}
+	}
+	std::stable_sort(runs.begin(), runs.end(), [](const CONCURRENT_RUN &a, const CONCURRENT_RUN &b) { return a.player < b.player; });
+	QHash<QScriptEngine *, CONCURRENT_RUN *> runForEngine;
+	for (auto &run : runs)
+	{
+		runForEngine.insert(run.engine, &run);
+	}
+	for (const auto &node : runlist)
+	{
+		CONCURRENT_RUN *run = runForEngine.value(node.engine);
+		ASSERT_OR_RETURN(, run != nullptr, "Timer %s of an unknown script", node.function.toUtf8().constData());
+		run->calls.push_back(std::make_pair(node.function, timerArguments(node)));
+		prepareEventHandlers(node.engine, node.function);
+	}
+
+	// Run one of the scripts on this thread, instead of waiting idly for the others.
+	concurrentRuns = runForEngine;
+	std::vector<wz::thread> threads;
+	CONCURRENT_RUN *local = nullptr;
+	for (auto &run : runs)
+	{
+		if (run.calls.empty())
+		{
+			continue;
+		}
+		if (local == nullptr)
+		{
+			local = &run;
+			continue;
+		}
+		threads.emplace_back(runConcurrentTimerCalls, &run);
+	}
+	if (local != nullptr)
+	{
+		runConcurrentTimerCalls(local);
+	}
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+	concurrentRuns.clear();
+
+	int newGroups = 0;
+	for (auto &run : runs)
+	{
+		for (const auto &message : run.messages)
+		{
+			reportScriptMessage(message);
+		}
+		newGroups = std::max(newGroups, run.newGroups);
+	}
+	nextGroup += newGroups;
+	for (auto &run : runs)
+	{
+		for (const auto &call : run.deferred)
+		{
+			QScriptValue result = call.function.call(call.thisObject, call.args);
+			if (run.engine->hasUncaughtException())
+			{
+				debug(LOG_ERROR, "Uncaught exception in a delayed call from player %d: %s", run.player, result.toString().toUtf8().constData());
+				run.engine->clearExceptions();
+			}
+		}
+	}
+}
+
 //-- ## setTimer(function, milliseconds[, object])
 //--
 //-- Set a function to run repeated at some given time interval. The function to run
@@ -268,6 +722,19 @@ static QScriptValue callFunction(QScriptEngine *engine, const QString &function,
 //-- parameter can be a **game object** to pass to the timer function. If the **game object**
 //-- dies, the timer stops running. The minimum number of milliseconds is 100, but such
 //-- fast timers are strongly discouraged as they may deteriorate the game performance.
+//-- To spread the work of timers with the same interval over time, the first call may
+//-- be delayed by up to one more interval.
+//--
+//-- If the game runs AI scripts concurrently (the "concurrentScripts" option), the timers of AI scripts
+//-- all see the game as it was before any of them ran in that game tick. Functions which change the game,
+//-- such as orders, production and research, take effect once all the timers have finished, in player order.
+//-- They return what they would have returned at the time of the call, so ```buildDroid``` and
+//-- ```pursueResearch``` return false if the factory or lab could not start, except that ```addDroid```,
+//-- ```addStructure```, ```addFeature``` and ```addSpotter``` return undefined. ```syncRandom``` draws from
+//-- numbers of the script's own, and ```newGroup``` numbers groups from the same start for every script.
+//-- Calls with invalid arguments still throw at once. The option is experimental: each script engine
+//-- is then also run from worker threads, one thread at a time, and all other API functions wait for each
+//-- other. tests/concurrentscripts.sh compares games played with and without it.
 //--
 //-- ```javascript
 //--   function conDroids()
@@ -302,7 +769,8 @@ static QScriptValue js_setTimer(QScriptContext *context, QScriptEngine *engine)
 		}
 	}
 	node.type = TIMER_REPEAT;
-	timers.push_back(node);
+	node.frameTime += timerPhase(engine, node.ms);
+	scheduleTimer(node);
 	return QScriptValue();
 }
 
@@ -316,17 +784,14 @@ static QScriptValue js_removeTimer(QScriptContext *context, QScriptEngine *engin
 	SCRIPT_ASSERT(context, context->argument(0).isString(), "Timer functions must be quoted");
 	QString function = context->argument(0).toString();
 	int player = engine->globalObject().property("me").toInt32();
-	int i, size = timers.size();
-	for (i = 0; i < size; ++i)
+	auto i = std::find_if(timers.begin(), timers.end(), [&](const std::pair<const TIMER_KEY, timerNode> &t) {
+		return t.second.function == function && t.second.player == player;
+	});
+	if (i != timers.end())
 	{
-		timerNode node = timers.at(i);
-		if (node.function == function && node.player == player)
-		{
-			timers.removeAt(i);
-			break;
-		}
+		timers.erase(i);
 	}
-	if (i == size)
+	else
 	{
 		// Friendly warning
 		QString warnName = function.left(15) + "...";
@@ -376,7 +841,7 @@ static QScriptValue js_queue(QScriptContext *context, QScriptEngine *engine)
 		}
 	}
 	node.type = TIMER_ONESHOT_READY;
-	timers.push_back(node);
+	scheduleTimer(node);
 	return QScriptValue();
 }
 
@@ -401,16 +866,15 @@ static QScriptValue js_profile(QScriptContext *context, QScriptEngine *engine)
 void scriptRemoveObject(BASE_OBJECT *psObj)
 {
 	// Weed out timers with dead objects
-	for (int i = 0; i < timers.count();)
+	for (auto i = timers.begin(); i != timers.end();)
 	{
-		const timerNode node = timers.at(i);
-		if (node.baseobj == psObj->id)
+		if (i->second.baseobj == (int)psObj->id)
 		{
-			timers.removeAt(i);
+			i = timers.erase(i);
 		}
 		else
 		{
-			i++;
+			++i;
 		}
 	}
 	groupRemoveObject(psObj);
@@ -426,6 +890,7 @@ static QScriptValue js_namespace(QScriptContext *context, QScriptEngine *engine)
 {
 	QString prefix(context->argument(0).toString());
 	eventNamespaces[engine].append(prefix);
+	scriptDispatchChanged(engine);
 	return QScriptValue(true);
 }
 
@@ -467,6 +932,7 @@ static QScriptValue js_include(QScriptContext *context, QScriptEngine *engine)
 	context->setActivationObject(engine->globalObject());
 	context->setThisObject(engine->globalObject());
 	QScriptValue result = engine->evaluate(source, path);
+	scriptDispatchChanged(engine);
 	if (engine->hasUncaughtException())
 	{
 		int line = engine->uncaughtExceptionLineNumber();
@@ -530,8 +996,18 @@ bool shutdownScripts()
 		unregisterFunctions(engine);
 	}
 	timers.clear();
+	timerSequence = 0;
+	if (scriptStateMutex != nullptr)
+	{
+		wzMutexDestroy(scriptStateMutex);
+		scriptStateMutex = nullptr;
+	}
+	globalScripts.clear();
+	concurrentEngines.clear();
+	autogameRandom.clear();
 	internalNamespace.clear();
 	monitors.clear();
+	dispatchTables.clear();
 	while (!scripts.isEmpty())
 	{
 		delete scripts.takeFirst();
@@ -558,48 +1034,48 @@ bool updateScripts()
 	{
 		engine->globalObject().setProperty("gameTime", gameTime, QScriptValue::ReadOnly | QScriptValue::Undeletable);
 	}
-	// Weed out dead timers
-	for (int i = 0; i < timers.count();)
+	// Check for timers, and run them if applicable, earliest first. Scripts with more than TIMER_CALLS_PER_TICK
+	// timers due get the rest in the next tick, ahead of the timers which only become due then.
+	std::vector<timerNode> runlist; // make a new list here, since we might trample all over the timers during execution
+	std::vector<timerNode> repeats;
+	QHash<QScriptEngine *, int> engineCalls;
+	for (auto i = timers.begin(); i != timers.end() && i->first.first <= (int)gameTime;)
 	{
-		const timerNode node = timers.at(i);
-		if (node.type == TIMER_ONESHOT_DONE)
+		int &calls = engineCalls[i->second.engine];
+		if (calls >= TIMER_CALLS_PER_TICK)
 		{
-			timers.removeAt(i);
+			++i;
+			continue;
 		}
-		else
+		++calls;
+		timerNode node = i->second;
+		i = timers.erase(i);
+		node.calls++;
+		if (node.type == TIMER_REPEAT)
 		{
-			i++;
+			node.frameTime = node.ms + gameTime;	// update for next invokation
+			repeats.push_back(node);
 		}
+		runlist.push_back(node);
 	}
-	// Check for timers, and run them if applicable.
-	// TODO - load balancing
-	QList<timerNode> runlist; // make a new list here, since we might trample all over the timer list during execution
-	QList<timerNode>::iterator iter;
-	for (iter = timers.begin(); iter != timers.end(); iter++)
+	for (const auto &node : repeats)
 	{
-		if (iter->frameTime <= gameTime)
-		{
-			iter->frameTime = iter->ms + gameTime;	// update for next invokation
-			if (iter->type == TIMER_ONESHOT_READY)
-			{
-				iter->type = TIMER_ONESHOT_DONE; // unless there is none
-			}
-			iter->calls++;
-			runlist.append(*iter);
-		}
+		scheduleTimer(node);
 	}
-	for (iter = runlist.begin(); iter != runlist.end(); iter++)
+	// With concurrent scripts, global scripts still run their timers first and on their own, since they run on every client.
+	std::vector<timerNode> concurrentList;
+	for (auto iter = runlist.begin(); iter != runlist.end(); iter++)
 	{
-		QScriptValueList args;
-		if (iter->baseobj > 0)
-		{
-			args += convMax(IdToObject(iter->baseobjtype, iter->baseobj, iter->player), iter->engine);
-		}
-		else if (!iter->stringarg.isEmpty())
+		if (concurrentEngines.contains(iter->engine))
 		{
-			args += iter->stringarg;
+			concurrentList.push_back(*iter);
+			continue;
 		}
-		callFunction(iter->engine, iter->function, args, true);
+		callFunction(iter->engine, iter->function, timerArguments(*iter), true);
+	}
+	if (!concurrentList.empty())
+	{
+		runConcurrentTimers(concurrentList);
 	}
 
 	if (globalDialog && doUpdateModels)
@@ -700,6 +1176,15 @@ QScriptEngine *loadPlayerScript(const WzString& path, int player, int difficulty
 	// Regular functions
 	QFileInfo basename(QString::fromUtf8(path.toUtf8().c_str()));
 	registerFunctions(engine, basename.baseName());
+	if (autogame_enabled())
+	{
+		autogameRandom.emplace(engine, MersenneTwister(gameRandSeed() ^ (player << 8) ^ scripts.size()));
+		engine->globalObject().property("Math").setProperty("random", engine->newFunction(js_autogameRandom));
+	}
+	if (concurrentScripts)
+	{
+		wrapConcurrentFunctions(engine);
+	}
 
 	// Remember internal, reserved names
 	QScriptValueIterator it(engine->globalObject());
@@ -727,9 +1212,14 @@ QScriptEngine *loadPlayerScript(const WzString& path, int player, int difficulty
 
 	// Register script
 	scripts.push_back(engine);
+	if (concurrentScripts)
+	{
+		concurrentEngines.insert(engine);
+	}
 
 	MONITOR *monitor = new MONITOR;
 	monitors.insert(engine, monitor);
+	scriptDispatchChanged(engine);
 
 	debug(LOG_SAVE, "Created script engine %d for player %d from %s", scripts.size() - 1, player, path.toUtf8().c_str());
 	return engine;
@@ -737,7 +1227,13 @@ QScriptEngine *loadPlayerScript(const WzString& path, int player, int difficulty
 
 bool loadGlobalScript(WzString path)
 {
-	return loadPlayerScript(std::move(path), selectedPlayer, 0);
+	QScriptEngine *engine = loadPlayerScript(std::move(path), selectedPlayer, 0);
+	if (engine != nullptr)
+	{
+		globalScripts.insert(engine);
+		concurrentEngines.remove(engine);
+	}
+	return engine != nullptr;
 }
 
 bool saveScriptStates(const char *filename)
@@ -766,10 +1262,11 @@ bool saveScriptStates(const char *filename)
 		saveGroups(ini, engine);
 		ini.endGroup();
 	}
-	for (int i = 0; i < timers.size(); ++i)
+	int i = 0;
+	for (const auto &timer : timers)
 	{
-		timerNode node = timers.at(i);
-		ini.beginGroup("triggers_" + WzString::number(i));
+		const timerNode &node = timer.second;
+		ini.beginGroup("triggers_" + WzString::number(i++));
 		// we have to save 'scriptName' and 'me' explicitly
 		ini.setValue("me", node.player);
 		ini.setValue("scriptName", QStringToWzString(node.engine->globalObject().property("scriptName").toString()));
@@ -825,7 +1322,10 @@ bool loadScriptStates(const char *filename)
 			node.function = QString::fromUtf8(ini.value("function").toWzString().toUtf8().c_str());
 			node.baseobj = ini.value("baseobj", -1).toInt();
 			node.type = (timerType)ini.value("type", TIMER_REPEAT).toInt();
-			timers.push_back(node);
+			if (node.type != TIMER_ONESHOT_DONE)  // Older savegames kept finished one-shot timers until the next tick.
+			{
+				scheduleTimer(node);
+			}
 		}
 		else if (engine && list[i].startsWith("globals_"))
 		{
@@ -839,6 +1339,7 @@ bool loadScriptStates(const char *filename)
 				//			  (mapJsonToQScriptValue handles this properly.)
 				engine->globalObject().setProperty(QString::fromUtf8(keys.at(j).toUtf8().c_str()), mapJsonToQScriptValue(engine, ini.json(keys.at(j)), 0));
 			}
+			scriptDispatchChanged(engine);  // 'me' may have been restored
 		}
 		else if (engine && list[i].startsWith("groups_"))
 		{
@@ -914,8 +1415,9 @@ static void updateGlobalModels()
 	}
 	QStandardItemModel *m = triggerModel;
 	m->setRowCount(0);
-	for (const auto &node : timers)
+	for (const auto &timer : timers)
 	{
+		const timerNode &node = timer.second;
 		int nextRow = m->rowCount();
 		m->setRowCount(nextRow);
 		m->setItem(nextRow, 0, new QStandardItem(node.function));
@@ -1130,8 +1632,8 @@ bool triggerEvent(SCRIPT_TRIGGER_TYPE trigger, BASE_OBJECT *psObj)
 
 		if (psObj)
 		{
-			int player = engine->globalObject().property("me").toInt32();
-			bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+			int player = engineDispatch(engine).player;
+			bool receiveAll = engineDispatch(engine).receiveAll;
 			if (player != psObj->player && !receiveAll)
 			{
 				continue;
@@ -1283,7 +1785,7 @@ bool triggerEventDroidIdle(DROID *psDroid)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
+		int player = engineDispatch(engine).player;
 		if (player == psDroid->player)
 		{
 			QScriptValueList args;
@@ -1305,8 +1807,8 @@ bool triggerEventDroidBuilt(DROID *psDroid, STRUCTURE *psFactory)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int player = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (player == psDroid->player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1332,8 +1834,8 @@ bool triggerEventStructBuilt(STRUCTURE *psStruct, DROID *psDroid)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int player = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (player == psStruct->player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1358,8 +1860,8 @@ bool triggerEventStructDemolish(STRUCTURE *psStruct, DROID *psDroid)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int player = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (player == psStruct->player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1385,8 +1887,8 @@ bool triggerEventStructureReady(STRUCTURE *psStruct)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int player = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (player == psStruct->player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1418,8 +1920,8 @@ bool triggerEventAttacked(BASE_OBJECT *psVictim, BASE_OBJECT *psAttacker, int la
 	}
 	for (auto *engine : scripts)
 	{
-		int player = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int player = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (player == psVictim->player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1449,8 +1951,8 @@ bool triggerEventResearched(RESEARCH *psResearch, STRUCTURE *psStruct, int playe
 	}
 	for (auto *engine : scripts)
 	{
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (me == player || receiveAll)
 		{
 			QScriptValueList args;
@@ -1560,8 +2062,8 @@ bool triggerEventObjectTransfer(BASE_OBJECT *psObj, int from)
 	for (int i = 0; i < scripts.size() && psObj; ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (me == psObj->player || me == from || receiveAll)
 		{
 			QScriptValueList args;
@@ -1584,8 +2086,8 @@ bool triggerEventChat(int from, int to, const char *message)
 	for (int i = 0; scriptsReady && message && i < scripts.size(); ++i)
 	{
 		QScriptEngine *engine = scripts.at(i);
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (me == to || (receiveAll && to == from))
 		{
 			QScriptValueList args;
@@ -1608,8 +2110,8 @@ bool triggerEventBeacon(int from, int to, const char *message, int x, int y)
 {
 	for (auto *engine : scripts)
 	{
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (me == to || receiveAll)
 		{
 			QScriptValueList args;
@@ -1637,8 +2139,8 @@ bool triggerEventBeaconRemoved(int from, int to)
 	ASSERT(scriptsReady, "Scripts not initialized yet");
 	for (auto *engine : scripts)
 	{
-		int me = engine->globalObject().property("me").toInt32();
-		bool receiveAll = engine->globalObject().property("isReceivingAllEvents").toBool();
+		int me = engineDispatch(engine).player;
+		bool receiveAll = engineDispatch(engine).receiveAll;
 		if (me == to || receiveAll)
 		{
 			QScriptValueList args;
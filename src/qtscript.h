@@ -78,6 +78,10 @@ bool prepareScripts(bool loadGame);
 /// Run this each logical frame to update frame-dependent script states
 bool updateScripts();
 
+/// Whether the timers of AI scripts run concurrently, one thread per script. Only affects scripts loaded afterwards.
+void setConcurrentScripts(bool enabled);
+bool getConcurrentScripts();
+
 // Load and evaluate the given script, kept in memory
 bool loadGlobalScript(WzString path);
 QScriptEngine *loadPlayerScript(const WzString& path, int player, int difficulty);
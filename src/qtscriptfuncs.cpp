@@ -29,6 +29,11 @@
 
 // **NOTE: Qt headers _must_ be before platform specific headers so we don't get conflicts.
 #include <QtScript/QScriptValue>
+#include <QtScript/QScriptClass>
+#include <QtScript/QScriptClassPropertyIterator>
+#include <QtScript/QScriptString>
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QStringList>
 #include <QtCore/QJsonArray>
 #include <QtGui/QStandardItemModel>
@@ -43,6 +48,7 @@
 #include "lib/sound/audio.h"
 #include "lib/sound/cdaudio.h"
 #include "lib/netplay/netplay.h"
+#include "lib/netplay/netreplay.h"
 #include "qtscriptfuncs.h"
 #include "lib/ivis_opengl/tex.h"
 
@@ -70,7 +76,6 @@
 #include "template.h"
 #include "lighting.h"
 #include "radar.h"
-#include "random.h"
 #include "frontend.h"
 #include "loop.h"
 #include "scriptextern.h"
@@ -83,6 +88,7 @@
 #include "component.h"
 #include "seqdisp.h"
 #include "ai.h"
+#include "objmem.h"
 
 #define FAKE_REF_LASSAT 999
 #define ALL_PLAYERS -1
@@ -497,101 +503,747 @@ QScriptValue convResearch(RESEARCH *psResearch, QScriptEngine *engine, int playe
 	return value;
 }
 
-//;; ## Structure
-//;;
-//;; Describes a structure (building). It inherits all the properties of the base object (see below).
-//;; In addition, the following properties are defined:
-//;;
-//;; * ```status``` The completeness status of the structure. It will be one of ```BEING_BUILT``` and ```BUILT```.
-//;; * ```type``` The type will always be ```STRUCTURE```.
-//;; * ```cost``` What it would cost to build this structure. (3.2+ only)
-//;; * ```stattype``` The stattype defines the type of structure. It will be one of ```HQ```, ```FACTORY```, ```POWER_GEN```,
-//;; ```RESOURCE_EXTRACTOR```, ```LASSAT```, ```DEFENSE```, ```WALL```, ```RESEARCH_LAB```, ```REPAIR_FACILITY```,
-//;; ```CYBORG_FACTORY```, ```VTOL_FACTORY```, ```REARM_PAD```, ```SAT_UPLINK```, ```GATE``` and ```COMMAND_CONTROL```.
-//;; * ```modules``` If the stattype is set to one of the factories, ```POWER_GEN``` or ```RESEARCH_LAB```, then this property is set to the
-//;; number of module upgrades it has.
-//;; * ```canHitAir``` True if the structure has anti-air capabilities. (3.2+ only)
-//;; * ```canHitGround``` True if the structure has anti-ground capabilities. (3.2+ only)
-//;; * ```isSensor``` True if the structure has sensor ability. (3.2+ only)
-//;; * ```isCB``` True if the structure has counter-battery ability. (3.2+ only)
-//;; * ```isRadarDetector``` True if the structure has radar detector ability. (3.2+ only)
-//;; * ```range``` Maximum range of its weapons. (3.2+ only)
-//;; * ```hasIndirect``` One or more of the structure's weapons are indirect. (3.2+ only)
-//;;
-QScriptValue convStructure(STRUCTURE *psStruct, QScriptEngine *engine)
+// ----------------------------------------------------------------------------------------
+// Game object proxies
+//
+// Droids, structures and features are given to scripts as proxies, which only compute a property
+// when it is read, since most scripts enumerate many objects but look at few properties of each.
+// A property is read from the live object the first time it is asked for and kept from then on,
+// so a proxy still behaves like a snapshot. Proxies made during the same game tick share their
+// values. Objects which can not be found by id, such as objects being destroyed or droids inside
+// a transporter, are converted to ordinary objects instead.
+//
+
+enum OBJ_PROPERTY
+{
+	OBJ_PROP_ID,
+	OBJ_PROP_X,
+	OBJ_PROP_Y,
+	OBJ_PROP_Z,
+	OBJ_PROP_PLAYER,
+	OBJ_PROP_ARMOUR,
+	OBJ_PROP_THERMAL,
+	OBJ_PROP_TYPE,
+	OBJ_PROP_SELECTED,
+	OBJ_PROP_NAME,
+	OBJ_PROP_BORN,
+	OBJ_PROP_GROUP,
+	OBJ_PROP_HEALTH,
+	OBJ_PROP_ACTION,
+	OBJ_PROP_ORDER,
+	OBJ_PROP_RANGE,
+	OBJ_PROP_COST,
+	OBJ_PROP_HAS_INDIRECT,
+	OBJ_PROP_BODY_SIZE,
+	OBJ_PROP_CARGO_CAPACITY,
+	OBJ_PROP_CARGO_LEFT,
+	OBJ_PROP_CARGO_COUNT,
+	OBJ_PROP_IS_RADAR_DETECTOR,
+	OBJ_PROP_IS_CB,
+	OBJ_PROP_IS_SENSOR,
+	OBJ_PROP_CAN_HIT_AIR,
+	OBJ_PROP_CAN_HIT_GROUND,
+	OBJ_PROP_IS_VTOL,
+	OBJ_PROP_DROID_TYPE,
+	OBJ_PROP_EXPERIENCE,
+	OBJ_PROP_BODY,
+	OBJ_PROP_PROPULSION,
+	OBJ_PROP_ARMED,
+	OBJ_PROP_WEAPONS,
+	OBJ_PROP_CARGO_SIZE,
+	OBJ_PROP_STATUS,
+	OBJ_PROP_STATTYPE,
+	OBJ_PROP_MODULES,
+	OBJ_PROP_DAMAGEABLE,
+	OBJ_PROP_COUNT
+};
+
+static const char *objPropertyNames[OBJ_PROP_COUNT] =
+{
+	"id", "x", "y", "z", "player", "armour", "thermal", "type", "selected", "name", "born", "group", "health",
+	"action", "order", "range", "cost", "hasIndirect", "bodySize", "cargoCapacity", "cargoLeft", "cargoCount",
+	"isRadarDetector", "isCB", "isSensor", "canHitAir", "canHitGround", "isVTOL", "droidType", "experience",
+	"body", "propulsion", "armed", "weapons", "cargoSize", "status", "stattype", "modules", "damageable"
+};
+
+#define OBJ_BASE_PROPERTIES OBJ_PROP_ID, OBJ_PROP_X, OBJ_PROP_Y, OBJ_PROP_Z, OBJ_PROP_PLAYER, OBJ_PROP_ARMOUR, \
+	OBJ_PROP_THERMAL, OBJ_PROP_TYPE, OBJ_PROP_SELECTED, OBJ_PROP_NAME, OBJ_PROP_BORN, OBJ_PROP_GROUP
+
+// The properties of each type of object, in the order scripts see them when enumerating.
+static const std::vector<OBJ_PROPERTY> objBaseProperties = {OBJ_BASE_PROPERTIES};
+static const std::vector<OBJ_PROPERTY> droidProperties =
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	for (int i = 0; i < psStruct->numWeaps; i++)
+	OBJ_BASE_PROPERTIES, OBJ_PROP_ACTION, OBJ_PROP_RANGE, OBJ_PROP_ORDER, OBJ_PROP_COST, OBJ_PROP_HAS_INDIRECT,
+	OBJ_PROP_BODY_SIZE, OBJ_PROP_CARGO_CAPACITY, OBJ_PROP_CARGO_LEFT, OBJ_PROP_CARGO_COUNT, OBJ_PROP_IS_RADAR_DETECTOR,
+	OBJ_PROP_IS_CB, OBJ_PROP_IS_SENSOR, OBJ_PROP_CAN_HIT_AIR, OBJ_PROP_CAN_HIT_GROUND, OBJ_PROP_IS_VTOL,
+	OBJ_PROP_DROID_TYPE, OBJ_PROP_EXPERIENCE, OBJ_PROP_HEALTH, OBJ_PROP_BODY, OBJ_PROP_PROPULSION, OBJ_PROP_ARMED,
+	OBJ_PROP_WEAPONS, OBJ_PROP_CARGO_SIZE
+};
+static const std::vector<OBJ_PROPERTY> structureProperties =
+{
+	OBJ_BASE_PROPERTIES, OBJ_PROP_IS_CB, OBJ_PROP_IS_SENSOR, OBJ_PROP_CAN_HIT_AIR, OBJ_PROP_CAN_HIT_GROUND,
+	OBJ_PROP_HAS_INDIRECT, OBJ_PROP_IS_RADAR_DETECTOR, OBJ_PROP_RANGE, OBJ_PROP_STATUS, OBJ_PROP_HEALTH, OBJ_PROP_COST,
+	OBJ_PROP_STATTYPE, OBJ_PROP_MODULES, OBJ_PROP_WEAPONS
+};
+static const std::vector<OBJ_PROPERTY> featureProperties =
+{
+	OBJ_BASE_PROPERTIES, OBJ_PROP_HEALTH, OBJ_PROP_DAMAGEABLE, OBJ_PROP_STATTYPE
+};
+
+#undef OBJ_BASE_PROPERTIES
+
+static const std::vector<OBJ_PROPERTY> &objPropertyList(OBJECT_TYPE type)
+{
+	switch (type)
 	{
-		if (psStruct->asWeaps[i].nStat)
+	case OBJ_DROID: return droidProperties;
+	case OBJ_STRUCTURE: return structureProperties;
+	case OBJ_FEATURE: return featureProperties;
+	default: return objBaseProperties;
+	}
+}
+
+static bool objPropertyIsCargo(OBJ_PROPERTY property)
+{
+	return property == OBJ_PROP_CARGO_CAPACITY || property == OBJ_PROP_CARGO_LEFT || property == OBJ_PROP_CARGO_COUNT;
+}
+
+static void objWeaponSummary(const BASE_OBJECT *psObj, bool &aa, bool &ga, bool &indirect, int &range)
+{
+	aa = false;
+	ga = false;
+	indirect = false;
+	range = -1;
+	for (unsigned i = 0; i < psObj->numWeaps; i++)
+	{
+		if (psObj->asWeaps[i].nStat)
 		{
-			WEAPON_STATS *psWeap = &asWeaponStats[psStruct->asWeaps[i].nStat];
+			WEAPON_STATS *psWeap = &asWeaponStats[psObj->asWeaps[i].nStat];
 			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
 			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
 			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(psWeap, psStruct->player), range);
-		}
-	}
-	QScriptValue value = convObj(psStruct, engine);
-	value.setProperty("isCB", structCBSensor(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("isSensor", structStandardSensor(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("canHitAir", aa, QScriptValue::ReadOnly);
-	value.setProperty("canHitGround", ga, QScriptValue::ReadOnly);
-	value.setProperty("hasIndirect", indirect, QScriptValue::ReadOnly);
-	value.setProperty("isRadarDetector", objRadarDetector(psStruct), QScriptValue::ReadOnly);
-	value.setProperty("range", range, QScriptValue::ReadOnly);
-	value.setProperty("status", (int)psStruct->status, QScriptValue::ReadOnly);
-	value.setProperty("health", 100 * psStruct->body / MAX(1, structureBody(psStruct)), QScriptValue::ReadOnly);
-	value.setProperty("cost", psStruct->pStructureType->powerToBuild, QScriptValue::ReadOnly);
+			range = MAX(proj_GetLongRange(psWeap, psObj->player), range);
+		}
+	}
+}
+
+static int structureStatType(const STRUCTURE *psStruct)
+{
 	switch (psStruct->pStructureType->type) // don't bleed our source insanities into the scripting world
 	{
 	case REF_WALL:
 	case REF_WALLCORNER:
 	case REF_GATE:
-		value.setProperty("stattype", (int)REF_WALL, QScriptValue::ReadOnly);
-		break;
+		return REF_WALL;
 	case REF_GENERIC:
 	case REF_DEFENSE:
-		if (isLasSat(psStruct->pStructureType))
+		return isLasSat(psStruct->pStructureType) ? FAKE_REF_LASSAT : REF_DEFENSE;
+	default:
+		return psStruct->pStructureType->type;
+	}
+}
+
+static int droidScriptType(const DROID *psDroid)
+{
+	switch (psDroid->droidType) // hide some engine craziness
+	{
+	case DROID_CYBORG_CONSTRUCT: return DROID_CONSTRUCT;
+	case DROID_CYBORG_SUPER: return DROID_CYBORG;
+	case DROID_DEFAULT: return DROID_WEAPON;
+	case DROID_CYBORG_REPAIR: return DROID_REPAIR;
+	default: return psDroid->droidType;
+	}
+}
+
+/// A weapon of an object, as it was when the object was converted.
+struct OBJ_WEAPON_SNAPSHOT
+{
+	unsigned nStat;
+	uint32_t lastFired;
+};
+
+/// Fields of OBJ_SNAPSHOT which are only worked out when a property needing them is first read.
+enum OBJ_DERIVED
+{
+	OBJ_DERIVED_NAME = 0x01,        ///< name
+	OBJ_DERIVED_ARMOUR = 0x02,      ///< armour, thermal
+	OBJ_DERIVED_WEAPONS = 0x04,     ///< canHitAir, canHitGround, hasIndirect, range
+	OBJ_DERIVED_SENSORS = 0x08,     ///< isRadarDetector, isCB, isSensor
+	OBJ_DERIVED_COST = 0x10,        ///< cost, for droids
+	OBJ_DERIVED_CARGO_SIZE = 0x20,  ///< cargoSize
+	OBJ_DERIVED_RELOAD = 0x40,      ///< armed of the weapons, for droids
+};
+
+/// The properties of a droid, structure or feature for a script. The plain fields are copied when the object is
+/// converted, and reading them later, even after the object is gone, gives what reading them at conversion would have.
+/// The mutable fields cost more to work out, so they are only worked out from the object when first read, see
+/// objSnapshotObject, and then kept.
+struct OBJ_SNAPSHOT
+{
+	OBJECT_TYPE type;
+	bool isTransporter = false;
+	uint32_t id, born;
+	uint32_t gameTime;       ///< Game time of the conversion.
+	BASE_OBJECT *psObj;      ///< Only valid while gameTime has not changed.
+	int x, y, z, player;
+	bool selected;
+	bool hasGroup = false;
+	int group = 0;
+	double health = 0.0;
+	unsigned numWeaps = 0;
+	OBJ_WEAPON_SNAPSHOT weapons[MAX_WEAPONS];
+	// Droids.
+	int action = 0, order = 0, droidType = 0, bodySize = 0, cargoLeft = 0, cargoCount = 0;
+	bool isVTOL = false;
+	double experience = 0.0;
+	unsigned body = 0, propulsion = 0;  ///< Indices into asBodyStats and asPropulsionStats.
+	// Structures and features.
+	int status = 0, statType = 0, modules = -1;  ///< modules is -1 for structures without modules.
+	int structureCost = 0;
+	bool damageable = false;
+
+	mutable unsigned derived = 0;  ///< OBJ_DERIVED fields worked out so far.
+	mutable std::string name;
+	mutable int armour = 0, thermal = 0, range = -1, cost = 0, cargoSize = 0;
+	mutable bool canHitAir = false, canHitGround = false, hasIndirect = false, isRadarDetector = false, isCB = false, isSensor = false;
+	mutable int armed[MAX_WEAPONS] = {};  ///< The reload bars.
+};
+typedef QSharedPointer<const OBJ_SNAPSHOT> OBJ_SNAPSHOT_PTR;
+Q_DECLARE_METATYPE(OBJ_SNAPSHOT_PTR)
+
+/// Copies the properties of an object which are cheap to copy. The others are left for objSnapshotDerive.
+static void objSnapshot(OBJ_SNAPSHOT &snapshot, BASE_OBJECT *psObj, QScriptEngine *engine)
+{
+	snapshot.type = psObj->type;
+	snapshot.id = psObj->id;
+	snapshot.gameTime = gameTime;
+	snapshot.psObj = psObj;
+	snapshot.x = map_coord(psObj->pos.x);
+	snapshot.y = map_coord(psObj->pos.y);
+	snapshot.z = map_coord(psObj->pos.z);
+	snapshot.player = psObj->player;
+	snapshot.selected = psObj->selected;
+	snapshot.born = psObj->born;
+	GROUPMAP *psMap = groups.value(engine);
+	if (psMap != nullptr && psMap->contains(psObj))
+	{
+		snapshot.hasGroup = true;
+		snapshot.group = psMap->value(psObj);
+	}
+
+	if (psObj->type == OBJ_DROID || psObj->type == OBJ_STRUCTURE)
+	{
+		snapshot.numWeaps = psObj->numWeaps;
+		for (unsigned i = 0; i < psObj->numWeaps; ++i)
 		{
-			value.setProperty("stattype", (int)FAKE_REF_LASSAT, QScriptValue::ReadOnly);
-			break;
+			snapshot.weapons[i].nStat = psObj->asWeaps[i].nStat;
+			snapshot.weapons[i].lastFired = psObj->asWeaps[i].lastFired;
 		}
-		value.setProperty("stattype", (int)REF_DEFENSE, QScriptValue::ReadOnly);
-		break;
-	default:
-		value.setProperty("stattype", (int)psStruct->pStructureType->type, QScriptValue::ReadOnly);
-		break;
 	}
-	if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
-	    || psStruct->pStructureType->type == REF_VTOL_FACTORY
-	    || psStruct->pStructureType->type == REF_RESEARCH
-	    || psStruct->pStructureType->type == REF_POWER_GEN)
+
+	if (psObj->type == OBJ_DROID)
 	{
-		value.setProperty("modules", psStruct->capacity, QScriptValue::ReadOnly);
+		DROID *psDroid = (DROID *)psObj;
+		snapshot.isTransporter = isTransporter(psDroid);
+		snapshot.action = psDroid->action;
+		snapshot.order = psDroid->order.type;
+		snapshot.bodySize = asBodyStats[psDroid->asBits[COMP_BODY]].size;
+		if (snapshot.isTransporter)
+		{
+			snapshot.cargoLeft = calcRemainingCapacity(psDroid);
+			snapshot.cargoCount = psDroid->psGroup != nullptr ? psDroid->psGroup->getNumMembers() : 0;
+		}
+		snapshot.isVTOL = isVtolDroid(psDroid);
+		snapshot.droidType = droidScriptType(psDroid);
+		snapshot.experience = (double)psDroid->experience / 65536.0;
+		snapshot.health = 100.0 / (double)psDroid->originalBody * (double)psDroid->body;
+		snapshot.body = psDroid->asBits[COMP_BODY];
+		snapshot.propulsion = psDroid->asBits[COMP_PROPULSION];
 	}
-	else
+	else if (psObj->type == OBJ_STRUCTURE)
+	{
+		STRUCTURE *psStruct = (STRUCTURE *)psObj;
+		snapshot.status = psStruct->status;
+		snapshot.health = 100 * psStruct->body / MAX(1, structureBody(psStruct));
+		snapshot.structureCost = psStruct->pStructureType->powerToBuild;
+		snapshot.statType = structureStatType(psStruct);
+		if (psStruct->pStructureType->type == REF_FACTORY || psStruct->pStructureType->type == REF_CYBORG_FACTORY
+		    || psStruct->pStructureType->type == REF_VTOL_FACTORY
+		    || psStruct->pStructureType->type == REF_RESEARCH
+		    || psStruct->pStructureType->type == REF_POWER_GEN)
+		{
+			snapshot.modules = psStruct->capacity;
+		}
+	}
+	else if (psObj->type == OBJ_FEATURE)
 	{
-		value.setProperty("modules", QScriptValue::NullValue);
+		FEATURE *psFeature = (FEATURE *)psObj;
+		const FEATURE_STATS *psStats = psFeature->psStats;
+		snapshot.health = 100 * psStats->body / MAX(1, psFeature->body);
+		snapshot.damageable = psStats->damageable;
+		snapshot.statType = psStats->subType;
 	}
-	QScriptValue weaponlist = engine->newArray(psStruct->numWeaps);
-	for (int j = 0; j < psStruct->numWeaps; j++)
+}
+
+/// The object the derived fields of a snapshot are worked out from. Objects are only freed in a later tick than the one
+/// they die in, so during the tick of the conversion that is the converted object, even if it has died since. In later
+/// ticks, the object is looked up by id, and is gone if it has been destroyed.
+static BASE_OBJECT *objSnapshotObject(const OBJ_SNAPSHOT &snapshot)
+{
+	if (snapshot.gameTime == gameTime)
+	{
+		return snapshot.psObj;
+	}
+	BASE_OBJECT *psObj = findObjectById(snapshot.id);
+	return psObj != nullptr && psObj->type == snapshot.type ? psObj : nullptr;
+}
+
+/// Works out the given OBJ_DERIVED fields of a snapshot, unless already done. Returns false if the object is gone.
+static bool objSnapshotDerive(const OBJ_SNAPSHOT &snapshot, unsigned fields)
+{
+	fields &= ~snapshot.derived;
+	if (fields == 0)
+	{
+		return true;
+	}
+	ScriptStateLock lock;
+	BASE_OBJECT *psObj = objSnapshotObject(snapshot);
+	if (psObj == nullptr)
+	{
+		return false;
+	}
+	if (fields & OBJ_DERIVED_NAME)
+	{
+		snapshot.name = objInfo(psObj);
+	}
+	if (fields & OBJ_DERIVED_ARMOUR)
+	{
+		snapshot.armour = objArmour(psObj, WC_KINETIC);
+		snapshot.thermal = objArmour(psObj, WC_HEAT);
+	}
+	if (fields & OBJ_DERIVED_WEAPONS)
+	{
+		objWeaponSummary(psObj, snapshot.canHitAir, snapshot.canHitGround, snapshot.hasIndirect, snapshot.range);
+	}
+	if (fields & OBJ_DERIVED_SENSORS)
+	{
+		snapshot.isRadarDetector = objRadarDetector(psObj);
+		snapshot.isCB = psObj->type == OBJ_DROID ? cbSensorDroid((DROID *)psObj) : structCBSensor((STRUCTURE *)psObj);
+		snapshot.isSensor = psObj->type == OBJ_DROID ? standardSensorDroid((DROID *)psObj) : structStandardSensor((STRUCTURE *)psObj);
+	}
+	if (fields & OBJ_DERIVED_COST)
+	{
+		snapshot.cost = calcDroidPower((DROID *)psObj);
+	}
+	if (fields & OBJ_DERIVED_CARGO_SIZE)
+	{
+		snapshot.cargoSize = transporterSpaceRequired((DROID *)psObj);
+	}
+	if (fields & OBJ_DERIVED_RELOAD)
+	{
+		for (unsigned i = 0; i < snapshot.numWeaps && i < psObj->numWeaps; ++i)
+		{
+			snapshot.armed[i] = droidReloadBar(psObj, &psObj->asWeaps[i], i);
+		}
+	}
+	snapshot.derived |= fields;
+	return true;
+}
+
+/// Whether a droid has a weapon, so that its range is not null, without working out the range.
+static bool objSnapshotHasWeapon(const OBJ_SNAPSHOT &snapshot)
+{
+	for (unsigned i = 0; i < snapshot.numWeaps; ++i)
+	{
+		if (snapshot.weapons[i].nStat)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Properties which are null are left writable, as scripts may set them to values of their own.
+static bool objPropertyIsNull(const OBJ_SNAPSHOT &snapshot, OBJ_PROPERTY property)
+{
+	switch (property)
+	{
+	case OBJ_PROP_GROUP: return !snapshot.hasGroup;
+	case OBJ_PROP_RANGE: return snapshot.type == OBJ_DROID && !objSnapshotHasWeapon(snapshot);
+	case OBJ_PROP_MODULES: return snapshot.type == OBJ_STRUCTURE && snapshot.modules < 0;
+	default: return false;
+	}
+}
+
+/// Only transporters have the cargo properties.
+static bool objHasProperty(const OBJ_SNAPSHOT &snapshot, OBJ_PROPERTY property)
+{
+	return !objPropertyIsCargo(property) || snapshot.isTransporter;
+}
+
+static QScriptValue objWeaponList(const OBJ_SNAPSHOT &snapshot, QScriptEngine *engine)
+{
+	if (snapshot.type == OBJ_DROID && !objSnapshotDerive(snapshot, OBJ_DERIVED_RELOAD))
+	{
+		return QScriptValue();
+	}
+	QScriptValue weaponlist = engine->newArray(snapshot.numWeaps);
+	for (unsigned j = 0; j < snapshot.numWeaps; j++)
 	{
 		QScriptValue weapon = engine->newObject();
-		const WEAPON_STATS *psStats = asWeaponStats + psStruct->asWeaps[j].nStat;
+		const WEAPON_STATS *psStats = asWeaponStats + snapshot.weapons[j].nStat;
 		weapon.setProperty("fullname", WzStringToQScriptValue(engine, psStats->name), QScriptValue::ReadOnly);
-		weapon.setProperty("name", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly); // will be changed to contain full name
-		weapon.setProperty("id", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly);
-		weapon.setProperty("lastFired", psStruct->asWeaps[j].lastFired, QScriptValue::ReadOnly);
+		if (snapshot.type == OBJ_DROID)
+		{
+			weapon.setProperty("id", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly); // will be changed to full name
+			weapon.setProperty("name", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly);
+			weapon.setProperty("lastFired", snapshot.weapons[j].lastFired, QScriptValue::ReadOnly);
+			weapon.setProperty("armed", snapshot.armed[j], QScriptValue::ReadOnly);
+		}
+		else
+		{
+			weapon.setProperty("name", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly); // will be changed to contain full name
+			weapon.setProperty("id", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly);
+			weapon.setProperty("lastFired", snapshot.weapons[j].lastFired, QScriptValue::ReadOnly);
+		}
 		weaponlist.setProperty(j, weapon, QScriptValue::ReadOnly);
 	}
-	value.setProperty("weapons", weaponlist, QScriptValue::ReadOnly);
+	return weaponlist;
+}
+
+/// Makes the script value of one property of a droid, structure or feature, as documented below.
+static QScriptValue objProperty(const OBJ_SNAPSHOT &snapshot, OBJ_PROPERTY property, QScriptEngine *engine)
+{
+	if (objPropertyIsNull(snapshot, property))
+	{
+		return QScriptValue(QScriptValue::NullValue);
+	}
+	unsigned derived = 0;
+	switch (property)
+	{
+	case OBJ_PROP_NAME: derived = OBJ_DERIVED_NAME; break;
+	case OBJ_PROP_ARMOUR: case OBJ_PROP_THERMAL: derived = OBJ_DERIVED_ARMOUR; break;
+	case OBJ_PROP_CAN_HIT_AIR: case OBJ_PROP_CAN_HIT_GROUND: case OBJ_PROP_HAS_INDIRECT: case OBJ_PROP_RANGE: derived = OBJ_DERIVED_WEAPONS; break;
+	case OBJ_PROP_IS_RADAR_DETECTOR: case OBJ_PROP_IS_CB: case OBJ_PROP_IS_SENSOR: derived = OBJ_DERIVED_SENSORS; break;
+	case OBJ_PROP_COST: derived = snapshot.type == OBJ_DROID ? OBJ_DERIVED_COST : 0; break;
+	case OBJ_PROP_CARGO_SIZE: derived = OBJ_DERIVED_CARGO_SIZE; break;
+	default: break;
+	}
+	if (!objSnapshotDerive(snapshot, derived))
+	{
+		return QScriptValue();  // The object is gone.
+	}
+
+	switch (property)
+	{
+	case OBJ_PROP_ID: return QScriptValue(snapshot.id);
+	case OBJ_PROP_X: return QScriptValue(snapshot.x);
+	case OBJ_PROP_Y: return QScriptValue(snapshot.y);
+	case OBJ_PROP_Z: return QScriptValue(snapshot.z);
+	case OBJ_PROP_PLAYER: return QScriptValue(snapshot.player);
+	case OBJ_PROP_ARMOUR: return QScriptValue(snapshot.armour);
+	case OBJ_PROP_THERMAL: return QScriptValue(snapshot.thermal);
+	case OBJ_PROP_TYPE: return QScriptValue(snapshot.type);
+	case OBJ_PROP_SELECTED: return QScriptValue(snapshot.selected);
+	case OBJ_PROP_NAME: return QScriptValue(snapshot.name.c_str());
+	case OBJ_PROP_BORN: return QScriptValue(snapshot.born);
+	case OBJ_PROP_GROUP: return QScriptValue(snapshot.group);
+	default:
+		break;
+	}
+
+	if (snapshot.type == OBJ_FEATURE)
+	{
+		switch (property)
+		{
+		case OBJ_PROP_HEALTH: return QScriptValue(snapshot.health);
+		case OBJ_PROP_DAMAGEABLE: return QScriptValue(snapshot.damageable);
+		case OBJ_PROP_STATTYPE: return QScriptValue(snapshot.statType);
+		default: break;
+		}
+	}
+	else if (snapshot.type == OBJ_STRUCTURE)
+	{
+		switch (property)
+		{
+		case OBJ_PROP_IS_CB: return QScriptValue(snapshot.isCB);
+		case OBJ_PROP_IS_SENSOR: return QScriptValue(snapshot.isSensor);
+		case OBJ_PROP_CAN_HIT_AIR: return QScriptValue(snapshot.canHitAir);
+		case OBJ_PROP_CAN_HIT_GROUND: return QScriptValue(snapshot.canHitGround);
+		case OBJ_PROP_HAS_INDIRECT: return QScriptValue(snapshot.hasIndirect);
+		case OBJ_PROP_IS_RADAR_DETECTOR: return QScriptValue(snapshot.isRadarDetector);
+		case OBJ_PROP_RANGE: return QScriptValue(snapshot.range);
+		case OBJ_PROP_STATUS: return QScriptValue(snapshot.status);
+		case OBJ_PROP_HEALTH: return QScriptValue(snapshot.health);
+		case OBJ_PROP_COST: return QScriptValue(snapshot.structureCost);
+		case OBJ_PROP_STATTYPE: return QScriptValue(snapshot.statType);
+		case OBJ_PROP_MODULES: return QScriptValue(snapshot.modules);
+		case OBJ_PROP_WEAPONS: return objWeaponList(snapshot, engine);
+		default: break;
+		}
+	}
+	else if (snapshot.type == OBJ_DROID)
+	{
+		switch (property)
+		{
+		case OBJ_PROP_ACTION: return QScriptValue(snapshot.action);
+		case OBJ_PROP_RANGE: return QScriptValue(snapshot.range);
+		case OBJ_PROP_ORDER: return QScriptValue(snapshot.order);
+		case OBJ_PROP_COST: return QScriptValue(snapshot.cost);
+		case OBJ_PROP_HAS_INDIRECT: return QScriptValue(snapshot.hasIndirect);
+		case OBJ_PROP_BODY_SIZE: return QScriptValue(snapshot.bodySize);
+		case OBJ_PROP_CARGO_CAPACITY: return QScriptValue(TRANSPORTER_CAPACITY);
+		case OBJ_PROP_CARGO_LEFT: return QScriptValue(snapshot.cargoLeft);
+		case OBJ_PROP_CARGO_COUNT: return QScriptValue(snapshot.cargoCount);
+		case OBJ_PROP_IS_RADAR_DETECTOR: return QScriptValue(snapshot.isRadarDetector);
+		case OBJ_PROP_IS_CB: return QScriptValue(snapshot.isCB);
+		case OBJ_PROP_IS_SENSOR: return QScriptValue(snapshot.isSensor);
+		case OBJ_PROP_CAN_HIT_AIR: return QScriptValue(snapshot.canHitAir);
+		case OBJ_PROP_CAN_HIT_GROUND: return QScriptValue(snapshot.canHitGround);
+		case OBJ_PROP_IS_VTOL: return QScriptValue(snapshot.isVTOL);
+		case OBJ_PROP_DROID_TYPE: return QScriptValue(snapshot.droidType);
+		case OBJ_PROP_EXPERIENCE: return QScriptValue(snapshot.experience);
+		case OBJ_PROP_HEALTH: return QScriptValue(snapshot.health);
+		case OBJ_PROP_BODY: return WzStringToQScriptValue(engine, asBodyStats[snapshot.body].id);
+		case OBJ_PROP_PROPULSION: return WzStringToQScriptValue(engine, asPropulsionStats[snapshot.propulsion].id);
+		case OBJ_PROP_ARMED: return QScriptValue(0.0); // deprecated!
+		case OBJ_PROP_WEAPONS: return objWeaponList(snapshot, engine);
+		case OBJ_PROP_CARGO_SIZE: return QScriptValue(snapshot.cargoSize);
+		default: break;
+		}
+	}
+	ASSERT(false, "Object %u has no property %s", snapshot.id, objPropertyNames[property]);
+	return QScriptValue();
+}
+
+/// Sets the given properties of an object as read-only properties of value, except null ones which are left writable.
+static void setObjProperties(QScriptValue &value, BASE_OBJECT *psObj, const std::vector<OBJ_PROPERTY> &properties, QScriptEngine *engine)
+{
+	OBJ_SNAPSHOT snapshot;
+	objSnapshot(snapshot, psObj, engine);
+	for (OBJ_PROPERTY property : properties)
+	{
+		if (objHasProperty(snapshot, property))
+		{
+			QScriptValue propertyValue = objProperty(snapshot, property, engine);
+			value.setProperty(objPropertyNames[property], propertyValue, objPropertyIsNull(snapshot, property) ? QScriptValue::KeepExistingFlags : QScriptValue::ReadOnly);
+		}
+	}
+}
+
+/// The script class of the proxies for one type of object in one engine. The data of each proxy is a variant holding
+/// the snapshot of the object taken at conversion. Properties are made from the snapshot when first read. The weapon
+/// lists, which are objects, and values scripts write to null properties, are kept in the data, so that each read gives
+/// the same value.
+class ObjectProxyClass : public QScriptClass
+{
+public:
+	ObjectProxyClass(QScriptEngine *engine, OBJECT_TYPE type) : QScriptClass(engine), objType(type)
+	{
+		for (int i = 0; i < OBJ_PROP_COUNT; ++i)
+		{
+			handles.push_back(engine->toStringHandle(QString::fromUtf8(objPropertyNames[i])));
+		}
+		for (OBJ_PROPERTY property : objPropertyList(type))
+		{
+			propertyIds.insert(handles[property], property);
+		}
+	}
+
+	QScriptValue newProxy(BASE_OBJECT *psObj)
+	{
+		QSharedPointer<OBJ_SNAPSHOT> snapshot = QSharedPointer<OBJ_SNAPSHOT>::create();
+		objSnapshot(*snapshot, psObj, engine());
+		return engine()->newObject(this, engine()->newVariant(QVariant::fromValue(OBJ_SNAPSHOT_PTR(snapshot))));
+	}
+
+	static OBJ_SNAPSHOT_PTR snapshot(const QScriptValue &object)
+	{
+		return object.data().toVariant().value<OBJ_SNAPSHOT_PTR>();
+	}
+
+	/// The flags of a property, which is writable if it was null.
+	static QScriptValue::PropertyFlags flags(const OBJ_SNAPSHOT &snapshot, OBJ_PROPERTY property)
+	{
+		return objPropertyIsNull(snapshot, property) ? QScriptValue::PropertyFlags() : QScriptValue::ReadOnly;
+	}
+
+	const std::vector<OBJ_PROPERTY> &properties() const
+	{
+		return objPropertyList(objType);
+	}
+
+	QScriptString handle(OBJ_PROPERTY property) const
+	{
+		return handles[property];
+	}
+
+	QueryFlags queryProperty(const QScriptValue &object, const QScriptString &name, QueryFlags flags, uint *id) override
+	{
+		auto i = propertyIds.constFind(name);
+		if (i == propertyIds.constEnd() || !objHasProperty(*snapshot(object), (OBJ_PROPERTY)i.value()))
+		{
+			return QueryFlags();  // Properties added by the script itself are ordinary properties of the proxy.
+		}
+		*id = i.value();
+		return flags;
+	}
+
+	QScriptValue property(const QScriptValue &object, const QScriptString &name, uint id) override
+	{
+		OBJ_SNAPSHOT_PTR psSnapshot = snapshot(object);
+		if (id != OBJ_PROP_WEAPONS && !objPropertyIsNull(*psSnapshot, (OBJ_PROPERTY)id))
+		{
+			return objProperty(*psSnapshot, (OBJ_PROPERTY)id, engine());
+		}
+		QScriptValue data = object.data();
+		QScriptValue value = data.property(name);
+		if (!value.isValid())
+		{
+			value = objProperty(*psSnapshot, (OBJ_PROPERTY)id, engine());
+			data.setProperty(name, value);
+		}
+		return value;
+	}
+
+	void setProperty(QScriptValue &object, const QScriptString &name, uint id, const QScriptValue &value) override
+	{
+		// Like the properties of an ordinary converted object, only the null ones are writable.
+		if (objPropertyIsNull(*snapshot(object), (OBJ_PROPERTY)id))
+		{
+			object.data().setProperty(name, value);
+		}
+	}
+
+	QScriptValue::PropertyFlags propertyFlags(const QScriptValue &object, const QScriptString &, uint id) override
+	{
+		return flags(*snapshot(object), (OBJ_PROPERTY)id);
+	}
+
+	QScriptClassPropertyIterator *newIterator(const QScriptValue &object) override;
+
+	QString name() const override
+	{
+		return QString::fromUtf8(objType == OBJ_DROID ? "Droid" : objType == OBJ_STRUCTURE ? "Structure" : "Feature");
+	}
+
+private:
+	OBJECT_TYPE objType;
+	std::vector<QScriptString> handles;       ///< Indexed by OBJ_PROPERTY.
+	QHash<QScriptString, uint> propertyIds;   ///< The properties of objType.
+};
+
+/// Enumerates the properties of a proxy, for for-in loops and for saving proxies stored in global variables.
+class ObjectProxyIterator : public QScriptClassPropertyIterator
+{
+public:
+	ObjectProxyIterator(const QScriptValue &object, const ObjectProxyClass *proxyClass)
+		: QScriptClassPropertyIterator(object), proxyClass(proxyClass), snapshot(ObjectProxyClass::snapshot(object))
+	{
+		for (OBJ_PROPERTY property : proxyClass->properties())
+		{
+			if (objHasProperty(*snapshot, property))
+			{
+				list.push_back(property);
+			}
+		}
+		toFront();
+	}
+
+	bool hasNext() const override
+	{
+		return index < (int)list.size();
+	}
+	void next() override
+	{
+		last = index++;
+	}
+	bool hasPrevious() const override
+	{
+		return index > 0;
+	}
+	void previous() override
+	{
+		last = --index;
+	}
+	void toFront() override
+	{
+		index = 0;
+		last = -1;
+	}
+	void toBack() override
+	{
+		index = list.size();
+		last = -1;
+	}
+	QScriptString name() const override
+	{
+		return proxyClass->handle(list[last]);
+	}
+	uint id() const override
+	{
+		return list[last];
+	}
+	QScriptValue::PropertyFlags flags() const override
+	{
+		return ObjectProxyClass::flags(*snapshot, list[last]);
+	}
+
+private:
+	const ObjectProxyClass *proxyClass;
+	OBJ_SNAPSHOT_PTR snapshot;
+	std::vector<OBJ_PROPERTY> list;
+	int index;
+	int last;
+};
+
+QScriptClassPropertyIterator *ObjectProxyClass::newIterator(const QScriptValue &object)
+{
+	return new ObjectProxyIterator(object, this);
+}
+
+static QHash<QScriptEngine *, ObjectProxyClass *> objectProxies[OBJ_FEATURE + 1];  // Indexed by OBJ_DROID, OBJ_STRUCTURE and OBJ_FEATURE.
+
+/// Converts a droid, structure or feature to a proxy, or to an ordinary object if the engine has no proxy class.
+static QScriptValue convGameObject(BASE_OBJECT *psObj, QScriptEngine *engine)
+{
+	ASSERT_OR_RETURN(engine->newObject(), psObj && psObj->type <= OBJ_FEATURE, "No object for conversion");
+	ObjectProxyClass *proxyClass = objectProxies[psObj->type].value(engine);
+	if (proxyClass != nullptr)
+	{
+		return proxyClass->newProxy(psObj);
+	}
+	QScriptValue value = engine->newObject();
+	setObjProperties(value, psObj, objPropertyList(psObj->type), engine);
 	return value;
 }
 
+//;; ## Structure
+//;;
+//;; Describes a structure (building). It inherits all the properties of the base object (see below).
+//;; In addition, the following properties are defined:
+//;;
+//;; * ```status``` The completeness status of the structure. It will be one of ```BEING_BUILT``` and ```BUILT```.
+//;; * ```type``` The type will always be ```STRUCTURE```.
+//;; * ```cost``` What it would cost to build this structure. (3.2+ only)
+//;; * ```stattype``` The stattype defines the type of structure. It will be one of ```HQ```, ```FACTORY```, ```POWER_GEN```,
+//;; ```RESOURCE_EXTRACTOR```, ```LASSAT```, ```DEFENSE```, ```WALL```, ```RESEARCH_LAB```, ```REPAIR_FACILITY```,
+//;; ```CYBORG_FACTORY```, ```VTOL_FACTORY```, ```REARM_PAD```, ```SAT_UPLINK```, ```GATE``` and ```COMMAND_CONTROL```.
+//;; * ```modules``` If the stattype is set to one of the factories, ```POWER_GEN``` or ```RESEARCH_LAB```, then this property is set to the
+//;; number of module upgrades it has.
+//;; * ```canHitAir``` True if the structure has anti-air capabilities. (3.2+ only)
+//;; * ```canHitGround``` True if the structure has anti-ground capabilities. (3.2+ only)
+//;; * ```isSensor``` True if the structure has sensor ability. (3.2+ only)
+//;; * ```isCB``` True if the structure has counter-battery ability. (3.2+ only)
+//;; * ```isRadarDetector``` True if the structure has radar detector ability. (3.2+ only)
+//;; * ```range``` Maximum range of its weapons. (3.2+ only)
+//;; * ```hasIndirect``` One or more of the structure's weapons are indirect. (3.2+ only)
+//;;
+QScriptValue convStructure(STRUCTURE *psStruct, QScriptEngine *engine)
+{
+	return convGameObject(psStruct, engine);
+}
+
 //;; ## Feature
 //;;
 //;; Describes a feature (a **game object** not owned by any player). It inherits all the properties of the base object (see below).
@@ -602,12 +1254,7 @@ QScriptValue convStructure(STRUCTURE *psStruct, QScriptEngine *engine)
 //;;
 QScriptValue convFeature(FEATURE *psFeature, QScriptEngine *engine)
 {
-	QScriptValue value = convObj(psFeature, engine);
-	const FEATURE_STATS *psStats = psFeature->psStats;
-	value.setProperty("health", 100 * psStats->body / MAX(1, psFeature->body), QScriptValue::ReadOnly);
-	value.setProperty("damageable", psStats->damageable, QScriptValue::ReadOnly);
-	value.setProperty("stattype", psStats->subType, QScriptValue::ReadOnly);
-	return value;
+	return convGameObject(psFeature, engine);
 }
 
 //;; ## Droid
@@ -675,85 +1322,7 @@ QScriptValue convFeature(FEATURE *psFeature, QScriptEngine *engine)
 //;;
 QScriptValue convDroid(DROID *psDroid, QScriptEngine *engine)
 {
-	bool aa = false;
-	bool ga = false;
-	bool indirect = false;
-	int range = -1;
-	const BODY_STATS *psBodyStats = &asBodyStats[psDroid->asBits[COMP_BODY]];
-
-	for (int i = 0; i < psDroid->numWeaps; i++)
-	{
-		if (psDroid->asWeaps[i].nStat)
-		{
-			WEAPON_STATS *psWeap = &asWeaponStats[psDroid->asWeaps[i].nStat];
-			aa = aa || psWeap->surfaceToAir & SHOOT_IN_AIR;
-			ga = ga || psWeap->surfaceToAir & SHOOT_ON_GROUND;
-			indirect = indirect || psWeap->movementModel == MM_INDIRECT || psWeap->movementModel == MM_HOMINGINDIRECT;
-			range = MAX(proj_GetLongRange(psWeap, psDroid->player), range);
-		}
-	}
-	DROID_TYPE type = psDroid->droidType;
-	QScriptValue value = convObj(psDroid, engine);
-	value.setProperty("action", (int)psDroid->action, QScriptValue::ReadOnly);
-	if (range >= 0)
-	{
-		value.setProperty("range", range, QScriptValue::ReadOnly);
-	}
-	else
-	{
-		value.setProperty("range", QScriptValue::NullValue);
-	}
-	value.setProperty("order", (int)psDroid->order.type, QScriptValue::ReadOnly);
-	value.setProperty("cost", calcDroidPower(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("hasIndirect", indirect, QScriptValue::ReadOnly);
-	switch (psDroid->droidType) // hide some engine craziness
-	{
-	case DROID_CYBORG_CONSTRUCT:
-		type = DROID_CONSTRUCT; break;
-	case DROID_CYBORG_SUPER:
-		type = DROID_CYBORG; break;
-	case DROID_DEFAULT:
-		type = DROID_WEAPON; break;
-	case DROID_CYBORG_REPAIR:
-		type = DROID_REPAIR; break;
-	default:
-		break;
-	}
-	value.setProperty("bodySize", psBodyStats->size, QScriptValue::ReadOnly);
-	if (isTransporter(psDroid))
-	{
-		value.setProperty("cargoCapacity", TRANSPORTER_CAPACITY, QScriptValue::ReadOnly);
-		value.setProperty("cargoLeft", calcRemainingCapacity(psDroid), QScriptValue::ReadOnly);
-		value.setProperty("cargoCount", psDroid->psGroup != nullptr? psDroid->psGroup->getNumMembers() : 0, QScriptValue::ReadOnly);
-	}
-	value.setProperty("isRadarDetector", objRadarDetector(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("isCB", cbSensorDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("isSensor", standardSensorDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("canHitAir", aa, QScriptValue::ReadOnly);
-	value.setProperty("canHitGround", ga, QScriptValue::ReadOnly);
-	value.setProperty("isVTOL", isVtolDroid(psDroid), QScriptValue::ReadOnly);
-	value.setProperty("droidType", (int)type, QScriptValue::ReadOnly);
-	value.setProperty("experience", (double)psDroid->experience / 65536.0, QScriptValue::ReadOnly);
-	value.setProperty("health", 100.0 / (double)psDroid->originalBody * (double)psDroid->body, QScriptValue::ReadOnly);
-	value.setProperty("body", WzStringToQScriptValue(engine, asBodyStats[psDroid->asBits[COMP_BODY]].id), QScriptValue::ReadOnly);
-	value.setProperty("propulsion", WzStringToQScriptValue(engine, asPropulsionStats[psDroid->asBits[COMP_PROPULSION]].id), QScriptValue::ReadOnly);
-	value.setProperty("armed", 0.0, QScriptValue::ReadOnly); // deprecated!
-	QScriptValue weaponlist = engine->newArray(psDroid->numWeaps);
-	for (int j = 0; j < psDroid->numWeaps; j++)
-	{
-		int armed = droidReloadBar(psDroid, &psDroid->asWeaps[j], j);
-		QScriptValue weapon = engine->newObject();
-		const WEAPON_STATS *psStats = asWeaponStats + psDroid->asWeaps[j].nStat;
-		weapon.setProperty("fullname", WzStringToQScriptValue(engine, psStats->name), QScriptValue::ReadOnly);
-		weapon.setProperty("id", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly); // will be changed to full name
-		weapon.setProperty("name", WzStringToQScriptValue(engine, psStats->id), QScriptValue::ReadOnly);
-		weapon.setProperty("lastFired", psDroid->asWeaps[j].lastFired, QScriptValue::ReadOnly);
-		weapon.setProperty("armed", armed, QScriptValue::ReadOnly);
-		weaponlist.setProperty(j, weapon, QScriptValue::ReadOnly);
-	}
-	value.setProperty("weapons", weaponlist, QScriptValue::ReadOnly);
-	value.setProperty("cargoSize", transporterSpaceRequired(psDroid), QScriptValue::ReadOnly);
-	return value;
+	return convGameObject(psDroid, engine);
 }
 
 //;; ## Base Object
@@ -776,31 +1345,17 @@ QScriptValue convDroid(DROID *psDroid, QScriptEngine *engine)
 //;; * ```thermal``` Amount of thermal protection that protect against heat based weapons.
 //;; * ```born``` The game time at which this object was produced or came into the world. (3.2+ only)
 //;;
+//;; The properties are those the object had when it was returned, except ```name```, ```armour```, ```thermal```,
+//;; ```range```, ```canHitAir```, ```canHitGround```, ```hasIndirect```, ```isRadarDetector```, ```isCB```,
+//;; ```isSensor```, the ```cost``` and ```cargoSize``` of droids and the ```armed``` of their weapons. These are
+//;; looked up from the object when first read, and then kept, even if the object has been destroyed since, as long as
+//;; that is in the same game tick. Read first in a later tick, they are undefined if the object has been destroyed.
+//;;
 QScriptValue convObj(BASE_OBJECT *psObj, QScriptEngine *engine)
 {
 	QScriptValue value = engine->newObject();
 	ASSERT_OR_RETURN(value, psObj, "No object for conversion");
-	value.setProperty("id", psObj->id, QScriptValue::ReadOnly);
-	value.setProperty("x", map_coord(psObj->pos.x), QScriptValue::ReadOnly);
-	value.setProperty("y", map_coord(psObj->pos.y), QScriptValue::ReadOnly);
-	value.setProperty("z", map_coord(psObj->pos.z), QScriptValue::ReadOnly);
-	value.setProperty("player", psObj->player, QScriptValue::ReadOnly);
-	value.setProperty("armour", objArmour(psObj, WC_KINETIC), QScriptValue::ReadOnly);
-	value.setProperty("thermal", objArmour(psObj, WC_HEAT), QScriptValue::ReadOnly);
-	value.setProperty("type", psObj->type, QScriptValue::ReadOnly);
-	value.setProperty("selected", psObj->selected, QScriptValue::ReadOnly);
-	value.setProperty("name", objInfo(psObj), QScriptValue::ReadOnly);
-	value.setProperty("born", psObj->born, QScriptValue::ReadOnly);
-	GROUPMAP *psMap = groups.value(engine);
-	if (psMap != nullptr && psMap->contains(psObj))
-	{
-		int group = psMap->value(psObj);
-		value.setProperty("group", group, QScriptValue::ReadOnly);
-	}
-	else
-	{
-		value.setProperty("group", QScriptValue::NullValue);
-	}
+	setObjProperties(value, psObj, objBaseProperties, engine);
 	return value;
 }
 
@@ -864,6 +1419,17 @@ QScriptValue convMax(BASE_OBJECT *psObj, QScriptEngine *engine)
 
 BASE_OBJECT *IdToObject(OBJECT_TYPE type, int id, int player)
 {
+	// The id index also contains the mission and limbo lists, which are only searched for structures, so only use it if those lists are empty.
+	if (!objmemHasOffWorldObjects(type))
+	{
+		BASE_OBJECT *psObj = findObjectById(id);
+		if (psObj == nullptr || psObj->type != type || (type != OBJ_FEATURE && player != ANYPLAYER && (int)psObj->player != player))
+		{
+			return nullptr;
+		}
+		return psObj;
+	}
+
 	switch (type)
 	{
 	case OBJ_DROID: return IdToDroid(id, player);
@@ -1209,6 +1775,11 @@ static QScriptValue js_removeLabel(QScriptContext *context, QScriptEngine *engin
 	return QScriptValue(result);
 }
 
+static QScriptValue js_removeLabelResult(QScriptContext *context, QScriptEngine *)
+{
+	return QScriptValue(labels.count(context->argument(0).toString()));
+}
+
 //-- ## getLabel(object)
 //--
 //-- Get a label string belonging to a game object. If the object has multiple labels, only the first
@@ -1448,8 +2019,7 @@ static QScriptValue js_enumGroup(QScriptContext *context, QScriptEngine *engine)
 //--
 static QScriptValue js_newGroup(QScriptContext *, QScriptEngine *engine)
 {
-	static int i = 1; // group zero reserved
-	return QScriptValue(i++);
+	return QScriptValue(scriptNewGroup(engine));
 }
 
 //-- ## activateStructure(structure, [target[, ability]])
@@ -1457,7 +2027,8 @@ static QScriptValue js_newGroup(QScriptContext *, QScriptEngine *engine)
 //-- Activate a special ability on a structure. Currently only works on the lassat.
 //-- The lassat needs a target.
 //--
-static QScriptValue js_activateStructure(QScriptContext *context, QScriptEngine *)
+/// Gives the order for activateStructure, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptActivateStructure(QScriptContext *context, bool act)
 {
 	QScriptValue structVal = context->argument(0);
 	int id = structVal.property("id").toInt32();
@@ -1471,10 +2042,24 @@ static QScriptValue js_activateStructure(QScriptContext *context, QScriptEngine
 	OBJECT_TYPE otype = (OBJECT_TYPE)objVal.property("type").toInt32();
 	BASE_OBJECT *psObj = IdToObject(otype, oid, oplayer);
 	SCRIPT_ASSERT(context, psObj, "No such object id %d belonging to player %d", oid, oplayer);
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	orderStructureObj(player, psObj);
 	return QScriptValue(true);
 }
 
+static QScriptValue js_activateStructure(QScriptContext *context, QScriptEngine *)
+{
+	return scriptActivateStructure(context, true);
+}
+
+static QScriptValue js_activateStructureResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptActivateStructure(context, false);
+}
+
 //-- ## findResearch(research, [player])
 //--
 //-- Return list of research items remaining to be researched for the given research item. (3.2+ only)
@@ -1539,7 +2124,8 @@ static QScriptValue js_findResearch(QScriptContext *context, QScriptEngine *engi
 //-- The second parameter may also be an array of such strings. The first technology that has
 //-- not yet been researched in that list will be pursued.
 //--
-static QScriptValue js_pursueResearch(QScriptContext *context, QScriptEngine *engine)
+/// Starts research for pursueResearch, or if start is false, only works out whether it would start any.
+static QScriptValue pursueResearch(QScriptContext *context, bool start)
 {
 	QScriptValue structVal = context->argument(0);
 	int id = structVal.property("id").toInt32();
@@ -1602,6 +2188,10 @@ static QScriptValue js_pursueResearch(QScriptContext *context, QScriptEngine *en
 					          || (bits & RESBITS_PENDING_ONLY) || (bits & RESEARCHED);
 				}
 			}
+			if (!started && !start)
+			{
+				return QScriptValue(true);
+			}
 			if (!started) // found relevant item on the path?
 			{
 				sendResearchStatus(psStruct, cur->index, player, true);
@@ -1636,6 +2226,16 @@ static QScriptValue js_pursueResearch(QScriptContext *context, QScriptEngine *en
 	return QScriptValue(false); // none found
 }
 
+static QScriptValue js_pursueResearch(QScriptContext *context, QScriptEngine *)
+{
+	return pursueResearch(context, true);
+}
+
+static QScriptValue js_pursueResearchResult(QScriptContext *context, QScriptEngine *)
+{
+	return pursueResearch(context, false);
+}
+
 //-- ## getResearch(research[, player])
 //--
 //-- Fetch information about a given technology item, given by a string that matches
@@ -1966,7 +2566,8 @@ static QScriptValue js_makeTemplate(QScriptContext *context, QScriptEngine *engi
 //-- It is now unused and in 3.2+ should be passed "", while in 3.1 it should be the
 //-- droid type to be built. Returns a boolean that is true if production was started.
 //--
-static QScriptValue js_buildDroid(QScriptContext *context, QScriptEngine *engine)
+/// Starts production for buildDroid, or if start is false, only works out whether it would start.
+static QScriptValue buildDroid(QScriptContext *context, bool start)
 {
 	QScriptValue structVal = context->argument(0);
 	int id = structVal.property("id").toInt32();
@@ -1983,6 +2584,11 @@ static QScriptValue js_buildDroid(QScriptContext *context, QScriptEngine *engine
 		SCRIPT_ASSERT(context, validTemplateForFactory(psTemplate, psStruct, true),
 		              "Invalid template %s for factory %s",
 		              getName(psTemplate), getName(psStruct->pStructureType));
+		if (!start)
+		{
+			delete psTemplate;
+			return QScriptValue(true);
+		}
 		// Delete similar template from existing list before adding this one
 		for (auto t : apsTemplateList)
 		{
@@ -2006,6 +2612,16 @@ static QScriptValue js_buildDroid(QScriptContext *context, QScriptEngine *engine
 	return QScriptValue(psTemplate != nullptr);
 }
 
+static QScriptValue js_buildDroid(QScriptContext *context, QScriptEngine *)
+{
+	return buildDroid(context, true);
+}
+
+static QScriptValue js_buildDroidResult(QScriptContext *context, QScriptEngine *)
+{
+	return buildDroid(context, false);
+}
+
 //-- ## enumStruct([player[, structure type[, looking player]]])
 //--
 //-- Returns an array of structure objects. If no parameters given, it will
@@ -2428,6 +3044,16 @@ static QScriptValue js_removeStruct(QScriptContext *context, QScriptEngine *)
 	return QScriptValue(removeStruct(psStruct, true));
 }
 
+static QScriptValue js_removeStructResult(QScriptContext *context, QScriptEngine *)
+{
+	QScriptValue structVal = context->argument(0);
+	int id = structVal.property("id").toInt32();
+	int player = structVal.property("player").toInt32();
+	STRUCTURE *psStruct = IdToStruct(id, player);
+	SCRIPT_ASSERT(context, psStruct, "No such structure id %d belonging to player %d", id, player);
+	return QScriptValue(psStruct->pStructureType->type == REF_RESOURCE_EXTRACTOR);  // removeStruct leaves oil behind
+}
+
 //-- ## removeObject(game object[, special effects?])
 //--
 //-- Remove the given game object with special effects. Returns a boolean that is true on success.
@@ -2470,6 +3096,23 @@ static QScriptValue js_removeObject(QScriptContext *context, QScriptEngine *)
 	return QScriptValue(retval);
 }
 
+static QScriptValue js_removeObjectResult(QScriptContext *context, QScriptEngine *)
+{
+	QScriptValue qval = context->argument(0);
+	int id = qval.property("id").toInt32();
+	int player = qval.property("player").toInt32();
+	OBJECT_TYPE type = (OBJECT_TYPE)qval.property("type").toInt32();
+	BASE_OBJECT *psObj = IdToObject(type, id, player);
+	SCRIPT_ASSERT(context, psObj, "Object id %d not found belonging to player %d", id, player);
+	bool sfx = context->argumentCount() > 1 && context->argument(1).toBool();
+	if (psObj->type == OBJ_STRUCTURE)
+	{
+		// destroyStruct reports nothing, and removeStruct whether it left oil behind.
+		return QScriptValue(!sfx && ((STRUCTURE *)psObj)->pStructureType->type == REF_RESOURCE_EXTRACTOR);
+	}
+	return QScriptValue(true);
+}
+
 //-- ## clearConsole()
 //--
 //-- Clear the console. (3.3+ only)
@@ -2647,7 +3290,8 @@ static QScriptValue js_terrainType(QScriptContext *context, QScriptEngine *)
 //--
 //-- Give a droid an order to do something. (3.2+ only)
 //--
-static QScriptValue js_orderDroid(QScriptContext *context, QScriptEngine *)
+/// Gives the order for orderDroid, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptOrderDroid(QScriptContext *context, bool act)
 {
 	QScriptValue droidVal = context->argument(0);
 	int id = droidVal.property("id").toInt32();
@@ -2658,6 +3302,10 @@ static QScriptValue js_orderDroid(QScriptContext *context, QScriptEngine *)
 	SCRIPT_ASSERT(context, order == DORDER_HOLD || order == DORDER_RTR || order == DORDER_STOP
 	              || order == DORDER_RTB || order == DORDER_REARM || order == DORDER_RECYCLE,
 	              "Invalid order: %s", getDroidOrderName(order));
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	if (order == DORDER_REARM)
 	{
 		if (STRUCTURE *psStruct = findNearestReArmPad(psDroid, psDroid->psBaseStruct, false))
@@ -2676,11 +3324,22 @@ static QScriptValue js_orderDroid(QScriptContext *context, QScriptEngine *)
 	return QScriptValue(true);
 }
 
+static QScriptValue js_orderDroid(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroid(context, true);
+}
+
+static QScriptValue js_orderDroidResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroid(context, false);
+}
+
 //-- ## orderDroidObj(droid, order, object)
 //--
 //-- Give a droid an order to do something to something.
 //--
-static QScriptValue js_orderDroidObj(QScriptContext *context, QScriptEngine *)
+/// Gives the order for orderDroidObj, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptOrderDroidObj(QScriptContext *context, bool act)
 {
 	QScriptValue droidVal = context->argument(0);
 	int id = droidVal.property("id").toInt32();
@@ -2695,20 +3354,36 @@ static QScriptValue js_orderDroidObj(QScriptContext *context, QScriptEngine *)
 	BASE_OBJECT *psObj = IdToObject(otype, oid, oplayer);
 	SCRIPT_ASSERT(context, psObj, "Object id %d not found belonging to player %d", oid, oplayer);
 	SCRIPT_ASSERT(context, validOrderForObj(order), "Invalid order: %s", getDroidOrderName(order));
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	orderDroidObj(psDroid, order, psObj, ModeQueue);
 	return QScriptValue(true);
 }
 
+static QScriptValue js_orderDroidObj(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidObj(context, true);
+}
+
+static QScriptValue js_orderDroidObjResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidObj(context, false);
+}
+
 //-- ## orderDroidBuild(droid, order, structure type, x, y[, direction])
 //--
 //-- Give a droid an order to build something at the given position. Returns true if allowed.
 //--
-static QScriptValue js_orderDroidBuild(QScriptContext *context, QScriptEngine *)
+/// Gives the order for orderDroidBuild, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptOrderDroidBuild(QScriptContext *context, bool act)
 {
 	QScriptValue droidVal = context->argument(0);
 	int id = droidVal.property("id").toInt32();
 	int player = droidVal.property("player").toInt32();
 	DROID *psDroid = IdToDroid(id, player);
+	SCRIPT_ASSERT(context, psDroid, "Droid id %d not found belonging to player %d", id, player);
 	DROID_ORDER order = (DROID_ORDER)context->argument(1).toInt32();
 	QString statName = context->argument(2).toString();
 	int index = getStructStatFromName(QStringToWzString(statName));
@@ -2724,15 +3399,30 @@ static QScriptValue js_orderDroidBuild(QScriptContext *context, QScriptEngine *)
 	{
 		direction = DEG(context->argument(5).toNumber());
 	}
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	orderDroidStatsLocDir(psDroid, order, psStats, world_coord(x) + TILE_UNITS / 2, world_coord(y) + TILE_UNITS / 2, direction, ModeQueue);
 	return QScriptValue(true);
 }
 
+static QScriptValue js_orderDroidBuild(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidBuild(context, true);
+}
+
+static QScriptValue js_orderDroidBuildResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidBuild(context, false);
+}
+
 //-- ## orderDroidLoc(droid, order, x, y)
 //--
 //-- Give a droid an order to do something at the given location.
 //--
-static QScriptValue js_orderDroidLoc(QScriptContext *context, QScriptEngine *)
+/// Gives the order for orderDroidLoc, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptOrderDroidLoc(QScriptContext *context, bool act)
 {
 	QScriptValue droidVal = context->argument(0);
 	int id = droidVal.property("id").toInt32();
@@ -2745,10 +3435,24 @@ static QScriptValue js_orderDroidLoc(QScriptContext *context, QScriptEngine *)
 	DROID *psDroid = IdToDroid(id, player);
 	SCRIPT_ASSERT(context, psDroid, "Droid id %d not found belonging to player %d", id, player);
 	SCRIPT_ASSERT(context, tileOnMap(x, y), "Outside map bounds (%d, %d)", x, y);
+	if (!act)
+	{
+		return QScriptValue();
+	}
 	orderDroidLoc(psDroid, order, world_coord(x), world_coord(y), ModeQueue);
 	return QScriptValue();
 }
 
+static QScriptValue js_orderDroidLoc(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidLoc(context, true);
+}
+
+static QScriptValue js_orderDroidLocResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptOrderDroidLoc(context, false);
+}
+
 //-- ## setMissionTime(time)
 //--
 //-- Set mission countdown in seconds.
@@ -3037,6 +3741,22 @@ static QScriptValue js_gameOverMessage(QScriptContext *context, QScriptEngine *e
 	if (autogame_enabled())
 	{
 		debug(LOG_WARNING, "Autogame completed successfully!");
+		// Enough of the outcome to compare test games by, see tests/concurrentscripts.sh.
+		debug(LOG_WARNING, "Autogame result: game time %u, player %d %s", gameTime, player, gameWon ? "won" : "lost");
+		for (int i = 0; i < game.maxPlayers; ++i)
+		{
+			int droids = 0, structures = 0;
+			for (DROID *psDroid = apsDroidLists[i]; psDroid != nullptr; psDroid = psDroid->psNext)
+			{
+				++droids;
+			}
+			for (STRUCTURE *psStruct = apsStructLists[i]; psStruct != nullptr; psStruct = psStruct->psNext)
+			{
+				++structures;
+			}
+			debug(LOG_WARNING, "Autogame result: player %d has %d droids, %d structures and %d power", i, droids, structures, getPower(i));
+		}
+		NETreplaySaveStop();
 		exit(0);
 	}
 	return QScriptValue();
@@ -3335,6 +4055,20 @@ static QScriptValue js_removeTemplate(QScriptContext *context, QScriptEngine *en
 	return QScriptValue();
 }
 
+/// What enableTemplate and removeTemplate return, which is false if there is no such template.
+static QScriptValue js_templateResult(QScriptContext *context, QScriptEngine *)
+{
+	WzString templateName = WzString::fromUtf8(context->argument(0).toString().toUtf8().constData());
+	for (auto &keyvaluepair : droidTemplates[selectedPlayer])
+	{
+		if (templateName.compare(keyvaluepair.second->id) == 0)
+		{
+			return QScriptValue();
+		}
+	}
+	return QScriptValue(false);
+}
+
 //-- ## setReticuleButton(id, filename, filenameHigh, tooltip, callback)
 //--
 //-- Add reticule button. id is which button to change, where zero is zero is the middle button, then going clockwise from the
@@ -3569,6 +4303,7 @@ static QScriptValue js_hackChangeMe(QScriptContext *context, QScriptEngine *engi
 	int me = context->argument(0).toInt32();
 	SCRIPT_ASSERT_PLAYER(context, me);
 	engine->globalObject().setProperty("me", me);
+	scriptDispatchChanged(engine);
 	return QScriptValue();
 }
 
@@ -3582,6 +4317,16 @@ static QScriptValue js_receiveAllEvents(QScriptContext *context, QScriptEngine *
 	{
 		bool value = context->argument(0).toBool();
 		engine->globalObject().setProperty("isReceivingAllEvents", value, QScriptValue::ReadOnly | QScriptValue::Undeletable);
+		scriptDispatchChanged(engine);
+	}
+	return engine->globalObject().property("isReceivingAllEvents");
+}
+
+static QScriptValue js_receiveAllEventsResult(QScriptContext *context, QScriptEngine *engine)
+{
+	if (context->argumentCount() > 0)
+	{
+		return QScriptValue(context->argument(0).toBool());
 	}
 	return engine->globalObject().property("isReceivingAllEvents");
 }
@@ -3651,7 +4396,8 @@ static QScriptValue js_setDroidExperience(QScriptContext *context, QScriptEngine
 //-- donation was successful. May return false if this donation would push the receiving player
 //-- over unit limits. (3.2+ only)
 //--
-static QScriptValue js_donateObject(QScriptContext *context, QScriptEngine *engine)
+/// Gives away an object for donateObject, or if send is false, only works out whether it would.
+static QScriptValue donateObject(QScriptContext *context, bool send)
 {
 	QScriptValue val = context->argument(0);
 	uint32_t id = val.property("id").toUInt32();
@@ -3687,6 +4433,10 @@ static QScriptValue js_donateObject(QScriptContext *context, QScriptEngine *engi
 	{
 		return QScriptValue(false);
 	}
+	if (!send)
+	{
+		return QScriptValue(true);
+	}
 	NETbeginEncode(NETgameQueue(selectedPlayer), GAME_GIFT);
 	NETuint8_t(&giftType);
 	NETuint8_t(&player);
@@ -3696,6 +4446,16 @@ static QScriptValue js_donateObject(QScriptContext *context, QScriptEngine *engi
 	return QScriptValue(true);
 }
 
+static QScriptValue js_donateObject(QScriptContext *context, QScriptEngine *)
+{
+	return donateObject(context, true);
+}
+
+static QScriptValue js_donateObjectResult(QScriptContext *context, QScriptEngine *)
+{
+	return donateObject(context, false);
+}
+
 //-- ## donatePower(amount, to)
 //--
 //-- Donate power to another player. Returns true. (3.2+ only)
@@ -3973,7 +4733,7 @@ static QScriptValue js_enumRange(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(4).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
+	gridQuery(gridList, x, y, range);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -4040,7 +4800,7 @@ static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 		seen = context->argument(nextparam - 1).toBool();
 	}
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateArea(x1, y1, x2, y2);
+	gridQueryArea(gridList, x1, y1, x2, y2);
 	QList<BASE_OBJECT *> list;
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
@@ -4068,7 +4828,8 @@ static QScriptValue js_enumArea(QScriptContext *context, QScriptEngine *engine)
 //-- Send a beacon message to target player. Target may also be ```ALLIES```.
 //-- Message is currently unused. Returns a boolean that is true on success. (3.2+ only)
 //--
-static QScriptValue js_addBeacon(QScriptContext *context, QScriptEngine *engine)
+/// Adds the beacons for addBeacon, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptAddBeacon(QScriptContext *context, QScriptEngine *engine, bool act)
 {
 	int x = world_coord(context->argument(0).toInt32());
 	int y = world_coord(context->argument(1).toInt32());
@@ -4076,6 +4837,10 @@ static QScriptValue js_addBeacon(QScriptContext *context, QScriptEngine *engine)
 	QString message = context->argument(3).toString();
 	int me = engine->globalObject().property("me").toInt32();
 	SCRIPT_ASSERT(context, target >= 0 || target == ALLIES, "Message to invalid player %d", target);
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (i != me && (i == target || (target == ALLIES && aiCheckAlliances(i, me))))
@@ -4087,16 +4852,31 @@ static QScriptValue js_addBeacon(QScriptContext *context, QScriptEngine *engine)
 	return QScriptValue(true);
 }
 
+static QScriptValue js_addBeacon(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptAddBeacon(context, engine, true);
+}
+
+static QScriptValue js_addBeaconResult(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptAddBeacon(context, engine, false);
+}
+
 //-- ## removeBeacon(target player)
 //--
 //-- Remove a beacon message sent to target player. Target may also be ```ALLIES```.
 //-- Returns a boolean that is true on success. (3.2+ only)
 //--
-static QScriptValue js_removeBeacon(QScriptContext *context, QScriptEngine *engine)
+/// Removes the beacons for removeBeacon, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptRemoveBeacon(QScriptContext *context, QScriptEngine *engine, bool act)
 {
 	int me = engine->globalObject().property("me").toInt32();
 	int target = context->argument(0).toInt32();
 	SCRIPT_ASSERT(context, target >= 0 || target == ALLIES, "Message to invalid player %d", target);
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		if (i == target || (target == ALLIES && aiCheckAlliances(i, me)))
@@ -4113,17 +4893,32 @@ static QScriptValue js_removeBeacon(QScriptContext *context, QScriptEngine *engi
 	return QScriptValue(true);
 }
 
+static QScriptValue js_removeBeacon(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptRemoveBeacon(context, engine, true);
+}
+
+static QScriptValue js_removeBeaconResult(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptRemoveBeacon(context, engine, false);
+}
+
 //-- ## chat(target player, message)
 //--
 //-- Send a message to target player. Target may also be ```ALL_PLAYERS``` or ```ALLIES```.
 //-- Returns a boolean that is true on success. (3.2+ only)
 //--
-static QScriptValue js_chat(QScriptContext *context, QScriptEngine *engine)
+/// Sends the message for chat, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptChat(QScriptContext *context, QScriptEngine *engine, bool act)
 {
 	int player = engine->globalObject().property("me").toInt32();
 	int target = context->argument(0).toInt32();
 	QString message = context->argument(1).toString();
 	SCRIPT_ASSERT(context, target >= 0 || target == ALL_PLAYERS || target == ALLIES, "Message to invalid player %d", target);
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	if (target == ALL_PLAYERS) // all
 	{
 		return QScriptValue(sendTextMessage(message.toUtf8().constData(), true, player));
@@ -4139,6 +4934,16 @@ static QScriptValue js_chat(QScriptContext *context, QScriptEngine *engine)
 	}
 }
 
+static QScriptValue js_chat(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptChat(context, engine, true);
+}
+
+static QScriptValue js_chatResult(QScriptContext *context, QScriptEngine *engine)
+{
+	return scriptChat(context, engine, false);
+}
+
 //-- ## setAlliance(player1, player2, value)
 //--
 //-- Set alliance status between two players to either true or false. (3.2+ only)
@@ -4178,7 +4983,8 @@ static QScriptValue js_sendAllianceRequest(QScriptContext *context, QScriptEngin
 //--
 //-- Set the assembly point droids go to when built for the specified structure. (3.2+ only)
 //--
-static QScriptValue js_setAssemblyPoint(QScriptContext *context, QScriptEngine *engine)
+/// Moves the assembly point for setAssemblyPoint, or if act is false, only checks the arguments, which throws if they are invalid.
+static QScriptValue scriptSetAssemblyPoint(QScriptContext *context, bool act)
 {
 	QScriptValue structVal = context->argument(0);
 	int id = structVal.property("id").toInt32();
@@ -4190,10 +4996,24 @@ static QScriptValue js_setAssemblyPoint(QScriptContext *context, QScriptEngine *
 	SCRIPT_ASSERT(context, psStruct->pStructureType->type == REF_FACTORY
 	              || psStruct->pStructureType->type == REF_CYBORG_FACTORY
 	              || psStruct->pStructureType->type == REF_VTOL_FACTORY, "Structure not a factory");
+	if (!act)
+	{
+		return QScriptValue(true);
+	}
 	setAssemblyPoint(((FACTORY *)psStruct->pFunctionality)->psAssemblyPoint, x, y, player, true);
 	return QScriptValue(true);
 }
 
+static QScriptValue js_setAssemblyPoint(QScriptContext *context, QScriptEngine *)
+{
+	return scriptSetAssemblyPoint(context, true);
+}
+
+static QScriptValue js_setAssemblyPointResult(QScriptContext *context, QScriptEngine *)
+{
+	return scriptSetAssemblyPoint(context, false);
+}
+
 //-- ## hackNetOff()
 //--
 //-- Turn off network transmissions. FIXME - find a better way.
@@ -4704,10 +5524,10 @@ static QScriptValue js_removeSpotter(QScriptContext *context, QScriptEngine *)
 //-- run on all network peers in the same game frame. If it is called on just one peer (such as would be
 //-- the case for AIs, for instance), then game sync will break. (3.2+ only)
 //--
-static QScriptValue js_syncRandom(QScriptContext *context, QScriptEngine *)
+static QScriptValue js_syncRandom(QScriptContext *context, QScriptEngine *engine)
 {
 	uint32_t limit = context->argument(0).toInt32();
-	return QScriptValue(gameRand(limit));
+	return QScriptValue(scriptSyncRandom(engine, limit));
 }
 
 //-- ## syncRequest(req_id, x, y[, obj[, obj2]])
@@ -4872,6 +5692,41 @@ static QScriptValue js_getMissionType(QScriptContext *context, QScriptEngine *)
 	return (int)mission.type;
 }
 
+static QScriptValue js_trueResult(QScriptContext *, QScriptEngine *)
+{
+	return QScriptValue(true);
+}
+
+/// What the deferred API functions which return something other than undefined return at the time of the call.
+static const struct
+{
+	const char *function;
+	QScriptEngine::FunctionSignature result;
+} deferredCallResults[] =
+{
+	{"removeLabel", js_removeLabelResult}, {"receiveAllEvents", js_receiveAllEventsResult},
+	{"pursueResearch", js_pursueResearchResult}, {"buildDroid", js_buildDroidResult},
+	{"donateObject", js_donateObjectResult}, {"removeStruct", js_removeStructResult},
+	{"removeObject", js_removeObjectResult}, {"enableTemplate", js_templateResult}, {"removeTemplate", js_templateResult},
+	{"setAssemblyPoint", js_setAssemblyPointResult}, {"orderDroid", js_orderDroidResult},
+	{"orderDroidBuild", js_orderDroidBuildResult}, {"orderDroidObj", js_orderDroidObjResult},
+	{"orderDroidLoc", js_orderDroidLocResult}, {"activateStructure", js_activateStructureResult},
+	{"chat", js_chatResult}, {"addBeacon", js_addBeaconResult}, {"removeBeacon", js_removeBeaconResult},
+	{"setAlliance", js_trueResult}, {"donatePower", js_trueResult}
+};
+
+QScriptEngine::FunctionSignature deferredCallResult(const QString &function)
+{
+	for (const auto &i : deferredCallResults)
+	{
+		if (function == i.function)
+		{
+			return i.result;
+		}
+	}
+	return nullptr;
+}
+
 // ----------------------------------------------------------------------------------------
 // Register functions with scripting system
 
@@ -4881,6 +5736,10 @@ bool unregisterFunctions(QScriptEngine *engine)
 	int num = groups.remove(engine);
 	delete psMap;
 	ASSERT(num == 1, "Number of engines removed from group map is %d!", num);
+	for (auto &proxies : objectProxies)
+	{
+		proxies.remove(engine);
+	}
 	labels.clear();
 	labelModel = nullptr;
 	return true;
@@ -5554,6 +6413,14 @@ bool registerFunctions(QScriptEngine *engine, const QString& scriptName)
 	GROUPMAP *psMap = new GROUPMAP;
 	groups.insert(engine, psMap);
 
+	// Create the classes of game object proxies. Scripts may hold on to proxies until the engine is gone, so the classes go with it.
+	for (OBJECT_TYPE type : {OBJ_DROID, OBJ_STRUCTURE, OBJ_FEATURE})
+	{
+		ObjectProxyClass *proxyClass = new ObjectProxyClass(engine, type);
+		objectProxies[type].insert(engine, proxyClass);
+		QObject::connect(engine, &QObject::destroyed, [proxyClass]() { delete proxyClass; });
+	}
+
 	/// Register 'Stats' object. It is a read-only representation of basic game component states.
 	//== * ```Stats``` A sparse, read-only array containing rules information for game entity types.
 	//== (For now only the highest level member attributes are documented here. Use the 'jsdebug' cheat
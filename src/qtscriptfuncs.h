@@ -54,6 +54,30 @@ enum SCRIPT_TYPE
 
 void doNotSaveGlobal(const QString &global);
 
+/// Call after changing 'me', 'isReceivingAllEvents' or the event namespaces of a script, which are cached for firing events.
+void scriptDispatchChanged(QScriptEngine *engine);
+
+/// Hold while a script reads the game state, since AI scripts may be running concurrently. Does nothing otherwise.
+class ScriptStateLock
+{
+public:
+	ScriptStateLock();
+	~ScriptStateLock();
+
+private:
+	bool locked;
+};
+
+/// Returns a number in [0...limit - 1] for syncRandom. While AI scripts run concurrently, each draws from a sequence of
+/// its own, so that the numbers do not depend on the order the threads get to them.
+int32_t scriptSyncRandom(QScriptEngine *engine, uint32_t limit);
+/// Returns the id of a new group of engine. Ids only need to be unique within a script, so while AI scripts run
+/// concurrently, each counts from the same start.
+int scriptNewGroup(QScriptEngine *engine);
+/// Returns a function which works out what a deferred API function returns, without doing anything, or nullptr if the
+/// API function returns undefined while AI scripts run concurrently.
+QScriptEngine::FunctionSignature deferredCallResult(const QString &function);
+
 void groupRemoveObject(BASE_OBJECT *psObj);
 
 /// Register functions to engine context
@@ -3908,7 +3908,7 @@ bool scrStructureBuiltInRange()
 	psTarget = &asStructureStats[index];
 
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(x, y, range);
+	gridQuery(gridList, x, y, range);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psCurr = *gi;
@@ -27,6 +27,7 @@
  */
 #include <string.h>
 #include <algorithm>
+#include <limits>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/geometry.h"
@@ -3541,7 +3542,7 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 
 	if (psBuilding->flags.test(OBJECT_FLAG_DIRTY) && !mission)
 	{
-		visTilesUpdate(psBuilding);
+		visTilesQueueUpdate(psBuilding);
 		psBuilding->flags.set(OBJECT_FLAG_DIRTY, false);
 	}
 
@@ -3552,7 +3553,7 @@ void structureUpdate(STRUCTURE *psBuilding, bool mission)
 			bool		found = false;
 
 			static GridList gridList;  // static to avoid allocations.
-			gridList = gridStartIterate(psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
+			gridQuery(gridList, psBuilding->pos.x, psBuilding->pos.y, TILE_UNITS);
 			for (GridIterator gi = gridList.begin(); !found && gi != gridList.end(); ++gi)
 			{
 				found = isDroid(*gi);
@@ -6673,57 +6674,46 @@ bool clearRearmPad(const STRUCTURE *psStruct)
 // psTarget can be NULL
 STRUCTURE *findNearestReArmPad(DROID *psDroid, STRUCTURE *psTarget, bool bClear)
 {
-	STRUCTURE		*psNearest, *psTotallyClear;
-	SDWORD			xdiff, ydiff, mindist, currdist, totallyDist;
-	SDWORD			cx, cy;
-
 	ASSERT_OR_RETURN(nullptr, psDroid != nullptr, "No droid was passed.");
 
+	Vector2i centre = psDroid->pos.xy();
 	if (psTarget != nullptr)
 	{
 		if (!vtolOnRearmPad(psTarget, psDroid))
 		{
 			return psTarget;
 		}
-		cx = (SDWORD)psTarget->pos.x;
-		cy = (SDWORD)psTarget->pos.y;
-	}
-	else
-	{
-		cx = (SDWORD)psDroid->pos.x;
-		cy = (SDWORD)psDroid->pos.y;
+		centre = psTarget->pos.xy();
 	}
-	mindist = SDWORD_MAX;
-	totallyDist = SDWORD_MAX;
-	psNearest = nullptr;
-	psTotallyClear = nullptr;
+
+	// A player has few pads, so scanning the live structure list is cheaper than a grid search, and also sees pads
+	// built since the grid was last updated.
+	STRUCTURE *psNearest = nullptr, *psTotallyClear = nullptr;
+	int64_t mindist = std::numeric_limits<int64_t>::max(), totallyDist = std::numeric_limits<int64_t>::max();
 	for (STRUCTURE *psStruct = apsStructLists[psDroid->player]; psStruct; psStruct = psStruct->psNext)
 	{
-		if (psStruct->pStructureType->type == REF_REARM_PAD
-		    && (!bClear || clearRearmPad(psStruct)))
+		if (psStruct->pStructureType->type != REF_REARM_PAD || (bClear && !clearRearmPad(psStruct)))
 		{
-			xdiff = (SDWORD)psStruct->pos.x - cx;
-			ydiff = (SDWORD)psStruct->pos.y - cy;
-			currdist = xdiff * xdiff + ydiff * ydiff;
-			if (bClear && !vtolOnRearmPad(psStruct, psDroid))
-			{
-				if (currdist < totallyDist)
-				{
-					totallyDist = currdist;
-					psTotallyClear = psStruct;
-				}
-			}
-			else
+			continue;
+		}
+		Vector2i diff = psStruct->pos.xy() - centre;
+		int64_t currdist = (int64_t)diff.x * diff.x + (int64_t)diff.y * diff.y;
+		if (bClear && !vtolOnRearmPad(psStruct, psDroid))
+		{
+			// Prefer a pad which is clear and has no other VTOL on it.
+			if (currdist < totallyDist)
 			{
-				if (currdist < mindist)
-				{
-					mindist = currdist;
-					psNearest = psStruct;
-				}
+				totallyDist = currdist;
+				psTotallyClear = psStruct;
 			}
 		}
+		else if (currdist < mindist)
+		{
+			mindist = currdist;
+			psNearest = psStruct;
+		}
 	}
-	if (bClear && (psTotallyClear != nullptr))
+	if (psTotallyClear != nullptr)
 	{
 		psNearest = psTotallyClear;
 	}
@@ -33,6 +33,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/opengl.h"
+#include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/ivisdef.h"
 #include "lib/ivis_opengl/imd.h"
 #include "lib/ivis_opengl/piefunc.h"
@@ -952,8 +953,11 @@ void shutdownTerrain()
 {
 	if (!sectors)
 	{
-		// This happens in some cases when loading a savegame from level init
-		debug(LOG_ERROR, "Trying to shutdown terrain when we did not need to!");
+		// This happens in some cases when loading a savegame from level init, and always when headless
+		if (!wzIsHeadless())
+		{
+			debug(LOG_ERROR, "Trying to shutdown terrain when we did not need to!");
+		}
 		return;
 	}
 	delete geometryVBO;
@@ -31,6 +31,7 @@
 
 #include "lib/framework/file.h"
 #include "lib/framework/string_ext.h"
+#include "lib/framework/wzapp.h"
 
 #include "lib/ivis_opengl/pietypes.h"
 #include "lib/ivis_opengl/piestate.h"
@@ -85,6 +86,10 @@ static int newPage(const char *name, int level, int width, int height, int count
 				wz_texture_compression ? gfx_api::pixel_format::compressed_rgba : gfx_api::pixel_format::rgba));
 	}
 	terrainPage = texPage;
+	if (wzIsHeadless())
+	{
+		return texPage;
+	}
 	pie_SetTexturePage(texPage);
 
 	// Specify first and last mipmap level to be used
@@ -131,7 +136,14 @@ bool texLoad(const char *fileName)
 	mipmap_max = MIPMAP_MAX;
 	mipmap_levels = MIPMAP_LEVELS;
 
-	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &glval);
+	if (wzIsHeadless())
+	{
+		glval = mipmap_max * TILES_IN_PAGE_COLUMN;  // No GL context to ask, and nothing will be uploaded anyway.
+	}
+	else
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &glval);
+	}
 
 	while (glval < mipmap_max * TILES_IN_PAGE_COLUMN)
 	{
@@ -0,0 +1,221 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Per-phase timing of game state updates.
+ */
+
+#include "lib/framework/frame.h"
+#include <physfs.h>
+#include "lib/framework/physfs_ext.h"
+#include "lib/gamelib/gtime.h"
+
+#include "tickperf.h"
+#include "console.h"
+
+#include <algorithm>
+#include <vector>
+
+struct TICK_PERF_STORE
+{
+	uint32_t gameTime;
+	uint64_t total;
+	uint64_t counters[TICK_PERF_COUNT];
+	std::vector<uint64_t> scripts;  ///< Indexed like perfScriptNames.
+};
+
+static const char *perfPointNames[TICK_PERF_COUNT] =
+{
+	"network", "scripts", "visibility", "grid", "map", "pathfinding", "droids", "structures", "projectiles", "features", "objmem"
+};
+
+static bool perfStarted = false;
+static bool perfInTick = false;
+static std::chrono::high_resolution_clock::time_point perfTickStart;
+static TICK_PERF_STORE perfCurrent;
+static std::vector<TICK_PERF_STORE> perfList;
+static std::vector<std::string> perfScriptNames;
+
+static uint64_t perfOther(TICK_PERF_STORE const &store)
+{
+	uint64_t phases = 0;
+	for (int i = 0; i < TICK_PERF_COUNT; ++i)
+	{
+		phases += store.counters[i];
+	}
+	return store.total - std::min(phases, store.total);
+}
+
+static void tickPerfWriteOut(const char *outfile)
+{
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(outfile);
+	if (!fileHandle)
+	{
+		debug(LOG_ERROR, "%s could not be opened: %s", outfile, WZ_PHYSFS_getLastError());
+		return;
+	}
+
+	std::string header = "gameTime, total";
+	for (int i = 0; i < TICK_PERF_COUNT; ++i)
+	{
+		header += std::string(", ") + perfPointNames[i];
+	}
+	header += ", other";
+	for (auto const &name : perfScriptNames)
+	{
+		header += ", " + name;
+	}
+	header += "\n";
+	bool ok = WZ_PHYSFS_writeBytes(fileHandle, header.data(), header.size()) == (PHYSFS_sint64)header.size();
+
+	for (size_t i = 0; i < perfList.size() && ok; ++i)
+	{
+		TICK_PERF_STORE const &store = perfList[i];
+		std::string line = std::to_string(store.gameTime) + ", " + std::to_string(store.total);
+		for (int j = 0; j < TICK_PERF_COUNT; ++j)
+		{
+			line += ", " + std::to_string(store.counters[j]);
+		}
+		line += ", " + std::to_string(perfOther(store));
+		for (size_t j = 0; j < perfScriptNames.size(); ++j)
+		{
+			line += ", " + std::to_string(j < store.scripts.size() ? store.scripts[j] : 0);
+		}
+		line += "\n";
+		ok = WZ_PHYSFS_writeBytes(fileHandle, line.data(), line.size()) == (PHYSFS_sint64)line.size();
+	}
+	if (!ok)
+	{
+		debug(LOG_ERROR, "Could not write to %s: %s", outfile, WZ_PHYSFS_getLastError());
+	}
+	PHYSFS_close(fileHandle);
+}
+
+void tickPerfStart()
+{
+	perfList.clear();
+	perfScriptNames.clear();
+	perfInTick = false;
+	perfStarted = true;
+	console("Started recording game state update times");
+}
+
+void tickPerfStop()
+{
+	if (!perfStarted)
+	{
+		return;
+	}
+	perfStarted = false;
+	perfInTick = false;
+
+	if (perfList.empty())
+	{
+		console("No game state updates were recorded");
+		return;
+	}
+
+	tickPerfWriteOut("tick-performance.csv");
+
+	// Summarise, so the worst phases can be seen without opening the file.
+	uint64_t totalSum = 0, totalMax = 0, overBudget = 0;
+	uint64_t sums[TICK_PERF_COUNT + 1] = {0}, maxes[TICK_PERF_COUNT + 1] = {0};
+	std::vector<uint64_t> scriptSums(perfScriptNames.size(), 0);
+	for (auto const &store : perfList)
+	{
+		totalSum += store.total;
+		totalMax = std::max(totalMax, store.total);
+		overBudget += store.total > GAME_TICKS_PER_UPDATE * 1000;
+		for (int i = 0; i < TICK_PERF_COUNT; ++i)
+		{
+			sums[i] += store.counters[i];
+			maxes[i] = std::max(maxes[i], store.counters[i]);
+		}
+		sums[TICK_PERF_COUNT] += perfOther(store);
+		maxes[TICK_PERF_COUNT] = std::max(maxes[TICK_PERF_COUNT], perfOther(store));
+		for (size_t i = 0; i < store.scripts.size(); ++i)
+		{
+			scriptSums[i] += store.scripts[i];
+		}
+	}
+	size_t count = perfList.size();
+	console("%u updates written to tick-performance.csv, avg %u us, max %u us, %u over the %u ms budget", (unsigned)count, (unsigned)(totalSum / count), (unsigned)totalMax, (unsigned)overBudget, GAME_TICKS_PER_UPDATE);
+	for (int i = 0; i <= TICK_PERF_COUNT; ++i)
+	{
+		console("%s: avg %u us, max %u us", i < TICK_PERF_COUNT ? perfPointNames[i] : "other", (unsigned)(sums[i] / count), (unsigned)maxes[i]);
+	}
+	if (!scriptSums.empty())
+	{
+		size_t worst = std::max_element(scriptSums.begin(), scriptSums.end()) - scriptSums.begin();
+		console("Slowest script %s: avg %u us", perfScriptNames[worst].c_str(), (unsigned)(scriptSums[worst] / count));
+	}
+}
+
+bool tickPerfActive()
+{
+	return perfStarted;
+}
+
+void tickPerfBeginTick()
+{
+	if (!perfStarted)
+	{
+		return;
+	}
+	perfCurrent.gameTime = gameTime;
+	perfCurrent.total = 0;
+	std::fill(perfCurrent.counters, perfCurrent.counters + TICK_PERF_COUNT, 0);
+	perfCurrent.scripts.assign(perfScriptNames.size(), 0);
+	perfInTick = true;
+	perfTickStart = std::chrono::high_resolution_clock::now();
+}
+
+void tickPerfEndTick()
+{
+	if (!perfStarted || !perfInTick)
+	{
+		return;
+	}
+	perfCurrent.total = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - perfTickStart).count();
+	perfList.push_back(perfCurrent);
+	perfInTick = false;
+}
+
+void tickPerfAdd(TICK_PERF_POINT pp, std::chrono::microseconds time)
+{
+	if (!perfInTick)
+	{
+		return;
+	}
+	perfCurrent.counters[pp] += time.count();
+}
+
+void tickPerfAddScript(std::string const &script, std::chrono::microseconds time)
+{
+	if (!perfInTick)
+	{
+		return;  // Scripts also run between game state updates, for example from the user interface.
+	}
+	size_t index = std::find(perfScriptNames.begin(), perfScriptNames.end(), script) - perfScriptNames.begin();
+	if (index == perfScriptNames.size())
+	{
+		perfScriptNames.push_back(script);
+	}
+	perfCurrent.scripts.resize(perfScriptNames.size(), 0);
+	perfCurrent.scripts[index] += time.count();
+}
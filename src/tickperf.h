@@ -0,0 +1,88 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Per-phase timing of game state updates.
+ */
+
+#ifndef __INCLUDED_SRC_TICKPERF_H__
+#define __INCLUDED_SRC_TICKPERF_H__
+
+#include "lib/framework/frame.h"
+
+#include <chrono>
+#include <string>
+
+/// Phases of a game state update, measured by the tick profiler. Time not spent in any of these is reported as "other".
+enum TICK_PERF_POINT
+{
+	TICK_PERF_NETWORK,      ///< Sending droid orders and game time messages.
+	TICK_PERF_SCRIPTS,      ///< Script events and timers, run from updateScripts.
+	TICK_PERF_VISIBILITY,   ///< Visibility levels and object visibility.
+	TICK_PERF_GRID,         ///< Putting all objects into the grid.
+	TICK_PERF_MAP,          ///< mapUpdate.
+	TICK_PERF_PATHFINDING,  ///< fpathUpdate.
+	TICK_PERF_DROIDS,       ///< Droid updates, including droids on missions.
+	TICK_PERF_STRUCTURES,   ///< Structure updates, including structures on missions.
+	TICK_PERF_PROJECTILES,  ///< proj_UpdateAll.
+	TICK_PERF_FEATURES,     ///< Feature updates.
+	TICK_PERF_OBJMEM,       ///< Freeing dead objects.
+	TICK_PERF_COUNT
+};
+
+/// Starts recording the duration of each phase of every game state update.
+void tickPerfStart();
+/// Stops recording, writes the samples to tick-performance.csv and prints a summary to the console.
+void tickPerfStop();
+bool tickPerfActive();
+
+void tickPerfBeginTick();  ///< Call just before a game state update.
+void tickPerfEndTick();    ///< Call just after a game state update.
+
+/// Adds time spent in the given phase to the current tick. A phase can be measured several times per tick.
+void tickPerfAdd(TICK_PERF_POINT pp, std::chrono::microseconds time);
+/// Adds time spent running a script function to the current tick. Scripts are counted by scriptName and player, and independently of the phases.
+/// Not thread-safe: callers running scripts on other threads must serialise calls, as callResolvedFunction does with ScriptStateLock.
+void tickPerfAddScript(std::string const &script, std::chrono::microseconds time);
+
+/// Measures the time until it goes out of scope, if the tick profiler is running.
+class TickPerfScope
+{
+public:
+	TickPerfScope(TICK_PERF_POINT pp) : point(pp), active(tickPerfActive())
+	{
+		if (active)
+		{
+			start = std::chrono::high_resolution_clock::now();
+		}
+	}
+	~TickPerfScope()
+	{
+		if (active)
+		{
+			tickPerfAdd(point, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start));
+		}
+	}
+
+private:
+	TICK_PERF_POINT point;
+	bool active;
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+#endif // __INCLUDED_SRC_TICKPERF_H__
@@ -24,6 +24,8 @@
  */
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
+#include "lib/framework/math_ext.h"
+#include "lib/framework/wzapp.h"
 
 #include "lib/gamelib/gtime.h"
 #include "lib/sound/audio.h"
@@ -39,6 +41,7 @@
 #include "geometry.h"
 #include "hci.h"
 #include "mapgrid.h"
+#include "pointtree.h"
 #include "research.h"
 #include "scriptextern.h"
 #include "structure.h"
@@ -99,6 +102,42 @@ struct VisibleObjectHelp_t
 static int *gNumWalls = nullptr;
 static Vector2i *gWall = nullptr;
 
+/// Maximum number of extra threads used for calculating which tiles objects can see.
+#define VIS_MAX_THREADS 3
+/// Minimum number of queued objects for using the threads, since waking them up isn't free.
+#define VIS_MIN_THREADED_JOBS 8
+
+/// Calculation of which tiles an object can see. Everything needed is copied from the object on the main thread,
+/// so that doWaveTerrain can run on any thread.
+struct VisTilesJob
+{
+	BASE_OBJECT *psObj;
+	const WavecastTile *tiles;      ///< nullptr if the object does not confer visibility.
+	size_t numTiles;
+	int x, y, z;                    ///< Sensor position.
+	std::vector<TILEPOS> seenTiles;
+};
+
+/// Objects waiting for visTilesUpdateQueued, in the order they were queued. Objects removed from the queue leave a nullptr.
+static std::vector<BASE_OBJECT *> visQueuedObjects;
+/// Jobs being processed by visTilesUpdateQueued. Reused to avoid allocations.
+static std::vector<VisTilesJob> visJobs;
+static unsigned visNumJobs;
+
+struct VisWorker
+{
+	WZ_THREAD *thread;
+	WZ_SEMAPHORE *start;            ///< Posted when there are jobs to do.
+	unsigned index;
+};
+static std::vector<VisWorker> visWorkers;
+static WZ_SEMAPHORE *visWorkersDone = nullptr;
+static bool visWorkersStarted = false;
+static bool visWorkersQuit = false;
+
+/// Objects each player has fully seen this tick, which later grid queries for that player can skip. Created on first use.
+static GridFilter *visUnseenFilters[MAX_PLAYERS] = {nullptr};
+
 // forward declarations
 static void setSeenBy(BASE_OBJECT *psObj, unsigned viewer, int val);
 
@@ -118,19 +157,27 @@ void visUpdateLevel()
 	visLevelDec = gameTimeAdjustedAverage(VIS_LEVEL_DEC);
 }
 
+/// Updates whether player sees the tile. Enough after changing the watchers or sensors of only that player.
+static inline void updateTileVis(MAPTILE *psTile, const MAPTILE_VISION *psVision, int i)
+{
+	/// The definition of whether a player can see something on a given tile or not
+	if (psVision->watchers[i] > 0 || (psVision->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
+	{
+		psTile->sensorBits |= (1 << i);         // mark it as being seen
+	}
+	else
+	{
+		psTile->sensorBits &= ~(1 << i);        // mark as hidden
+	}
+}
+
+/// Updates whether each player sees the tile. Needed after changing the jammers.
 static inline void updateTileVis(MAPTILE *psTile)
 {
+	const MAPTILE_VISION *psVision = mapTileVision(psTile);
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
-		/// The definition of whether a player can see something on a given tile or not
-		if (psTile->watchers[i] > 0 || (psTile->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
-		{
-			psTile->sensorBits |= (1 << i);         // mark it as being seen
-		}
-		else
-		{
-			psTile->sensorBits &= ~(1 << i);        // mark as hidden
-		}
+		updateTileVis(psTile, psVision, i);
 	}
 }
 
@@ -150,12 +197,13 @@ uint32_t addSpotter(int x, int y, int player, int radius, bool radar, uint32_t e
 		}
 		MAPTILE *psTile = mapTile(mapX, mapY);
 		psTile->tileExploredBits |= alliancebits[player];
-		uint8_t *visionType = (!radar) ? psTile->watchers : psTile->sensors;
+		MAPTILE_VISION *psVision = mapTileVision(psTile);
+		uint8_t *visionType = (!radar) ? psVision->watchers : psVision->sensors;
 		if (visionType[player] < UBYTE_MAX)
 		{
 			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(radar)};
 			visionType[player]++;          // we observe this tile
-			updateTileVis(psTile);
+			updateTileVis(psTile, psVision, player);
 			psSpot->watchedTiles[psSpot->numWatchedTiles++] = tilePos;    // record having seen it
 		}
 	}
@@ -201,7 +249,7 @@ static void updateSpotters()
 			continue;
 		}
 		// else, ie if not expired, show objects around it
-		gridList = gridStartIterateUnseen(world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player);
+		gridQueryUnseen(gridList, world_coord(psSpot->pos.x), world_coord(psSpot->pos.y), psSpot->sensorRadius, psSpot->player, visUnseenFilters[psSpot->player]);
 		for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 		{
 			BASE_OBJECT *psObj = *gi;
@@ -218,10 +266,11 @@ SPOTTER::~SPOTTER()
 	{
 		const TILEPOS tilePos = watchedTiles[i];
 		MAPTILE *psTile = mapTile(tilePos.x, tilePos.y);
-		uint8_t *visionType = (tilePos.type == 0) ? psTile->watchers : psTile->sensors;
+		MAPTILE_VISION *psVision = mapTileVision(psTile);
+		uint8_t *visionType = (tilePos.type == 0) ? psVision->watchers : psVision->sensors;
 		ASSERT(visionType[player] > 0, "Not watching watched tile (%d, %d)", (int)tilePos.x, (int)tilePos.y);
 		visionType[player]--;
-		updateTileVis(psTile);
+		updateTileVis(psTile, psVision, player);
 	}
 	free(watchedTiles);
 }
@@ -237,7 +286,8 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 	const int ydiff = map_coord(psObj->pos.y) - mapY;
 	const int distSq = xdiff * xdiff + ydiff * ydiff;
 	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
+	MAPTILE_VISION *psVision = mapTileVision(psTile);
+	uint8_t *visionType = inRange ? psVision->watchers : psVision->sensors;
 
 	if (visionType[rayPlayer] < UBYTE_MAX && *lastRecordTilePos < MAX_SEEN_TILES)
 	{
@@ -246,25 +296,23 @@ static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAP
 		visionType[rayPlayer]++;                        // we observe this tile
 		if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))   // we are a jammer object
 		{
-			psTile->jammers[rayPlayer]++;
+			psVision->jammers[rayPlayer]++;
 			psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
+			updateTileVis(psTile);
+		}
+		else
+		{
+			updateTileVis(psTile, psVision, rayPlayer);
 		}
-		updateTileVis(psTile);
 		recordTilePos[*lastRecordTilePos] = tilePos;    // record having seen it
 		++*lastRecordTilePos;
 	}
 }
 
 /* The terrain revealing ray callback */
-static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int *lastRecordTilePos)
+// Only reads the map heights, so may be called from any thread. The tiles which can be seen are added to seenTiles.
+static void doWaveTerrain(int sx, int sy, int sz, const WavecastTile *tiles, size_t size, std::vector<TILEPOS> &seenTiles)
 {
-	const int sx = psObj->pos.x;
-	const int sy = psObj->pos.y;
-	const int sz = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
-	const unsigned radius = objSensorRange(psObj);
-	const int rayPlayer = psObj->player;
-	size_t size;
-	const WavecastTile *tiles = getWavecastTable(radius, &size);
 #define MAX_WAVECAST_LIST_SIZE 1360  // Trivial upper bound to what a fully upgraded WSS can use (its number of angles). Should probably be some factor times the maximum possible radius. Is probably a lot more than needed. Tested to need at least 180.
 	int heights[2][MAX_WAVECAST_LIST_SIZE];
 	size_t angles[2][MAX_WAVECAST_LIST_SIZE + 1];
@@ -332,8 +380,8 @@ static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int
 		if (seen)
 		{
 			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
+			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), 0};
+			seenTiles.push_back(tilePos);
 		}
 	}
 }
@@ -383,9 +431,21 @@ static bool rayLOSCallback(Vector2i pos, int32_t dist, void *data)
 }
 
 
+/// Forget about updating the object's tiles later, since it is leaving the map or being deleted.
+static void visTilesDequeue(BASE_OBJECT *psObj)
+{
+	if (psObj->visQueueIndex != UINT32_MAX)
+	{
+		ASSERT(psObj->visQueueIndex < visQueuedObjects.size() && visQueuedObjects[psObj->visQueueIndex] == psObj, "Bad visibility queue index");
+		visQueuedObjects[psObj->visQueueIndex] = nullptr;  // Skipped by visTilesUpdateQueued, so the queue stays in order.
+		psObj->visQueueIndex = UINT32_MAX;
+	}
+}
+
 /* Remove tile visibility from object */
 void visRemoveVisibility(BASE_OBJECT *psObj)
 {
+	visTilesDequeue(psObj);
 	if (psObj->watchedTiles && mapWidth && mapHeight)
 	{
 		for (int i = 0; i < psObj->numWatchedTiles; i++)
@@ -393,9 +453,10 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			const TILEPOS pos = psObj->watchedTiles[i];
 			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
 			MAPTILE *psTile = mapTile(pos.x, pos.y);
+			MAPTILE_VISION *psVision = mapTileVision(psTile);
 
 			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
+			uint8_t *visionType = (pos.type == 0) ? psVision->sensors : psVision->watchers;
 			if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
 			{
 				continue;
@@ -405,14 +466,18 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 			if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
 			{
 				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
+				ASSERT(psVision->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+				psVision->jammers[psObj->player]--;
+				if (psVision->jammers[psObj->player] == 0)
 				{
 					psTile->jammerBits &= ~(1 << psObj->player);
 				}
+				updateTileVis(psTile);
+			}
+			else
+			{
+				updateTileVis(psTile, psVision, psObj->player);
 			}
-			updateTileVis(psTile);
 		}
 	}
 	free(psObj->watchedTiles);
@@ -423,21 +488,21 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 
 void visRemoveVisibilityOffWorld(BASE_OBJECT *psObj)
 {
+	visTilesDequeue(psObj);
 	free(psObj->watchedTiles);
 	psObj->watchedTiles = nullptr;
 	psObj->numWatchedTiles = 0;
 }
 
-/* Check which tiles can be seen by an object */
-void visTilesUpdate(BASE_OBJECT *psObj)
+/* Copy what doWaveTerrain needs to know about the object. */
+static void visTilesPrepare(BASE_OBJECT *psObj, VisTilesJob &job)
 {
-	TILEPOS recordTilePos[MAX_SEEN_TILES];
-	int lastRecordTilePos = 0;
-
 	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
 
-	// Remove previous map visibility provided by object
-	visRemoveVisibility(psObj);
+	job.psObj = psObj;
+	job.tiles = nullptr;
+	job.numTiles = 0;
+	job.seenTiles.clear();
 
 	if (psObj->type == OBJ_STRUCTURE)
 	{
@@ -450,9 +515,34 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 		}
 	}
 
-	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
+	job.x = psObj->pos.x;
+	job.y = psObj->pos.y;
+	job.z = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
+	job.tiles = getWavecastTable(objSensorRange(psObj), &job.numTiles);  // Not thread safe, since it generates the tables when first needed.
+}
+
+/* Replace the map visibility provided by the object with the tiles found by doWaveTerrain. */
+static void visTilesApply(VisTilesJob const &job)
+{
+	BASE_OBJECT *psObj = job.psObj;
+	TILEPOS recordTilePos[MAX_SEEN_TILES];
+	int lastRecordTilePos = 0;
+
+	// Remove previous map visibility provided by object
+	visRemoveVisibility(psObj);
+
+	if (job.tiles == nullptr)
+	{
+		return;
+	}
+
 	psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, objJammerPower(psObj) > 0);
-	doWaveTerrain(psObj, recordTilePos, &lastRecordTilePos);
+	for (TILEPOS const &tilePos : job.seenTiles)
+	{
+		MAPTILE *psTile = mapTile(tilePos.x, tilePos.y);
+		psTile->tileExploredBits |= alliancebits[psObj->player];                                   // Share exploration with allies too
+		visMarkTile(psObj, tilePos.x, tilePos.y, psTile, recordTilePos, &lastRecordTilePos);   // Mark this tile as seen by our sensor
+	}
 
 	// Record new map visibility provided by object
 	if (lastRecordTilePos > 0)
@@ -463,6 +553,159 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 	}
 }
 
+/* Check which tiles can be seen by an object */
+void visTilesUpdate(BASE_OBJECT *psObj)
+{
+	static VisTilesJob job;  // static to avoid allocations.
+
+	visTilesPrepare(psObj, job);
+	if (job.tiles != nullptr)
+	{
+		// Do the whole circle in ∞ steps. No more pretty moiré patterns.
+		doWaveTerrain(job.x, job.y, job.z, job.tiles, job.numTiles, job.seenTiles);
+	}
+	visTilesApply(job);
+}
+
+void visTilesQueueUpdate(BASE_OBJECT *psObj)
+{
+	if (psObj->visQueueIndex == UINT32_MAX)
+	{
+		psObj->visQueueIndex = visQueuedObjects.size();
+		visQueuedObjects.push_back(psObj);
+	}
+}
+
+/* Run the wavecasts of every stride'th job, starting with job first. */
+static void visTilesCalculate(unsigned first, unsigned stride)
+{
+	for (unsigned i = first; i < visNumJobs; i += stride)
+	{
+		VisTilesJob &job = visJobs[i];
+		if (job.tiles != nullptr)
+		{
+			doWaveTerrain(job.x, job.y, job.z, job.tiles, job.numTiles, job.seenTiles);
+		}
+	}
+}
+
+static int visThreadFunc(void *data)
+{
+	VisWorker &worker = *static_cast<VisWorker *>(data);
+	while (true)
+	{
+		wzSemaphoreWait(worker.start);  // Go to sleep until needed.
+		if (visWorkersQuit)
+		{
+			return 0;
+		}
+		visTilesCalculate(worker.index + 1, visWorkers.size() + 1);  // The main thread does every visWorkers.size() + 1'th job too.
+		wzSemaphorePost(visWorkersDone);
+	}
+}
+
+void visTilesUpdateQueued()
+{
+	if (visQueuedObjects.empty())
+	{
+		return;
+	}
+
+	if (!visWorkersStarted)
+	{
+		visWorkersStarted = true;
+		visWorkersQuit = false;
+		unsigned numThreads = clip(wzGetCPUCount() - 1, 0, VIS_MAX_THREADS);
+		if (numThreads > 0)
+		{
+			visWorkersDone = wzSemaphoreCreate(0);
+			visWorkers.resize(numThreads);  // Must not be resized while the threads are running, since they keep a reference to their VisWorker.
+			for (unsigned i = 0; i < numThreads; ++i)
+			{
+				visWorkers[i].index = i;
+				visWorkers[i].start = wzSemaphoreCreate(0);
+				visWorkers[i].thread = wzThreadCreate(visThreadFunc, &visWorkers[i]);
+				wzThreadStart(visWorkers[i].thread);
+			}
+		}
+	}
+
+	// Copy what the wavecasts need on the main thread, in the order the objects were queued.
+	if (visJobs.size() < visQueuedObjects.size())
+	{
+		visJobs.resize(visQueuedObjects.size());
+	}
+	visNumJobs = 0;
+	for (BASE_OBJECT *psObj : visQueuedObjects)
+	{
+		if (psObj != nullptr)
+		{
+			psObj->visQueueIndex = UINT32_MAX;
+			visTilesPrepare(psObj, visJobs[visNumJobs++]);
+		}
+	}
+	visQueuedObjects.clear();
+
+	// The wavecasts only read the map heights, so they can run in parallel.
+	if (!visWorkers.empty() && visNumJobs >= VIS_MIN_THREADED_JOBS)
+	{
+		for (VisWorker &worker : visWorkers)
+		{
+			wzSemaphorePost(worker.start);
+		}
+		visTilesCalculate(0, visWorkers.size() + 1);
+		for (unsigned i = 0; i < visWorkers.size(); ++i)
+		{
+			wzSemaphoreWait(visWorkersDone);
+		}
+	}
+	else
+	{
+		visTilesCalculate(0, 1);
+	}
+
+	// Update the tiles in the same order as the objects were queued, so the result does not depend on the number of threads.
+	for (unsigned i = 0; i < visNumJobs; ++i)
+	{
+		visTilesApply(visJobs[i]);
+	}
+	visNumJobs = 0;
+}
+
+void visShutdown()
+{
+	if (!visWorkers.empty())
+	{
+		visWorkersQuit = true;
+		for (VisWorker &worker : visWorkers)
+		{
+			wzSemaphorePost(worker.start);  // Wake up thread, so it can quit.
+		}
+		for (VisWorker &worker : visWorkers)
+		{
+			wzThreadJoin(worker.thread);
+			wzSemaphoreDestroy(worker.start);
+		}
+		visWorkers.clear();
+		wzSemaphoreDestroy(visWorkersDone);
+		visWorkersDone = nullptr;
+	}
+	visWorkersStarted = false;
+	for (GridFilter *&filter : visUnseenFilters)
+	{
+		gridFilterDelete(filter);
+		filter = nullptr;
+	}
+	for (BASE_OBJECT *psObj : visQueuedObjects)
+	{
+		if (psObj != nullptr)
+		{
+			psObj->visQueueIndex = UINT32_MAX;
+		}
+	}
+	visQueuedObjects.clear();
+}
+
 /*reveals all the terrain in the map*/
 void revealAll(UBYTE player)
 {
@@ -597,8 +840,8 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	int top = psTarget->pos.z + map_Height(psViewer->pos.x, psViewer->pos.y) - help.startHeight;
 	int targetGrad = top * GRAD_MUL / MAX(1, help.lastDist);
 
-	bool tileWatched = psTile->watchers[psViewer->player] > 0;
-	bool tileWatchedSensor = psTile->sensors[psViewer->player] > 0;
+	bool tileWatched = mapTileVision(psTile)->watchers[psViewer->player] > 0;
+	bool tileWatchedSensor = mapTileVision(psTile)->sensors[psViewer->player] > 0;
 
 	// Show objects hidden by ECM jamming with radar blips
 	if (jammed)
@@ -741,7 +984,7 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 	// get all the objects from the grid the droid is in
 	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
 	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
+	gridQueryUnseen(gridList, psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player, visUnseenFilters[psViewer->player]);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -838,8 +1081,58 @@ static void processVisibilityLevel(BASE_OBJECT *psObj)
 	}
 }
 
+// Radar detectors can see all sensors with active radar within a long range.
+static void processVisibilityRadarDetectors()
+{
+	static PointTree radarTree;  // static to avoid allocations.
+	radarTree.clear();
+	bool haveDetector = false;
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
+	{
+		if (objActiveRadar(psObj))
+		{
+			radarTree.insert(psObj, psObj->pos.x, psObj->pos.y);
+		}
+		haveDetector = haveDetector || objRadarDetector(psObj);
+	}
+	if (!haveDetector)
+	{
+		return;
+	}
+	radarTree.sort();
+
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
+	{
+		if (objRadarDetector(psObj))
+		{
+			int range = objSensorRange(psObj) * 10;
+			for (void *target : radarTree.query(psObj->pos.x, psObj->pos.y, range))
+			{
+				BASE_OBJECT *psTarget = (BASE_OBJECT *)target;
+				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
+				    && iHypot((psTarget->pos - psObj->pos).xy()) < range)
+				{
+					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+				}
+			}
+		}
+	}
+}
+
 void processVisibility()
 {
+	for (GridFilter *&filter : visUnseenFilters)
+	{
+		if (filter == nullptr)
+		{
+			filter = gridFilterCreate();
+		}
+		else
+		{
+			gridFilterReset(*filter);
+		}
+	}
+	visTilesUpdateQueued();
 	updateSpotters();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
@@ -865,21 +1158,7 @@ void processVisibility()
 			}
 		}
 	}
-	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
-	{
-		if (objRadarDetector(psObj))
-		{
-			for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != nullptr; psTarget = psTarget->psNextFunc)
-			{
-				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
-				    && objActiveRadar(psTarget)
-				    && iHypot((psTarget->pos - psObj->pos).xy()) < objSensorRange(psObj) * 10)
-				{
-					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
-				}
-			}
-		}
-	}
+	processVisibilityRadarDetectors();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
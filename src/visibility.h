@@ -30,9 +30,19 @@
 // initialise the visibility stuff
 bool visInitialise();
 
+// Stop the threads used by visTilesUpdateQueued
+void visShutdown();
+
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj);
 
+/// Check which tiles can be seen by an object, the next time visTilesUpdateQueued is called.
+void visTilesQueueUpdate(BASE_OBJECT *psObj);
+
+/// Update the tiles seen by all queued objects. The wavecasts are done in parallel, but the tiles are updated in the order the objects were queued.
+/// Called after updating the droids and structures, by processVisibility, and before swapping out the map.
+void visTilesUpdateQueued();
+
 void revealAll(UBYTE player);
 
 /* Check whether psViewer can see psTarget
@@ -58,6 +58,9 @@ struct WARZONE_GLOBALS
 	int cameraSpeed = CAMERASPEED_DEFAULT;
 	int scrollEvent = 0; // map/radar zoom
 	bool radarJump = false;
+	int pathfindingThreads = 0; // 0 = one less than the number of cores
+	bool binarySaves = false;
+	bool recordReplays = true;
 };
 
 static WARZONE_GLOBALS warGlobs;
@@ -311,3 +314,33 @@ void war_SetRadarJump(bool radarJump)
 {
 	warGlobs.radarJump = radarJump;
 }
+
+int war_GetPathfindingThreads()
+{
+	return warGlobs.pathfindingThreads;
+}
+
+void war_SetPathfindingThreads(int threads)
+{
+	warGlobs.pathfindingThreads = MAX(threads, 0);
+}
+
+bool war_GetBinarySaves()
+{
+	return warGlobs.binarySaves;
+}
+
+void war_SetBinarySaves(bool binarySaves)
+{
+	warGlobs.binarySaves = binarySaves;
+}
+
+bool war_GetRecordReplays()
+{
+	return warGlobs.recordReplays;
+}
+
+void war_SetRecordReplays(bool recordReplays)
+{
+	warGlobs.recordReplays = recordReplays;
+}
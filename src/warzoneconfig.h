@@ -85,6 +85,15 @@ int war_GetRadarZoom();
 void war_SetRadarZoom(int radarZoom);
 bool war_GetRadarJump();
 void war_SetRadarJump(bool radarJump);
+/// Number of pathfinding threads to start, or 0 to choose based on the number of cores. Takes effect on the next fpathInitialise().
+int war_GetPathfindingThreads();
+void war_SetPathfindingThreads(int threads);
+/// Whether savegames store their templates and research in the binary format instead of as JSON text. Their objects are always stored as records.
+bool war_GetBinarySaves();
+void war_SetBinarySaves(bool binarySaves);
+/// Whether skirmish and multiplayer games are recorded to replay/.
+bool war_GetRecordReplays();
+void war_SetRecordReplays(bool recordReplays);
 int war_GetCameraSpeed();
 void war_SetCameraSpeed(int cameraSpeed);
 int war_GetScrollEvent();
@@ -59,7 +59,7 @@ static UBYTE    scriptWinLoseVideo = PLAY_NONE;
 void	runCreditsScreen();
 
 static	UDWORD	lastChange = 0;
-int hostlaunch = 0;				// used to detect if we are hosting a game via command line option.
+int hostlaunch = 0;				// used to detect if we are hosting a game via command line option. 1 = --host, 2 = --skirmish, 3 = --replay.
 
 static uint32_t lastTick = 0;
 static int barLeftX, barLeftY, barRightX, barRightY, boxWidth, boxHeight, starsNum, starHeight;
@@ -135,7 +135,7 @@ TITLECODE titleLoop()
 		// then check --join and if neither, run the normal game menu.
 		if (hostlaunch)
 		{
-			if (hostlaunch == 2)
+			if (hostlaunch == 2 || hostlaunch == 3)
 			{
 				SPinit();
 			}
@@ -291,7 +291,7 @@ void loadingScreenCallback()
 	const uint32_t currTick = wzGetTicks();
 	unsigned int i;
 
-	if (currTick - lastTick < 50)
+	if (currTick - lastTick < 50 || wzIsHeadless())
 	{
 		return;
 	}
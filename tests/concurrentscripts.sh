@@ -0,0 +1,66 @@
+#!/bin/sh
+# Plays the same AI skirmish test with the timers of AI scripts run one after another, and with them run concurrently
+# (the "concurrentScripts" option), twice each, and compares the outcomes.
+#
+# Usage: tests/concurrentscripts.sh path/to/warzone2100 [skirmish test] [extra game options...]
+#
+# The skirmish test defaults to tenai.json, ten AIs on Emergence. Its "seed", together with Math.random being replaced
+# by a sequence of each script's own in autogames, makes a game play out the same each time. Two runs in the same mode
+# must therefore end the same way, or the script fails. The serial and concurrent games are expected to differ, since
+# concurrently running scripts see the game as it was at the start of the tick, so for those the outcomes and times are
+# only shown side by side.
+
+if [ $# -lt 1 ]; then
+	echo "Usage: $0 path/to/warzone2100 [skirmish test] [extra game options...]" >&2
+	exit 2
+fi
+WZ="$1"
+TEST="${2:-tenai.json}"
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] && shift
+
+WORKDIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+
+# Runs a game, leaving its result lines in $WORKDIR/$1.result. Fails if the game did not finish.
+run_game()
+{
+	name="$1"
+	concurrent="$2"
+	shift 2
+	mkdir -p "$WORKDIR/$name"
+	printf '[General]\nconcurrentScripts=%s\n' "$concurrent" > "$WORKDIR/$name/config"
+	start=$(date +%s)
+	"$WZ" --configdir="$WORKDIR/$name" --headless --skirmish="$TEST" "$@" > "$WORKDIR/$name.log" 2>&1
+	status=$?
+	end=$(date +%s)
+	grep "Autogame result:" "$WORKDIR/$name.log" | sed 's/^.*Autogame result: //' > "$WORKDIR/$name.result"
+	echo "$name: exit status $status, $((end - start)) s"
+	if [ $status -ne 0 ] || [ ! -s "$WORKDIR/$name.result" ]; then
+		echo "$name did not finish, the end of its log follows:" >&2
+		tail -n 40 "$WORKDIR/$name.log" >&2
+		return 1
+	fi
+}
+
+failed=0
+run_game serial1 false "$@" || failed=1
+run_game serial2 false "$@" || failed=1
+run_game concurrent1 true "$@" || failed=1
+run_game concurrent2 true "$@" || failed=1
+[ $failed -eq 0 ] || exit 1
+
+if ! cmp -s "$WORKDIR/serial1.result" "$WORKDIR/serial2.result"; then
+	echo "The serial games ended differently, so the test game is not reproducible:" >&2
+	diff "$WORKDIR/serial1.result" "$WORKDIR/serial2.result" >&2
+	exit 1
+fi
+if ! cmp -s "$WORKDIR/concurrent1.result" "$WORKDIR/concurrent2.result"; then
+	echo "The concurrent games ended differently, so their outcome depends on the threads:" >&2
+	diff "$WORKDIR/concurrent1.result" "$WORKDIR/concurrent2.result" >&2
+	exit 1
+fi
+
+echo "Serial and concurrent outcomes:"
+paste -d '|' "$WORKDIR/serial1.result" "$WORKDIR/concurrent1.result" | sed 's/|/    |    /'
+exit 0